@@ -0,0 +1,515 @@
+/*
+ *  linux/arch/arm/crypto/aesbs-glue.c
+ *
+ *  Copyright (C) 2010 Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * ECB, CBC, CTR and XTS modes of AES on top of the bit-sliced NEON code,
+ * which takes eight blocks at a time.  What is left over after the last
+ * group of eight, the whole of CBC encryption, which cannot be done in
+ * parallel, and requests made in interrupt context, where the NEON unit
+ * cannot be taken, go through the table-driven code of aes_generic.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/crypto.h>
+#include <linux/string.h>
+#include <crypto/aes.h>
+#include <crypto/algapi.h>
+#include <crypto/b128ops.h>
+#include <crypto/gf128mul.h>
+
+#include <asm/neon.h>
+
+#include "aesbs.h"
+
+#define AESBS_ALIGN	16
+#define AESBS_BYTES	(AESBS_BLOCKS * AES_BLOCK_SIZE)
+
+struct aesbs_ctx {
+	struct aesbs_key	bs;
+	struct crypto_aes_ctx	fallback;
+	int			bs_valid;
+};
+
+struct aesbs_xts_ctx {
+	struct aesbs_ctx	key;
+	struct crypto_aes_ctx	twkey;
+};
+
+static inline void *aesbs_ctx(void *raw_ctx)
+{
+	return PTR_ALIGN(raw_ctx, AESBS_ALIGN);
+}
+
+static int aesbs_expand_key(struct aesbs_ctx *ctx, const u8 *in_key,
+			    unsigned int key_len)
+{
+	int err;
+
+	err = crypto_aes_expand_key(&ctx->fallback, in_key, key_len);
+	if (err)
+		return err;
+
+	/* a key set from interrupt context leaves its user on aes_generic */
+	ctx->bs_valid = 0;
+	if (kernel_neon_usable()) {
+		kernel_neon_begin();
+		aesbs_convert_key(&ctx->bs, ctx->fallback.key_enc,
+				  6 + key_len / 4);
+		kernel_neon_end();
+		ctx->bs_valid = 1;
+	}
+	return 0;
+}
+
+static int aesbs_set_key(struct crypto_tfm *tfm, const u8 *in_key,
+			 unsigned int key_len)
+{
+	struct aesbs_ctx *ctx = aesbs_ctx(crypto_tfm_ctx(tfm));
+
+	if (aesbs_expand_key(ctx, in_key, key_len)) {
+		tfm->crt_flags |= CRYPTO_TFM_RES_BAD_KEY_LEN;
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static int aesbs_xts_set_key(struct crypto_tfm *tfm, const u8 *in_key,
+			     unsigned int key_len)
+{
+	struct aesbs_xts_ctx *ctx = aesbs_ctx(crypto_tfm_ctx(tfm));
+
+	/* the data key, then the tweak key, of the same size */
+	if (key_len % 2 ||
+	    aesbs_expand_key(&ctx->key, in_key, key_len / 2) ||
+	    crypto_aes_expand_key(&ctx->twkey, in_key + key_len / 2,
+				  key_len / 2)) {
+		tfm->crt_flags |= CRYPTO_TFM_RES_BAD_KEY_LEN;
+		return -EINVAL;
+	}
+	return 0;
+}
+
+/*
+ * Takes the NEON unit for the rest of the request if it can be used.  The
+ * walk must have been started, as that may sleep, and must not sleep from
+ * here on, as preemption is disabled.
+ */
+static int aesbs_begin(struct aesbs_ctx *ctx, struct blkcipher_desc *desc)
+{
+	if (!ctx->bs_valid || !kernel_neon_usable())
+		return 0;
+
+	desc->flags &= ~CRYPTO_TFM_REQ_MAY_SLEEP;
+	kernel_neon_begin();
+	return 1;
+}
+
+static void aesbs_end(int neon)
+{
+	if (neon)
+		kernel_neon_end();
+}
+
+static int aesbs_ecb_crypt(struct blkcipher_desc *desc,
+			   struct scatterlist *dst, struct scatterlist *src,
+			   unsigned int nbytes, int enc)
+{
+	struct aesbs_ctx *ctx = aesbs_ctx(crypto_blkcipher_ctx(desc->tfm));
+	struct blkcipher_walk walk;
+	int neon, err;
+
+	blkcipher_walk_init(&walk, dst, src, nbytes);
+	err = blkcipher_walk_virt_block(desc, &walk, AESBS_BYTES);
+	neon = aesbs_begin(ctx, desc);
+
+	while ((nbytes = walk.nbytes)) {
+		u8 *out = walk.dst.virt.addr;
+		u8 *in = walk.src.virt.addr;
+
+		for (; neon && nbytes >= AESBS_BYTES; nbytes -= AESBS_BYTES) {
+			if (enc)
+				aesbs_encrypt8(&ctx->bs, out, in);
+			else
+				aesbs_decrypt8(&ctx->bs, out, in);
+			out += AESBS_BYTES;
+			in += AESBS_BYTES;
+		}
+		for (; nbytes >= AES_BLOCK_SIZE; nbytes -= AES_BLOCK_SIZE) {
+			if (enc)
+				crypto_aes_encrypt_block(&ctx->fallback, out,
+							 in);
+			else
+				crypto_aes_decrypt_block(&ctx->fallback, out,
+							 in);
+			out += AES_BLOCK_SIZE;
+			in += AES_BLOCK_SIZE;
+		}
+		err = blkcipher_walk_done(desc, &walk, nbytes);
+	}
+
+	aesbs_end(neon);
+	return err;
+}
+
+static int aesbs_ecb_encrypt(struct blkcipher_desc *desc,
+			     struct scatterlist *dst, struct scatterlist *src,
+			     unsigned int nbytes)
+{
+	return aesbs_ecb_crypt(desc, dst, src, nbytes, 1);
+}
+
+static int aesbs_ecb_decrypt(struct blkcipher_desc *desc,
+			     struct scatterlist *dst, struct scatterlist *src,
+			     unsigned int nbytes)
+{
+	return aesbs_ecb_crypt(desc, dst, src, nbytes, 0);
+}
+
+/* each block depends on the one before: nothing to do eight at a time */
+static int aesbs_cbc_encrypt(struct blkcipher_desc *desc,
+			     struct scatterlist *dst, struct scatterlist *src,
+			     unsigned int nbytes)
+{
+	struct aesbs_ctx *ctx = aesbs_ctx(crypto_blkcipher_ctx(desc->tfm));
+	struct blkcipher_walk walk;
+	int err;
+
+	blkcipher_walk_init(&walk, dst, src, nbytes);
+	err = blkcipher_walk_virt(desc, &walk);
+
+	while ((nbytes = walk.nbytes)) {
+		u8 *out = walk.dst.virt.addr;
+		u8 *in = walk.src.virt.addr;
+
+		for (; nbytes >= AES_BLOCK_SIZE; nbytes -= AES_BLOCK_SIZE) {
+			crypto_xor(walk.iv, in, AES_BLOCK_SIZE);
+			crypto_aes_encrypt_block(&ctx->fallback, walk.iv,
+						 walk.iv);
+			memcpy(out, walk.iv, AES_BLOCK_SIZE);
+			out += AES_BLOCK_SIZE;
+			in += AES_BLOCK_SIZE;
+		}
+		err = blkcipher_walk_done(desc, &walk, nbytes);
+	}
+
+	return err;
+}
+
+/*
+ * Eight blocks from in to out, which may be the same: the blocks are
+ * decrypted aside, then combined with the ciphertext from the last one
+ * down, so that no ciphertext block is overwritten before it is used.
+ */
+static void aesbs_cbc_decrypt8(struct aesbs_ctx *ctx, u8 *out, const u8 *in,
+			       u8 *iv)
+{
+	u8 buf[AESBS_BYTES] __aligned(8);
+	u8 next_iv[AES_BLOCK_SIZE] __aligned(8);
+	int i;
+
+	aesbs_decrypt8(&ctx->bs, buf, in);
+	memcpy(next_iv, in + AESBS_BYTES - AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+	for (i = AESBS_BLOCKS - 1; i > 0; i--) {
+		crypto_xor(buf + i * AES_BLOCK_SIZE,
+			   in + (i - 1) * AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+		memcpy(out + i * AES_BLOCK_SIZE, buf + i * AES_BLOCK_SIZE,
+		       AES_BLOCK_SIZE);
+	}
+	crypto_xor(buf, iv, AES_BLOCK_SIZE);
+	memcpy(out, buf, AES_BLOCK_SIZE);
+	memcpy(iv, next_iv, AES_BLOCK_SIZE);
+}
+
+static int aesbs_cbc_decrypt(struct blkcipher_desc *desc,
+			     struct scatterlist *dst, struct scatterlist *src,
+			     unsigned int nbytes)
+{
+	struct aesbs_ctx *ctx = aesbs_ctx(crypto_blkcipher_ctx(desc->tfm));
+	struct blkcipher_walk walk;
+	u8 buf[AES_BLOCK_SIZE] __aligned(8);
+	int neon, err;
+
+	blkcipher_walk_init(&walk, dst, src, nbytes);
+	err = blkcipher_walk_virt_block(desc, &walk, AESBS_BYTES);
+	neon = aesbs_begin(ctx, desc);
+
+	while ((nbytes = walk.nbytes)) {
+		u8 *out = walk.dst.virt.addr;
+		u8 *in = walk.src.virt.addr;
+
+		for (; neon && nbytes >= AESBS_BYTES; nbytes -= AESBS_BYTES) {
+			aesbs_cbc_decrypt8(ctx, out, in, walk.iv);
+			out += AESBS_BYTES;
+			in += AESBS_BYTES;
+		}
+		for (; nbytes >= AES_BLOCK_SIZE; nbytes -= AES_BLOCK_SIZE) {
+			memcpy(buf, in, AES_BLOCK_SIZE);
+			crypto_aes_decrypt_block(&ctx->fallback, out, in);
+			crypto_xor(out, walk.iv, AES_BLOCK_SIZE);
+			memcpy(walk.iv, buf, AES_BLOCK_SIZE);
+			out += AES_BLOCK_SIZE;
+			in += AES_BLOCK_SIZE;
+		}
+		err = blkcipher_walk_done(desc, &walk, nbytes);
+	}
+
+	aesbs_end(neon);
+	return err;
+}
+
+/* the counter is a big-endian number over the whole block */
+static int aesbs_ctr_crypt(struct blkcipher_desc *desc,
+			   struct scatterlist *dst, struct scatterlist *src,
+			   unsigned int nbytes)
+{
+	struct aesbs_ctx *ctx = aesbs_ctx(crypto_blkcipher_ctx(desc->tfm));
+	struct blkcipher_walk walk;
+	u8 ks[AESBS_BYTES] __aligned(8);
+	int neon, err, i;
+
+	blkcipher_walk_init(&walk, dst, src, nbytes);
+	err = blkcipher_walk_virt_block(desc, &walk, AESBS_BYTES);
+	neon = aesbs_begin(ctx, desc);
+
+	while ((nbytes = walk.nbytes)) {
+		u8 *out = walk.dst.virt.addr;
+		u8 *in = walk.src.virt.addr;
+		unsigned int n, left = 0;
+
+		/* a partial block can only be the end of the request */
+		if (nbytes < walk.total) {
+			left = nbytes % AES_BLOCK_SIZE;
+			nbytes -= left;
+		}
+
+		for (; neon && nbytes >= AESBS_BYTES; nbytes -= AESBS_BYTES) {
+			for (i = 0; i < AESBS_BLOCKS; i++) {
+				memcpy(ks + i * AES_BLOCK_SIZE, walk.iv,
+				       AES_BLOCK_SIZE);
+				crypto_inc(walk.iv, AES_BLOCK_SIZE);
+			}
+			aesbs_encrypt8(&ctx->bs, ks, ks);
+			crypto_xor(ks, in, AESBS_BYTES);
+			memcpy(out, ks, AESBS_BYTES);
+			out += AESBS_BYTES;
+			in += AESBS_BYTES;
+		}
+		for (; nbytes; nbytes -= n) {
+			n = min_t(unsigned int, nbytes, AES_BLOCK_SIZE);
+			crypto_aes_encrypt_block(&ctx->fallback, ks, walk.iv);
+			crypto_inc(walk.iv, AES_BLOCK_SIZE);
+			crypto_xor(ks, in, n);
+			memcpy(out, ks, n);
+			out += n;
+			in += n;
+		}
+		err = blkcipher_walk_done(desc, &walk, left);
+	}
+
+	aesbs_end(neon);
+	return err;
+}
+
+/*
+ * XTS as in IEEE 1619: each block is masked before and after the cipher
+ * with its tweak, the encrypted IV multiplied by x once per block.
+ */
+static int aesbs_xts_crypt(struct blkcipher_desc *desc,
+			   struct scatterlist *dst, struct scatterlist *src,
+			   unsigned int nbytes, int enc)
+{
+	struct aesbs_xts_ctx *xctx = aesbs_ctx(crypto_blkcipher_ctx(desc->tfm));
+	struct aesbs_ctx *ctx = &xctx->key;
+	struct blkcipher_walk walk;
+	be128 tweak[AESBS_BLOCKS], buf[AESBS_BLOCKS];
+	int neon, err, i;
+
+	blkcipher_walk_init(&walk, dst, src, nbytes);
+	err = blkcipher_walk_virt_block(desc, &walk, AESBS_BYTES);
+	if (!walk.nbytes)
+		return err;
+
+	crypto_aes_encrypt_block(&xctx->twkey, (u8 *)buf, walk.iv);
+	tweak[0] = buf[0];
+	neon = aesbs_begin(ctx, desc);
+
+	while ((nbytes = walk.nbytes)) {
+		be128 *out = (be128 *)walk.dst.virt.addr;
+		be128 *in = (be128 *)walk.src.virt.addr;
+
+		for (; neon && nbytes >= AESBS_BYTES; nbytes -= AESBS_BYTES) {
+			for (i = 0; i < AESBS_BLOCKS; i++) {
+				if (i)
+					gf128mul_x_ble(&tweak[i],
+						       &tweak[i - 1]);
+				be128_xor(&buf[i], &in[i], &tweak[i]);
+			}
+			if (enc)
+				aesbs_encrypt8(&ctx->bs, (u8 *)buf, (u8 *)buf);
+			else
+				aesbs_decrypt8(&ctx->bs, (u8 *)buf, (u8 *)buf);
+			for (i = 0; i < AESBS_BLOCKS; i++)
+				be128_xor(&out[i], &buf[i], &tweak[i]);
+			gf128mul_x_ble(&tweak[0], &tweak[AESBS_BLOCKS - 1]);
+			out += AESBS_BLOCKS;
+			in += AESBS_BLOCKS;
+		}
+		for (; nbytes >= AES_BLOCK_SIZE; nbytes -= AES_BLOCK_SIZE) {
+			be128_xor(buf, in, tweak);
+			if (enc)
+				crypto_aes_encrypt_block(&ctx->fallback,
+							 (u8 *)buf, (u8 *)buf);
+			else
+				crypto_aes_decrypt_block(&ctx->fallback,
+							 (u8 *)buf, (u8 *)buf);
+			be128_xor(out, buf, tweak);
+			gf128mul_x_ble(tweak, tweak);
+			out++;
+			in++;
+		}
+		err = blkcipher_walk_done(desc, &walk, nbytes);
+	}
+
+	aesbs_end(neon);
+	return err;
+}
+
+static int aesbs_xts_encrypt(struct blkcipher_desc *desc,
+			     struct scatterlist *dst, struct scatterlist *src,
+			     unsigned int nbytes)
+{
+	return aesbs_xts_crypt(desc, dst, src, nbytes, 1);
+}
+
+static int aesbs_xts_decrypt(struct blkcipher_desc *desc,
+			     struct scatterlist *dst, struct scatterlist *src,
+			     unsigned int nbytes)
+{
+	return aesbs_xts_crypt(desc, dst, src, nbytes, 0);
+}
+
+static struct crypto_alg aesbs_algs[] = { {
+	.cra_name		= "ecb(aes)",
+	.cra_driver_name	= "ecb-aes-neonbs",
+	.cra_priority		= 300,
+	.cra_flags		= CRYPTO_ALG_TYPE_BLKCIPHER,
+	.cra_blocksize		= AES_BLOCK_SIZE,
+	.cra_ctxsize		= sizeof(struct aesbs_ctx)+AESBS_ALIGN-1,
+	.cra_alignmask		= 3,
+	.cra_type		= &crypto_blkcipher_type,
+	.cra_module		= THIS_MODULE,
+	.cra_u = {
+		.blkcipher = {
+			.min_keysize	= AES_MIN_KEY_SIZE,
+			.max_keysize	= AES_MAX_KEY_SIZE,
+			.setkey		= aesbs_set_key,
+			.encrypt	= aesbs_ecb_encrypt,
+			.decrypt	= aesbs_ecb_decrypt,
+		},
+	},
+}, {
+	.cra_name		= "cbc(aes)",
+	.cra_driver_name	= "cbc-aes-neonbs",
+	.cra_priority		= 300,
+	.cra_flags		= CRYPTO_ALG_TYPE_BLKCIPHER,
+	.cra_blocksize		= AES_BLOCK_SIZE,
+	.cra_ctxsize		= sizeof(struct aesbs_ctx)+AESBS_ALIGN-1,
+	.cra_alignmask		= 3,
+	.cra_type		= &crypto_blkcipher_type,
+	.cra_module		= THIS_MODULE,
+	.cra_u = {
+		.blkcipher = {
+			.min_keysize	= AES_MIN_KEY_SIZE,
+			.max_keysize	= AES_MAX_KEY_SIZE,
+			.ivsize		= AES_BLOCK_SIZE,
+			.setkey		= aesbs_set_key,
+			.encrypt	= aesbs_cbc_encrypt,
+			.decrypt	= aesbs_cbc_decrypt,
+		},
+	},
+}, {
+	.cra_name		= "ctr(aes)",
+	.cra_driver_name	= "ctr-aes-neonbs",
+	.cra_priority		= 300,
+	.cra_flags		= CRYPTO_ALG_TYPE_BLKCIPHER,
+	.cra_blocksize		= 1,
+	.cra_ctxsize		= sizeof(struct aesbs_ctx)+AESBS_ALIGN-1,
+	.cra_alignmask		= 3,
+	.cra_type		= &crypto_blkcipher_type,
+	.cra_module		= THIS_MODULE,
+	.cra_u = {
+		.blkcipher = {
+			.min_keysize	= AES_MIN_KEY_SIZE,
+			.max_keysize	= AES_MAX_KEY_SIZE,
+			.ivsize		= AES_BLOCK_SIZE,
+			.setkey		= aesbs_set_key,
+			.encrypt	= aesbs_ctr_crypt,
+			.decrypt	= aesbs_ctr_crypt,
+		},
+	},
+}, {
+	.cra_name		= "xts(aes)",
+	.cra_driver_name	= "xts-aes-neonbs",
+	.cra_priority		= 300,
+	.cra_flags		= CRYPTO_ALG_TYPE_BLKCIPHER,
+	.cra_blocksize		= AES_BLOCK_SIZE,
+	.cra_ctxsize		= sizeof(struct aesbs_xts_ctx)+AESBS_ALIGN-1,
+	.cra_alignmask		= 3,
+	.cra_type		= &crypto_blkcipher_type,
+	.cra_module		= THIS_MODULE,
+	.cra_u = {
+		.blkcipher = {
+			.min_keysize	= 2 * AES_MIN_KEY_SIZE,
+			.max_keysize	= 2 * AES_MAX_KEY_SIZE,
+			.ivsize		= AES_BLOCK_SIZE,
+			.setkey		= aesbs_xts_set_key,
+			.encrypt	= aesbs_xts_encrypt,
+			.decrypt	= aesbs_xts_decrypt,
+		},
+	},
+} };
+
+static int __init aesbs_mod_init(void)
+{
+	int i, err;
+
+	if (!cpu_has_neon())
+		return -ENODEV;
+
+	for (i = 0; i < ARRAY_SIZE(aesbs_algs); i++) {
+		INIT_LIST_HEAD(&aesbs_algs[i].cra_list);
+		err = crypto_register_alg(&aesbs_algs[i]);
+		if (err)
+			goto unregister;
+	}
+	return 0;
+
+unregister:
+	while (--i >= 0)
+		crypto_unregister_alg(&aesbs_algs[i]);
+	return err;
+}
+
+static void __exit aesbs_mod_exit(void)
+{
+	int i;
+
+	for (i = ARRAY_SIZE(aesbs_algs) - 1; i >= 0; i--)
+		crypto_unregister_alg(&aesbs_algs[i]);
+}
+
+module_init(aesbs_mod_init);
+module_exit(aesbs_mod_exit);
+
+MODULE_DESCRIPTION("Bit-sliced AES in ECB, CBC, CTR and XTS modes using NEON");
+MODULE_LICENSE("GPL");
+MODULE_ALIAS("ecb(aes)");
+MODULE_ALIAS("cbc(aes)");
+MODULE_ALIAS("ctr(aes)");
+MODULE_ALIAS("xts(aes)");
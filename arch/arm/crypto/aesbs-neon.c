@@ -0,0 +1,550 @@
+/*
+ *  linux/arch/arm/crypto/aesbs-neon.c
+ *
+ *  Copyright (C) 2010 Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Bit-sliced AES on NEON, eight blocks at a time.
+ *
+ * Four blocks are spread over eight 64-bit words, word i holding bit i of
+ * every byte, as in Thomas Pornin's constant time "ct64" AES code; each
+ * 128-bit NEON register holds such a word for two groups of four blocks.
+ * SubBytes is then the Boyar-Peralta circuit of 113 logic operations on
+ * the eight registers, ShiftRows and MixColumns are shifts, masks and
+ * rotations within each word, and AddRoundKey is eight XORs.  There are
+ * no table lookups, so the time taken does not depend on the key or the
+ * data, and the D-cache is left alone.
+ *
+ * The file is built with -mfpu=neon: gcc may then use NEON registers for
+ * any 64-bit arithmetic, not only for the vector types.
+ */
+
+#include <linux/kernel.h>
+#include <linux/types.h>
+
+#include <asm/unaligned.h>
+
+#include "aesbs.h"
+
+typedef u64 bs_t __attribute__((vector_size(16)));
+
+#define BS(c)		((bs_t){ (c), (c) })
+
+/* gcc has no shift operators on vector types; rotations are per 64 bits */
+#define bs_shl(x, n) ({							\
+	bs_t __r;							\
+	asm("vshl.i64	%q0, %q1, %2"					\
+	    : "=w" (__r) : "w" (x), "i" (n));				\
+	__r;								\
+})
+
+#define bs_shr(x, n) ({							\
+	bs_t __r;							\
+	asm("vshr.u64	%q0, %q1, %2"					\
+	    : "=w" (__r) : "w" (x), "i" (n));				\
+	__r;								\
+})
+
+#define bs_rotr16(x) ({							\
+	bs_t __r;							\
+	asm("vshr.u64	%q0, %q1, #16\n\t"				\
+	    "vsli.64	%q0, %q1, #48" : "=&w" (__r) : "w" (x));	\
+	__r;								\
+})
+
+#define bs_rotr32(x) ({							\
+	bs_t __r;							\
+	asm("vrev64.32	%q0, %q1" : "=w" (__r) : "w" (x));		\
+	__r;								\
+})
+
+/*
+ * Four 32-bit words of a block into two 64-bit words: the even bytes of
+ * each column go to *q0, the odd bytes to *q1, 16 bits per column.
+ */
+static inline void interleave_in(u64 *q0, u64 *q1, const u8 *in)
+{
+	u64 x0, x1, x2, x3;
+
+	x0 = get_unaligned_le32(in);
+	x1 = get_unaligned_le32(in + 4);
+	x2 = get_unaligned_le32(in + 8);
+	x3 = get_unaligned_le32(in + 12);
+	x0 |= (x0 << 16);
+	x1 |= (x1 << 16);
+	x2 |= (x2 << 16);
+	x3 |= (x3 << 16);
+	x0 &= 0x0000FFFF0000FFFFULL;
+	x1 &= 0x0000FFFF0000FFFFULL;
+	x2 &= 0x0000FFFF0000FFFFULL;
+	x3 &= 0x0000FFFF0000FFFFULL;
+	x0 |= (x0 << 8);
+	x1 |= (x1 << 8);
+	x2 |= (x2 << 8);
+	x3 |= (x3 << 8);
+	x0 &= 0x00FF00FF00FF00FFULL;
+	x1 &= 0x00FF00FF00FF00FFULL;
+	x2 &= 0x00FF00FF00FF00FFULL;
+	x3 &= 0x00FF00FF00FF00FFULL;
+	*q0 = x0 | (x2 << 8);
+	*q1 = x1 | (x3 << 8);
+}
+
+static inline void interleave_out(u8 *out, u64 q0, u64 q1)
+{
+	u64 x0, x1, x2, x3;
+
+	x0 = q0 & 0x00FF00FF00FF00FFULL;
+	x1 = q1 & 0x00FF00FF00FF00FFULL;
+	x2 = (q0 >> 8) & 0x00FF00FF00FF00FFULL;
+	x3 = (q1 >> 8) & 0x00FF00FF00FF00FFULL;
+	x0 |= (x0 >> 8);
+	x1 |= (x1 >> 8);
+	x2 |= (x2 >> 8);
+	x3 |= (x3 >> 8);
+	x0 &= 0x0000FFFF0000FFFFULL;
+	x1 &= 0x0000FFFF0000FFFFULL;
+	x2 &= 0x0000FFFF0000FFFFULL;
+	x3 &= 0x0000FFFF0000FFFFULL;
+	put_unaligned_le32((u32)x0 | (u32)(x0 >> 16), out);
+	put_unaligned_le32((u32)x1 | (u32)(x1 >> 16), out + 4);
+	put_unaligned_le32((u32)x2 | (u32)(x2 >> 16), out + 8);
+	put_unaligned_le32((u32)x3 | (u32)(x3 >> 16), out + 12);
+}
+
+#define SWAPN(cl, ch, s, x, y) do {					\
+	bs_t a = (x), b = (y);						\
+	(x) = (a & BS(cl)) | bs_shl(b & BS(cl), s);			\
+	(y) = bs_shr(a & BS(ch), s) | (b & BS(ch));			\
+} while (0)
+
+#define SWAP2(x, y)	\
+	SWAPN(0x5555555555555555ULL, 0xAAAAAAAAAAAAAAAAULL, 1, x, y)
+#define SWAP4(x, y)	\
+	SWAPN(0x3333333333333333ULL, 0xCCCCCCCCCCCCCCCCULL, 2, x, y)
+#define SWAP8(x, y)	\
+	SWAPN(0x0F0F0F0F0F0F0F0FULL, 0xF0F0F0F0F0F0F0F0ULL, 4, x, y)
+
+/* 8x8 bit matrix transposition, into and out of the bit-sliced layout */
+static void ortho(bs_t *q)
+{
+	SWAP2(q[0], q[1]);
+	SWAP2(q[2], q[3]);
+	SWAP2(q[4], q[5]);
+	SWAP2(q[6], q[7]);
+
+	SWAP4(q[0], q[2]);
+	SWAP4(q[1], q[3]);
+	SWAP4(q[4], q[6]);
+	SWAP4(q[5], q[7]);
+
+	SWAP8(q[0], q[4]);
+	SWAP8(q[1], q[5]);
+	SWAP8(q[2], q[6]);
+	SWAP8(q[3], q[7]);
+}
+
+/* the S-box circuit of Boyar and Peralta, bit 7 in q[7] */
+static void sub_bytes(bs_t *q)
+{
+	bs_t x0, x1, x2, x3, x4, x5, x6, x7;
+	bs_t y1, y2, y3, y4, y5, y6, y7, y8, y9;
+	bs_t y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+	bs_t y20, y21;
+	bs_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+	bs_t z10, z11, z12, z13, z14, z15, z16, z17;
+	bs_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+	bs_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+	bs_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+	bs_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+	bs_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+	bs_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+	bs_t t60, t61, t62, t63, t64, t65, t66, t67;
+	bs_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+	x0 = q[7];
+	x1 = q[6];
+	x2 = q[5];
+	x3 = q[4];
+	x4 = q[3];
+	x5 = q[2];
+	x6 = q[1];
+	x7 = q[0];
+
+	/* top linear transformation */
+	y14 = x3 ^ x5;
+	y13 = x0 ^ x6;
+	y9 = x0 ^ x3;
+	y8 = x0 ^ x5;
+	t0 = x1 ^ x2;
+	y1 = t0 ^ x7;
+	y4 = y1 ^ x3;
+	y12 = y13 ^ y14;
+	y2 = y1 ^ x0;
+	y5 = y1 ^ x6;
+	y3 = y5 ^ y8;
+	t1 = x4 ^ y12;
+	y15 = t1 ^ x5;
+	y20 = t1 ^ x1;
+	y6 = y15 ^ x7;
+	y10 = y15 ^ t0;
+	y11 = y20 ^ y9;
+	y7 = x7 ^ y11;
+	y17 = y10 ^ y11;
+	y19 = y10 ^ y8;
+	y16 = t0 ^ y11;
+	y21 = y13 ^ y16;
+	y18 = x0 ^ y16;
+
+	/* non-linear section: inversion in GF(2^8) */
+	t2 = y12 & y15;
+	t3 = y3 & y6;
+	t4 = t3 ^ t2;
+	t5 = y4 & x7;
+	t6 = t5 ^ t2;
+	t7 = y13 & y16;
+	t8 = y5 & y1;
+	t9 = t8 ^ t7;
+	t10 = y2 & y7;
+	t11 = t10 ^ t7;
+	t12 = y9 & y11;
+	t13 = y14 & y17;
+	t14 = t13 ^ t12;
+	t15 = y8 & y10;
+	t16 = t15 ^ t12;
+	t17 = t4 ^ t14;
+	t18 = t6 ^ t16;
+	t19 = t9 ^ t14;
+	t20 = t11 ^ t16;
+	t21 = t17 ^ y20;
+	t22 = t18 ^ y19;
+	t23 = t19 ^ y21;
+	t24 = t20 ^ y18;
+
+	t25 = t21 ^ t22;
+	t26 = t21 & t23;
+	t27 = t24 ^ t26;
+	t28 = t25 & t27;
+	t29 = t28 ^ t22;
+	t30 = t23 ^ t24;
+	t31 = t22 ^ t26;
+	t32 = t31 & t30;
+	t33 = t32 ^ t24;
+	t34 = t23 ^ t33;
+	t35 = t27 ^ t33;
+	t36 = t24 & t35;
+	t37 = t36 ^ t34;
+	t38 = t27 ^ t36;
+	t39 = t29 & t38;
+	t40 = t25 ^ t39;
+
+	t41 = t40 ^ t37;
+	t42 = t29 ^ t33;
+	t43 = t29 ^ t40;
+	t44 = t33 ^ t37;
+	t45 = t42 ^ t41;
+	z0 = t44 & y15;
+	z1 = t37 & y6;
+	z2 = t33 & x7;
+	z3 = t43 & y16;
+	z4 = t40 & y1;
+	z5 = t29 & y7;
+	z6 = t42 & y11;
+	z7 = t45 & y17;
+	z8 = t41 & y10;
+	z9 = t44 & y12;
+	z10 = t37 & y3;
+	z11 = t33 & y4;
+	z12 = t43 & y13;
+	z13 = t40 & y5;
+	z14 = t29 & y2;
+	z15 = t42 & y9;
+	z16 = t45 & y14;
+	z17 = t41 & y8;
+
+	/* bottom linear transformation */
+	t46 = z15 ^ z16;
+	t47 = z10 ^ z11;
+	t48 = z5 ^ z13;
+	t49 = z9 ^ z10;
+	t50 = z2 ^ z12;
+	t51 = z2 ^ z5;
+	t52 = z7 ^ z8;
+	t53 = z0 ^ z3;
+	t54 = z6 ^ z7;
+	t55 = z16 ^ z17;
+	t56 = z12 ^ t48;
+	t57 = t50 ^ t53;
+	t58 = z4 ^ t46;
+	t59 = z3 ^ t54;
+	t60 = t46 ^ t57;
+	t61 = z14 ^ t57;
+	t62 = t52 ^ t58;
+	t63 = t49 ^ t58;
+	t64 = z4 ^ t59;
+	t65 = t61 ^ t62;
+	t66 = z1 ^ t63;
+	s0 = t59 ^ t63;
+	s6 = t56 ^ ~t62;
+	s7 = t48 ^ ~t60;
+	t67 = t64 ^ t65;
+	s3 = t53 ^ t66;
+	s4 = t51 ^ t66;
+	s5 = t47 ^ t65;
+	s1 = t64 ^ ~s3;
+	s2 = t55 ^ ~t67;
+
+	q[7] = s0;
+	q[6] = s1;
+	q[5] = s2;
+	q[4] = s3;
+	q[3] = s4;
+	q[2] = s5;
+	q[1] = s6;
+	q[0] = s7;
+}
+
+/* the inverse of the S-box affine transformation, which is an involution */
+static void inv_affine(bs_t *q)
+{
+	bs_t q0, q1, q2, q3, q4, q5, q6, q7;
+
+	q0 = ~q[0];
+	q1 = ~q[1];
+	q2 = q[2];
+	q3 = q[3];
+	q4 = q[4];
+	q5 = ~q[5];
+	q6 = ~q[6];
+	q7 = q[7];
+	q[7] = q1 ^ q4 ^ q6;
+	q[6] = q0 ^ q3 ^ q5;
+	q[5] = q7 ^ q2 ^ q4;
+	q[4] = q6 ^ q1 ^ q3;
+	q[3] = q5 ^ q0 ^ q2;
+	q[2] = q4 ^ q7 ^ q1;
+	q[1] = q3 ^ q6 ^ q0;
+	q[0] = q2 ^ q5 ^ q7;
+}
+
+/* inversion in GF(2^8) commutes with itself: undo the affine on each side */
+static void inv_sub_bytes(bs_t *q)
+{
+	inv_affine(q);
+	sub_bytes(q);
+	inv_affine(q);
+}
+
+static inline void add_round_key(bs_t *q, const bs_t *rk)
+{
+	q[0] ^= rk[0];
+	q[1] ^= rk[1];
+	q[2] ^= rk[2];
+	q[3] ^= rk[3];
+	q[4] ^= rk[4];
+	q[5] ^= rk[5];
+	q[6] ^= rk[6];
+	q[7] ^= rk[7];
+}
+
+/* each 16-bit row of a word is rotated by its own number of columns */
+static void shift_rows(bs_t *q)
+{
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		bs_t x = q[i];
+
+		q[i] = (x & BS(0x000000000000FFFFULL))
+			| bs_shr(x & BS(0x00000000FFF00000ULL), 4)
+			| bs_shl(x & BS(0x00000000000F0000ULL), 12)
+			| bs_shr(x & BS(0x0000FF0000000000ULL), 8)
+			| bs_shl(x & BS(0x000000FF00000000ULL), 8)
+			| bs_shr(x & BS(0xF000000000000000ULL), 12)
+			| bs_shl(x & BS(0x0FFF000000000000ULL), 4);
+	}
+}
+
+static void inv_shift_rows(bs_t *q)
+{
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		bs_t x = q[i];
+
+		q[i] = (x & BS(0x000000000000FFFFULL))
+			| bs_shl(x & BS(0x000000000FFF0000ULL), 4)
+			| bs_shr(x & BS(0x00000000F0000000ULL), 12)
+			| bs_shl(x & BS(0x000000FF00000000ULL), 8)
+			| bs_shr(x & BS(0x0000FF0000000000ULL), 8)
+			| bs_shl(x & BS(0x000F000000000000ULL), 12)
+			| bs_shr(x & BS(0xFFF0000000000000ULL), 4);
+	}
+}
+
+static void mix_columns(bs_t *q)
+{
+	bs_t q0, q1, q2, q3, q4, q5, q6, q7;
+	bs_t r0, r1, r2, r3, r4, r5, r6, r7;
+
+	q0 = q[0];
+	q1 = q[1];
+	q2 = q[2];
+	q3 = q[3];
+	q4 = q[4];
+	q5 = q[5];
+	q6 = q[6];
+	q7 = q[7];
+	r0 = bs_rotr16(q0);
+	r1 = bs_rotr16(q1);
+	r2 = bs_rotr16(q2);
+	r3 = bs_rotr16(q3);
+	r4 = bs_rotr16(q4);
+	r5 = bs_rotr16(q5);
+	r6 = bs_rotr16(q6);
+	r7 = bs_rotr16(q7);
+
+	q[0] = q7 ^ r7 ^ r0 ^ bs_rotr32(q0 ^ r0);
+	q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ bs_rotr32(q1 ^ r1);
+	q[2] = q1 ^ r1 ^ r2 ^ bs_rotr32(q2 ^ r2);
+	q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ bs_rotr32(q3 ^ r3);
+	q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ bs_rotr32(q4 ^ r4);
+	q[5] = q4 ^ r4 ^ r5 ^ bs_rotr32(q5 ^ r5);
+	q[6] = q5 ^ r5 ^ r6 ^ bs_rotr32(q6 ^ r6);
+	q[7] = q6 ^ r6 ^ r7 ^ bs_rotr32(q7 ^ r7);
+}
+
+static void inv_mix_columns(bs_t *q)
+{
+	bs_t q0, q1, q2, q3, q4, q5, q6, q7;
+	bs_t r0, r1, r2, r3, r4, r5, r6, r7;
+
+	q0 = q[0];
+	q1 = q[1];
+	q2 = q[2];
+	q3 = q[3];
+	q4 = q[4];
+	q5 = q[5];
+	q6 = q[6];
+	q7 = q[7];
+	r0 = bs_rotr16(q0);
+	r1 = bs_rotr16(q1);
+	r2 = bs_rotr16(q2);
+	r3 = bs_rotr16(q3);
+	r4 = bs_rotr16(q4);
+	r5 = bs_rotr16(q5);
+	r6 = bs_rotr16(q6);
+	r7 = bs_rotr16(q7);
+
+	q[0] = q5 ^ q6 ^ q7 ^ r0 ^ r5 ^ r7
+		^ bs_rotr32(q0 ^ q5 ^ q6 ^ r0 ^ r5);
+	q[1] = q0 ^ q5 ^ r0 ^ r1 ^ r5 ^ r6 ^ r7
+		^ bs_rotr32(q1 ^ q5 ^ q7 ^ r1 ^ r5 ^ r6);
+	q[2] = q0 ^ q1 ^ q6 ^ r1 ^ r2 ^ r6 ^ r7
+		^ bs_rotr32(q0 ^ q2 ^ q6 ^ r2 ^ r6 ^ r7);
+	q[3] = q0 ^ q1 ^ q2 ^ q5 ^ q6 ^ r0 ^ r2 ^ r3 ^ r5
+		^ bs_rotr32(q0 ^ q1 ^ q3 ^ q5 ^ q6 ^ q7 ^ r0 ^ r3 ^ r5 ^ r7);
+	q[4] = q1 ^ q2 ^ q3 ^ q5 ^ r1 ^ r3 ^ r4 ^ r5 ^ r6 ^ r7
+		^ bs_rotr32(q1 ^ q2 ^ q4 ^ q5 ^ q7 ^ r1 ^ r4 ^ r5 ^ r6);
+	q[5] = q2 ^ q3 ^ q4 ^ q6 ^ r2 ^ r4 ^ r5 ^ r6 ^ r7
+		^ bs_rotr32(q2 ^ q3 ^ q5 ^ q6 ^ r2 ^ r5 ^ r6 ^ r7);
+	q[6] = q3 ^ q4 ^ q5 ^ q7 ^ r3 ^ r5 ^ r6 ^ r7
+		^ bs_rotr32(q3 ^ q4 ^ q6 ^ q7 ^ r3 ^ r6 ^ r7);
+	q[7] = q4 ^ q5 ^ q6 ^ r4 ^ r6 ^ r7
+		^ bs_rotr32(q4 ^ q5 ^ q7 ^ r4 ^ r7);
+}
+
+/* blocks 0-3 go to the low half of each register, 4-7 to the high half */
+static void load8(bs_t *q, const u8 *in)
+{
+	u64 lo[8], hi[8];
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		interleave_in(&lo[i], &lo[i + 4], in + 16 * i);
+		interleave_in(&hi[i], &hi[i + 4], in + 16 * (i + 4));
+	}
+	for (i = 0; i < 8; i++)
+		q[i] = (bs_t){ lo[i], hi[i] };
+	ortho(q);
+}
+
+static void store8(u8 *out, bs_t *q)
+{
+	union {
+		bs_t	v[8];
+		u64	w[8][2];
+	} s;
+	int i;
+
+	ortho(q);
+	for (i = 0; i < 8; i++)
+		s.v[i] = q[i];
+	for (i = 0; i < 4; i++) {
+		interleave_out(out + 16 * i, s.w[i][0], s.w[i + 4][0]);
+		interleave_out(out + 16 * (i + 4), s.w[i][1], s.w[i + 4][1]);
+	}
+}
+
+void aesbs_convert_key(struct aesbs_key *key, const u32 *key_enc, int rounds)
+{
+	bs_t *rk = (bs_t *)key->rk;
+	u8 buf[16];
+	u64 w0, w1;
+	int r, i;
+
+	for (r = 0; r <= rounds; r++, rk += 8) {
+		for (i = 0; i < 4; i++)
+			put_unaligned_le32(key_enc[4 * r + i], buf + 4 * i);
+		interleave_in(&w0, &w1, buf);
+		for (i = 0; i < 4; i++) {
+			rk[i] = (bs_t){ w0, w0 };
+			rk[i + 4] = (bs_t){ w1, w1 };
+		}
+		ortho(rk);
+	}
+	key->rounds = rounds;
+}
+
+void aesbs_encrypt8(const struct aesbs_key *key, u8 *out, const u8 *in)
+{
+	const bs_t *rk = (const bs_t *)key->rk;
+	bs_t q[8];
+	int r;
+
+	load8(q, in);
+	add_round_key(q, rk);
+	for (r = 1; r < key->rounds; r++) {
+		sub_bytes(q);
+		shift_rows(q);
+		mix_columns(q);
+		add_round_key(q, rk + 8 * r);
+	}
+	sub_bytes(q);
+	shift_rows(q);
+	add_round_key(q, rk + 8 * key->rounds);
+	store8(out, q);
+}
+
+void aesbs_decrypt8(const struct aesbs_key *key, u8 *out, const u8 *in)
+{
+	const bs_t *rk = (const bs_t *)key->rk;
+	bs_t q[8];
+	int r;
+
+	load8(q, in);
+	add_round_key(q, rk + 8 * key->rounds);
+	for (r = key->rounds - 1; r > 0; r--) {
+		inv_shift_rows(q);
+		inv_sub_bytes(q);
+		add_round_key(q, rk + 8 * r);
+		inv_mix_columns(q);
+	}
+	inv_shift_rows(q);
+	inv_sub_bytes(q);
+	add_round_key(q, rk);
+	store8(out, q);
+}
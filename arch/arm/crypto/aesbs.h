@@ -0,0 +1,38 @@
+/*
+ *  linux/arch/arm/crypto/aesbs.h
+ *
+ *  Copyright (C) 2010 Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __ARM_CRYPTO_AESBS_H
+#define __ARM_CRYPTO_AESBS_H
+
+#include <linux/compiler.h>
+#include <linux/types.h>
+
+#define AESBS_BLOCKS		8
+#define AESBS_MAX_ROUNDS	14
+
+/*
+ * The round keys in the bit-sliced layout: eight 128-bit words per round,
+ * word i holding bit i of each key byte, repeated for the eight blocks.
+ * The same schedule serves encryption and decryption.
+ */
+struct aesbs_key {
+	u64	rk[AESBS_MAX_ROUNDS + 1][8][2] __aligned(16);
+	int	rounds;
+};
+
+/*
+ * These use the NEON unit, also for their 64-bit integer arithmetic, and
+ * must be called between kernel_neon_begin() and kernel_neon_end().
+ */
+void aesbs_convert_key(struct aesbs_key *key, const u32 *key_enc, int rounds);
+void aesbs_encrypt8(const struct aesbs_key *key, u8 *out, const u8 *in);
+void aesbs_decrypt8(const struct aesbs_key *key, u8 *out, const u8 *in);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef __ASM_ARM_IDLE_H
+#define __ASM_ARM_IDLE_H
+
+/*
+ * Idle notifiers, called on the idle thread when it starts idling and
+ * when it stops because there is work to run.  Same interface as x86-64.
+ */
+
+#define IDLE_START 1
+#define IDLE_END 2
+
+struct notifier_block;
+void idle_notifier_register(struct notifier_block *n);
+void idle_notifier_unregister(struct notifier_block *n);
+
+void enter_idle(void);
+void exit_idle(void);
+
+#endif /* __ASM_ARM_IDLE_H */
@@ -0,0 +1,78 @@
+/*
+ *  linux/arch/arm/include/asm/neon.h
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __ASM_NEON_H
+#define __ASM_NEON_H
+
+#include <linux/hardirq.h>
+#include <linux/irqflags.h>
+#include <linux/percpu.h>
+#include <linux/smp.h>
+#include <linux/types.h>
+#include <asm/hwcap.h>
+
+#define cpu_has_neon()		(!!(elf_hwcap & HWCAP_NEON))
+
+/*
+ * kernel_neon_begin() - obtain the NEON unit for use in the kernel
+ *
+ * The VFP/NEON state of the task that last used the unit is saved and
+ * preemption is disabled until kernel_neon_end(), so the registers need
+ * not be preserved.  Not allowed in interrupt context.
+ */
+extern void kernel_neon_begin(void);
+extern void kernel_neon_end(void);
+
+#ifdef CONFIG_KERNEL_MODE_NEON
+DECLARE_PER_CPU(int, kernel_neon_busy);
+
+/*
+ * Whether this cpu is between kernel_neon_begin() and kernel_neon_end().
+ * Preemption is disabled in there, so this is only ever set for the cpu
+ * we run on by ourselves.
+ */
+static inline int kernel_neon_held(void)
+{
+	return per_cpu(kernel_neon_busy, raw_smp_processor_id());
+}
+#else
+static inline int kernel_neon_held(void)
+{
+	return 0;
+}
+#endif
+
+/*
+ * The unit is only taken in process context with interrupts enabled,
+ * which keeps it out of the sleep and idle paths, that run before the
+ * VFP is set up again.  It does not nest: code that holds it, such as
+ * a cipher between blocks, has its memcpy() done without NEON.
+ */
+static inline int kernel_neon_usable(void)
+{
+	return cpu_has_neon() && !in_interrupt() && !irqs_disabled() &&
+	       !kernel_neon_held();
+}
+
+#ifdef CONFIG_NEON_COPY
+/* copies from this size on go through NEON, 0 disables them */
+extern unsigned int neon_copy_threshold;
+
+extern void neon_memcpy(void *dest, const void *src, size_t n);
+extern void __memcpy_neon(void *dest, const void *src, size_t n);
+extern void *__memcpy_std(void *dest, const void *src, size_t n);
+extern void __copy_page_std(void *to, const void *from);
+
+static inline int neon_copy_usable(size_t n)
+{
+	return neon_copy_threshold && n >= neon_copy_threshold &&
+	       kernel_neon_usable();
+}
+#endif /* CONFIG_NEON_COPY */
+
+#endif /* __ASM_NEON_H */
@@ -50,6 +50,15 @@ release_pmu(struct platform_device *pdev);
 extern int
 init_pmu(enum arm_pmu_type device);
 
+/**
+ * pmu_reserved() - Check whether the performance counters are in use
+ *
+ * Platforms whose idle states reset the counters use this to stay out of
+ * those states while someone holds the PMU.
+ */
+extern int
+pmu_reserved(enum arm_pmu_type device);
+
 #else /* CONFIG_CPU_HAS_PMU */
 
 #include <linux/err.h>
@@ -72,6 +81,12 @@ init_pmu(enum arm_pmu_type device)
 	return -ENODEV;
 }
 
+static inline int
+pmu_reserved(enum arm_pmu_type device)
+{
+	return 0;
+}
+
 #endif /* CONFIG_CPU_HAS_PMU */
 
 #endif /* __ARM_PMU_H__ */
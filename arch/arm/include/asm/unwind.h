@@ -49,6 +49,10 @@ extern struct unwind_table *unwind_table_add(unsigned long start,
 extern void unwind_table_del(struct unwind_table *tab);
 extern void unwind_backtrace(struct pt_regs *regs, struct task_struct *tsk);
 
+#ifdef CONFIG_ARM_UNWIND_USER
+extern int unwind_user_frame(unsigned long *vrs, int leaf);
+#endif
+
 #ifdef CONFIG_ARM_UNWIND
 extern int __init unwind_init(void);
 #else
@@ -20,6 +20,7 @@
 #include <asm/checksum.h>
 #include <asm/system.h>
 #include <asm/ftrace.h>
+#include <asm/neon.h>
 
 /*
  * libgcc functions - functions that are used internally by the
@@ -102,6 +103,13 @@ EXPORT_SYMBOL(__copy_from_user);
 EXPORT_SYMBOL(__copy_to_user);
 EXPORT_SYMBOL(__clear_user);
 
+#ifdef CONFIG_NEON_COPY
+EXPORT_SYMBOL(__memcpy_std);
+EXPORT_SYMBOL(__copy_page_std);
+EXPORT_SYMBOL(__copy_from_user_std);
+EXPORT_SYMBOL(__copy_to_user_std);
+#endif
+
 EXPORT_SYMBOL(__get_user_1);
 EXPORT_SYMBOL(__get_user_2);
 EXPORT_SYMBOL(__get_user_4);
@@ -27,6 +27,7 @@
 #include <asm/irq_regs.h>
 #include <asm/pmu.h>
 #include <asm/stacktrace.h>
+#include <asm/unwind.h>
 
 static struct platform_device *pmu_device;
 
@@ -3051,17 +3052,63 @@ user_backtrace(struct frame_tail *tail,
 	return buftail.fp - 1;
 }
 
+#ifdef CONFIG_ARM_UNWIND_USER
+/*
+ * Walk the user stack with the EHABI unwind tables, for code built
+ * without frame pointers. The walk stops at the first frame that has no
+ * table entry, e.g. JIT code. Returns the number of frames unwound.
+ */
+static int
+user_unwind(unsigned long *vrs,
+	    struct perf_callchain_entry *entry)
+{
+	int frames = 0;
+
+	pagefault_disable();
+	while (entry->nr < PERF_MAX_STACK_DEPTH &&
+	       unwind_user_frame(vrs, !frames) == URC_OK) {
+		callchain_store(entry, vrs[15]);
+		frames++;
+	}
+	pagefault_enable();
+
+	return frames;
+}
+#else
+static inline int
+user_unwind(unsigned long *vrs,
+	    struct perf_callchain_entry *entry)
+{
+	return 0;
+}
+#endif
+
 static void
 perf_callchain_user(struct pt_regs *regs,
 		    struct perf_callchain_entry *entry)
 {
 	struct frame_tail *tail;
+	unsigned long vrs[16];
+	int i;
 
 	callchain_store(entry, PERF_CONTEXT_USER);
 
 	if (!user_mode(regs))
 		regs = task_pt_regs(current);
 
+	callchain_store(entry, regs->ARM_pc);
+
+	for (i = 0; i < 16; i++)
+		vrs[i] = regs->uregs[i];
+
+	/*
+	 * Code with unwind tables is Thumb-2 or built without frame
+	 * pointers, where r11 is no frame pointer: once the tables have
+	 * been used, following it would only add junk frames.
+	 */
+	if (user_unwind(vrs, entry))
+		return;
+
 	tail = (struct frame_tail *)regs->ARM_fp - 1;
 
 	while (tail && !((unsigned long)tail & 0x3))
@@ -86,6 +86,13 @@ release_pmu(struct platform_device *pdev)
 }
 EXPORT_SYMBOL_GPL(release_pmu);
 
+int
+pmu_reserved(enum arm_pmu_type device)
+{
+	return test_bit(device, &pmu_lock);
+}
+EXPORT_SYMBOL_GPL(pmu_reserved);
+
 static int
 set_irq_affinity(int irq,
 		 unsigned int cpu)
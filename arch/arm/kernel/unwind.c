@@ -44,6 +44,10 @@
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/list.h>
+#include <linux/elf.h>
+#include <linux/mm.h>
+#include <linux/percpu.h>
+#include <linux/uaccess.h>
 
 #include <asm/stacktrace.h>
 #include <asm/traps.h>
@@ -70,6 +74,7 @@ struct unwind_ctrl_block {
 	unsigned long *insn;		/* pointer to the current instructions word */
 	int entries;			/* number of entries left to interpret */
 	int byte;			/* current byte number in the instructions word */
+	int user;			/* unwinding a user space stack */
 };
 
 enum regs {
@@ -89,6 +94,16 @@ extern struct unwind_idx __stop_unwind_idx[];
 static DEFINE_SPINLOCK(unwind_lock);
 static LIST_HEAD(unwind_tables);
 
+/*
+ * User space tables are not ours to vouch for, and perf walks them at
+ * every sample: keep quiet about what they contain.
+ */
+#define unwind_warn(ctrl, fmt, args...)			\
+do {							\
+	if (!(ctrl)->user)				\
+		pr_warning(fmt, ##args);		\
+} while (0)
+
 /* Convert a prel31 symbol to an absolute address */
 #define prel31_to_addr(ptr)				\
 ({							\
@@ -161,7 +176,7 @@ static unsigned long unwind_get_byte(struct unwind_ctrl_block *ctrl)
 	unsigned long ret;
 
 	if (ctrl->entries <= 0) {
-		pr_warning("unwind: Corrupt unwind table\n");
+		unwind_warn(ctrl, "unwind: Corrupt unwind table\n");
 		return 0;
 	}
 
@@ -177,6 +192,25 @@ static unsigned long unwind_get_byte(struct unwind_ctrl_block *ctrl)
 	return ret;
 }
 
+/*
+ * Pop one register off the virtual stack. A user space stack is read
+ * without sleeping, as the unwinder runs from the PMU interrupt.
+ */
+static int unwind_pop_register(struct unwind_ctrl_block *ctrl,
+			       unsigned long **vsp, unsigned int reg)
+{
+	if (ctrl->user) {
+		if (!access_ok(VERIFY_READ, *vsp, sizeof(**vsp)) ||
+		    __copy_from_user_inatomic(&ctrl->vrs[reg],
+					      (void __user *)*vsp,
+					      sizeof(**vsp)))
+			return -URC_FAILURE;
+	} else
+		ctrl->vrs[reg] = **vsp;
+	(*vsp)++;
+	return URC_OK;
+}
+
 /*
  * Execute the current unwind instruction.
  */
@@ -198,16 +232,16 @@ static int unwind_exec_insn(struct unwind_ctrl_block *ctrl)
 		insn = (insn << 8) | unwind_get_byte(ctrl);
 		mask = insn & 0x0fff;
 		if (mask == 0) {
-			pr_warning("unwind: 'Refuse to unwind' instruction %04lx\n",
-				   insn);
+			unwind_warn(ctrl, "unwind: 'Refuse to unwind' instruction %04lx\n",
+				    insn);
 			return -URC_FAILURE;
 		}
 
 		/* pop R4-R15 according to mask */
 		load_sp = mask & (1 << (13 - 4));
 		while (mask) {
-			if (mask & 1)
-				ctrl->vrs[reg] = *vsp++;
+			if ((mask & 1) && unwind_pop_register(ctrl, &vsp, reg))
+				return -URC_FAILURE;
 			mask >>= 1;
 			reg++;
 		}
@@ -222,9 +256,10 @@ static int unwind_exec_insn(struct unwind_ctrl_block *ctrl)
 
 		/* pop R4-R[4+bbb] */
 		for (reg = 4; reg <= 4 + (insn & 7); reg++)
-			ctrl->vrs[reg] = *vsp++;
-		if (insn & 0x80)
-			ctrl->vrs[14] = *vsp++;
+			if (unwind_pop_register(ctrl, &vsp, reg))
+				return -URC_FAILURE;
+		if ((insn & 0x08) && unwind_pop_register(ctrl, &vsp, LR))
+			return -URC_FAILURE;
 		ctrl->vrs[SP] = (unsigned long)vsp;
 	} else if (insn == 0xb0) {
 		if (ctrl->vrs[PC] == 0)
@@ -237,15 +272,15 @@ static int unwind_exec_insn(struct unwind_ctrl_block *ctrl)
 		int reg = 0;
 
 		if (mask == 0 || mask & 0xf0) {
-			pr_warning("unwind: Spare encoding %04lx\n",
-			       (insn << 8) | mask);
+			unwind_warn(ctrl, "unwind: Spare encoding %04lx\n",
+				    (insn << 8) | mask);
 			return -URC_FAILURE;
 		}
 
 		/* pop R0-R3 according to mask */
 		while (mask) {
-			if (mask & 1)
-				ctrl->vrs[reg] = *vsp++;
+			if ((mask & 1) && unwind_pop_register(ctrl, &vsp, reg))
+				return -URC_FAILURE;
 			mask >>= 1;
 			reg++;
 		}
@@ -254,8 +289,18 @@ static int unwind_exec_insn(struct unwind_ctrl_block *ctrl)
 		unsigned long uleb128 = unwind_get_byte(ctrl);
 
 		ctrl->vrs[SP] += 0x204 + (uleb128 << 2);
+	} else if (insn == 0xb3 || insn == 0xc8 || insn == 0xc9) {
+		/* pop VFP D[ssss]-D[ssss+cccc], only the count matters */
+		unsigned long count = (unwind_get_byte(ctrl) & 0x0f) + 1;
+
+		ctrl->vrs[SP] += count * 8 + (insn == 0xb3 ? 4 : 0);
+	} else if ((insn & 0xf8) == 0xb8 || (insn & 0xf8) == 0xd0) {
+		/* pop VFP D8-D[8+nnn], FSTMFDX (0xb8) or VPUSH (0xd0) */
+		unsigned long count = (insn & 0x07) + 1;
+
+		ctrl->vrs[SP] += count * 8 + ((insn & 0xf8) == 0xb8 ? 4 : 0);
 	} else {
-		pr_warning("unwind: Unhandled instruction %02lx\n", insn);
+		unwind_warn(ctrl, "unwind: Unhandled instruction %02lx\n", insn);
 		return -URC_FAILURE;
 	}
 
@@ -295,6 +340,7 @@ int unwind_frame(struct stackframe *frame)
 	ctrl.vrs[SP] = frame->sp;
 	ctrl.vrs[LR] = frame->lr;
 	ctrl.vrs[PC] = 0;
+	ctrl.user = 0;
 
 	if (idx->insn == 1)
 		/* can't unwind */
@@ -347,6 +393,273 @@ int unwind_frame(struct stackframe *frame)
 	return URC_OK;
 }
 
+#ifdef CONFIG_ARM_UNWIND_USER
+/*
+ * User space unwinding, for perf callchains of code built without frame
+ * pointers. The index of a shared object or executable is found through
+ * its PT_ARM_EXIDX program header, read from the ELF header at the start
+ * of the mapping that holds the address; the index and the unwind
+ * instructions are then read from user memory as they are needed.
+ */
+#ifndef PT_ARM_EXIDX
+#define PT_ARM_EXIDX		(PT_LOPROC + 1)
+#endif
+
+#define UNWIND_USER_CACHE	8	/* mappings remembered per cpu */
+#define UNWIND_USER_PHNUM	32	/* program headers looked at */
+#define UNWIND_USER_INSNS	8	/* unwind instruction words per frame */
+
+struct unwind_user_table {
+	struct mm_struct *mm;
+	struct file *file;
+	unsigned long begin_addr;	/* the mapping the index covers */
+	unsigned long end_addr;
+	unsigned long start;		/* user address of the index, 0 if none */
+	unsigned long stop;
+};
+
+struct unwind_user_cache {
+	struct unwind_user_table tables[UNWIND_USER_CACHE];
+	int next;
+};
+
+/*
+ * Entries are never invalidated: once the mapping they describe is gone,
+ * a match can only give a wrong callchain, as user memory is always read
+ * with the checking accessors.
+ */
+static DEFINE_PER_CPU(struct unwind_user_cache, unwind_user_cache);
+
+static int unwind_user_read(void *dst, unsigned long addr, unsigned long size)
+{
+	if (!access_ok(VERIFY_READ, addr, size))
+		return -EFAULT;
+	if (__copy_from_user_inatomic(dst, (void __user *)addr, size))
+		return -EFAULT;
+	return 0;
+}
+
+/* Convert a prel31 word read from user address addr */
+static unsigned long unwind_user_prel31(unsigned long word, unsigned long addr)
+{
+	return addr + ((long)(word << 1) >> 1);
+}
+
+/* Find the index of the object mapped at the start of vma, if any */
+static void unwind_user_load(struct unwind_user_table *tab,
+			     struct vm_area_struct *vma)
+{
+	unsigned long base = vma->vm_start, bias = 0, phdr;
+	struct elf32_hdr ehdr;
+	struct elf32_phdr ph;
+	int i, have_bias = 0;
+
+	tab->start = tab->stop = 0;
+
+	if (unwind_user_read(&ehdr, base, sizeof(ehdr)) ||
+	    memcmp(ehdr.e_ident, ELFMAG, SELFMAG) ||
+	    ehdr.e_ident[EI_CLASS] != ELFCLASS32 ||
+	    ehdr.e_phentsize != sizeof(ph) ||
+	    ehdr.e_phnum > UNWIND_USER_PHNUM)
+		return;
+
+	phdr = base + ehdr.e_phoff;
+	for (i = 0; i < ehdr.e_phnum; i++, phdr += sizeof(ph)) {
+		if (unwind_user_read(&ph, phdr, sizeof(ph)))
+			return;
+		if (ph.p_type == PT_LOAD && !have_bias) {
+			/* the first segment is the one mapped at base */
+			bias = base - (ph.p_vaddr & PAGE_MASK);
+			have_bias = 1;
+		} else if (ph.p_type == PT_ARM_EXIDX && have_bias) {
+			tab->start = ph.p_vaddr + bias;
+			tab->stop = tab->start +
+				    (ph.p_memsz & ~(sizeof(struct unwind_idx) - 1));
+			return;
+		}
+	}
+}
+
+/*
+ * Look up the index for a user address. Called from interrupt context, so
+ * a sample that lands while mmap_sem is held for writing is not unwound.
+ */
+static int unwind_user_find_table(unsigned long addr,
+				  struct unwind_user_table *ret)
+{
+	struct unwind_user_cache *cache = &__get_cpu_var(unwind_user_cache);
+	struct mm_struct *mm = current->mm;
+	struct unwind_user_table *tab;
+	struct vm_area_struct *vma;
+	int i, found = 0;
+
+	if (!mm || !down_read_trylock(&mm->mmap_sem))
+		return -URC_FAILURE;
+
+	vma = find_vma(mm, addr);
+	if (!vma || addr < vma->vm_start || !vma->vm_file ||
+	    vma->vm_pgoff || !(vma->vm_flags & VM_EXEC))
+		goto out;
+
+	for (i = 0; i < UNWIND_USER_CACHE; i++) {
+		tab = &cache->tables[i];
+		if (tab->mm == mm && tab->file == vma->vm_file &&
+		    tab->begin_addr == vma->vm_start &&
+		    tab->end_addr == vma->vm_end)
+			break;
+	}
+
+	if (i == UNWIND_USER_CACHE) {
+		/* remember objects without an index too */
+		tab = &cache->tables[cache->next];
+		cache->next = (cache->next + 1) % UNWIND_USER_CACHE;
+
+		tab->mm = mm;
+		tab->file = vma->vm_file;
+		tab->begin_addr = vma->vm_start;
+		tab->end_addr = vma->vm_end;
+		unwind_user_load(tab, vma);
+	}
+
+	if (tab->start < tab->stop) {
+		*ret = *tab;
+		found = 1;
+	}
+out:
+	up_read(&mm->mmap_sem);
+	return found ? URC_OK : -URC_FAILURE;
+}
+
+/* Binary search in a user index, whose addresses are still prel31 */
+static int unwind_user_search(struct unwind_user_table *tab,
+			      unsigned long addr, unsigned long *entry,
+			      unsigned long *insn)
+{
+	unsigned long first = 0, last, mid, word;
+	struct unwind_idx idx;
+
+	last = (tab->stop - tab->start) / sizeof(idx);
+
+	if (unwind_user_read(&word, tab->start, sizeof(word)) ||
+	    addr < unwind_user_prel31(word, tab->start))
+		return -URC_FAILURE;
+
+	/* the entry in [first, last) with the highest address <= addr */
+	while (last - first > 1) {
+		mid = first + (last - first) / 2;
+		*entry = tab->start + mid * sizeof(idx);
+		if (unwind_user_read(&word, *entry, sizeof(word)))
+			return -URC_FAILURE;
+		if (addr < unwind_user_prel31(word, *entry))
+			last = mid;
+		else
+			first = mid;
+	}
+
+	*entry = tab->start + first * sizeof(idx);
+	if (unwind_user_read(&idx, *entry, sizeof(idx)))
+		return -URC_FAILURE;
+	*insn = idx.insn;
+	return URC_OK;
+}
+
+/**
+ * unwind_user_frame() - unwind one frame of the current task's user stack
+ * @vrs: r0-r15 of the frame, updated to those of its caller
+ * @leaf: vrs[PC] is where the task was interrupted, not a return address
+ *
+ * Must be called with page faults disabled. Returns URC_OK or
+ * -URC_FAILURE, when the caller may still try the frame pointer.
+ */
+int unwind_user_frame(unsigned long *vrs, int leaf)
+{
+	unsigned long insns[UNWIND_USER_INSNS];
+	struct unwind_user_table tab;
+	struct unwind_ctrl_block ctrl;
+	unsigned long addr, entry, insn;
+	int i;
+
+	/* a return address may be just past the end of a noreturn call */
+	addr = vrs[PC] & ~1UL;
+	if (!leaf)
+		addr--;
+
+	if (unwind_user_find_table(addr, &tab) ||
+	    unwind_user_search(&tab, addr, &entry, &insn))
+		return -URC_FAILURE;
+
+	if (insn == 1)
+		/* EXIDX_CANTUNWIND */
+		return -URC_FAILURE;
+
+	if (insn & 0x80000000) {
+		/* inline in the index */
+		insns[0] = insn;
+		addr = 0;
+	} else {
+		/* prel31 to the unwind table entry */
+		addr = unwind_user_prel31(insn, entry + 4);
+		if (unwind_user_read(&insns[0], addr, sizeof(insns[0])))
+			return -URC_FAILURE;
+	}
+
+	if ((insns[0] & 0xff000000) == 0x80000000) {
+		/* personality routine 0 */
+		ctrl.byte = 2;
+		ctrl.entries = 1;
+	} else if (addr && ((insns[0] & 0xff000000) == 0x81000000 ||
+			    (insns[0] & 0xff000000) == 0x82000000)) {
+		/* personality routines 1 and 2 */
+		ctrl.byte = 1;
+		ctrl.entries = 1 + ((insns[0] & 0x00ff0000) >> 16);
+	} else if (addr && !(insns[0] & 0x80000000)) {
+		/*
+		 * Generic model, as gcc's C++ personality: a prel31 to the
+		 * routine, then the instructions laid out as for pr1.
+		 */
+		addr += 4;
+		if (unwind_user_read(&insns[0], addr, sizeof(insns[0])))
+			return -URC_FAILURE;
+		ctrl.byte = 2;
+		ctrl.entries = 1 + (insns[0] >> 24);
+	} else
+		return -URC_FAILURE;
+
+	if (ctrl.entries > UNWIND_USER_INSNS ||
+	    (ctrl.entries > 1 &&
+	     unwind_user_read(&insns[1], addr + 4,
+			      (ctrl.entries - 1) * sizeof(insns[0]))))
+		return -URC_FAILURE;
+
+	ctrl.insn = insns;
+	ctrl.user = 1;
+
+	for (i = 0; i < 16; i++)
+		ctrl.vrs[i] = vrs[i];
+	ctrl.vrs[PC] = 0;
+
+	while (ctrl.entries > 0) {
+		if (unwind_exec_insn(&ctrl) < 0)
+			return -URC_FAILURE;
+		/* only go to a higher address on the stack */
+		if (ctrl.vrs[SP] < vrs[SP] || ctrl.vrs[SP] >= TASK_SIZE)
+			return -URC_FAILURE;
+	}
+
+	if (ctrl.vrs[PC] == 0)
+		ctrl.vrs[PC] = ctrl.vrs[LR];
+
+	/* check for infinite loop */
+	if (ctrl.vrs[PC] == vrs[PC] && ctrl.vrs[SP] == vrs[SP])
+		return -URC_FAILURE;
+
+	for (i = 0; i < 16; i++)
+		vrs[i] = ctrl.vrs[i];
+
+	return URC_OK;
+}
+#endif /* CONFIG_ARM_UNWIND_USER */
+
 void unwind_backtrace(struct pt_regs *regs, struct task_struct *tsk)
 {
 	struct stackframe frame;
@@ -0,0 +1,80 @@
+/*
+ *  linux/arch/arm/lib/neon_copy.c
+ *
+ *  Copyright (C) 2010 Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * memcpy() and copy_page() through NEON for large copies.  The Cortex-A8
+ * moves a cache line with two 32 byte NEON loads and stores where the
+ * LDM/STM routines need eight 8-word transfers, but taking the unit means
+ * saving the VFP state of its last user, so small copies and those made
+ * from interrupt context keep using the ARM routines.  copy_to_user() and
+ * copy_from_user() come here through uaccess_with_memcpy.c.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/string.h>
+
+#include <asm/neon.h>
+#include <asm/page.h>
+
+unsigned int neon_copy_threshold = 512;
+module_param_named(threshold, neon_copy_threshold, uint, 0644);
+MODULE_PARM_DESC(threshold, "Smallest copy done with NEON, 0 to disable");
+EXPORT_SYMBOL(neon_copy_threshold);
+
+/*
+ * Copy with the NEON unit, whatever the size: the head up to a 16 byte
+ * aligned destination and the tail of less than a cache line are done by
+ * the ARM routine.
+ */
+void neon_memcpy(void *dest, const void *src, size_t n)
+{
+	size_t head = -(unsigned long)dest & 15, bulk;
+
+	if (head > n)
+		head = n;
+	bulk = (n - head) & ~63;
+
+	if (head) {
+		__memcpy_std(dest, src, head);
+		dest += head;
+		src += head;
+	}
+	if (bulk) {
+		kernel_neon_begin();
+		__memcpy_neon(dest, src, bulk);
+		kernel_neon_end();
+		dest += bulk;
+		src += bulk;
+	}
+	if (n - head - bulk)
+		__memcpy_std(dest, src, n - head - bulk);
+}
+EXPORT_SYMBOL(neon_memcpy);
+
+void *memcpy(void *dest, const void *src, size_t n)
+{
+	if (!neon_copy_usable(n))
+		return __memcpy_std(dest, src, n);
+
+	neon_memcpy(dest, src, n);
+	return dest;
+}
+
+void copy_page(void *to, const void *from)
+{
+	if (!neon_copy_usable(PAGE_SIZE)) {
+		__copy_page_std(to, from);
+		return;
+	}
+
+	kernel_neon_begin();
+	__memcpy_neon(to, from, PAGE_SIZE);
+	kernel_neon_end();
+}
@@ -0,0 +1,223 @@
+/*
+ *  linux/arch/arm/lib/neon_copy_bench.c
+ *
+ *  Copyright (C) 2010 Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Cycles per byte of memcpy(), copy_to_user(), copy_from_user() and
+ * copy_page() done by the ARM routines and with NEON, from the Cortex-A8
+ * cycle counter.  Loading the module prints the table, after which it
+ * refuses to stay loaded:
+ *
+ *	insmod neon_copy_bench.ko
+ *
+ * The buffers are hot in the cache and each figure is the best of NR_RUNS
+ * copies.  While the NEON figures are taken, the threshold is lowered to
+ * one byte, so every copy in the system goes through NEON for that time.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/err.h>
+#include <linux/gfp.h>
+#include <linux/mm.h>
+#include <linux/mman.h>
+#include <linux/sched.h>
+#include <linux/uaccess.h>
+
+#include <asm/neon.h>
+#include <asm/pmu.h>
+
+#define BENCH_ORDER	4
+#define BENCH_MAX	(PAGE_SIZE << BENCH_ORDER)
+#define NR_RUNS		8
+
+enum {
+	BENCH_MEMCPY,
+	BENCH_TO_USER,
+	BENCH_FROM_USER,
+	BENCH_COPY_PAGE,
+	NR_BENCH
+};
+
+static const char *bench_names[NR_BENCH] = {
+	"memcpy", "to_user", "from_user", "copy_page",
+};
+
+static void *kdst, *ksrc;
+static void __user *ubuf;
+static unsigned long bench_left;
+
+static inline u32 ccnt_read(void)
+{
+	u32 val;
+
+	asm volatile("mrc p15, 0, %0, c9, c13, 0" : "=r" (val));
+	return val;
+}
+
+static void ccnt_start(void)
+{
+	/* PMCR: reset and enable the counters, no divider; then CCNT on */
+	asm volatile("mcr p15, 0, %0, c9, c12, 0" : : "r" ((1 << 2) | (1 << 0)));
+	asm volatile("mcr p15, 0, %0, c9, c12, 1" : : "r" (1 << 31));
+}
+
+static void ccnt_stop(void)
+{
+	asm volatile("mcr p15, 0, %0, c9, c12, 2" : : "r" (1 << 31));
+	asm volatile("mcr p15, 0, %0, c9, c12, 0" : : "r" (0));
+}
+
+static void bench_copy(int op, int neon, unsigned long n)
+{
+	switch (op) {
+	case BENCH_MEMCPY:
+		if (neon)
+			neon_memcpy(kdst, ksrc, n);
+		else
+			__memcpy_std(kdst, ksrc, n);
+		break;
+	case BENCH_TO_USER:
+		if (neon)
+			bench_left |= __copy_to_user(ubuf, ksrc, n);
+		else
+			bench_left |= __copy_to_user_std(ubuf, ksrc, n);
+		break;
+	case BENCH_FROM_USER:
+		if (neon)
+			bench_left |= __copy_from_user(kdst, ubuf, n);
+		else
+			bench_left |= __copy_from_user_std(kdst, ubuf, n);
+		break;
+	case BENCH_COPY_PAGE:
+		if (neon)
+			copy_page(kdst, ksrc);
+		else
+			__copy_page_std(kdst, ksrc);
+		break;
+	}
+}
+
+/* best of NR_RUNS, in hundredths of a cycle per byte */
+static unsigned long bench_run(int op, int neon, unsigned long n)
+{
+	unsigned int threshold = neon_copy_threshold;
+	u32 start, t, best = ~0;
+	int i;
+
+	if (neon)
+		neon_copy_threshold = 1;
+
+	bench_copy(op, neon, n);
+	for (i = 0; i < NR_RUNS; i++) {
+		start = ccnt_read();
+		bench_copy(op, neon, n);
+		t = ccnt_read() - start;
+		if (t < best)
+			best = t;
+	}
+
+	neon_copy_threshold = threshold;
+	return (unsigned long)best * 100 / n;
+}
+
+static void bench_size(unsigned long n)
+{
+	char line[128];
+	int len, op;
+
+	len = snprintf(line, sizeof(line), "%6lu", n);
+	for (op = 0; op < NR_BENCH; op++) {
+		unsigned long arm, neon;
+
+		if (op == BENCH_COPY_PAGE && n != PAGE_SIZE)
+			continue;
+		arm = bench_run(op, 0, n);
+		neon = bench_run(op, 1, n);
+		len += snprintf(line + len, sizeof(line) - len,
+				"  %3lu.%02lu/%3lu.%02lu", arm / 100, arm % 100,
+				neon / 100, neon % 100);
+	}
+	printk(KERN_INFO "%s\n", line);
+}
+
+static int __init neon_copy_bench_init(void)
+{
+	struct platform_device *pmu;
+	unsigned long uaddr, n;
+	char header[128];
+	int len, op, ret = -ENOMEM;
+
+	if (!cpu_has_neon())
+		return -ENODEV;
+
+	pmu = reserve_pmu(ARM_PMU_DEVICE_CPU);
+	if (IS_ERR(pmu)) {
+		printk(KERN_ERR "neon_copy_bench: PMU in use\n");
+		return PTR_ERR(pmu);
+	}
+
+	kdst = (void *)__get_free_pages(GFP_KERNEL, BENCH_ORDER);
+	ksrc = (void *)__get_free_pages(GFP_KERNEL, BENCH_ORDER);
+	if (!kdst || !ksrc)
+		goto out_free;
+	memset(ksrc, 0x5a, BENCH_MAX);
+
+	down_write(&current->mm->mmap_sem);
+	uaddr = do_mmap(NULL, 0, BENCH_MAX, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, 0);
+	up_write(&current->mm->mmap_sem);
+	if (IS_ERR_VALUE(uaddr)) {
+		ret = uaddr;
+		goto out_free;
+	}
+	ubuf = (void __user *)uaddr;
+
+	/* fault the user buffer in, so that it is present and dirty */
+	ret = -EFAULT;
+	if (clear_user(ubuf, BENCH_MAX))
+		goto out_unmap;
+
+	len = snprintf(header, sizeof(header), "%6s", "bytes");
+	for (op = 0; op < NR_BENCH; op++)
+		len += snprintf(header + len, sizeof(header) - len,
+				"  %15s", bench_names[op]);
+	printk(KERN_INFO "neon_copy_bench: cycles/byte, arm/neon\n");
+	printk(KERN_INFO "%s\n", header);
+
+	bench_left = 0;
+	ccnt_start();
+	for (n = 64; n <= BENCH_MAX; n *= 2)
+		bench_size(n);
+	ccnt_stop();
+
+	if (bench_left)
+		printk(KERN_WARNING "neon_copy_bench: user copies faulted\n");
+
+	/* not meant to stay loaded */
+	ret = -EAGAIN;
+
+out_unmap:
+	down_write(&current->mm->mmap_sem);
+	do_munmap(current->mm, uaddr, BENCH_MAX);
+	up_write(&current->mm->mmap_sem);
+out_free:
+	free_pages((unsigned long)ksrc, BENCH_ORDER);
+	free_pages((unsigned long)kdst, BENCH_ORDER);
+	release_pmu(pmu);
+	return ret;
+}
+
+static void __exit neon_copy_bench_exit(void)
+{
+}
+
+module_init(neon_copy_bench_init);
+module_exit(neon_copy_bench_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("NEON copy benchmark");
@@ -18,10 +18,25 @@
 #include <linux/hardirq.h> /* for in_atomic() */
 #include <linux/gfp.h>
 #include <asm/current.h>
+#include <asm/neon.h>
 #include <asm/page.h>
 
+/*
+ * Whether an access of @n bytes is worth pinning the pages for.  With
+ * NEON_COPY, which selects this file, that is only so for what is big
+ * enough to go through NEON; the threshold for the ARM copies is lower.
+ */
+static inline int uaccess_pin_pays(unsigned long n)
+{
+#ifdef CONFIG_NEON_COPY
+	return neon_copy_usable(n);
+#else
+	return n >= 64;
+#endif
+}
+
 static int
-pin_page_for_write(const void __user *_addr, pte_t **ptep, spinlock_t **ptlp)
+pin_page(const void __user *_addr, int write, pte_t **ptep, spinlock_t **ptlp)
 {
 	unsigned long addr = (unsigned long)_addr;
 	pgd_t *pgd;
@@ -39,7 +54,8 @@ pin_page_for_write(const void __user *_addr, pte_t **ptep, spinlock_t **ptlp)
 
 	pte = pte_offset_map_lock(current->mm, pmd, addr, &ptl);
 	if (unlikely(!pte_present(*pte) || !pte_young(*pte) ||
-	    !pte_write(*pte) || !pte_dirty(*pte))) {
+	    (write ? !pte_write(*pte) || !pte_dirty(*pte) :
+		     !(pte_val(*pte) & L_PTE_USER)))) {
 		pte_unmap_unlock(pte, ptl);
 		return 0;
 	}
@@ -70,7 +86,7 @@ __copy_to_user_memcpy(void __user *to, const void *from, unsigned long n)
 		spinlock_t *ptl;
 		int tocopy;
 
-		while (!pin_page_for_write(to, &pte, &ptl)) {
+		while (!pin_page(to, 1, &pte, &ptl)) {
 			if (!atomic)
 				up_read(&current->mm->mmap_sem);
 			if (__put_user(0, (char __user *)to))
@@ -107,11 +123,76 @@ __copy_to_user(void __user *to, const void *from, unsigned long n)
 	 * With frame pointer disabled, tail call optimization kicks in
 	 * as well making this test almost invisible.
 	 */
-	if (n < 64)
+	if (!uaccess_pin_pays(n))
 		return __copy_to_user_std(to, from, n);
 	return __copy_to_user_memcpy(to, from, n);
 }
 	
+#ifdef CONFIG_NEON_COPY
+/*
+ * The NEON copy has no exception fixups, so user memory is read one
+ * pinned page at a time, as it is written above.  Without NEON this would
+ * gain nothing over __copy_from_user_std().
+ */
+static unsigned long noinline
+__copy_from_user_memcpy(void *to, const void __user *from, unsigned long n)
+{
+	int atomic;
+
+	if (unlikely(segment_eq(get_fs(), KERNEL_DS))) {
+		memcpy(to, (const void *)from, n);
+		return 0;
+	}
+
+	/* the mmap semaphore is taken only if not in an atomic context */
+	atomic = in_atomic();
+
+	if (!atomic)
+		down_read(&current->mm->mmap_sem);
+	while (n) {
+		pte_t *pte;
+		spinlock_t *ptl;
+		int tocopy;
+		char c;
+
+		while (!pin_page(from, 0, &pte, &ptl)) {
+			if (!atomic)
+				up_read(&current->mm->mmap_sem);
+			if (__get_user(c, (char __user *)from)) {
+				memset(to, 0, n);
+				goto out;
+			}
+			if (!atomic)
+				down_read(&current->mm->mmap_sem);
+		}
+
+		tocopy = (~(unsigned long)from & ~PAGE_MASK) + 1;
+		if (tocopy > n)
+			tocopy = n;
+
+		memcpy(to, (const void *)from, tocopy);
+		to += tocopy;
+		from += tocopy;
+		n -= tocopy;
+
+		pte_unmap_unlock(pte, ptl);
+	}
+	if (!atomic)
+		up_read(&current->mm->mmap_sem);
+
+out:
+	return n;
+}
+
+unsigned long
+__copy_from_user(void *to, const void __user *from, unsigned long n)
+{
+	if (!uaccess_pin_pays(n))
+		return __copy_from_user_std(to, from, n);
+	return __copy_from_user_memcpy(to, from, n);
+}
+#endif /* CONFIG_NEON_COPY */
+
 static unsigned long noinline
 __clear_user_memset(void __user *addr, unsigned long n)
 {
@@ -126,7 +207,7 @@ __clear_user_memset(void __user *addr, unsigned long n)
 		spinlock_t *ptl;
 		int tocopy;
 
-		while (!pin_page_for_write(addr, &pte, &ptl)) {
+		while (!pin_page(addr, 1, &pte, &ptl)) {
 			up_read(&current->mm->mmap_sem);
 			if (__put_user(0, (char __user *)addr))
 				goto out;
@@ -152,7 +233,7 @@ out:
 unsigned long __clear_user(void __user *addr, unsigned long n)
 {
 	/* See rational for this in __copy_to_user() above. */
-	if (n < 64)
+	if (!uaccess_pin_pays(n))
 		return __clear_user_std(addr, n);
 	return __clear_user_memset(addr, n);
 }
@@ -34,6 +34,7 @@
 #include <plat/s5pv210.h>
 #include <plat/devs.h>
 #include <mach/regs-audss.h>
+#include <mach/cpuidle.h>
 
 static int s5pv210_usbosc_enable(struct clk *clk, int enable);
 
@@ -161,12 +162,18 @@ static struct clksrc_clk clk_pclk_psys = {
 
 static int s5pv210_clk_ip0_ctrl(struct clk *clk, int enable)
 {
-	return s5p_gatectrl(S5P_CLKGATE_IP0, clk, enable);
+	int ret = s5p_gatectrl(S5P_CLKGATE_IP0, clk, enable);
+
+	s5pv210_idle_clkgate_changed();
+	return ret;
 }
 
 static int s5pv210_clk_ip1_ctrl(struct clk *clk, int enable)
 {
-	return s5p_gatectrl(S5P_CLKGATE_IP1, clk, enable);
+	int ret = s5p_gatectrl(S5P_CLKGATE_IP1, clk, enable);
+
+	s5pv210_idle_clkgate_changed();
+	return ret;
 }
 
 static int s5pv210_clk_ip2_ctrl(struct clk *clk, int enable)
@@ -176,7 +183,10 @@ static int s5pv210_clk_ip2_ctrl(struct clk *clk, int enable)
 
 static int s5pv210_clk_ip3_ctrl(struct clk *clk, int enable)
 {
-	return s5p_gatectrl(S5P_CLKGATE_IP3, clk, enable);
+	int ret = s5p_gatectrl(S5P_CLKGATE_IP3, clk, enable);
+
+	s5pv210_idle_clkgate_changed();
+	return ret;
 }
 
 static int s5pv210_clk_ip4_ctrl(struct clk *clk, int enable)
@@ -21,6 +21,8 @@
 #include <linux/suspend.h>
 #include <linux/regulator/consumer.h>
 #include <linux/gpio.h>
+#include <linux/ktime.h>
+#include <linux/moduleparam.h>
 #include <asm/system.h>
 
 #include <mach/map.h>
@@ -42,6 +44,19 @@ static struct regulator *internal_regulator;
 struct s3c_cpufreq_freqs s3c_freqs;
 
 static unsigned long previous_arm_volt;
+static unsigned long previous_int_volt;
+
+/*
+ * Direct path: leave out the steps of a transition that would only set
+ * what is set already - the regulator of a rail whose voltage does not
+ * change, the ONEDRAM divider and DMC refresh counters when the memory
+ * clocks do not change.
+ */
+static int direct_path = 1;
+module_param(direct_path, bool, 0644);
+
+/* timing of the transition in progress, protected by set_freq_lock */
+static struct cpufreq_transition_cost trans_cost;
 
 static unsigned int backup_dmc0_reg;
 static unsigned int backup_dmc1_reg;
@@ -193,6 +208,11 @@ static unsigned int s5pv210_cpufreq_getspeed(unsigned int cpu)
 	return rate;
 }
 
+static inline void cost_phase_end(enum cpufreq_cost_phase phase, ktime_t start)
+{
+	trans_cost.phase_ns[phase] += ktime_to_ns(ktime_sub(ktime_get(), start));
+}
+
 static void wait4div_gxd(void)
 {
 	unsigned int reg;
@@ -265,6 +285,7 @@ static void s5pv210_cpufreq_clksrcs_MPLL2APLL(unsigned int index,
 		unsigned int bus_speed_changing)
 {
 	unsigned int reg;
+	ktime_t t;
 
 	/*
 	 * 1. Set Lock time = 30us*24MHz = 02cf
@@ -282,9 +303,11 @@ static void s5pv210_cpufreq_clksrcs_MPLL2APLL(unsigned int index,
 		/* APLL FOUT becomes 800 Mhz */
 		__raw_writel(PLL45XX_APLL_VAL_800, S5P_APLL_CON);
 	/* 2-2. Wait until the PLL is locked */
+	t = ktime_get();
 	do {
 		reg = __raw_readl(S5P_APLL_CON);
 	} while (!(reg & (0x1 << 29)));
+	cost_phase_end(CPUFREQ_COST_PLL_LOCK, t);
 
 	/*
 	 * 3. Change source clock from SCLKMPLL(667MHz)
@@ -399,9 +422,11 @@ static int s5pv210_cpufreq_target(struct cpufreq_policy *policy,
 	static bool first_run = true;
 	int ret = 0;
 	unsigned long arm_clk;
-	unsigned int index, reg, arm_volt, int_volt;
+	unsigned int index, reg, arm_volt, int_volt, dmc0_div;
 	unsigned int pll_changing = 0;
 	unsigned int bus_speed_changing = 0;
+	int direct;
+	ktime_t start, t;
 
 	mutex_lock(&set_freq_lock);
 
@@ -458,6 +483,10 @@ static int s5pv210_cpufreq_target(struct cpufreq_policy *policy,
 	if (s3c_freqs.freqs.new == s3c_freqs.freqs.old && !first_run)
 		goto out;
 
+	start = ktime_get();
+	memset(&trans_cost, 0, sizeof(trans_cost));
+	direct = direct_path && !first_run;
+
 	arm_volt = dvs_conf[index].arm_volt;
 	int_volt = dvs_conf[index].int_volt;
 
@@ -469,14 +498,20 @@ static int s5pv210_cpufreq_target(struct cpufreq_policy *policy,
 		/* Voltage up code: increase ARM first */
 		if (!IS_ERR_OR_NULL(arm_regulator) &&
 				!IS_ERR_OR_NULL(internal_regulator)) {
-			ret = regulator_set_voltage(arm_regulator,
-						    arm_volt, arm_volt_max);
-			if (ret)
-				goto out;
-			ret = regulator_set_voltage(internal_regulator,
-						    int_volt, int_volt_max);
-			if (ret)
-				goto out;
+			t = ktime_get();
+			if (!direct || arm_volt != previous_arm_volt) {
+				ret = regulator_set_voltage(arm_regulator,
+						arm_volt, arm_volt_max);
+				if (ret)
+					goto out;
+			}
+			if (!direct || int_volt != previous_int_volt) {
+				ret = regulator_set_voltage(internal_regulator,
+						int_volt, int_volt_max);
+				if (ret)
+					goto out;
+			}
+			cost_phase_end(CPUFREQ_COST_VOLTAGE, t);
 		}
 	}
 	cpufreq_notify_transition(&s3c_freqs.freqs, CPUFREQ_PRECHANGE);
@@ -494,8 +529,10 @@ static int s5pv210_cpufreq_target(struct cpufreq_policy *policy,
 	 * changes. This is a temporary setting for the transition.
 	 * Stable setting is done at the end of this function.
 	 */
+	t = ktime_get();
 	reg = (__raw_readl(S5P_CLK_DIV6) & S5P_CLKDIV6_ONEDRAM_MASK)
 		>> S5P_CLKDIV6_ONEDRAM_SHIFT;
+	dmc0_div = reg;
 	if (clkdiv_val[index][8] > reg) {
 		reg = backup_dmc0_reg * (reg + 1) / (clkdiv_val[index][8] + 1);
 		WARN_ON(reg > 0xFFFF);
@@ -545,6 +582,7 @@ static int s5pv210_cpufreq_target(struct cpufreq_policy *policy,
 		WARN_ON(reg > 0xFFFF);
 		__raw_writel(reg & 0xFFFF, S5P_VA_DMC1 + 0x30);
 	}
+	cost_phase_end(CPUFREQ_COST_MEMORY, t);
 
 	/*
 	 * APLL should be changed in this level
@@ -552,6 +590,7 @@ static int s5pv210_cpufreq_target(struct cpufreq_policy *policy,
 	 * Some clock source's clock API  are not prepared. Do not use clock API
 	 * in below code.
 	 */
+	t = ktime_get();
 	if (pll_changing)
 		s5pv210_cpufreq_clksrcs_APLL2MPLL(index, bus_speed_changing);
 
@@ -595,50 +634,68 @@ static int s5pv210_cpufreq_target(struct cpufreq_policy *policy,
 
 	if (pll_changing)
 		s5pv210_cpufreq_clksrcs_MPLL2APLL(index, bus_speed_changing);
+	cost_phase_end(CPUFREQ_COST_CLOCK, t);
+	trans_cost.phase_ns[CPUFREQ_COST_CLOCK] -=
+		trans_cost.phase_ns[CPUFREQ_COST_PLL_LOCK];
 
-	/*
-	 * Adjust DMC0 refresh ratio according to the rate of DMC0
-	 * The DIV value of DMC0 clock changes and SRC value is not controlled.
-	 * We assume that no one changes SRC value of DMC0 clock, either.
-	 */
-	reg = __raw_readl(S5P_CLK_DIV6);
-	reg &= ~S5P_CLKDIV6_ONEDRAM_MASK;
-	reg |= (clkdiv_val[index][8] << S5P_CLKDIV6_ONEDRAM_SHIFT);
-	/* ONEDRAM(DMC0) Clock Divider Ratio: 7+1 for L4, 3+1 for Others */
-	__raw_writel(reg, S5P_CLK_DIV6);
-	do {
-		reg = __raw_readl(S5P_CLK_DIV_STAT1);
-	} while (reg & (1 << 15));
+	t = ktime_get();
+	if (!direct || clkdiv_val[index][8] != dmc0_div) {
+		/*
+		 * Adjust DMC0 refresh ratio according to the rate of DMC0
+		 * The DIV value of DMC0 clock changes and SRC value is not
+		 * controlled. We assume that no one changes SRC value of
+		 * DMC0 clock, either.
+		 */
+		reg = __raw_readl(S5P_CLK_DIV6);
+		reg &= ~S5P_CLKDIV6_ONEDRAM_MASK;
+		reg |= (clkdiv_val[index][8] << S5P_CLKDIV6_ONEDRAM_SHIFT);
+		/* ONEDRAM(DMC0) Clock Divider Ratio: 7+1 for L4, 3+1 others */
+		__raw_writel(reg, S5P_CLK_DIV6);
+		do {
+			reg = __raw_readl(S5P_CLK_DIV_STAT1);
+		} while (reg & (1 << 15));
 
-	/*
-	 * If DMC0 clock gets slower (by orginal clock speed / n),
-	 * then, the refresh rate should decrease
-	 * (by original refresh count / n) (n: divider)
-	 */
-	reg = backup_dmc0_reg * (clkdiv_val[backup_freq_level][8] + 1)
-		/ (clkdiv_val[index][8] + 1);
-	__raw_writel(reg & 0xFFFF, S5P_VA_DMC0 + 0x30);
+		/*
+		 * If DMC0 clock gets slower (by orginal clock speed / n),
+		 * then, the refresh rate should decrease
+		 * (by original refresh count / n) (n: divider)
+		 */
+		reg = backup_dmc0_reg * (clkdiv_val[backup_freq_level][8] + 1)
+			/ (clkdiv_val[index][8] + 1);
+		__raw_writel(reg & 0xFFFF, S5P_VA_DMC0 + 0x30);
+	}
 
 	/*
-	 * Adjust DMC1 refresh ratio according to the rate of hclk_msys
-	 * (L0~L3: 200 <-> L4: 100)
-	 * If DMC1 clock gets slower (by original clock speed * n),
-	 * then, the refresh rate should decrease
-	 * (by original refresh count * n) (n : clock rate)
+	 * Unless the PLL changed, DMC1's refresh counter was not touched
+	 * above when hclk_msys keeps its rate.
 	 */
-	reg = backup_dmc1_reg * clk_info[index].hclk_msys;
-	reg /= clk_info[backup_freq_level].hclk_msys;
-	__raw_writel(reg & 0xFFFF, S5P_VA_DMC1 + 0x30);
+	if (!direct || pll_changing || bus_speed_changing) {
+		/*
+		 * Adjust DMC1 refresh ratio according to the rate of
+		 * hclk_msys (L0~L3: 200 <-> L4: 100)
+		 * If DMC1 clock gets slower (by original clock speed * n),
+		 * then, the refresh rate should decrease
+		 * (by original refresh count * n) (n : clock rate)
+		 */
+		reg = backup_dmc1_reg * clk_info[index].hclk_msys;
+		reg /= clk_info[backup_freq_level].hclk_msys;
+		__raw_writel(reg & 0xFFFF, S5P_VA_DMC1 + 0x30);
+	}
+	cost_phase_end(CPUFREQ_COST_MEMORY, t);
 	cpufreq_notify_transition(&s3c_freqs.freqs, CPUFREQ_POSTCHANGE);
 
 	if (s3c_freqs.freqs.new < s3c_freqs.freqs.old) {
 		/* Voltage down: decrease INT first.*/
 		if (!IS_ERR_OR_NULL(arm_regulator) &&
 				!IS_ERR_OR_NULL(internal_regulator)) {
-			regulator_set_voltage(internal_regulator,
-					int_volt, int_volt_max);
-			regulator_set_voltage(arm_regulator,
-					arm_volt, arm_volt_max);
+			t = ktime_get();
+			if (!direct || int_volt != previous_int_volt)
+				regulator_set_voltage(internal_regulator,
+						int_volt, int_volt_max);
+			if (!direct || arm_volt != previous_arm_volt)
+				regulator_set_voltage(arm_regulator,
+						arm_volt, arm_volt_max);
+			cost_phase_end(CPUFREQ_COST_VOLTAGE, t);
 		}
 	}
 
@@ -646,10 +703,20 @@ static int s5pv210_cpufreq_target(struct cpufreq_policy *policy,
 	cpufreq_debug_printk(CPUFREQ_DEBUG_DRIVER, KERN_INFO,
 			"cpufreq: Performance changed[L%d]\n", index);
 	previous_arm_volt = dvs_conf[index].arm_volt;
+	previous_int_volt = dvs_conf[index].int_volt;
+
+	trans_cost.freqs = s3c_freqs.freqs;
+	trans_cost.latency_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	cpufreq_notify_transition_cost(&trans_cost);
 
 	if (first_run)
 		first_run = false;
 out:
+	/* a regulator may have been left half way: set both next time */
+	if (ret) {
+		previous_arm_volt = 0;
+		previous_int_volt = 0;
+	}
 	mutex_unlock(&set_freq_lock);
 	return ret;
 }
@@ -688,7 +755,9 @@ static int s5pv210_cpufreq_resume(struct cpufreq_policy *policy)
 
 	memcpy(&s3c_freqs.old, &clk_info[level],
 			sizeof(struct s3c_freq));
-	previous_arm_volt = dvs_conf[level].arm_volt;
+	/* the regulators may have been changed across sleep */
+	previous_arm_volt = 0;
+	previous_int_volt = 0;
 
 	return ret;
 }
@@ -757,6 +826,7 @@ static int __init s5pv210_cpufreq_driver_init(struct cpufreq_policy *policy)
 	memcpy(&s3c_freqs.old, &clk_info[level],
 			sizeof(struct s3c_freq));
 	previous_arm_volt = dvs_conf[level].arm_volt;
+	previous_int_volt = dvs_conf[level].int_volt;
 
 #ifdef CONFIG_DVFS_LIMIT
 	for(i = 0; i < DVFS_LOCK_TOKEN_NUM; i++)
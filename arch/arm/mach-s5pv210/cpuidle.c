@@ -18,16 +18,15 @@
 #include <linux/io.h>
 #include <asm/proc-fns.h>
 #include <asm/cacheflush.h>
+#include <asm/pmu.h>
 
 #include <mach/map.h>
 #include <mach/regs-irq.h>
 #include <mach/regs-clock.h>
 #include <mach/regs-gpio.h>
-#include <plat/regs-otg.h>
 #include <mach/cpuidle.h>
 #include <mach/power-domain.h>
 #include <plat/pm.h>
-#include <plat/devs.h>
 
 /*
  * For saving & restoring VIC register before entering
@@ -37,132 +36,58 @@ static unsigned long vic_regs[4];
 static unsigned long *regs_save;
 static dma_addr_t phy_regs_save;
 
-#define MAX_CHK_DEV	0xf
+/* S5P_IDLE_BUSY_* bits of the devices that are active */
+static unsigned long didle_busy;
 
-/*
- * Specific device list for checking before entering
- * didle mode
- */
-struct check_device_op {
-	void __iomem		*base;
-	struct platform_device	*pdev;
-};
-
-/* Array of checking devices list */
-static struct check_device_op chk_dev_op[] = {
-#if defined(CONFIG_S3C_DEV_HSMMC)
-	{.base = 0, .pdev = &s3c_device_hsmmc0},
-#endif
-#if defined(CONFIG_S3C_DEV_HSMMC1)
-	{.base = 0, .pdev = &s3c_device_hsmmc1},
-#endif
-#if defined(CONFIG_S3C_DEV_HSMMC2)
-	{.base = 0, .pdev = &s3c_device_hsmmc2},
-#endif
-#if defined(CONFIG_S3C_DEV_HSMMC3)
-	{.base = 0, .pdev = &s3c_device_hsmmc3},
-#endif
-	{.base = 0, .pdev = NULL},
-};
-
-#define S3C_HSMMC_PRNSTS	(0x24)
-#define S3C_HSMMC_CLKCON	(0x2c)
-#define S3C_HSMMC_CMD_INHIBIT	0x00000001
-#define S3C_HSMMC_DATA_INHIBIT	0x00000002
-#define S3C_HSMMC_CLOCK_CARD_EN	0x0004
-
-static int sdmmc_dev_num;
-/* If SD/MMC interface is working: return = 1 or not 0 */
-static int check_sdmmc_op(unsigned int ch)
+void s5pv210_idle_set_busy(unsigned int dev, int busy)
 {
-	unsigned int reg1, reg2;
-	void __iomem *base_addr;
-
-	if (unlikely(ch > sdmmc_dev_num)) {
-		printk(KERN_ERR "Invalid ch[%d] for SD/MMC\n", ch);
-		return 0;
-	}
-
-	base_addr = chk_dev_op[ch].base;
-	/* Check CMDINHDAT[1] and CMDINHCMD [0] */
-	reg1 = readl(base_addr + S3C_HSMMC_PRNSTS);
-	/* Check CLKCON [2]: ENSDCLK */
-	reg2 = readl(base_addr + S3C_HSMMC_CLKCON);
-
-	return !!(reg1 & (S3C_HSMMC_CMD_INHIBIT | S3C_HSMMC_DATA_INHIBIT)) ||
-	       (reg2 & (S3C_HSMMC_CLOCK_CARD_EN));
-}
-
-/* Check all sdmmc controller */
-static int loop_sdmmc_check(void)
-{
-	unsigned int iter;
-
-	for (iter = 0; iter < sdmmc_dev_num + 1; iter++) {
-		if (check_sdmmc_op(iter))
-			return 1;
-	}
-	return 0;
-}
-
-/*
- * Check USBOTG is working or not
- * GOTGCTL(0xEC000000)
- * BSesVld (Indicates the Device mode transceiver status)
- * BSesVld =	1b : B-session is valid
- *		0b : B-session is not valid
- */
-static int check_usbotg_op(void)
-{
-	unsigned int val;
-
-	val = __raw_readl(S3C_UDC_OTG_GOTGCTL);
-
-	return val & (B_SESSION_VALID);
+	if (busy)
+		set_bit(dev, &didle_busy);
+	else
+		clear_bit(dev, &didle_busy);
 }
 
 /*
  * Check power gating : LCD, CAM, TV, MFC, G3D
- * Check clock gating : DMA, USBHOST, I2C
+ * Called by the power domain code after it writes S5P_NORMAL_CFG.
  */
-extern volatile int s5p_rp_is_running;
-extern int s5p_rp_get_op_level(void);
-
-static int check_power_clock_gating(void)
+void s5pv210_idle_pd_changed(void)
 {
 	unsigned long val;
+	int busy;
 
-	/* check power gating */
 	val = __raw_readl(S5P_NORMAL_CFG);
-	if (val & (S5PV210_PD_LCD | S5PV210_PD_CAM | S5PV210_PD_TV
-				  | S5PV210_PD_MFC | S5PV210_PD_G3D))
-		return 1;
+	busy = !!(val & (S5PV210_PD_LCD | S5PV210_PD_CAM | S5PV210_PD_TV
+				       | S5PV210_PD_MFC | S5PV210_PD_G3D));
 #ifdef CONFIG_S5P_INTERNAL_DMA
 	if (!(val & S5PV210_PD_AUDIO))
-		return 1;
-#endif
-#ifdef CONFIG_SND_S5P_RP
-	if (s5p_rp_get_op_level())
-		return 1;
+		busy = 1;
 #endif
-	/* check clock gating */
-	val = __raw_readl(S5P_CLKGATE_IP0);
-	if (val & (S5P_CLKGATE_IP0_MDMA | S5P_CLKGATE_IP0_PDMA0
-					| S5P_CLKGATE_IP0_PDMA1))
-		return 1;
+	s5pv210_idle_set_busy(S5P_IDLE_BUSY_PD, busy);
+}
 
-	val = __raw_readl(S5P_CLKGATE_IP1);
-	if (val & S5P_CLKGATE_IP1_USBHOST)
-		return 1;
+/*
+ * Check clock gating : DMA, USBHOST, I2C
+ * Called by the clock code after it writes S5P_CLKGATE_IP0/1/3.
+ */
+void s5pv210_idle_clkgate_changed(void)
+{
+	int busy;
 
-	val = __raw_readl(S5P_CLKGATE_IP3);
-	if (val & (S5P_CLKGATE_IP3_I2C0 | S5P_CLKGATE_IP3_I2C_HDMI_DDC
-					| S5P_CLKGATE_IP3_I2C2))
-		return 1;
+	busy = (__raw_readl(S5P_CLKGATE_IP0) &
+		(S5P_CLKGATE_IP0_MDMA | S5P_CLKGATE_IP0_PDMA0 |
+		 S5P_CLKGATE_IP0_PDMA1)) ||
+	       (__raw_readl(S5P_CLKGATE_IP1) & S5P_CLKGATE_IP1_USBHOST) ||
+	       (__raw_readl(S5P_CLKGATE_IP3) &
+		(S5P_CLKGATE_IP3_I2C0 | S5P_CLKGATE_IP3_I2C_HDMI_DDC |
+		 S5P_CLKGATE_IP3_I2C2));
 
-	return 0;
+	s5pv210_idle_set_busy(S5P_IDLE_BUSY_CLK, busy);
 }
 
+extern volatile int s5p_rp_is_running;
+extern int s5p_rp_get_op_level(void);
+
 /*
  * Skipping enter the didle mode when RTC & I2S interrupts be issued
  * during critical section of entering didle mode (around 20ms).
@@ -359,17 +284,27 @@ skipped_didle:
 	__raw_writel(vic_regs[3], S5P_VIC3REG(VIC_INT_ENABLE));
 }
 
+/*
+ * Device activity is reported by the drivers as it changes; only the RTC
+ * tick, the audio DMA position and the RP operation level are read here.
+ * Deep idle powers the ARM core down, which resets the performance
+ * counters, so it is also avoided while perf or oprofile holds them.
+ */
 static int s5p_idle_bm_check(void)
 {
-	if (check_power_clock_gating()	|| loop_sdmmc_check() ||
-	    check_usbotg_op()		|| check_rtcint())
+	if (didle_busy || check_rtcint())
+		return 1;
+	if (pmu_reserved(ARM_PMU_DEVICE_CPU))
+		return 1;
+#ifdef CONFIG_SND_S5P_RP
+	if (s5p_rp_get_op_level())
 		return 1;
+#endif
 #ifdef CONFIG_S5P_INTERNAL_DMA
-	else if (check_idmapos())
+	if (check_idmapos())
 		return 1;
 #endif
-	else
-		return 0;
+	return 0;
 }
 
 /* Actual code that puts the SoC in different idle states */
@@ -390,12 +325,14 @@ static int s5p_enter_didle_state(struct cpuidle_device *dev,
 	return idle_time;
 }
 
+/* Deep idle, or WFI if a device is active */
 static int s5p_enter_idle_bm(struct cpuidle_device *dev,
 				struct cpuidle_state *state)
 {
-	if (s5p_idle_bm_check())
-		return s5p_enter_idle_state(dev, state);
-	else
+	if (s5p_idle_bm_check()) {
+		dev->last_state = dev->safe_state;
+		return s5p_enter_idle_state(dev, dev->safe_state);
+	} else
 		return s5p_enter_didle_state(dev, state);
 }
 
@@ -410,9 +347,6 @@ static struct cpuidle_driver s5p_idle_driver = {
 static int s5p_init_cpuidle(void)
 {
 	struct cpuidle_device *device;
-	struct platform_device *pdev;
-	struct resource *res;
-	int i = 0;
 	int ret;
 
 	ret = cpuidle_register_driver(&s5p_idle_driver);
@@ -421,67 +355,50 @@ static int s5p_init_cpuidle(void)
 		goto err;
 	}
 
+	regs_save = dma_alloc_coherent(NULL, 4096, &phy_regs_save, GFP_KERNEL);
+	if (regs_save == NULL) {
+		printk(KERN_ERR "%s: DMA alloc error\n", __func__);
+		ret = -ENOMEM;
+		goto err_register_driver;
+	}
+	printk(KERN_INFO "cpuidle: phy_regs_save:0x%x\n", phy_regs_save);
+
+	/* power domains and clocks may have changed before we were here */
+	s5pv210_idle_pd_changed();
+	s5pv210_idle_clkgate_changed();
+
 	device = &per_cpu(s5p_cpuidle_device, smp_processor_id());
-	device->state_count = 1;
+	device->state_count = 2;
 
 	/* Wait for interrupt state */
-	device->states[0].enter = s5p_enter_idle_bm;
+	device->states[0].enter = s5p_enter_idle_state;
 	device->states[0].exit_latency = 1;	/* uS */
-	device->states[0].target_residency = 10000;
+	device->states[0].target_residency = 1;
 	device->states[0].flags = CPUIDLE_FLAG_TIME_VALID;
 	strcpy(device->states[0].name, "IDLE");
 	strcpy(device->states[0].desc, "ARM clock gating - WFI");
 
+	/* Deep idle state, falls back to WFI while a device is active */
+	device->states[1].enter = s5p_enter_idle_bm;
+	device->states[1].exit_latency = 300;	/* uS, includes APLL relock */
+	device->states[1].target_residency = 10000;
+	device->states[1].flags = CPUIDLE_FLAG_TIME_VALID |
+				  CPUIDLE_FLAG_CHECK_BM;
+	strcpy(device->states[1].name, "DIDLE");
+	strcpy(device->states[1].desc, "ARM power gating - deep idle");
+
+	device->safe_state = &device->states[0];
+
 	ret = cpuidle_register_device(device);
 	if (ret) {
 		printk(KERN_ERR "%s: Failed registering device\n", __func__);
-		goto err_register_driver;
-	}
-
-	regs_save = dma_alloc_coherent(NULL, 4096, &phy_regs_save, GFP_KERNEL);
-	if (regs_save == NULL) {
-		printk(KERN_ERR "%s: DMA alloc error\n", __func__);
-		ret = -ENOMEM;
-		goto err_register_device;
-	}
-	printk(KERN_INFO "cpuidle: phy_regs_save:0x%x\n", phy_regs_save);
-
-	/* Allocate memory region to access IP's directly */
-	for (i = 0 ; i < MAX_CHK_DEV ; i++) {
-
-		pdev = chk_dev_op[i].pdev;
-
-		if (pdev == NULL) {
-			sdmmc_dev_num = i - 1;
-			break;
-		}
-
-		res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
-		if (!res) {
-			printk(KERN_ERR "%s: failed to get io memory region\n",
-					__func__);
-			ret = -EINVAL;
-			goto err_alloc;
-		}
-		chk_dev_op[i].base = ioremap_nocache(res->start, 4096);
-
-		if (!chk_dev_op[i].base) {
-			printk(KERN_ERR "failed to remap io region\n");
-			ret = -EINVAL;
-			goto err_resource;
-		}
+		goto err_alloc;
 	}
 
 	return 0;
 
 err_alloc:
-	while (--i >= 0) {
-		iounmap(chk_dev_op[i].base);
-	}
-err_resource:
 	dma_free_coherent(NULL, 4096, regs_save, phy_regs_save);
-err_register_device:
-	cpuidle_unregister_device(device);
 err_register_driver:
 	cpuidle_unregister_driver(&s5p_idle_driver);
 err:
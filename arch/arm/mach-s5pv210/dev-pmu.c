@@ -0,0 +1,37 @@
+/* linux/arch/arm/mach-s5pv210/dev-pmu.c
+ *
+ * Copyright (c) 2010 Samsung Electronics Co., Ltd.
+ *		http://www.samsung.com/
+ *
+ * S5PV210 - Cortex-A8 performance monitor unit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/init.h>
+#include <linux/platform_device.h>
+
+#include <asm/pmu.h>
+
+#include <mach/irqs.h>
+
+static struct resource s5pv210_pmu_resource = {
+	.start	= IRQ_PMU,
+	.end	= IRQ_PMU,
+	.flags	= IORESOURCE_IRQ,
+};
+
+static struct platform_device s5pv210_device_pmu = {
+	.name		= "arm-pmu",
+	.id		= ARM_PMU_DEVICE_CPU,
+	.num_resources	= 1,
+	.resource	= &s5pv210_pmu_resource,
+};
+
+static int __init s5pv210_pmu_init(void)
+{
+	return platform_device_register(&s5pv210_device_pmu);
+}
+arch_initcall(s5pv210_pmu_init);
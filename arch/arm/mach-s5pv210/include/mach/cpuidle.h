@@ -10,7 +10,33 @@
  * published by the Free Software Foundation.
 */
 
+#ifndef __ASM_ARCH_CPUIDLE_H
+#define __ASM_ARCH_CPUIDLE_H __FILE__
+
+#include <linux/types.h>
+
 extern int  s5pv210_didle_save(unsigned long *saveblk);
 extern void s5pv210_didle_resume(void);
 extern void i2sdma_getpos(dma_addr_t *src);
 extern unsigned int get_rtc_cnt(void);
+
+/*
+ * Device activity that keeps the SoC out of deep idle.  Drivers report it
+ * as it changes, so that idle entry only has to test a bitmask.
+ */
+#define S5P_IDLE_BUSY_PD	0	/* LCD, CAM, TV, MFC, G3D, audio domains */
+#define S5P_IDLE_BUSY_CLK	1	/* DMA, USB host and I2C clocks */
+#define S5P_IDLE_BUSY_USBOTG	2	/* USB device controller enabled */
+#define S5P_IDLE_BUSY_SDMMC(ch)	(3 + (ch))	/* SD/MMC card clock on */
+
+#ifdef CONFIG_CPU_IDLE
+extern void s5pv210_idle_set_busy(unsigned int dev, int busy);
+extern void s5pv210_idle_pd_changed(void);
+extern void s5pv210_idle_clkgate_changed(void);
+#else
+static inline void s5pv210_idle_set_busy(unsigned int dev, int busy) { }
+static inline void s5pv210_idle_pd_changed(void) { }
+static inline void s5pv210_idle_clkgate_changed(void) { }
+#endif
+
+#endif /* __ASM_ARCH_CPUIDLE_H */
@@ -53,6 +53,7 @@
 /* VIC1: ARM, Power, Memory, Connectivity, Storage */
 
 #define IRQ_CORTEX0		S5P_IRQ_VIC1(0)
+#define IRQ_PMU			IRQ_CORTEX0
 #define IRQ_CORTEX1		S5P_IRQ_VIC1(1)
 #define IRQ_CORTEX2		S5P_IRQ_VIC1(2)
 #define IRQ_CORTEX3		S5P_IRQ_VIC1(3)
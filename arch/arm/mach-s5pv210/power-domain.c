@@ -23,6 +23,7 @@
 #include <mach/power-domain.h>
 
 #include <mach/regs-clock.h>
+#include <mach/cpuidle.h>
 #include <plat/devs.h>
 
 struct s5pv210_pd_data {
@@ -343,10 +344,12 @@ static int s5pv210_pd_ctrl(int ctrlbit, int enable)
 
 	if (enable) {
 		__raw_writel((pd_reg | ctrlbit), S5P_NORMAL_CFG);
+		s5pv210_idle_pd_changed();
 		if (s5pv210_pd_pwr_done(ctrlbit))
 			return -ETIME;
 	} else {
 		__raw_writel((pd_reg & ~(ctrlbit)), S5P_NORMAL_CFG);
+		s5pv210_idle_pd_changed();
 		if (s5pv210_pd_pwr_off(ctrlbit))
 			return -ETIME;
 	}
@@ -26,6 +26,7 @@
 #include <plat/gpio-cfg.h>
 #include <mach/regs-gpio.h>
 #include <mach/gpio.h>
+#include <mach/cpuidle.h>
 #include <asm/mach-types.h>
 
 /* clock sources for the mmc bus clock, order as for the ctrl2[5..4] */
@@ -246,6 +247,12 @@ void s5pv210_adjust_sdhci_cfg_card(struct s3c_sdhci_platdata *pdata,
 	writel(ctrl3, r + S3C_SDHCI_CONTROL3);
 }
 
+/* deep idle would stop the card clock */
+void s5pv210_sdhci_card_clock(struct platform_device *dev, int on)
+{
+	s5pv210_idle_set_busy(S5P_IDLE_BUSY_SDMMC(dev->id), on);
+}
+
 #if defined(CONFIG_MACH_SMDKV210)
 static void setup_sdhci0_gpio_wp(void)
 {
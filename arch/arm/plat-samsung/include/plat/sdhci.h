@@ -29,6 +29,7 @@ struct mmc_ios;
  *            is necessary the controllers and/or GPIO blocks require the
  *	      changing of driver-strength and other controls dependant on
  *	      the card and speed of operation.
+ * @card_clock: Called after the clock to the card is turned on or off.
  *
  * Initialisation data specific to either the machine or the platform
  * for the device driver to use or call-back when configuring gpio or
@@ -46,6 +47,7 @@ struct s3c_sdhci_platdata {
 			    struct mmc_ios *ios,
 			    struct mmc_card *card);
 	void	(*adjust_cfg_card)(struct s3c_sdhci_platdata *pdata, void __iomem *regbase, int rw);
+	void	(*card_clock)(struct platform_device *dev, int on);
 	int		rx_cfg;
 	int		tx_cfg;
 
@@ -253,6 +255,7 @@ extern void s5pv210_setup_sdhci_cfg_card(struct platform_device *dev,
 					 struct mmc_ios *ios,
 					 struct mmc_card *card);
 extern void s5pv210_adjust_sdhci_cfg_card(struct s3c_sdhci_platdata *pdata, void __iomem *r, int rw);
+extern void s5pv210_sdhci_card_clock(struct platform_device *dev, int on);
 
 #ifdef CONFIG_S3C_DEV_HSMMC
 static inline void s5pv210_default_sdhci0(void)
@@ -261,6 +264,7 @@ static inline void s5pv210_default_sdhci0(void)
 	s3c_hsmmc0_def_platdata.cfg_gpio = s5pv210_setup_sdhci0_cfg_gpio;
 	s3c_hsmmc0_def_platdata.cfg_card = s5pv210_setup_sdhci_cfg_card;
 	s3c_hsmmc0_def_platdata.adjust_cfg_card = s5pv210_adjust_sdhci_cfg_card;
+	s3c_hsmmc0_def_platdata.card_clock = s5pv210_sdhci_card_clock;
 }
 #else
 static inline void s5pv210_default_sdhci0(void) { }
@@ -273,6 +277,7 @@ static inline void s5pv210_default_sdhci1(void)
 	s3c_hsmmc1_def_platdata.cfg_gpio = s5pv210_setup_sdhci1_cfg_gpio;
 	s3c_hsmmc1_def_platdata.cfg_card = s5pv210_setup_sdhci_cfg_card;
 	s3c_hsmmc1_def_platdata.adjust_cfg_card = s5pv210_adjust_sdhci_cfg_card;
+	s3c_hsmmc1_def_platdata.card_clock = s5pv210_sdhci_card_clock;
 }
 #else
 static inline void s5pv210_default_sdhci1(void) { }
@@ -285,6 +290,7 @@ static inline void s5pv210_default_sdhci2(void)
 	s3c_hsmmc2_def_platdata.cfg_gpio = s5pv210_setup_sdhci2_cfg_gpio;
 	s3c_hsmmc2_def_platdata.cfg_card = s5pv210_setup_sdhci_cfg_card;
 	s3c_hsmmc2_def_platdata.adjust_cfg_card = s5pv210_adjust_sdhci_cfg_card;
+	s3c_hsmmc2_def_platdata.card_clock = s5pv210_sdhci_card_clock;
 }
 #else
 static inline void s5pv210_default_sdhci2(void) { }
@@ -297,6 +303,7 @@ static inline void s5pv210_default_sdhci3(void)
 	s3c_hsmmc3_def_platdata.cfg_gpio = s5pv210_setup_sdhci3_cfg_gpio;
 	s3c_hsmmc3_def_platdata.cfg_card = s5pv210_setup_sdhci_cfg_card;
 	s3c_hsmmc3_def_platdata.adjust_cfg_card = s5pv210_adjust_sdhci_cfg_card;
+	s3c_hsmmc3_def_platdata.card_clock = s5pv210_sdhci_card_clock;
 }
 #else
 static inline void s5pv210_default_sdhci3(void) { }
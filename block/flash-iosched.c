@@ -0,0 +1,566 @@
+/*
+ *  Flash i/o scheduler.
+ *
+ *  Based on the deadline i/o scheduler,
+ *  Copyright (C) 2002 Jens Axboe <axboe@kernel.dk>
+ *
+ *  Non-rotational devices (eMMC, OneNAND) have no seek penalty, so this
+ *  scheduler never idles and never sorts reads.  Synchronous reads are
+ *  served strictly ahead of writes until a write expires, while writes are
+ *  dispatched in sector-sorted batches so the device sees large contiguous
+ *  runs.  Each request gets a deadline scaled by a weight derived from the
+ *  submitting task's io priority and blkio cgroup weight, which keeps the
+ *  service order fair between processes without per-process queues.
+ */
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/blkdev.h>
+#include <linux/elevator.h>
+#include <linux/bio.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/init.h>
+#include <linux/compiler.h>
+#include <linux/rbtree.h>
+#include <linux/ioprio.h>
+#include "blk-cgroup.h"
+
+/*
+ * See Documentation/block/flash-iosched.txt
+ */
+static const int read_expire = HZ / 8;	/* max time before a read is submitted. */
+static const int write_expire = 2 * HZ;	/* ditto for writes, these limits are SOFT! */
+static const int writes_starved = 4;	/* max times reads can starve a write */
+static const int write_batch = 16;	/* max writes dispatched in one go */
+
+/*
+ * service classes, in the order reads are picked
+ */
+enum {
+	FLASH_CLASS_RT,
+	FLASH_CLASS_BE,
+	FLASH_CLASS_IDLE,
+	FLASH_CLASS_NR,
+};
+
+/*
+ * a task at the default io priority in the default cgroup gets
+ * FLASH_WEIGHT_NORM, which leaves fifo_expire unscaled.
+ */
+#define FLASH_PRIO_WEIGHT(level)	((IOPRIO_BE_NR - (level)) * 100)
+#define FLASH_WEIGHT_NORM		FLASH_PRIO_WEIGHT(IOPRIO_NORM)
+
+/*
+ * class and weight are captured when the request is allocated, in the
+ * context of the submitting task, and packed into elevator_private.
+ */
+#define FLASH_CLASS_BITS	2
+#define FLASH_CLASS_MASK	((1UL << FLASH_CLASS_BITS) - 1)
+
+struct flash_data {
+	/*
+	 * run time data
+	 */
+
+	/*
+	 * requests are present on both sort_list and one of the fifos.
+	 * fifos are kept ordered by deadline.
+	 */
+	struct rb_root sort_list[2];
+	struct list_head read_fifo[FLASH_CLASS_NR];
+	struct list_head write_fifo;
+
+	unsigned int starved;		/* times reads have starved writes */
+
+	/*
+	 * settings that change how the i/o scheduler behaves
+	 */
+	int fifo_expire[2];
+	int writes_starved;
+	int write_batch;
+	int front_merges;
+};
+
+static inline int flash_rq_class(struct request *rq)
+{
+	unsigned long priv = (unsigned long) rq->elevator_private;
+
+	/* requests allocated while the elevator was bypassed carry nothing */
+	if (!priv)
+		return FLASH_CLASS_BE;
+
+	return priv & FLASH_CLASS_MASK;
+}
+
+static inline unsigned int flash_rq_weight(struct request *rq)
+{
+	unsigned long priv = (unsigned long) rq->elevator_private;
+
+	if (!priv)
+		return FLASH_WEIGHT_NORM;
+
+	return priv >> FLASH_CLASS_BITS;
+}
+
+static inline struct rb_root *
+flash_rb_root(struct flash_data *fd, struct request *rq)
+{
+	return &fd->sort_list[rq_data_dir(rq)];
+}
+
+static inline struct list_head *
+flash_fifo(struct flash_data *fd, struct request *rq)
+{
+	if (rq_data_dir(rq) == WRITE)
+		return &fd->write_fifo;
+
+	return &fd->read_fifo[flash_rq_class(rq)];
+}
+
+static void flash_move_to_dispatch(struct flash_data *, struct request *);
+
+static void
+flash_add_rq_rb(struct flash_data *fd, struct request *rq)
+{
+	struct rb_root *root = flash_rb_root(fd, rq);
+	struct request *__alias;
+
+	while (unlikely(__alias = elv_rb_add(root, rq)))
+		flash_move_to_dispatch(fd, __alias);
+}
+
+/*
+ * insert rq into its fifo, keeping it ordered by deadline. Most requests
+ * carry the default weight and so belong at the tail; start looking there.
+ */
+static void
+flash_add_rq_fifo(struct list_head *fifo, struct request *rq)
+{
+	struct list_head *entry;
+
+	list_for_each_prev(entry, fifo) {
+		struct request *pos = rq_entry_fifo(entry);
+
+		if (!time_before(rq_fifo_time(rq), rq_fifo_time(pos)))
+			break;
+	}
+
+	list_add(&rq->queuelist, entry);
+}
+
+#if defined(CONFIG_BLK_CGROUP) || defined(CONFIG_BLK_CGROUP_MODULE)
+static unsigned int flash_cgroup_weight(struct task_struct *tsk)
+{
+	struct blkio_cgroup *blkcg;
+	unsigned int weight;
+
+	rcu_read_lock();
+	blkcg = cgroup_to_blkio_cgroup(task_cgroup(tsk, blkio_subsys_id));
+	weight = blkcg->weight;
+	rcu_read_unlock();
+
+	return weight;
+}
+#else
+static inline unsigned int flash_cgroup_weight(struct task_struct *tsk)
+{
+	return BLKIO_WEIGHT_DEFAULT;
+}
+#endif
+
+/*
+ * record the service class and weight of the allocating task. Like cfq,
+ * tasks that never set an io priority inherit one from their nice level.
+ */
+static int
+flash_set_request(struct request_queue *q, struct request *rq, gfp_t gfp_mask)
+{
+	struct task_struct *tsk = current;
+	struct io_context *ioc = tsk->io_context;
+	int ioprio_class, level, class;
+	unsigned int weight;
+
+	if (ioc && ioprio_valid(ioc->ioprio)) {
+		ioprio_class = IOPRIO_PRIO_CLASS(ioc->ioprio);
+		level = IOPRIO_PRIO_DATA(ioc->ioprio);
+	} else {
+		ioprio_class = task_nice_ioclass(tsk);
+		level = task_nice_ioprio(tsk);
+	}
+
+	switch (ioprio_class) {
+	case IOPRIO_CLASS_RT:
+		class = FLASH_CLASS_RT;
+		break;
+	case IOPRIO_CLASS_IDLE:
+		class = FLASH_CLASS_IDLE;
+		level = IOPRIO_BE_NR - 1;
+		break;
+	default:
+		class = FLASH_CLASS_BE;
+		break;
+	}
+
+	weight = FLASH_PRIO_WEIGHT(level) * flash_cgroup_weight(tsk) /
+		BLKIO_WEIGHT_DEFAULT;
+	if (!weight)
+		weight = 1;
+
+	rq->elevator_private = (void *) ((unsigned long) weight << FLASH_CLASS_BITS
+					 | class);
+	return 0;
+}
+
+/*
+ * add rq to rbtree and fifo
+ */
+static void
+flash_add_request(struct request_queue *q, struct request *rq)
+{
+	struct flash_data *fd = q->elevator->elevator_data;
+	const int data_dir = rq_data_dir(rq);
+	unsigned long expire;
+
+	flash_add_rq_rb(fd, rq);
+
+	/*
+	 * heavier requests expire sooner, lighter ones later
+	 */
+	expire = (unsigned long) fd->fifo_expire[data_dir] * FLASH_WEIGHT_NORM /
+		flash_rq_weight(rq);
+	rq_set_fifo_time(rq, jiffies + expire);
+	flash_add_rq_fifo(flash_fifo(fd, rq), rq);
+}
+
+/*
+ * remove rq from rbtree and fifo.
+ */
+static void flash_remove_request(struct request_queue *q, struct request *rq)
+{
+	struct flash_data *fd = q->elevator->elevator_data;
+
+	rq_fifo_clear(rq);
+	elv_rb_del(flash_rb_root(fd, rq), rq);
+}
+
+static int
+flash_merge(struct request_queue *q, struct request **req, struct bio *bio)
+{
+	struct flash_data *fd = q->elevator->elevator_data;
+	struct request *__rq;
+
+	/*
+	 * check for front merge
+	 */
+	if (fd->front_merges) {
+		sector_t sector = bio->bi_sector + bio_sectors(bio);
+
+		__rq = elv_rb_find(&fd->sort_list[bio_data_dir(bio)], sector);
+		if (__rq) {
+			BUG_ON(sector != blk_rq_pos(__rq));
+
+			if (elv_rq_merge_ok(__rq, bio)) {
+				*req = __rq;
+				return ELEVATOR_FRONT_MERGE;
+			}
+		}
+	}
+
+	return ELEVATOR_NO_MERGE;
+}
+
+static void flash_merged_request(struct request_queue *q,
+				 struct request *req, int type)
+{
+	struct flash_data *fd = q->elevator->elevator_data;
+
+	/*
+	 * if the merge was a front merge, we need to reposition request
+	 */
+	if (type == ELEVATOR_FRONT_MERGE) {
+		elv_rb_del(flash_rb_root(fd, req), req);
+		flash_add_rq_rb(fd, req);
+	}
+}
+
+static void
+flash_merged_requests(struct request_queue *q, struct request *req,
+		      struct request *next)
+{
+	/*
+	 * if next expires before rq, assign its expire time to rq and move
+	 * into next position (next will be deleted) in fifo. Only do so
+	 * within one fifo, rq must not change service class.
+	 */
+	if (!list_empty(&req->queuelist) && !list_empty(&next->queuelist) &&
+	    flash_rq_class(req) == flash_rq_class(next)) {
+		if (time_before(rq_fifo_time(next), rq_fifo_time(req))) {
+			list_move(&req->queuelist, &next->queuelist);
+			rq_set_fifo_time(req, rq_fifo_time(next));
+		}
+	}
+
+	/*
+	 * kill knowledge of next, this one is a goner
+	 */
+	flash_remove_request(q, next);
+}
+
+/*
+ * move request from sort list to dispatch queue.
+ */
+static void
+flash_move_to_dispatch(struct flash_data *fd, struct request *rq)
+{
+	struct request_queue *q = rq->q;
+
+	flash_remove_request(q, rq);
+	elv_dispatch_add_tail(q, rq);
+}
+
+static inline int flash_fifo_expired(struct list_head *fifo)
+{
+	struct request *rq = rq_entry_fifo(fifo->next);
+
+	return time_after(jiffies, rq_fifo_time(rq));
+}
+
+/*
+ * pick the read to serve next: an expired read in any class wins,
+ * otherwise the earliest deadline of the best class. Idle class reads
+ * are only served when nothing else is waiting.
+ */
+static struct request *flash_choose_read(struct flash_data *fd, int writes)
+{
+	int class;
+
+	for (class = 0; class < FLASH_CLASS_NR; class++) {
+		struct list_head *fifo = &fd->read_fifo[class];
+
+		if (!list_empty(fifo) && flash_fifo_expired(fifo))
+			return rq_entry_fifo(fifo->next);
+	}
+
+	for (class = 0; class < FLASH_CLASS_NR; class++) {
+		struct list_head *fifo = &fd->read_fifo[class];
+
+		if (class == FLASH_CLASS_IDLE && writes)
+			break;
+		if (!list_empty(fifo))
+			return rq_entry_fifo(fifo->next);
+	}
+
+	return NULL;
+}
+
+/*
+ * dispatch up to write_batch writes, starting at the earliest deadline and
+ * continuing in ascending sector order.
+ */
+static int flash_dispatch_writes(struct flash_data *fd)
+{
+	struct request *rq = rq_entry_fifo(fd->write_fifo.next);
+	int batch = 0;
+
+	BUG_ON(RB_EMPTY_ROOT(&fd->sort_list[WRITE]));
+
+	fd->starved = 0;
+
+	do {
+		struct rb_node *node = rb_next(&rq->rb_node);
+
+		flash_move_to_dispatch(fd, rq);
+		batch++;
+
+		rq = node ? rb_entry_rq(node) : NULL;
+	} while (rq && batch < fd->write_batch);
+
+	return batch;
+}
+
+/*
+ * flash_dispatch_requests selects the best request according to
+ * read/write expire, writes_starved, write_batch, etc
+ */
+static int flash_dispatch_requests(struct request_queue *q, int force)
+{
+	struct flash_data *fd = q->elevator->elevator_data;
+	const int writes = !list_empty(&fd->write_fifo);
+	struct request *rq;
+
+	if (writes && (flash_fifo_expired(&fd->write_fifo) ||
+		       fd->starved >= fd->writes_starved))
+		return flash_dispatch_writes(fd);
+
+	rq = flash_choose_read(fd, writes);
+	if (rq) {
+		if (writes)
+			fd->starved++;
+		flash_move_to_dispatch(fd, rq);
+		return 1;
+	}
+
+	if (writes)
+		return flash_dispatch_writes(fd);
+
+	return 0;
+}
+
+static int flash_data_empty(struct flash_data *fd)
+{
+	int class;
+
+	for (class = 0; class < FLASH_CLASS_NR; class++)
+		if (!list_empty(&fd->read_fifo[class]))
+			return 0;
+
+	return list_empty(&fd->write_fifo);
+}
+
+static int flash_queue_empty(struct request_queue *q)
+{
+	return flash_data_empty(q->elevator->elevator_data);
+}
+
+static void flash_exit_queue(struct elevator_queue *e)
+{
+	struct flash_data *fd = e->elevator_data;
+
+	BUG_ON(!flash_data_empty(fd));
+
+	kfree(fd);
+}
+
+/*
+ * initialize elevator private data (flash_data).
+ */
+static void *flash_init_queue(struct request_queue *q)
+{
+	struct flash_data *fd;
+	int class;
+
+	fd = kmalloc_node(sizeof(*fd), GFP_KERNEL | __GFP_ZERO, q->node);
+	if (!fd)
+		return NULL;
+
+	for (class = 0; class < FLASH_CLASS_NR; class++)
+		INIT_LIST_HEAD(&fd->read_fifo[class]);
+	INIT_LIST_HEAD(&fd->write_fifo);
+	fd->sort_list[READ] = RB_ROOT;
+	fd->sort_list[WRITE] = RB_ROOT;
+	fd->fifo_expire[READ] = read_expire;
+	fd->fifo_expire[WRITE] = write_expire;
+	fd->writes_starved = writes_starved;
+	fd->write_batch = write_batch;
+	fd->front_merges = 1;
+	return fd;
+}
+
+/*
+ * sysfs parts below
+ */
+
+static ssize_t
+flash_var_show(int var, char *page)
+{
+	return sprintf(page, "%d\n", var);
+}
+
+static ssize_t
+flash_var_store(int *var, const char *page, size_t count)
+{
+	char *p = (char *) page;
+
+	*var = simple_strtol(p, &p, 10);
+	return count;
+}
+
+#define SHOW_FUNCTION(__FUNC, __VAR, __CONV)				\
+static ssize_t __FUNC(struct elevator_queue *e, char *page)		\
+{									\
+	struct flash_data *fd = e->elevator_data;			\
+	int __data = __VAR;						\
+	if (__CONV)							\
+		__data = jiffies_to_msecs(__data);			\
+	return flash_var_show(__data, (page));				\
+}
+SHOW_FUNCTION(flash_read_expire_show, fd->fifo_expire[READ], 1);
+SHOW_FUNCTION(flash_write_expire_show, fd->fifo_expire[WRITE], 1);
+SHOW_FUNCTION(flash_writes_starved_show, fd->writes_starved, 0);
+SHOW_FUNCTION(flash_write_batch_show, fd->write_batch, 0);
+SHOW_FUNCTION(flash_front_merges_show, fd->front_merges, 0);
+#undef SHOW_FUNCTION
+
+#define STORE_FUNCTION(__FUNC, __PTR, MIN, MAX, __CONV)			\
+static ssize_t __FUNC(struct elevator_queue *e, const char *page, size_t count)	\
+{									\
+	struct flash_data *fd = e->elevator_data;			\
+	int __data;							\
+	int ret = flash_var_store(&__data, (page), count);		\
+	if (__data < (MIN))						\
+		__data = (MIN);						\
+	else if (__data > (MAX))					\
+		__data = (MAX);						\
+	if (__CONV)							\
+		*(__PTR) = msecs_to_jiffies(__data);			\
+	else								\
+		*(__PTR) = __data;					\
+	return ret;							\
+}
+STORE_FUNCTION(flash_read_expire_store, &fd->fifo_expire[READ], 0, INT_MAX, 1);
+STORE_FUNCTION(flash_write_expire_store, &fd->fifo_expire[WRITE], 0, INT_MAX, 1);
+STORE_FUNCTION(flash_writes_starved_store, &fd->writes_starved, 0, INT_MAX, 0);
+STORE_FUNCTION(flash_write_batch_store, &fd->write_batch, 1, INT_MAX, 0);
+STORE_FUNCTION(flash_front_merges_store, &fd->front_merges, 0, 1, 0);
+#undef STORE_FUNCTION
+
+#define FD_ATTR(name) \
+	__ATTR(name, S_IRUGO|S_IWUSR, flash_##name##_show, \
+				      flash_##name##_store)
+
+static struct elv_fs_entry flash_attrs[] = {
+	FD_ATTR(read_expire),
+	FD_ATTR(write_expire),
+	FD_ATTR(writes_starved),
+	FD_ATTR(write_batch),
+	FD_ATTR(front_merges),
+	__ATTR_NULL
+};
+
+static struct elevator_type iosched_flash = {
+	.ops = {
+		.elevator_merge_fn = 		flash_merge,
+		.elevator_merged_fn =		flash_merged_request,
+		.elevator_merge_req_fn =	flash_merged_requests,
+		.elevator_dispatch_fn =		flash_dispatch_requests,
+		.elevator_add_req_fn =		flash_add_request,
+		.elevator_queue_empty_fn =	flash_queue_empty,
+		.elevator_former_req_fn =	elv_rb_former_request,
+		.elevator_latter_req_fn =	elv_rb_latter_request,
+		.elevator_set_req_fn =		flash_set_request,
+		.elevator_init_fn =		flash_init_queue,
+		.elevator_exit_fn =		flash_exit_queue,
+	},
+
+	.elevator_attrs = flash_attrs,
+	.elevator_name = "flash",
+	.elevator_owner = THIS_MODULE,
+};
+
+static int __init flash_init(void)
+{
+	elv_register(&iosched_flash);
+
+	return 0;
+}
+
+static void __exit flash_exit(void)
+{
+	elv_unregister(&iosched_flash);
+}
+
+module_init(flash_init);
+module_exit(flash_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("flash IO scheduler");
@@ -33,6 +33,9 @@
 #include <linux/delay.h>
 #include <linux/version.h>
 #include <linux/hrtimer.h>
+#include <linux/completion.h>
+#include <linux/math64.h>
+#include <linux/slab.h>
 
 #include <asm/cacheflush.h>
 
@@ -47,6 +50,9 @@
 
 #define ACE_AES_SW_AES_BLOCK_SIZE	16
 
+/* requests queued behind the one on the engine before callers backlog */
+#define ACE_BC_QUEUE_LEN		16
+
 #define CONFIG_ACE_SWAES_FOR_SMALLBLOCK
 #define CONFIG_ACE_BC_ASYNC
 #define CONFIG_ACE_BC_IRQMODE
@@ -113,6 +119,28 @@ struct timeval timestamp[5];
 
 struct s5p_ace_reqctx {
 	u32				mode;
+	ktime_t				start;
+};
+
+enum {
+	ACE_BC_ECB,
+	ACE_BC_CBC,
+	ACE_BC_CTR,
+	ACE_BC_NR_MODES
+};
+
+enum {
+	ACE_PATH_HW,
+	ACE_PATH_SW,
+	ACE_NR_PATHS
+};
+
+/* per mode and path, latency from submission to completion */
+struct s5p_ace_stats {
+	u32				reqs;
+	u64				bytes;
+	u64				ns;
+	u64				max_ns;
 };
 
 struct s5p_ace_device {
@@ -135,6 +163,7 @@ struct s5p_ace_device {
 	struct tasklet_struct		task_bc;
 
 	struct s5p_ace_aes_ctx		*ctx_bc;
+	struct s5p_ace_stats		stats_bc[ACE_BC_NR_MODES][ACE_NR_PATHS];
 #endif
 
 #if defined(CONFIG_ACE_HASH_ASYNC)
@@ -668,16 +697,81 @@ static struct crypto_alg aes_alg = {
 #endif
 
 #if defined(CONFIG_ACE_BC_ASYNC)
+#if defined(CONFIG_ACE_SWAES_FOR_SMALLBLOCK)
+/*
+ * Requests shorter than this are done by the software fallback: for them
+ * the DMA setup and the completion interrupt cost more than the cipher.
+ * Left at -1, it is measured when the device is probed.
+ */
+static int s5p_ace_sw_threshold = -1;
+module_param_named(sw_threshold, s5p_ace_sw_threshold, int, 0644);
+MODULE_PARM_DESC(sw_threshold,
+	"Shortest request given to the engine, -1 to measure at probe");
+
+#define ACE_SW_THRESHOLD_DEFAULT	256
+#endif
+
+static int s5p_ace_aes_mode(struct s5p_ace_aes_ctx *sctx)
+{
+	switch (sctx->sfr_ctrl & ACE_AES_OPERMODE_MASK) {
+	case ACE_AES_OPERMODE_CBC:
+		return ACE_BC_CBC;
+	case ACE_AES_OPERMODE_CTR:
+		return ACE_BC_CTR;
+	default:
+		return ACE_BC_ECB;
+	}
+}
+
+static void s5p_ace_account(struct s5p_ace_aes_ctx *sctx, int path,
+				unsigned int nbytes, ktime_t start)
+{
+	struct s5p_ace_stats *st;
+	unsigned long flags;
+	u64 ns;
+
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	st = &s5p_ace_dev.stats_bc[s5p_ace_aes_mode(sctx)][path];
+
+	spin_lock_irqsave(&s5p_ace_dev.lock, flags);
+	st->reqs++;
+	st->bytes += nbytes;
+	st->ns += ns;
+	if (ns > st->max_ns)
+		st->max_ns = ns;
+	spin_unlock_irqrestore(&s5p_ace_dev.lock, flags);
+}
+
 void s5p_ace_sg_update(struct scatterlist **sg, size_t *offset,
 					size_t count)
 {
 	*offset += count;
-	if (*offset >= sg_dma_len(*sg)) {
+	while (*sg && *offset >= sg_dma_len(*sg)) {
 		*offset -= sg_dma_len(*sg);
 		*sg = sg_next(*sg);
 	}
 }
 
+/*
+ * Bytes from offset ofs of sg on which one DMA run can go: the entries
+ * following sg are merged in as long as they continue it in memory.
+ */
+static size_t s5p_ace_sg_run(struct scatterlist *sg, size_t ofs, size_t max)
+{
+	size_t len = sg_dma_len(sg) - ofs;
+	struct scatterlist *next;
+
+	while (len < max) {
+		next = sg_next(sg);
+		if (!next || sg_phys(next) != sg_phys(sg) + sg_dma_len(sg))
+			break;
+		len += sg_dma_len(next);
+		sg = next;
+	}
+
+	return min(len, max);
+}
+
 int s5p_ace_sg_set_from_sg(struct scatterlist *dst, struct scatterlist *src,
 			u32 num)
 {
@@ -848,8 +942,8 @@ static int s5p_ace_aes_crypt_dma_start(struct s5p_ace_device *dev)
 
 	while (1) {
 		count = sctx->total;
-		count = min(count, sg_dma_len(sctx->in_sg) - sctx->in_ofs);
-		count = min(count, sg_dma_len(sctx->out_sg) - sctx->out_ofs);
+		count = s5p_ace_sg_run(sctx->in_sg, sctx->in_ofs, count);
+		count = s5p_ace_sg_run(sctx->out_sg, sctx->out_ofs, count);
 
 #if defined(CONFIG_ACE_DEBUG)
 		printk(KERN_NOTICE "total_start: %d (%d)\n",
@@ -1117,17 +1211,54 @@ static void s5p_ace_bc_task(unsigned long data)
 	}
 
 	if (!sctx->total) {
-		sctx->req->base.complete(&sctx->req->base, ret);
+		struct ablkcipher_request *req = sctx->req;
+		struct s5p_ace_reqctx *rctx = ablkcipher_request_ctx(req);
+
+		s5p_ace_account(sctx, ACE_PATH_HW, req->nbytes, rctx->start);
 		dev->ctx_bc = NULL;
 
 #if defined(CONFIG_ACE_WATCHDOG)
 		hrtimer_cancel(&s5p_ace_dev.watchdog_bc);
 #endif
+
+		/*
+		 * Have the engine on the next queued request before running
+		 * the completion, which may take a while or queue more.
+		 */
+		s5p_ace_aes_handle_req(dev);
+		req->base.complete(&req->base, ret);
+		return;
 	}
 
 	s5p_ace_aes_handle_req(dev);
 }
 
+#if defined(CONFIG_ACE_SWAES_FOR_SMALLBLOCK)
+static int s5p_ace_aes_crypt_sw(struct ablkcipher_request *req, u32 encmode)
+{
+	struct s5p_ace_aes_ctx *sctx =
+		crypto_ablkcipher_ctx(crypto_ablkcipher_reqtfm(req));
+	struct blkcipher_desc desc;
+	ktime_t start = ktime_get();
+	int ret;
+
+	desc.tfm = sctx->fallback_bc;
+	desc.info = req->info;
+	desc.flags = req->base.flags & CRYPTO_TFM_REQ_MAY_SLEEP;
+
+	if (encmode == BC_MODE_ENC)
+		ret = crypto_blkcipher_encrypt_iv(&desc, req->dst, req->src,
+						req->nbytes);
+	else
+		ret = crypto_blkcipher_decrypt_iv(&desc, req->dst, req->src,
+						req->nbytes);
+
+	s5p_ace_account(sctx, ACE_PATH_SW, req->nbytes, start);
+
+	return ret;
+}
+#endif
+
 static int s5p_ace_aes_crypt(struct ablkcipher_request *req, u32 encmode)
 {
 	struct s5p_ace_reqctx *rctx = ablkcipher_request_ctx(req);
@@ -1144,7 +1275,13 @@ static int s5p_ace_aes_crypt(struct ablkcipher_request *req, u32 encmode)
 				__func__, (u32)req->nbytes, encmode);
 #endif
 
+#if defined(CONFIG_ACE_SWAES_FOR_SMALLBLOCK)
+	if ((int)req->nbytes < ACCESS_ONCE(s5p_ace_sw_threshold))
+		return s5p_ace_aes_crypt_sw(req, encmode);
+#endif
+
 	rctx->mode = encmode;
+	rctx->start = ktime_get();
 
 	timeout = jiffies + msecs_to_jiffies(10);
 	while (time_before(jiffies, timeout)) {
@@ -1939,6 +2076,182 @@ static irqreturn_t s5p_ace_interrupt(int irq, void *data)
 }
 #endif
 
+#if defined(CONFIG_ACE_BC_ASYNC)
+static const char *s5p_ace_mode_names[ACE_BC_NR_MODES] = {
+	"ecb", "cbc", "ctr",
+};
+
+static ssize_t s5p_ace_show_stats(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct s5p_ace_stats stats[ACE_BC_NR_MODES][ACE_NR_PATHS];
+	unsigned long flags;
+	ssize_t len = 0;
+	int i, j;
+
+	spin_lock_irqsave(&s5p_ace_dev.lock, flags);
+	memcpy(stats, s5p_ace_dev.stats_bc, sizeof(stats));
+	spin_unlock_irqrestore(&s5p_ace_dev.lock, flags);
+
+#if defined(CONFIG_ACE_SWAES_FOR_SMALLBLOCK)
+	len += sprintf(buf + len, "sw_threshold %d\n", s5p_ace_sw_threshold);
+#endif
+	len += sprintf(buf + len, "mode path %10s %12s %8s %8s %8s\n",
+			"requests", "bytes", "avg_us", "max_us", "KB/s");
+	for (i = 0; i < ACE_BC_NR_MODES; i++) {
+		for (j = 0; j < ACE_NR_PATHS; j++) {
+			struct s5p_ace_stats *st = &stats[i][j];
+			u64 avg = 0, rate = 0;
+
+			if (st->reqs)
+				avg = div64_u64(st->ns, st->reqs);
+			if (st->ns)
+				rate = div64_u64(st->bytes * 1000000, st->ns);
+			len += sprintf(buf + len,
+				"%-4s %-4s %10u %12llu %8llu %8llu %8llu\n",
+				s5p_ace_mode_names[i], j == ACE_PATH_HW ?
+				"hw" : "sw", st->reqs,
+				(unsigned long long)st->bytes,
+				(unsigned long long)div64_u64(avg, 1000),
+				(unsigned long long)div64_u64(st->max_ns, 1000),
+				(unsigned long long)rate);
+		}
+	}
+
+	return len;
+}
+
+/* any write clears the counters */
+static ssize_t s5p_ace_store_stats(struct device *dev,
+				struct device_attribute *attr,
+				const char *buf, size_t count)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&s5p_ace_dev.lock, flags);
+	memset(s5p_ace_dev.stats_bc, 0, sizeof(s5p_ace_dev.stats_bc));
+	spin_unlock_irqrestore(&s5p_ace_dev.lock, flags);
+
+	return count;
+}
+
+static DEVICE_ATTR(stats, 0644, s5p_ace_show_stats, s5p_ace_store_stats);
+#endif
+
+#if defined(CONFIG_ACE_BC_ASYNC) && defined(CONFIG_ACE_SWAES_FOR_SMALLBLOCK)
+#define ACE_CALIB_MAX		4096
+#define ACE_CALIB_RUNS		8
+
+struct s5p_ace_calib_result {
+	struct completion	completion;
+	int			err;
+};
+
+static void s5p_ace_calib_complete(struct crypto_async_request *req, int err)
+{
+	struct s5p_ace_calib_result *res = req->data;
+
+	if (err == -EINPROGRESS)
+		return;
+
+	res->err = err;
+	complete(&res->completion);
+}
+
+/* best of ACE_CALIB_RUNS, in ns, of a request going the given way */
+static s64 __init s5p_ace_calib_run(struct ablkcipher_request *req,
+				struct s5p_ace_calib_result *res,
+				int threshold)
+{
+	s64 t, best = LLONG_MAX;
+	ktime_t start;
+	int i, ret;
+
+	s5p_ace_sw_threshold = threshold;
+
+	for (i = 0; i < ACE_CALIB_RUNS; i++) {
+		start = ktime_get();
+		ret = crypto_ablkcipher_encrypt(req);
+		if (ret == -EINPROGRESS || ret == -EBUSY) {
+			wait_for_completion(&res->completion);
+			INIT_COMPLETION(res->completion);
+			ret = res->err;
+		}
+		if (ret)
+			return ret;
+		t = ktime_to_ns(ktime_sub(ktime_get(), start));
+		if (t < best)
+			best = t;
+	}
+
+	return best;
+}
+
+/*
+ * Time CBC encryption on the engine and in software, with the requests
+ * going through the driver as any user's would, and return the shortest
+ * size at which the engine wins.  Sizes past the sweep go to the engine.
+ */
+static int __init s5p_ace_calibrate(void)
+{
+	struct s5p_ace_calib_result res;
+	struct crypto_ablkcipher *tfm;
+	struct ablkcipher_request *req;
+	struct scatterlist sg;
+	u8 key[AES_MIN_KEY_SIZE], iv[AES_BLOCK_SIZE];
+	s64 hw, sw;
+	void *buf;
+	int size, ret;
+
+	tfm = crypto_alloc_ablkcipher("cbc-aes-s5p-ace", 0, 0);
+	if (IS_ERR(tfm))
+		return PTR_ERR(tfm);
+
+	ret = -ENOMEM;
+	buf = kzalloc(ACE_CALIB_MAX, GFP_KERNEL);
+	if (!buf)
+		goto out_tfm;
+	req = ablkcipher_request_alloc(tfm, GFP_KERNEL);
+	if (!req)
+		goto out_buf;
+
+	memset(key, 0, sizeof(key));
+	memset(iv, 0, sizeof(iv));
+	ret = crypto_ablkcipher_setkey(tfm, key, sizeof(key));
+	if (ret)
+		goto out_req;
+
+	init_completion(&res.completion);
+	ablkcipher_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+					s5p_ace_calib_complete, &res);
+
+	for (size = AES_BLOCK_SIZE; size <= ACE_CALIB_MAX; size *= 2) {
+		sg_init_one(&sg, buf, size);
+		ablkcipher_request_set_crypt(req, &sg, &sg, size, iv);
+
+		hw = s5p_ace_calib_run(req, &res, 0);
+		sw = s5p_ace_calib_run(req, &res, INT_MAX);
+		if (hw < 0 || sw < 0) {
+			ret = hw < 0 ? hw : sw;
+			goto out_req;
+		}
+		printk(KERN_INFO "ACE: %5d bytes, engine %7lld ns, "
+			"software %7lld ns\n", size, hw, sw);
+		if (hw < sw)
+			break;
+	}
+	ret = size;
+
+out_req:
+	ablkcipher_request_free(req);
+out_buf:
+	kfree(buf);
+out_tfm:
+	crypto_free_ablkcipher(tfm);
+	return ret;
+}
+#endif
+
 static int __init s5p_ace_probe(struct platform_device *pdev)
 {
 	struct resource *res;
@@ -2016,7 +2329,7 @@ static int __init s5p_ace_probe(struct platform_device *pdev)
 #endif
 
 #if defined(CONFIG_ACE_BC_ASYNC)
-	crypto_init_queue(&s5p_adt->queue_bc, 1);
+	crypto_init_queue(&s5p_adt->queue_bc, ACE_BC_QUEUE_LEN);
 	tasklet_init(&s5p_adt->task_bc, s5p_ace_bc_task,
 			(unsigned long)s5p_adt);
 #endif
@@ -2063,6 +2376,24 @@ static int __init s5p_ace_probe(struct platform_device *pdev)
 	}
 #endif
 
+#if defined(CONFIG_ACE_BC_ASYNC)
+	if (device_create_file(&pdev->dev, &dev_attr_stats))
+		dev_err(&pdev->dev, "failed to create stats file\n");
+#endif
+
+#if defined(CONFIG_ACE_BC_ASYNC) && defined(CONFIG_ACE_SWAES_FOR_SMALLBLOCK)
+	if (s5p_ace_sw_threshold < 0) {
+		ret = s5p_ace_calibrate();
+		if (ret < 0) {
+			dev_err(&pdev->dev, "calibration failed: %d\n", ret);
+			ret = ACE_SW_THRESHOLD_DEFAULT;
+		}
+		s5p_ace_sw_threshold = ret;
+	}
+	printk(KERN_INFO "ACE: software below %d bytes\n",
+		s5p_ace_sw_threshold);
+#endif
+
 	printk(KERN_NOTICE "ACE driver is initialized\n");
 
 	return 0;
@@ -2112,6 +2443,10 @@ static int s5p_ace_remove(struct platform_device *dev)
 	struct s5p_ace_device *s5p_adt = &s5p_ace_dev;
 	int i;
 
+#if defined(CONFIG_ACE_BC_ASYNC)
+	device_remove_file(&dev->dev, &dev_attr_stats);
+#endif
+
 #if defined(CONFIG_ACE_BC_IRQMODE) || defined(CONFIG_ACE_HASH_IRQMODE)
 	if (s5p_adt->irq) {
 		free_irq(s5p_adt->irq, (void *)s5p_adt);
@@ -1326,9 +1326,18 @@ EXPORT_SYMBOL_GPL(crypto_aes_set_key);
 	f_rl(bo, bi, 3, k);	\
 } while (0)
 
-static void aes_encrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
+/**
+ * crypto_aes_encrypt_block - Encrypt a single block with an expanded key
+ * @ctx:	The key schedule, from crypto_aes_expand_key()
+ * @out:	Ciphertext, 32-bit aligned
+ * @in:		Plaintext, 32-bit aligned
+ *
+ * For drivers that do several blocks at a time and need the odd single
+ * block done in software, without a cipher tfm of their own.
+ */
+void crypto_aes_encrypt_block(const struct crypto_aes_ctx *ctx, u8 *out,
+			      const u8 *in)
 {
-	const struct crypto_aes_ctx *ctx = crypto_tfm_ctx(tfm);
 	const __le32 *src = (const __le32 *)in;
 	__le32 *dst = (__le32 *)out;
 	u32 b0[4], b1[4];
@@ -1366,6 +1375,12 @@ static void aes_encrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
 	dst[2] = cpu_to_le32(b0[2]);
 	dst[3] = cpu_to_le32(b0[3]);
 }
+EXPORT_SYMBOL_GPL(crypto_aes_encrypt_block);
+
+static void aes_encrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
+{
+	crypto_aes_encrypt_block(crypto_tfm_ctx(tfm), out, in);
+}
 
 /* decrypt a block of text */
 
@@ -1398,9 +1413,15 @@ static void aes_encrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
 	i_rl(bo, bi, 3, k);	\
 } while (0)
 
-static void aes_decrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
+/**
+ * crypto_aes_decrypt_block - Decrypt a single block with an expanded key
+ * @ctx:	The key schedule, from crypto_aes_expand_key()
+ * @out:	Plaintext, 32-bit aligned
+ * @in:		Ciphertext, 32-bit aligned
+ */
+void crypto_aes_decrypt_block(const struct crypto_aes_ctx *ctx, u8 *out,
+			      const u8 *in)
 {
-	const struct crypto_aes_ctx *ctx = crypto_tfm_ctx(tfm);
 	const __le32 *src = (const __le32 *)in;
 	__le32 *dst = (__le32 *)out;
 	u32 b0[4], b1[4];
@@ -1438,6 +1459,12 @@ static void aes_decrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
 	dst[2] = cpu_to_le32(b0[2]);
 	dst[3] = cpu_to_le32(b0[3]);
 }
+EXPORT_SYMBOL_GPL(crypto_aes_decrypt_block);
+
+static void aes_decrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
+{
+	crypto_aes_decrypt_block(crypto_tfm_ctx(tfm), out, in);
+}
 
 static struct crypto_alg aes_alg = {
 	.cra_name		=	"aes",
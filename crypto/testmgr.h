@@ -2933,16 +2933,16 @@ static struct cipher_testvec cast6_dec_tv_template[] = {
 /*
  * AES test vectors.
  */
-#define AES_ENC_TEST_VECTORS 3
-#define AES_DEC_TEST_VECTORS 3
-#define AES_CBC_ENC_TEST_VECTORS 4
-#define AES_CBC_DEC_TEST_VECTORS 4
+#define AES_ENC_TEST_VECTORS 4
+#define AES_DEC_TEST_VECTORS 4
+#define AES_CBC_ENC_TEST_VECTORS 5
+#define AES_CBC_DEC_TEST_VECTORS 5
 #define AES_LRW_ENC_TEST_VECTORS 8
 #define AES_LRW_DEC_TEST_VECTORS 8
 #define AES_XTS_ENC_TEST_VECTORS 4
 #define AES_XTS_DEC_TEST_VECTORS 4
-#define AES_CTR_ENC_TEST_VECTORS 3
-#define AES_CTR_DEC_TEST_VECTORS 3
+#define AES_CTR_ENC_TEST_VECTORS 4
+#define AES_CTR_DEC_TEST_VECTORS 4
 #define AES_CTR_3686_ENC_TEST_VECTORS 7
 #define AES_CTR_3686_DEC_TEST_VECTORS 6
 #define AES_GCM_ENC_TEST_VECTORS 9
@@ -2986,6 +2986,48 @@ static struct cipher_testvec aes_enc_tv_template[] = {
 		.result	= "\x8e\xa2\xb7\xca\x51\x67\x45\xbf"
 			  "\xea\xfc\x49\x90\x4b\x49\x60\x89",
 		.rlen	= 16,
+	}, {
+		.key	= "\x91\xb8\x63\x44\x6d\x65\x74\x13"
+			  "\x0c\x51\xf5\x84\xf0\x70\x5f\x2d",
+		.klen	= 16,
+		.input	= "\x88\x5b\x7c\xb6\x55\xc7\x4b\x92"
+			  "\xe6\xcd\x45\xc5\x78\xa6\x61\xa1"
+			  "\xa8\x3d\xf9\xf3\x39\xcd\xbd\xcb"
+			  "\xc6\xc6\xd6\x23\x41\xe5\x56\xea"
+			  "\xc5\xea\x30\xaa\x14\xcf\xdb\x54"
+			  "\xe4\x10\xa5\xac\x93\xbb\xa5\xb5"
+			  "\x75\x6f\xbe\xaf\x68\xe2\x09\xce"
+			  "\x5a\xfb\xaa\x90\xa7\xd7\xcf\xd6"
+			  "\xbe\x70\x47\x9b\x2f\xf1\x3c\x6c"
+			  "\xa5\x24\xa1\x4c\x04\xde\x67\x8f"
+			  "\x25\x0c\x8e\xc0\x63\x89\x79\x55"
+			  "\x4a\x8f\xbe\xe6\x6d\xdf\x47\x0a"
+			  "\xef\x8b\x2b\x3c\x89\x39\xbd\xdd"
+			  "\x88\xb4\x0c\x08\xd4\x2f\x81\x79"
+			  "\xa8\x08\x11\x2b\xf1\x93\x01\x91"
+			  "\x09\x5f\xe6\xfd\xb5\x4d\x14\x9b"
+			  "\x4b\xb8\x0c\xad\xfc\x07\xd6\xce"
+			  "\x99\x0f\x2e\x8e\xce\xdd\xb6\xe9",
+		.ilen	= 144,
+		.result	= "\x2b\x0f\x11\x8b\xf8\xfc\xfa\x2f"
+			  "\xde\x42\x42\xb2\xc3\x81\x0c\xcc"
+			  "\x76\xbb\x50\x89\x99\x03\x54\xdf"
+			  "\x37\xb4\x1b\x68\x42\x8a\xa4\x3b"
+			  "\x62\xfe\x72\x6b\x70\xb7\xde\x3a"
+			  "\xe3\x2f\xb4\x64\xc5\x18\xd8\x3d"
+			  "\x29\xd9\xc0\xd9\xf9\x15\x92\x30"
+			  "\xca\xb2\xb7\x64\x37\x58\xf8\x8b"
+			  "\x6a\xe3\x50\x15\x4a\xf7\xe8\xe0"
+			  "\xdc\xd3\x89\x04\x30\xae\xad\xf8"
+			  "\x47\x38\x2d\xa2\x7d\x7d\xb0\xc8"
+			  "\xd7\x71\x8a\x9e\xd0\x8d\x6a\x72"
+			  "\x5b\x73\xb7\x3b\x32\xfc\xfc\xe0"
+			  "\x81\xab\xeb\x55\xb2\x4a\xa9\x20"
+			  "\x98\xbe\x52\xa7\x00\x71\xc0\xc2"
+			  "\x5e\x69\x06\x58\x52\x1e\xba\xcc"
+			  "\xd9\x54\x1c\xe0\x0c\x58\x34\x8b"
+			  "\x79\x65\x4b\xf3\x46\xaf\x97\x83",
+		.rlen	= 144,
 	},
 };
 
@@ -3023,6 +3065,48 @@ static struct cipher_testvec aes_dec_tv_template[] = {
 		.result	= "\x00\x11\x22\x33\x44\x55\x66\x77"
 			  "\x88\x99\xaa\xbb\xcc\xdd\xee\xff",
 		.rlen	= 16,
+	}, {
+		.key	= "\x91\xb8\x63\x44\x6d\x65\x74\x13"
+			  "\x0c\x51\xf5\x84\xf0\x70\x5f\x2d",
+		.klen	= 16,
+		.input	= "\x2b\x0f\x11\x8b\xf8\xfc\xfa\x2f"
+			  "\xde\x42\x42\xb2\xc3\x81\x0c\xcc"
+			  "\x76\xbb\x50\x89\x99\x03\x54\xdf"
+			  "\x37\xb4\x1b\x68\x42\x8a\xa4\x3b"
+			  "\x62\xfe\x72\x6b\x70\xb7\xde\x3a"
+			  "\xe3\x2f\xb4\x64\xc5\x18\xd8\x3d"
+			  "\x29\xd9\xc0\xd9\xf9\x15\x92\x30"
+			  "\xca\xb2\xb7\x64\x37\x58\xf8\x8b"
+			  "\x6a\xe3\x50\x15\x4a\xf7\xe8\xe0"
+			  "\xdc\xd3\x89\x04\x30\xae\xad\xf8"
+			  "\x47\x38\x2d\xa2\x7d\x7d\xb0\xc8"
+			  "\xd7\x71\x8a\x9e\xd0\x8d\x6a\x72"
+			  "\x5b\x73\xb7\x3b\x32\xfc\xfc\xe0"
+			  "\x81\xab\xeb\x55\xb2\x4a\xa9\x20"
+			  "\x98\xbe\x52\xa7\x00\x71\xc0\xc2"
+			  "\x5e\x69\x06\x58\x52\x1e\xba\xcc"
+			  "\xd9\x54\x1c\xe0\x0c\x58\x34\x8b"
+			  "\x79\x65\x4b\xf3\x46\xaf\x97\x83",
+		.ilen	= 144,
+		.result	= "\x88\x5b\x7c\xb6\x55\xc7\x4b\x92"
+			  "\xe6\xcd\x45\xc5\x78\xa6\x61\xa1"
+			  "\xa8\x3d\xf9\xf3\x39\xcd\xbd\xcb"
+			  "\xc6\xc6\xd6\x23\x41\xe5\x56\xea"
+			  "\xc5\xea\x30\xaa\x14\xcf\xdb\x54"
+			  "\xe4\x10\xa5\xac\x93\xbb\xa5\xb5"
+			  "\x75\x6f\xbe\xaf\x68\xe2\x09\xce"
+			  "\x5a\xfb\xaa\x90\xa7\xd7\xcf\xd6"
+			  "\xbe\x70\x47\x9b\x2f\xf1\x3c\x6c"
+			  "\xa5\x24\xa1\x4c\x04\xde\x67\x8f"
+			  "\x25\x0c\x8e\xc0\x63\x89\x79\x55"
+			  "\x4a\x8f\xbe\xe6\x6d\xdf\x47\x0a"
+			  "\xef\x8b\x2b\x3c\x89\x39\xbd\xdd"
+			  "\x88\xb4\x0c\x08\xd4\x2f\x81\x79"
+			  "\xa8\x08\x11\x2b\xf1\x93\x01\x91"
+			  "\x09\x5f\xe6\xfd\xb5\x4d\x14\x9b"
+			  "\x4b\xb8\x0c\xad\xfc\x07\xd6\xce"
+			  "\x99\x0f\x2e\x8e\xce\xdd\xb6\xe9",
+		.rlen	= 144,
 	},
 };
 
@@ -3105,6 +3189,54 @@ static struct cipher_testvec aes_cbc_enc_tv_template[] = {
 			  "\xb2\xeb\x05\xe2\xc3\x9b\xe9\xfc"
 			  "\xda\x6c\x19\x07\x8c\x6a\x9d\x1b",
 		.rlen	= 64,
+	}, {
+		.key	= "\x97\x65\x2a\xa5\x4e\x5f\xaa\x05"
+			  "\x22\xa8\x2f\x22\x50\x30\xed\x90"
+			  "\xa7\x5d\xb0\x9c\xa7\x83\xbd\x24"
+			  "\x13\xb3\xf9\xac\x19\x98\xd2\x46",
+		.klen	= 32,
+		.iv	= "\x44\x2d\xc0\x6b\x34\x87\x13\xf4"
+			  "\xa5\x77\x11\x95\xbd\xe5\x27\xcf",
+		.input	= "\x50\x6b\x25\x74\xc4\x95\xb6\x1f"
+			  "\xe0\x98\x38\x59\xcd\xd9\x52\x0a"
+			  "\xab\x51\x41\x77\x96\x14\x9b\x9f"
+			  "\x55\x40\x17\x46\x33\x9b\x55\x97"
+			  "\x3d\x77\x94\xd0\x5a\x49\xff\x0d"
+			  "\x87\xa3\xff\x1d\x7c\xc2\x61\x65"
+			  "\x3d\x40\x3c\x7e\x5f\x16\xb2\x07"
+			  "\xd2\xf9\xb1\x7a\x2b\xb8\xf4\xf1"
+			  "\xc9\x01\xe1\x2f\xe2\x60\xd0\xc4"
+			  "\xfc\x24\xff\x36\xaa\x85\xde\x3c"
+			  "\xbf\x1e\xe2\x3c\xb0\x7a\xbe\x5a"
+			  "\xd6\x5c\x12\xf0\x1d\xee\x7c\x32"
+			  "\x39\xcd\xc8\xb1\x2e\xd1\x25\xb3"
+			  "\xe0\xb4\x73\x88\x19\x76\x91\x5c"
+			  "\x46\x93\x11\xe0\xa0\x33\x43\x18"
+			  "\x37\xc3\x06\x0f\xa1\x26\xd3\x14"
+			  "\xb0\xa9\x36\x51\x59\xc6\xec\x68"
+			  "\x44\x9b\x8d\x58\x86\x3a\xd1\x80",
+		.ilen	= 144,
+		.result	= "\xf2\xd1\x4d\xf0\x14\x92\xb2\xb6"
+			  "\x05\x15\x08\xca\xb8\x68\xf9\xb6"
+			  "\xb9\x85\xc3\xcd\x09\x90\x98\x77"
+			  "\xcc\x44\x0b\x3e\x4d\x27\x89\x55"
+			  "\xec\x65\xd5\xaa\x12\x80\x3d\x6b"
+			  "\xcc\xb2\x65\xb4\x00\x75\x14\xed"
+			  "\xd1\x40\xbb\x72\xc0\xaf\x9b\xc5"
+			  "\x63\xdc\x6c\x81\x6e\x49\x19\x25"
+			  "\x4b\x23\x7b\xf2\xd8\x1c\xb1\x00"
+			  "\x1a\xc5\xe3\x55\xa5\x9c\x95\xa9"
+			  "\x6e\x03\xe0\x18\x0f\x33\xca\xf8"
+			  "\xde\xc2\xda\x56\x04\xf6\x51\x34"
+			  "\xc2\x59\x04\xdb\xc5\x0b\x0c\x91"
+			  "\xa4\x3f\xa1\x4e\xf6\x67\xbe\xae"
+			  "\xbd\xc9\xe5\xe8\x11\xd2\x9f\xf4"
+			  "\x85\x6e\xe1\x0a\x5f\x18\x4c\xb5"
+			  "\x52\x55\xf4\xb1\x19\x8c\xa4\xdd"
+			  "\x57\x3f\x49\xf5\x5d\x2f\x4b\xad",
+		.rlen	= 144,
+		.np	= 2,
+		.tap	= { 72, 72 },
 	},
 };
 
@@ -3187,6 +3319,54 @@ static struct cipher_testvec aes_cbc_dec_tv_template[] = {
 			  "\xf6\x9f\x24\x45\xdf\x4f\x9b\x17"
 			  "\xad\x2b\x41\x7b\xe6\x6c\x37\x10",
 		.rlen	= 64,
+	}, {
+		.key	= "\x97\x65\x2a\xa5\x4e\x5f\xaa\x05"
+			  "\x22\xa8\x2f\x22\x50\x30\xed\x90"
+			  "\xa7\x5d\xb0\x9c\xa7\x83\xbd\x24"
+			  "\x13\xb3\xf9\xac\x19\x98\xd2\x46",
+		.klen	= 32,
+		.iv	= "\x44\x2d\xc0\x6b\x34\x87\x13\xf4"
+			  "\xa5\x77\x11\x95\xbd\xe5\x27\xcf",
+		.input	= "\xf2\xd1\x4d\xf0\x14\x92\xb2\xb6"
+			  "\x05\x15\x08\xca\xb8\x68\xf9\xb6"
+			  "\xb9\x85\xc3\xcd\x09\x90\x98\x77"
+			  "\xcc\x44\x0b\x3e\x4d\x27\x89\x55"
+			  "\xec\x65\xd5\xaa\x12\x80\x3d\x6b"
+			  "\xcc\xb2\x65\xb4\x00\x75\x14\xed"
+			  "\xd1\x40\xbb\x72\xc0\xaf\x9b\xc5"
+			  "\x63\xdc\x6c\x81\x6e\x49\x19\x25"
+			  "\x4b\x23\x7b\xf2\xd8\x1c\xb1\x00"
+			  "\x1a\xc5\xe3\x55\xa5\x9c\x95\xa9"
+			  "\x6e\x03\xe0\x18\x0f\x33\xca\xf8"
+			  "\xde\xc2\xda\x56\x04\xf6\x51\x34"
+			  "\xc2\x59\x04\xdb\xc5\x0b\x0c\x91"
+			  "\xa4\x3f\xa1\x4e\xf6\x67\xbe\xae"
+			  "\xbd\xc9\xe5\xe8\x11\xd2\x9f\xf4"
+			  "\x85\x6e\xe1\x0a\x5f\x18\x4c\xb5"
+			  "\x52\x55\xf4\xb1\x19\x8c\xa4\xdd"
+			  "\x57\x3f\x49\xf5\x5d\x2f\x4b\xad",
+		.ilen	= 144,
+		.result	= "\x50\x6b\x25\x74\xc4\x95\xb6\x1f"
+			  "\xe0\x98\x38\x59\xcd\xd9\x52\x0a"
+			  "\xab\x51\x41\x77\x96\x14\x9b\x9f"
+			  "\x55\x40\x17\x46\x33\x9b\x55\x97"
+			  "\x3d\x77\x94\xd0\x5a\x49\xff\x0d"
+			  "\x87\xa3\xff\x1d\x7c\xc2\x61\x65"
+			  "\x3d\x40\x3c\x7e\x5f\x16\xb2\x07"
+			  "\xd2\xf9\xb1\x7a\x2b\xb8\xf4\xf1"
+			  "\xc9\x01\xe1\x2f\xe2\x60\xd0\xc4"
+			  "\xfc\x24\xff\x36\xaa\x85\xde\x3c"
+			  "\xbf\x1e\xe2\x3c\xb0\x7a\xbe\x5a"
+			  "\xd6\x5c\x12\xf0\x1d\xee\x7c\x32"
+			  "\x39\xcd\xc8\xb1\x2e\xd1\x25\xb3"
+			  "\xe0\xb4\x73\x88\x19\x76\x91\x5c"
+			  "\x46\x93\x11\xe0\xa0\x33\x43\x18"
+			  "\x37\xc3\x06\x0f\xa1\x26\xd3\x14"
+			  "\xb0\xa9\x36\x51\x59\xc6\xec\x68"
+			  "\x44\x9b\x8d\x58\x86\x3a\xd1\x80",
+		.rlen	= 144,
+		.np	= 2,
+		.tap	= { 72, 72 },
 	},
 };
 
@@ -4162,6 +4342,53 @@ static struct cipher_testvec aes_ctr_enc_tv_template[] = {
 			  "\xdf\xc9\xc5\x8d\xb6\x7a\xad\xa6"
 			  "\x13\xc2\xdd\x08\x45\x79\x41\xa6",
 		.rlen	= 64,
+	}, {
+		.key	= "\x2b\xb2\xb1\x4d\x16\xdb\x0b\x5b"
+			  "\xd8\xcf\x16\xc4\x56\xa9\x9a\x01"
+			  "\x17\xc5\xb4\x1c\x70\xae\xa8\xc6",
+		.klen	= 24,
+		.iv	= "\x6d\x1a\x78\xff\xbe\x93\x06\xf7"
+			  "\xff\xff\xff\xff\xff\xff\xff\xfb",
+		.input	= "\x48\x2f\xd8\x16\x0e\x25\x81\x18"
+			  "\x77\x60\x49\x32\x73\xd7\xad\x13"
+			  "\x50\x5d\xb6\xc0\x57\x03\xfb\xfd"
+			  "\x7e\x15\x63\x41\x30\x6e\x88\x9a"
+			  "\xd9\xa2\x6d\x45\xa2\xa9\x9e\xd6"
+			  "\x62\x7f\xed\xd7\xa8\x1f\x85\xd0"
+			  "\x7d\xa9\x9d\xbf\x4b\x72\x3a\x29"
+			  "\x58\xa5\x5c\x61\x67\x15\x6c\x3f"
+			  "\xad\x0a\x4d\xbe\xbd\x09\x0a\x23"
+			  "\x80\x67\x28\x42\x36\x41\xbc\x32"
+			  "\xba\xd3\xae\xe0\x48\x07\x01\x03"
+			  "\x8d\x18\xeb\x3a\x00\x43\x6e\x69"
+			  "\xb5\x29\xca\x0b\xe9\x8d\xde\x3e"
+			  "\x4e\x39\x8c\x0a\x8d\x11\x4b\x27"
+			  "\xb1\x10\xd7\x2f\x1a\xb2\x98\x43"
+			  "\xaa\x19\x52\xc9\xf1\x27\x2d\x94"
+			  "\x8d\x86\xf2\xbb\x31\x44\xb3\xb7"
+			  "\xb2\x2e\xed\xe4\x86\x37\x47\xb0"
+			  "\x3c\x7e\x44",
+		.ilen	= 147,
+		.result	= "\xcb\x74\xb6\xdb\x87\x3f\x9f\x6a"
+			  "\x15\x29\xd5\x06\x6d\x2e\x5b\xf7"
+			  "\x15\x8e\x3d\x8f\x76\x34\x30\x49"
+			  "\x46\x13\xe1\x78\x1f\x12\x42\xdf"
+			  "\x45\x2b\x6c\xb0\xfb\xc1\x44\x93"
+			  "\x9b\x25\xc0\x26\x59\x3b\x41\x5d"
+			  "\xda\xde\xce\x58\xb9\x69\x06\x57"
+			  "\x01\x99\x68\xd2\xbe\x03\x31\x0f"
+			  "\x3d\xb2\x5f\x6f\x70\x49\xc0\x14"
+			  "\x91\x42\xaf\xf7\x4a\x0d\xbd\xe7"
+			  "\xa0\x85\xe9\x81\xb0\x55\xcb\x17"
+			  "\xbc\xb6\x7f\xff\x82\x36\x75\xf5"
+			  "\x3a\xce\x64\x56\x09\x9b\xe0\xbd"
+			  "\x10\x9d\xf2\x99\x07\x0d\xe1\x75"
+			  "\xe0\xe7\xf3\x7b\x5b\x73\x50\x84"
+			  "\xe5\x0e\xed\x70\x0e\xfa\xa9\x72"
+			  "\x9b\x57\x93\x12\x35\xf3\xde\xf8"
+			  "\xb2\xb1\xb4\x98\x78\x89\x2a\x2a"
+			  "\x06\x74\xa0",
+		.rlen	= 147,
 	}
 };
 
@@ -4241,6 +4468,53 @@ static struct cipher_testvec aes_ctr_dec_tv_template[] = {
 			  "\xf6\x9f\x24\x45\xdf\x4f\x9b\x17"
 			  "\xad\x2b\x41\x7b\xe6\x6c\x37\x10",
 		.rlen	= 64,
+	}, {
+		.key	= "\x2b\xb2\xb1\x4d\x16\xdb\x0b\x5b"
+			  "\xd8\xcf\x16\xc4\x56\xa9\x9a\x01"
+			  "\x17\xc5\xb4\x1c\x70\xae\xa8\xc6",
+		.klen	= 24,
+		.iv	= "\x6d\x1a\x78\xff\xbe\x93\x06\xf7"
+			  "\xff\xff\xff\xff\xff\xff\xff\xfb",
+		.input	= "\xcb\x74\xb6\xdb\x87\x3f\x9f\x6a"
+			  "\x15\x29\xd5\x06\x6d\x2e\x5b\xf7"
+			  "\x15\x8e\x3d\x8f\x76\x34\x30\x49"
+			  "\x46\x13\xe1\x78\x1f\x12\x42\xdf"
+			  "\x45\x2b\x6c\xb0\xfb\xc1\x44\x93"
+			  "\x9b\x25\xc0\x26\x59\x3b\x41\x5d"
+			  "\xda\xde\xce\x58\xb9\x69\x06\x57"
+			  "\x01\x99\x68\xd2\xbe\x03\x31\x0f"
+			  "\x3d\xb2\x5f\x6f\x70\x49\xc0\x14"
+			  "\x91\x42\xaf\xf7\x4a\x0d\xbd\xe7"
+			  "\xa0\x85\xe9\x81\xb0\x55\xcb\x17"
+			  "\xbc\xb6\x7f\xff\x82\x36\x75\xf5"
+			  "\x3a\xce\x64\x56\x09\x9b\xe0\xbd"
+			  "\x10\x9d\xf2\x99\x07\x0d\xe1\x75"
+			  "\xe0\xe7\xf3\x7b\x5b\x73\x50\x84"
+			  "\xe5\x0e\xed\x70\x0e\xfa\xa9\x72"
+			  "\x9b\x57\x93\x12\x35\xf3\xde\xf8"
+			  "\xb2\xb1\xb4\x98\x78\x89\x2a\x2a"
+			  "\x06\x74\xa0",
+		.ilen	= 147,
+		.result	= "\x48\x2f\xd8\x16\x0e\x25\x81\x18"
+			  "\x77\x60\x49\x32\x73\xd7\xad\x13"
+			  "\x50\x5d\xb6\xc0\x57\x03\xfb\xfd"
+			  "\x7e\x15\x63\x41\x30\x6e\x88\x9a"
+			  "\xd9\xa2\x6d\x45\xa2\xa9\x9e\xd6"
+			  "\x62\x7f\xed\xd7\xa8\x1f\x85\xd0"
+			  "\x7d\xa9\x9d\xbf\x4b\x72\x3a\x29"
+			  "\x58\xa5\x5c\x61\x67\x15\x6c\x3f"
+			  "\xad\x0a\x4d\xbe\xbd\x09\x0a\x23"
+			  "\x80\x67\x28\x42\x36\x41\xbc\x32"
+			  "\xba\xd3\xae\xe0\x48\x07\x01\x03"
+			  "\x8d\x18\xeb\x3a\x00\x43\x6e\x69"
+			  "\xb5\x29\xca\x0b\xe9\x8d\xde\x3e"
+			  "\x4e\x39\x8c\x0a\x8d\x11\x4b\x27"
+			  "\xb1\x10\xd7\x2f\x1a\xb2\x98\x43"
+			  "\xaa\x19\x52\xc9\xf1\x27\x2d\x94"
+			  "\x8d\x86\xf2\xbb\x31\x44\xb3\xb7"
+			  "\xb2\x2e\xed\xe4\x86\x37\x47\xb0"
+			  "\x3c\x7e\x44",
+		.rlen	= 147,
 	}
 };
 
@@ -18,6 +18,9 @@
 #include <linux/radix-tree.h>
 #include <linux/buffer_head.h> /* invalidate_bh_lrus() */
 #include <linux/slab.h>
+#include <linux/lzo.h>
+#include <linux/mutex.h>
+#include <linux/vmalloc.h>
 
 #include <asm/uaccess.h>
 
@@ -49,8 +52,34 @@ struct brd_device {
 	 */
 	spinlock_t		brd_lock;
 	struct radix_tree_root	brd_pages;
+
+	/*
+	 * Bytes of backing store in use, and the cap on it (0: no cap).
+	 * Protected by brd_lock, or by brd_zmutex for compressed devices.
+	 */
+	size_t			brd_mem_used;
+	size_t			brd_mem_limit;
+#ifdef CONFIG_BLK_DEV_RAM_COMPRESS
+	int			brd_compress;
+#endif
 };
 
+#ifdef CONFIG_BLK_DEV_RAM_COMPRESS
+/*
+ * A compressed brd stores a brd_zpage per non-zero page in brd_pages
+ * instead of a struct page. Pages that are entirely zero are not stored
+ * at all and read back as zeroes, just like never written ones. Pages
+ * that do not compress to fit in a page with the header are kept whole
+ * in a page of their own, so that no allocation is above order 0.
+ */
+struct brd_zpage {
+	pgoff_t		index;
+	unsigned int	len;	/* PAGE_SIZE if stored uncompressed */
+	struct page	*raw;	/* the page stored uncompressed, or NULL */
+	unsigned char	data[0];
+};
+#endif
+
 /*
  * Look up and return a brd's page for a given sector.
  */
@@ -83,7 +112,8 @@ static struct page *brd_lookup_page(struct brd_device *brd, sector_t sector)
 /*
  * Look up and return a brd's page for a given sector.
  * If one does not exist, allocate an empty page, and insert that. Then
- * return it.
+ * return it. Returns ERR_PTR(-ENOSPC) if the cap on the device's memory
+ * is reached, or ERR_PTR(-ENOMEM) if the page cannot be allocated.
  */
 static struct page *brd_insert_page(struct brd_device *brd, sector_t sector)
 {
@@ -108,13 +138,17 @@ static struct page *brd_insert_page(struct brd_device *brd, sector_t sector)
 #ifndef CONFIG_BLK_DEV_XIP
 	gfp_flags |= __GFP_HIGHMEM;
 #endif
+	if (brd->brd_mem_limit &&
+	    brd->brd_mem_used + PAGE_SIZE > brd->brd_mem_limit)
+		return ERR_PTR(-ENOSPC);
+
 	page = alloc_page(gfp_flags);
 	if (!page)
-		return NULL;
+		return ERR_PTR(-ENOMEM);
 
 	if (radix_tree_preload(GFP_NOIO)) {
 		__free_page(page);
-		return NULL;
+		return ERR_PTR(-ENOMEM);
 	}
 
 	spin_lock(&brd->brd_lock);
@@ -124,8 +158,10 @@ static struct page *brd_insert_page(struct brd_device *brd, sector_t sector)
 		page = radix_tree_lookup(&brd->brd_pages, idx);
 		BUG_ON(!page);
 		BUG_ON(page->index != idx);
-	} else
+	} else {
 		page->index = idx;
+		brd->brd_mem_used += PAGE_SIZE;
+	}
 	spin_unlock(&brd->brd_lock);
 
 	radix_tree_preload_end();
@@ -141,6 +177,8 @@ static void brd_free_page(struct brd_device *brd, sector_t sector)
 	spin_lock(&brd->brd_lock);
 	idx = sector >> PAGE_SECTORS_SHIFT;
 	page = radix_tree_delete(&brd->brd_pages, idx);
+	if (page)
+		brd->brd_mem_used -= PAGE_SIZE;
 	spin_unlock(&brd->brd_lock);
 	if (page)
 		__free_page(page);
@@ -155,17 +193,295 @@ static void brd_zero_page(struct brd_device *brd, sector_t sector)
 		clear_highpage(page);
 }
 
+#define FREE_BATCH 16
+
+#ifdef CONFIG_BLK_DEV_RAM_COMPRESS
+/*
+ * All compressed devices share one set of buffers, serialized by
+ * brd_zmutex, which also protects their brd_pages and brd_mem_used.
+ */
+static DEFINE_MUTEX(brd_zmutex);
+static void *brd_zbuf;		/* uncompressed contents of one page */
+static void *brd_zcbuf;		/* compressor output */
+static void *brd_zwrkmem;	/* compressor work memory */
+
+static int rd_compress = 1;
+
+static int brd_zinit(void)
+{
+	if (!rd_compress)
+		return 0;
+
+	brd_zbuf = kmalloc(PAGE_SIZE, GFP_KERNEL);
+	brd_zcbuf = kmalloc(lzo1x_worst_compress(PAGE_SIZE), GFP_KERNEL);
+	brd_zwrkmem = vmalloc(LZO1X_MEM_COMPRESS);
+	if (!brd_zbuf || !brd_zcbuf || !brd_zwrkmem)
+		return -ENOMEM;
+	return 0;
+}
+
+static void brd_zexit(void)
+{
+	kfree(brd_zbuf);
+	kfree(brd_zcbuf);
+	vfree(brd_zwrkmem);
+}
+
+/* The memory a stored page takes, as the allocators hand it out */
+static inline size_t brd_zpage_size(struct brd_zpage *zpage)
+{
+	return ksize(zpage) + (zpage->raw ? PAGE_SIZE : 0);
+}
+
+static void brd_zpage_release(struct brd_zpage *zpage)
+{
+	if (zpage->raw)
+		__free_page(zpage->raw);
+	kfree(zpage);
+}
+
+static int brd_zpage_is_zero(const void *buf)
+{
+	const unsigned long *p = buf;
+	int i;
+
+	for (i = 0; i < PAGE_SIZE / sizeof(*p); i++)
+		if (p[i])
+			return 0;
+	return 1;
+}
+
+/*
+ * Read the page at idx into brd_zbuf. Called with brd_zmutex held.
+ */
+static int brd_zpage_read(struct brd_device *brd, pgoff_t idx)
+{
+	struct brd_zpage *zpage;
+	size_t len = PAGE_SIZE;
+	int ret;
+
+	zpage = radix_tree_lookup(&brd->brd_pages, idx);
+	if (!zpage) {
+		memset(brd_zbuf, 0, PAGE_SIZE);
+		return 0;
+	}
+
+	if (zpage->raw) {
+		void *mem = kmap_atomic(zpage->raw, KM_USER1);
+
+		memcpy(brd_zbuf, mem, PAGE_SIZE);
+		kunmap_atomic(mem, KM_USER1);
+		return 0;
+	}
+
+	ret = lzo1x_decompress_safe(zpage->data, zpage->len, brd_zbuf, &len);
+	if (ret != LZO_E_OK || len != PAGE_SIZE) {
+		printk(KERN_ERR "brd: ram%d: corrupt page %lu (%d)\n",
+		       brd->brd_number, idx, ret);
+		return -EIO;
+	}
+	return 0;
+}
+
+static void brd_zpage_free(struct brd_device *brd, pgoff_t idx)
+{
+	struct brd_zpage *zpage;
+
+	zpage = radix_tree_delete(&brd->brd_pages, idx);
+	if (zpage) {
+		brd->brd_mem_used -= brd_zpage_size(zpage);
+		brd_zpage_release(zpage);
+	}
+}
+
+/*
+ * Store brd_zbuf as the page at idx. Called with brd_zmutex held.
+ */
+static int brd_zpage_write(struct brd_device *brd, pgoff_t idx)
+{
+	struct brd_zpage *zpage, *old;
+	size_t len, old_size = 0;
+	int raw;
+
+	if (brd_zpage_is_zero(brd_zbuf)) {
+		brd_zpage_free(brd, idx);
+		return 0;
+	}
+
+	raw = lzo1x_1_compress(brd_zbuf, PAGE_SIZE, brd_zcbuf, &len,
+			       brd_zwrkmem) != LZO_E_OK ||
+	      sizeof(*zpage) + len > PAGE_SIZE;
+
+	/*
+	 * Must use NOIO because we don't want to recurse back into the
+	 * block or filesystem layers from page reclaim.
+	 */
+	zpage = kmalloc(sizeof(*zpage) + (raw ? 0 : len), GFP_NOIO);
+	if (!zpage)
+		return -ENOMEM;
+	zpage->index = idx;
+	if (raw) {
+		void *mem;
+
+		zpage->raw = alloc_page(GFP_NOIO | __GFP_HIGHMEM);
+		if (!zpage->raw) {
+			kfree(zpage);
+			return -ENOMEM;
+		}
+		zpage->len = PAGE_SIZE;
+		mem = kmap_atomic(zpage->raw, KM_USER1);
+		memcpy(mem, brd_zbuf, PAGE_SIZE);
+		kunmap_atomic(mem, KM_USER1);
+	} else {
+		zpage->raw = NULL;
+		zpage->len = len;
+		memcpy(zpage->data, brd_zcbuf, len);
+	}
+
+	old = radix_tree_lookup(&brd->brd_pages, idx);
+	if (old)
+		old_size = brd_zpage_size(old);
+	if (brd->brd_mem_limit && brd->brd_mem_used - old_size +
+	    brd_zpage_size(zpage) > brd->brd_mem_limit) {
+		brd_zpage_release(zpage);
+		return -ENOSPC;
+	}
+
+	if (radix_tree_preload(GFP_NOIO)) {
+		brd_zpage_release(zpage);
+		return -ENOMEM;
+	}
+	brd_zpage_free(brd, idx);
+	radix_tree_insert(&brd->brd_pages, idx, zpage);
+	radix_tree_preload_end();
+
+	brd->brd_mem_used += brd_zpage_size(zpage);
+	return 0;
+}
+
+static void brd_zfree_pages(struct brd_device *brd)
+{
+	unsigned long pos = 0;
+	struct brd_zpage *zpages[FREE_BATCH];
+	int nr_pages;
+
+	mutex_lock(&brd_zmutex);
+	do {
+		int i;
+
+		nr_pages = radix_tree_gang_lookup(&brd->brd_pages,
+				(void **)zpages, pos, FREE_BATCH);
+
+		for (i = 0; i < nr_pages; i++) {
+			pos = zpages[i]->index;
+			brd_zpage_free(brd, pos);
+		}
+
+		pos++;
+	} while (nr_pages == FREE_BATCH);
+	mutex_unlock(&brd_zmutex);
+}
+
+static void brd_zdiscard(struct brd_device *brd, sector_t sector, size_t n)
+{
+	/*
+	 * Unlike uncompressed pages, compressed ones are reallocated on
+	 * every write anyway, so give the memory back right away.
+	 */
+	mutex_lock(&brd_zmutex);
+	while (n >= PAGE_SIZE) {
+		brd_zpage_free(brd, sector >> PAGE_SECTORS_SHIFT);
+		sector += PAGE_SIZE >> SECTOR_SHIFT;
+		n -= PAGE_SIZE;
+	}
+	mutex_unlock(&brd_zmutex);
+}
+
+/*
+ * Process a single bvec of a bio on a compressed brd. Partial page writes
+ * decompress the old contents first.
+ */
+static int brd_zdo_bvec(struct brd_device *brd, struct page *page,
+			unsigned int len, unsigned int off, int rw,
+			sector_t sector)
+{
+	int err = 0;
+
+	mutex_lock(&brd_zmutex);
+	while (len) {
+		pgoff_t idx = sector >> PAGE_SECTORS_SHIFT;
+		unsigned int offset = (sector & (PAGE_SECTORS-1)) << SECTOR_SHIFT;
+		unsigned int copy = min_t(unsigned int, len, PAGE_SIZE - offset);
+		void *mem;
+
+		if (rw == READ || copy < PAGE_SIZE) {
+			err = brd_zpage_read(brd, idx);
+			if (err)
+				break;
+		}
+
+		mem = kmap_atomic(page, KM_USER0);
+		if (rw == READ) {
+			memcpy(mem + off, brd_zbuf + offset, copy);
+			flush_dcache_page(page);
+		} else {
+			flush_dcache_page(page);
+			memcpy(brd_zbuf + offset, mem + off, copy);
+		}
+		kunmap_atomic(mem, KM_USER0);
+
+		if (rw != READ) {
+			err = brd_zpage_write(brd, idx);
+			if (err)
+				break;
+		}
+
+		len -= copy;
+		off += copy;
+		sector += copy >> SECTOR_SHIFT;
+	}
+	mutex_unlock(&brd_zmutex);
+
+	return err;
+}
+
+static inline int brd_compressed(struct brd_device *brd)
+{
+	return brd->brd_compress;
+}
+#else
+static inline int brd_zinit(void) { return 0; }
+static inline void brd_zexit(void) { }
+static inline void brd_zfree_pages(struct brd_device *brd) { }
+static inline void brd_zdiscard(struct brd_device *brd, sector_t sector,
+				size_t n) { }
+static inline int brd_zdo_bvec(struct brd_device *brd, struct page *page,
+			unsigned int len, unsigned int off, int rw,
+			sector_t sector)
+{
+	return -EIO;
+}
+static inline int brd_compressed(struct brd_device *brd)
+{
+	return 0;
+}
+#endif
+
 /*
  * Free all backing store pages and radix tree. This must only be called when
  * there are no other users of the device.
  */
-#define FREE_BATCH 16
 static void brd_free_pages(struct brd_device *brd)
 {
 	unsigned long pos = 0;
 	struct page *pages[FREE_BATCH];
 	int nr_pages;
 
+	if (brd_compressed(brd)) {
+		brd_zfree_pages(brd);
+		return;
+	}
+
 	do {
 		int i;
 
@@ -190,6 +506,8 @@ static void brd_free_pages(struct brd_device *brd)
 		 * so will this have to.
 		 */
 	} while (nr_pages == FREE_BATCH);
+
+	brd->brd_mem_used = 0;
 }
 
 /*
@@ -198,15 +516,18 @@ static void brd_free_pages(struct brd_device *brd)
 static int copy_to_brd_setup(struct brd_device *brd, sector_t sector, size_t n)
 {
 	unsigned int offset = (sector & (PAGE_SECTORS-1)) << SECTOR_SHIFT;
+	struct page *page;
 	size_t copy;
 
 	copy = min_t(size_t, n, PAGE_SIZE - offset);
-	if (!brd_insert_page(brd, sector))
-		return -ENOMEM;
+	page = brd_insert_page(brd, sector);
+	if (IS_ERR(page))
+		return PTR_ERR(page);
 	if (copy < n) {
 		sector += copy >> SECTOR_SHIFT;
-		if (!brd_insert_page(brd, sector))
-			return -ENOMEM;
+		page = brd_insert_page(brd, sector);
+		if (IS_ERR(page))
+			return PTR_ERR(page);
 	}
 	return 0;
 }
@@ -342,7 +663,10 @@ static int brd_make_request(struct request_queue *q, struct bio *bio)
 
 	if (unlikely(bio_rw_flagged(bio, BIO_RW_DISCARD))) {
 		err = 0;
-		discard_from_brd(brd, sector, bio->bi_size);
+		if (brd_compressed(brd))
+			brd_zdiscard(brd, sector, bio->bi_size);
+		else
+			discard_from_brd(brd, sector, bio->bi_size);
 		goto out;
 	}
 
@@ -352,7 +676,11 @@ static int brd_make_request(struct request_queue *q, struct bio *bio)
 
 	bio_for_each_segment(bvec, bio, i) {
 		unsigned int len = bvec->bv_len;
-		err = brd_do_bvec(brd, bvec->bv_page, len,
+		if (brd_compressed(brd))
+			err = brd_zdo_bvec(brd, bvec->bv_page, len,
+					bvec->bv_offset, rw, sector);
+		else
+			err = brd_do_bvec(brd, bvec->bv_page, len,
 					bvec->bv_offset, rw, sector);
 		if (err)
 			break;
@@ -379,8 +707,8 @@ static int brd_direct_access(struct block_device *bdev, sector_t sector,
 	if (sector + PAGE_SECTORS > get_capacity(bdev->bd_disk))
 		return -ERANGE;
 	page = brd_insert_page(brd, sector);
-	if (!page)
-		return -ENOMEM;
+	if (IS_ERR(page))
+		return PTR_ERR(page);
 	*kaddr = page_address(page);
 	*pfn = page_to_pfn(page);
 
@@ -434,12 +762,19 @@ static const struct block_device_operations brd_fops = {
  */
 static int rd_nr;
 int rd_size = CONFIG_BLK_DEV_RAM_SIZE;
+static int rd_mem_limit;
 static int max_part;
 static int part_shift;
 module_param(rd_nr, int, 0);
 MODULE_PARM_DESC(rd_nr, "Maximum number of brd devices");
 module_param(rd_size, int, 0);
 MODULE_PARM_DESC(rd_size, "Size of each RAM disk in kbytes.");
+module_param(rd_mem_limit, int, 0);
+MODULE_PARM_DESC(rd_mem_limit, "Max memory used by each RAM disk in kbytes, 0 for no limit.");
+#ifdef CONFIG_BLK_DEV_RAM_COMPRESS
+module_param(rd_compress, bool, 0);
+MODULE_PARM_DESC(rd_compress, "Store RAM disk pages LZO compressed.");
+#endif
 module_param(max_part, int, 0);
 MODULE_PARM_DESC(max_part, "Maximum number of partitions per RAM disk");
 MODULE_LICENSE("GPL");
@@ -472,6 +807,10 @@ static struct brd_device *brd_alloc(int i)
 	if (!brd)
 		goto out;
 	brd->brd_number		= i;
+	brd->brd_mem_limit	= (size_t)rd_mem_limit << 10;
+#ifdef CONFIG_BLK_DEV_RAM_COMPRESS
+	brd->brd_compress	= rd_compress;
+#endif
 	spin_lock_init(&brd->brd_lock);
 	INIT_RADIX_TREE(&brd->brd_pages, GFP_ATOMIC);
 
@@ -593,8 +932,15 @@ static int __init brd_init(void)
 		range = 1UL << (MINORBITS - part_shift);
 	}
 
-	if (register_blkdev(RAMDISK_MAJOR, "ramdisk"))
+	if (brd_zinit()) {
+		brd_zexit();
+		return -ENOMEM;
+	}
+
+	if (register_blkdev(RAMDISK_MAJOR, "ramdisk")) {
+		brd_zexit();
 		return -EIO;
+	}
 
 	for (i = 0; i < nr; i++) {
 		brd = brd_alloc(i);
@@ -620,6 +966,7 @@ out_free:
 		brd_free(brd);
 	}
 	unregister_blkdev(RAMDISK_MAJOR, "ramdisk");
+	brd_zexit();
 
 	return -ENOMEM;
 }
@@ -636,6 +983,7 @@ static void __exit brd_exit(void)
 
 	blk_unregister_region(MKDEV(RAMDISK_MAJOR, 0), range);
 	unregister_blkdev(RAMDISK_MAJOR, "ramdisk");
+	brd_zexit();
 }
 
 module_init(brd_init);
@@ -363,6 +363,21 @@ void cpufreq_notify_transition(struct cpufreq_freqs *freqs, unsigned int state)
 }
 EXPORT_SYMBOL_GPL(cpufreq_notify_transition);
 
+/**
+ * cpufreq_notify_transition_cost - report what a transition cost
+ *
+ * Called by drivers that time their transitions, after the
+ * CPUFREQ_POSTCHANGE notification and whatever follows it, such as
+ * lowering the voltage.
+ */
+void cpufreq_notify_transition_cost(struct cpufreq_transition_cost *cost)
+{
+	cost->freqs.flags = cpufreq_driver->flags;
+	srcu_notifier_call_chain(&cpufreq_transition_notifier_list,
+			CPUFREQ_TRANSITION_COST, cost);
+}
+EXPORT_SYMBOL_GPL(cpufreq_notify_transition_cost);
+
 
 
 /*********************************************************************
@@ -0,0 +1,683 @@
+/*
+ *  drivers/cpufreq/cpufreq_interactive.c
+ *
+ *  Copyright (c) 2010 by Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * The "interactive" governor is built for latency sensitive, touch driven
+ * use.  Rather than sampling load on a fixed period like ondemand, it
+ * starts a short sample when the CPU leaves idle, so a CPU that stays busy
+ * is taken to hispeed_freq within a scheduler tick.  Input events raise
+ * the speed to hispeed_freq straight away, before the work they cause has
+ * even been scheduled.  Speed is lowered only once it has been held for
+ * min_sample_time, so short idle gaps between frames do not make it
+ * oscillate.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/cpufreq.h>
+#include <linux/cpu.h>
+#include <linux/cpumask.h>
+#include <linux/input.h>
+#include <linux/jiffies.h>
+#include <linux/kernel_stat.h>
+#include <linux/kthread.h>
+#include <linux/notifier.h>
+#include <linux/rwsem.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/tick.h>
+#include <linux/timer.h>
+#include <asm/idle.h>
+
+/* Go to hispeed_freq when load reaches this percentage */
+#define DEFAULT_GO_HISPEED_LOAD		85
+
+/* Hold a speed this long, in uS, before lowering it */
+#define DEFAULT_MIN_SAMPLE_TIME		(80 * USEC_PER_MSEC)
+
+/* Load sampling period, in uS, while the CPU is busy */
+#define DEFAULT_TIMER_RATE		(20 * USEC_PER_MSEC)
+
+/* Keep at least hispeed_freq this long, in uS, after an input event */
+#define DEFAULT_INPUT_BOOST_TIME	(200 * USEC_PER_MSEC)
+
+/* Shortest sample, in uS, the load is computed over */
+#define MIN_SAMPLE_DURATION		1000
+
+#define TRANSITION_LATENCY_LIMIT	(10 * 1000 * 1000)
+
+static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
+					unsigned int event);
+
+#ifndef CONFIG_CPU_FREQ_DEFAULT_GOV_INTERACTIVE
+static
+#endif
+struct cpufreq_governor cpufreq_gov_interactive = {
+	.name			= "interactive",
+	.governor		= cpufreq_governor_interactive,
+	.max_transition_latency	= TRANSITION_LATENCY_LIMIT,
+	.owner			= THIS_MODULE,
+};
+
+struct cpufreq_interactive_cpuinfo {
+	struct timer_list cpu_timer;
+	/* idle time and wall time at the start of the current sample */
+	u64 time_in_idle;
+	u64 sample_start;
+	/* when target_freq was last changed, in uS of ktime */
+	u64 target_set_time;
+	struct cpufreq_policy *policy;
+	struct cpufreq_frequency_table *freq_table;
+	unsigned int target_freq;
+	/*
+	 * enable_sem keeps the speed change thread off the policy while
+	 * the governor is being stopped.
+	 */
+	struct rw_semaphore enable_sem;
+	int governor_enabled;
+};
+static DEFINE_PER_CPU(struct cpufreq_interactive_cpuinfo, cpuinfo);
+
+/* CPUs whose target_freq changed, for the speed change thread */
+static struct task_struct *speedchange_task;
+static cpumask_t speedchange_cpumask;
+static DEFINE_SPINLOCK(speedchange_cpumask_lock);
+
+/* number of CPUs using this governor, protected by gov_mutex */
+static unsigned int gov_enable;
+static DEFINE_MUTEX(gov_mutex);
+
+/* ktime in uS until which input keeps the speed at hispeed_freq or above */
+static u64 boost_until;
+
+static struct interactive_tuners {
+	unsigned int hispeed_freq;
+	unsigned int go_hispeed_load;
+	unsigned int min_sample_time;
+	unsigned int timer_rate;
+	unsigned int input_boost_time;
+} tuners = {
+	.go_hispeed_load = DEFAULT_GO_HISPEED_LOAD,
+	.min_sample_time = DEFAULT_MIN_SAMPLE_TIME,
+	.timer_rate = DEFAULT_TIMER_RATE,
+	.input_boost_time = DEFAULT_INPUT_BOOST_TIME,
+};
+
+static inline u64 now_us(void)
+{
+	return ktime_to_us(ktime_get());
+}
+
+static u64 get_cpu_idle_time_jiffy(unsigned int cpu, u64 *wall)
+{
+	cputime64_t cur_wall_time;
+	cputime64_t busy_time;
+
+	cur_wall_time = jiffies64_to_cputime64(get_jiffies_64());
+	busy_time = cputime64_add(kstat_cpu(cpu).cpustat.user,
+			kstat_cpu(cpu).cpustat.system);
+	busy_time = cputime64_add(busy_time, kstat_cpu(cpu).cpustat.irq);
+	busy_time = cputime64_add(busy_time, kstat_cpu(cpu).cpustat.softirq);
+	busy_time = cputime64_add(busy_time, kstat_cpu(cpu).cpustat.steal);
+	busy_time = cputime64_add(busy_time, kstat_cpu(cpu).cpustat.nice);
+
+	*wall = jiffies_to_usecs(cur_wall_time);
+	return jiffies_to_usecs(cputime64_sub(cur_wall_time, busy_time));
+}
+
+static u64 get_cpu_idle_time(unsigned int cpu, u64 *wall)
+{
+	u64 idle_time = get_cpu_idle_time_us(cpu, wall);
+
+	if (idle_time == -1ULL)
+		return get_cpu_idle_time_jiffy(cpu, wall);
+
+	return idle_time;
+}
+
+/* Start a new load sample on @cpu, ending @delay jiffies from now. */
+static void cpufreq_interactive_timer_start(int cpu, unsigned long delay)
+{
+	struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, cpu);
+
+	pcpu->time_in_idle = get_cpu_idle_time(cpu, &pcpu->sample_start);
+	mod_timer_pinned(&pcpu->cpu_timer, jiffies + delay);
+}
+
+/* hispeed_freq within the limits of @policy */
+static inline unsigned int policy_hispeed(struct cpufreq_policy *policy)
+{
+	return min(tuners.hispeed_freq, policy->max);
+}
+
+static void cpufreq_interactive_set_target(int cpu, unsigned int freq, u64 now)
+{
+	struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, cpu);
+	unsigned long flags;
+
+	pcpu->target_freq = freq;
+	pcpu->target_set_time = now;
+
+	spin_lock_irqsave(&speedchange_cpumask_lock, flags);
+	cpumask_set_cpu(cpu, &speedchange_cpumask);
+	spin_unlock_irqrestore(&speedchange_cpumask_lock, flags);
+	wake_up_process(speedchange_task);
+}
+
+static void cpufreq_interactive_timer(unsigned long data)
+{
+	struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, data);
+	struct cpufreq_policy *policy = pcpu->policy;
+	u64 now_idle, wall, delta_idle, delta_time, now;
+	unsigned int load, new_freq, index;
+
+	/* GOV_START leaves a cpu without a table to its current speed */
+	if (!pcpu->governor_enabled || !pcpu->freq_table)
+		return;
+
+	now_idle = get_cpu_idle_time(data, &wall);
+	delta_idle = now_idle - pcpu->time_in_idle;
+	delta_time = wall - pcpu->sample_start;
+
+	/* too short to tell anything, e.g. the timer fired right after idle */
+	if (delta_time < MIN_SAMPLE_DURATION)
+		goto rearm;
+
+	if (delta_idle > delta_time)
+		load = 0;
+	else
+		load = div64_u64(100 * (delta_time - delta_idle), delta_time);
+
+	if (load >= tuners.go_hispeed_load) {
+		if (pcpu->target_freq < policy_hispeed(policy))
+			new_freq = policy_hispeed(policy);
+		else
+			new_freq = policy->max * load / 100;
+	} else {
+		new_freq = policy->max * load / 100;
+	}
+
+	now = now_us();
+	if (now < boost_until)
+		new_freq = max(new_freq, policy_hispeed(policy));
+
+	if (cpufreq_frequency_table_target(policy, pcpu->freq_table, new_freq,
+					   CPUFREQ_RELATION_L, &index))
+		goto rearm;
+	new_freq = pcpu->freq_table[index].frequency;
+
+	/* only lower the speed once it has been held for min_sample_time */
+	if (new_freq < pcpu->target_freq &&
+	    now - pcpu->target_set_time < tuners.min_sample_time)
+		goto rearm;
+
+	if (new_freq != pcpu->target_freq)
+		cpufreq_interactive_set_target(data, new_freq, now);
+
+rearm:
+	/*
+	 * An idle CPU at the lowest speed needs no sampling: leaving idle
+	 * starts the next sample.
+	 */
+	if (idle_cpu(data) && pcpu->target_freq <= policy->min)
+		return;
+
+	cpufreq_interactive_timer_start(data,
+				usecs_to_jiffies(tuners.timer_rate));
+}
+
+static int cpufreq_interactive_idle_notifier(struct notifier_block *nb,
+					     unsigned long val, void *data)
+{
+	int cpu = smp_processor_id();
+	struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, cpu);
+
+	/* no sampling on a cpu without a table, as at GOV_START */
+	if (!pcpu->governor_enabled || !pcpu->freq_table)
+		return NOTIFY_OK;
+
+	switch (val) {
+	case IDLE_START:
+		/*
+		 * Keep sampling through idle while above the lowest speed,
+		 * or the speed reached for the last burst stays up.
+		 */
+		if (!timer_pending(&pcpu->cpu_timer) &&
+		    pcpu->target_freq > pcpu->policy->min)
+			cpufreq_interactive_timer_start(cpu,
+					usecs_to_jiffies(tuners.timer_rate));
+		break;
+
+	case IDLE_END:
+		/*
+		 * Below hispeed_freq, judge the load over the next tick so a
+		 * burst of work is caught at once.  The sample started at
+		 * idle entry would be mostly idle time and is dropped.
+		 */
+		if (pcpu->target_freq < policy_hispeed(pcpu->policy))
+			cpufreq_interactive_timer_start(cpu, 1);
+		else if (!timer_pending(&pcpu->cpu_timer))
+			cpufreq_interactive_timer_start(cpu,
+					usecs_to_jiffies(tuners.timer_rate));
+		break;
+	}
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block cpufreq_interactive_idle_nb = {
+	.notifier_call = cpufreq_interactive_idle_notifier,
+};
+
+static int cpufreq_interactive_speedchange_task(void *data)
+{
+	cpumask_t tmp_mask;
+	unsigned int cpu, j, max_freq;
+	unsigned long flags;
+
+	while (1) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		spin_lock_irqsave(&speedchange_cpumask_lock, flags);
+
+		if (cpumask_empty(&speedchange_cpumask)) {
+			spin_unlock_irqrestore(&speedchange_cpumask_lock,
+					       flags);
+			schedule();
+
+			if (kthread_should_stop())
+				break;
+
+			spin_lock_irqsave(&speedchange_cpumask_lock, flags);
+		}
+
+		set_current_state(TASK_RUNNING);
+		cpumask_copy(&tmp_mask, &speedchange_cpumask);
+		cpumask_clear(&speedchange_cpumask);
+		spin_unlock_irqrestore(&speedchange_cpumask_lock, flags);
+
+		for_each_cpu(cpu, &tmp_mask) {
+			struct cpufreq_interactive_cpuinfo *pcpu =
+				&per_cpu(cpuinfo, cpu);
+
+			down_read(&pcpu->enable_sem);
+			if (!pcpu->governor_enabled) {
+				up_read(&pcpu->enable_sem);
+				continue;
+			}
+
+			/* CPUs sharing a policy run at the fastest one's speed */
+			max_freq = 0;
+			for_each_cpu(j, pcpu->policy->cpus) {
+				struct cpufreq_interactive_cpuinfo *pjcpu =
+					&per_cpu(cpuinfo, j);
+
+				max_freq = max(max_freq, pjcpu->target_freq);
+			}
+
+			if (max_freq != pcpu->policy->cur)
+				__cpufreq_driver_target(pcpu->policy, max_freq,
+							CPUFREQ_RELATION_H);
+			up_read(&pcpu->enable_sem);
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Input boost: an input event raises every CPU below hispeed_freq to it
+ * and keeps it there for input_boost_time.  Called with the input device's
+ * event lock held and interrupts off.
+ */
+static void cpufreq_interactive_input_event(struct input_handle *handle,
+					    unsigned int type,
+					    unsigned int code, int value)
+{
+	unsigned int boost_time = tuners.input_boost_time;
+	u64 now;
+	int cpu;
+
+	if (!boost_time || type == EV_SYN)
+		return;
+
+	now = now_us();
+	boost_until = now + boost_time;
+
+	for_each_online_cpu(cpu) {
+		struct cpufreq_interactive_cpuinfo *pcpu =
+			&per_cpu(cpuinfo, cpu);
+
+		if (pcpu->governor_enabled &&
+		    pcpu->target_freq < policy_hispeed(pcpu->policy))
+			cpufreq_interactive_set_target(cpu,
+					policy_hispeed(pcpu->policy), now);
+	}
+}
+
+static int cpufreq_interactive_input_connect(struct input_handler *handler,
+					     struct input_dev *dev,
+					     const struct input_device_id *id)
+{
+	struct input_handle *handle;
+	int error;
+
+	handle = kzalloc(sizeof(struct input_handle), GFP_KERNEL);
+	if (!handle)
+		return -ENOMEM;
+
+	handle->dev = dev;
+	handle->handler = handler;
+	handle->name = "cpufreq_interactive";
+
+	error = input_register_handle(handle);
+	if (error)
+		goto err_free;
+
+	error = input_open_device(handle);
+	if (error)
+		goto err_unregister;
+
+	return 0;
+
+err_unregister:
+	input_unregister_handle(handle);
+err_free:
+	kfree(handle);
+	return error;
+}
+
+static void cpufreq_interactive_input_disconnect(struct input_handle *handle)
+{
+	input_close_device(handle);
+	input_unregister_handle(handle);
+	kfree(handle);
+}
+
+static const struct input_device_id cpufreq_interactive_ids[] = {
+	/* multi-touch touchscreens */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT |
+			 INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.evbit = { BIT_MASK(EV_ABS) },
+		.absbit = { [BIT_WORD(ABS_MT_POSITION_X)] =
+			    BIT_MASK(ABS_MT_POSITION_X) |
+			    BIT_MASK(ABS_MT_POSITION_Y) },
+	},
+	/* touchscreens and touchpads */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_KEYBIT |
+			 INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.keybit = { [BIT_WORD(BTN_TOUCH)] = BIT_MASK(BTN_TOUCH) },
+		.absbit = { [BIT_WORD(ABS_X)] =
+			    BIT_MASK(ABS_X) | BIT_MASK(ABS_Y) },
+	},
+	/* keypads and touch keys */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT,
+		.evbit = { BIT_MASK(EV_KEY) },
+	},
+	{ },
+};
+
+static struct input_handler cpufreq_interactive_input_handler = {
+	.event		= cpufreq_interactive_input_event,
+	.connect	= cpufreq_interactive_input_connect,
+	.disconnect	= cpufreq_interactive_input_disconnect,
+	.name		= "cpufreq_interactive",
+	.id_table	= cpufreq_interactive_ids,
+};
+
+/************************** sysfs interface ************************/
+
+#define show_one(file_name, object)					\
+static ssize_t show_##file_name						\
+(struct kobject *kobj, struct attribute *attr, char *buf)		\
+{									\
+	return sprintf(buf, "%u\n", tuners.object);			\
+}
+show_one(hispeed_freq, hispeed_freq);
+show_one(go_hispeed_load, go_hispeed_load);
+show_one(min_sample_time, min_sample_time);
+show_one(timer_rate, timer_rate);
+show_one(input_boost_time, input_boost_time);
+
+static ssize_t store_hispeed_freq(struct kobject *a, struct attribute *b,
+				  const char *buf, size_t count)
+{
+	unsigned int input;
+
+	if (sscanf(buf, "%u", &input) != 1)
+		return -EINVAL;
+
+	tuners.hispeed_freq = input;
+	return count;
+}
+
+static ssize_t store_go_hispeed_load(struct kobject *a, struct attribute *b,
+				     const char *buf, size_t count)
+{
+	unsigned int input;
+
+	if (sscanf(buf, "%u", &input) != 1 || input > 100)
+		return -EINVAL;
+
+	tuners.go_hispeed_load = input;
+	return count;
+}
+
+static ssize_t store_min_sample_time(struct kobject *a, struct attribute *b,
+				     const char *buf, size_t count)
+{
+	unsigned int input;
+
+	if (sscanf(buf, "%u", &input) != 1)
+		return -EINVAL;
+
+	tuners.min_sample_time = input;
+	return count;
+}
+
+static ssize_t store_timer_rate(struct kobject *a, struct attribute *b,
+				const char *buf, size_t count)
+{
+	unsigned int input;
+
+	if (sscanf(buf, "%u", &input) != 1 || input < MIN_SAMPLE_DURATION)
+		return -EINVAL;
+
+	tuners.timer_rate = input;
+	return count;
+}
+
+static ssize_t store_input_boost_time(struct kobject *a, struct attribute *b,
+				      const char *buf, size_t count)
+{
+	unsigned int input;
+
+	if (sscanf(buf, "%u", &input) != 1)
+		return -EINVAL;
+
+	tuners.input_boost_time = input;
+	return count;
+}
+
+define_one_global_rw(hispeed_freq);
+define_one_global_rw(go_hispeed_load);
+define_one_global_rw(min_sample_time);
+define_one_global_rw(timer_rate);
+define_one_global_rw(input_boost_time);
+
+static struct attribute *interactive_attributes[] = {
+	&hispeed_freq.attr,
+	&go_hispeed_load.attr,
+	&min_sample_time.attr,
+	&timer_rate.attr,
+	&input_boost_time.attr,
+	NULL
+};
+
+static struct attribute_group interactive_attr_group = {
+	.attrs = interactive_attributes,
+	.name = "interactive",
+};
+
+/************************** sysfs end ************************/
+
+static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
+					unsigned int event)
+{
+	struct cpufreq_interactive_cpuinfo *pcpu;
+	unsigned int j;
+	int rc;
+
+	switch (event) {
+	case CPUFREQ_GOV_START:
+		if (!cpu_online(policy->cpu) || !policy->cur)
+			return -EINVAL;
+
+		mutex_lock(&gov_mutex);
+
+		if (!gov_enable) {
+			rc = sysfs_create_group(cpufreq_global_kobject,
+						&interactive_attr_group);
+			if (rc) {
+				mutex_unlock(&gov_mutex);
+				return rc;
+			}
+
+			rc = input_register_handler(
+					&cpufreq_interactive_input_handler);
+			if (rc)
+				printk(KERN_WARNING "cpufreq_interactive: "
+				       "no input boost (%d)\n", rc);
+
+			idle_notifier_register(&cpufreq_interactive_idle_nb);
+		}
+		gov_enable++;
+
+		if (!tuners.hispeed_freq)
+			tuners.hispeed_freq = policy->max;
+
+		for_each_cpu(j, policy->cpus) {
+			pcpu = &per_cpu(cpuinfo, j);
+			pcpu->policy = policy;
+			pcpu->freq_table = cpufreq_frequency_get_table(j);
+			pcpu->target_freq = policy->cur;
+			pcpu->target_set_time = now_us();
+			down_write(&pcpu->enable_sem);
+			pcpu->governor_enabled = 1;
+			up_write(&pcpu->enable_sem);
+			if (!pcpu->freq_table)
+				printk(KERN_WARNING "cpufreq_interactive: "
+				       "cpu%u has no frequency table\n", j);
+		}
+		mutex_unlock(&gov_mutex);
+
+		/* later samples are started from the CPUs themselves */
+		for_each_cpu(j, policy->cpus) {
+			pcpu = &per_cpu(cpuinfo, j);
+			if (!pcpu->freq_table)
+				continue;
+			pcpu->time_in_idle = get_cpu_idle_time(j,
+							&pcpu->sample_start);
+			pcpu->cpu_timer.expires = jiffies +
+				usecs_to_jiffies(tuners.timer_rate);
+			add_timer_on(&pcpu->cpu_timer, j);
+		}
+		break;
+
+	case CPUFREQ_GOV_STOP:
+		mutex_lock(&gov_mutex);
+		for_each_cpu(j, policy->cpus) {
+			pcpu = &per_cpu(cpuinfo, j);
+			down_write(&pcpu->enable_sem);
+			pcpu->governor_enabled = 0;
+			del_timer_sync(&pcpu->cpu_timer);
+			up_write(&pcpu->enable_sem);
+		}
+
+		if (!--gov_enable) {
+			idle_notifier_unregister(&cpufreq_interactive_idle_nb);
+			input_unregister_handler(
+					&cpufreq_interactive_input_handler);
+			sysfs_remove_group(cpufreq_global_kobject,
+					   &interactive_attr_group);
+		}
+		mutex_unlock(&gov_mutex);
+		break;
+
+	case CPUFREQ_GOV_LIMITS:
+		if (policy->max < policy->cur)
+			__cpufreq_driver_target(policy, policy->max,
+						CPUFREQ_RELATION_H);
+		else if (policy->min > policy->cur)
+			__cpufreq_driver_target(policy, policy->min,
+						CPUFREQ_RELATION_L);
+
+		for_each_cpu(j, policy->cpus) {
+			pcpu = &per_cpu(cpuinfo, j);
+			pcpu->target_freq = clamp(pcpu->target_freq,
+						  policy->min, policy->max);
+		}
+		break;
+	}
+	return 0;
+}
+
+static int __init cpufreq_interactive_init(void)
+{
+	struct sched_param param = { .sched_priority = MAX_RT_PRIO - 1 };
+	unsigned int i;
+	int err;
+
+	for_each_possible_cpu(i) {
+		struct cpufreq_interactive_cpuinfo *pcpu =
+			&per_cpu(cpuinfo, i);
+
+		init_timer(&pcpu->cpu_timer);
+		pcpu->cpu_timer.function = cpufreq_interactive_timer;
+		pcpu->cpu_timer.data = i;
+		init_rwsem(&pcpu->enable_sem);
+	}
+
+	speedchange_task = kthread_create(cpufreq_interactive_speedchange_task,
+					  NULL, "kinteractive");
+	if (IS_ERR(speedchange_task))
+		return PTR_ERR(speedchange_task);
+
+	/* speed changes are what interactive tasks are waiting for */
+	sched_setscheduler_nocheck(speedchange_task, SCHED_FIFO, &param);
+	get_task_struct(speedchange_task);
+	wake_up_process(speedchange_task);
+
+	err = cpufreq_register_governor(&cpufreq_gov_interactive);
+	if (err) {
+		kthread_stop(speedchange_task);
+		put_task_struct(speedchange_task);
+	}
+	return err;
+}
+
+static void __exit cpufreq_interactive_exit(void)
+{
+	cpufreq_unregister_governor(&cpufreq_gov_interactive);
+	kthread_stop(speedchange_task);
+	put_task_struct(speedchange_task);
+}
+
+MODULE_DESCRIPTION("'cpufreq_interactive' - A cpufreq governor for "
+	"latency sensitive workloads");
+MODULE_LICENSE("GPL");
+
+#ifdef CONFIG_CPU_FREQ_DEFAULT_GOV_INTERACTIVE
+fs_initcall(cpufreq_interactive_init);
+#else
+module_init(cpufreq_interactive_init);
+#endif
+module_exit(cpufreq_interactive_exit);
@@ -30,6 +30,16 @@ static struct freq_attr _attr_##_name = {\
 	.show = _show,\
 };
 
+#ifdef CONFIG_CPU_FREQ_STAT_DETAILS
+/* cost of the transitions from one frequency to another, if reported */
+struct cpufreq_trans_cost {
+	unsigned int count;
+	unsigned int max_ns;
+	u64 total_ns;
+	u64 phase_ns[CPUFREQ_COST_NR_PHASES];
+};
+#endif
+
 struct cpufreq_stats {
 	unsigned int cpu;
 	unsigned int total_trans;
@@ -41,6 +51,7 @@ struct cpufreq_stats {
 	unsigned int *freq_table;
 #ifdef CONFIG_CPU_FREQ_STAT_DETAILS
 	unsigned int *trans_table;
+	struct cpufreq_trans_cost *trans_cost;
 #endif
 };
 
@@ -138,6 +149,121 @@ static ssize_t show_trans_table(struct cpufreq_policy *policy, char *buf)
 	return len;
 }
 CPUFREQ_STATDEVICE_ATTR(trans_table, 0444, show_trans_table);
+
+/* average latency, in uS, of the transitions from one frequency to another */
+static ssize_t show_trans_latency(struct cpufreq_policy *policy, char *buf)
+{
+	ssize_t len = 0;
+	int i, j;
+
+	struct cpufreq_stats *stat = per_cpu(cpufreq_stats_table, policy->cpu);
+	if (!stat)
+		return 0;
+	len += snprintf(buf + len, PAGE_SIZE - len, "   From  :    To\n");
+	len += snprintf(buf + len, PAGE_SIZE - len, "         : ");
+	for (i = 0; i < stat->state_num; i++) {
+		if (len >= PAGE_SIZE)
+			break;
+		len += snprintf(buf + len, PAGE_SIZE - len, "%9u ",
+				stat->freq_table[i]);
+	}
+	if (len >= PAGE_SIZE)
+		return PAGE_SIZE;
+
+	len += snprintf(buf + len, PAGE_SIZE - len, "\n");
+
+	spin_lock(&cpufreq_stats_lock);
+	for (i = 0; i < stat->state_num; i++) {
+		if (len >= PAGE_SIZE)
+			break;
+
+		len += snprintf(buf + len, PAGE_SIZE - len, "%9u: ",
+				stat->freq_table[i]);
+
+		for (j = 0; j < stat->state_num; j++)   {
+			struct cpufreq_trans_cost *cost =
+				&stat->trans_cost[i * stat->max_state + j];
+			u64 avg = 0;
+
+			if (len >= PAGE_SIZE)
+				break;
+			if (cost->count)
+				avg = div_u64(div_u64(cost->total_ns,
+						      cost->count),
+					      NSEC_PER_USEC);
+			len += snprintf(buf + len, PAGE_SIZE - len, "%9llu ",
+					(unsigned long long)avg);
+		}
+		if (len >= PAGE_SIZE)
+			break;
+		len += snprintf(buf + len, PAGE_SIZE - len, "\n");
+	}
+	spin_unlock(&cpufreq_stats_lock);
+	if (len >= PAGE_SIZE)
+		return PAGE_SIZE;
+	return len;
+}
+
+static const char *cost_phase_names[CPUFREQ_COST_NR_PHASES] = {
+	[CPUFREQ_COST_VOLTAGE]		= "voltage",
+	[CPUFREQ_COST_PLL_LOCK]		= "pll_lock",
+	[CPUFREQ_COST_CLOCK]		= "clock",
+	[CPUFREQ_COST_MEMORY]		= "memory",
+};
+
+/*
+ * One line per pair of frequencies a transition was reported for: count,
+ * then average and maximum latency and the average of each phase, in nS.
+ */
+static ssize_t show_trans_cost(struct cpufreq_policy *policy, char *buf)
+{
+	ssize_t len = 0;
+	int i, j, p;
+
+	struct cpufreq_stats *stat = per_cpu(cpufreq_stats_table, policy->cpu);
+	if (!stat)
+		return 0;
+	len += snprintf(buf + len, PAGE_SIZE - len, "%9s %9s %8s %9s %9s",
+			"from", "to", "count", "avg", "max");
+	for (p = 0; p < CPUFREQ_COST_NR_PHASES; p++)
+		len += snprintf(buf + len, PAGE_SIZE - len, " %9s",
+				cost_phase_names[p]);
+	len += snprintf(buf + len, PAGE_SIZE - len, "\n");
+
+	spin_lock(&cpufreq_stats_lock);
+	for (i = 0; i < stat->state_num; i++) {
+		for (j = 0; j < stat->state_num; j++) {
+			struct cpufreq_trans_cost *cost =
+				&stat->trans_cost[i * stat->max_state + j];
+
+			if (!cost->count)
+				continue;
+			if (len >= PAGE_SIZE)
+				break;
+			len += snprintf(buf + len, PAGE_SIZE - len,
+					"%9u %9u %8u %9llu %9u",
+					stat->freq_table[i],
+					stat->freq_table[j], cost->count,
+					(unsigned long long)div_u64(
+						cost->total_ns, cost->count),
+					cost->max_ns);
+			for (p = 0; p < CPUFREQ_COST_NR_PHASES; p++)
+				len += snprintf(buf + len, PAGE_SIZE - len,
+					" %9llu",
+					(unsigned long long)div_u64(
+						cost->phase_ns[p],
+						cost->count));
+			len += snprintf(buf + len, PAGE_SIZE - len, "\n");
+		}
+	}
+	spin_unlock(&cpufreq_stats_lock);
+	if (len >= PAGE_SIZE)
+		return PAGE_SIZE;
+	return len;
+}
+
+CPUFREQ_STATDEVICE_ATTR(trans_latency, 0444, show_trans_latency);
+CPUFREQ_STATDEVICE_ATTR(trans_cost, 0444, show_trans_cost);
 #endif
 
 CPUFREQ_STATDEVICE_ATTR(total_trans, 0444, show_total_trans);
@@ -148,6 +274,8 @@ static struct attribute *default_attrs[] = {
 	&_attr_time_in_state.attr,
 #ifdef CONFIG_CPU_FREQ_STAT_DETAILS
 	&_attr_trans_table.attr,
+	&_attr_trans_latency.attr,
+	&_attr_trans_cost.attr,
 #endif
 	NULL
 };
@@ -173,6 +301,9 @@ static void cpufreq_stats_free_table(unsigned int cpu)
 		sysfs_remove_group(&policy->kobj, &stats_attr_group);
 	if (stat) {
 		kfree(stat->time_in_state);
+#ifdef CONFIG_CPU_FREQ_STAT_DETAILS
+		kfree(stat->trans_cost);
+#endif
 		kfree(stat);
 	}
 	per_cpu(cpufreq_stats_table, cpu) = NULL;
@@ -229,6 +360,14 @@ static int cpufreq_stats_create_table(struct cpufreq_policy *policy,
 
 #ifdef CONFIG_CPU_FREQ_STAT_DETAILS
 	stat->trans_table = stat->freq_table + count;
+	stat->trans_cost = kzalloc(count * count *
+				   sizeof(struct cpufreq_trans_cost),
+				   GFP_KERNEL);
+	if (!stat->trans_cost) {
+		kfree(stat->time_in_state);
+		ret = -ENOMEM;
+		goto error_out;
+	}
 #endif
 	j = 0;
 	for (i = 0; table[i].frequency != CPUFREQ_TABLE_END; i++) {
@@ -271,6 +410,35 @@ static int cpufreq_stat_notifier_policy(struct notifier_block *nb,
 	return 0;
 }
 
+#ifdef CONFIG_CPU_FREQ_STAT_DETAILS
+static int cpufreq_stat_trans_cost(struct cpufreq_transition_cost *tc)
+{
+	struct cpufreq_stats *stat;
+	struct cpufreq_trans_cost *cost;
+	int old_index, new_index, p;
+
+	stat = per_cpu(cpufreq_stats_table, tc->freqs.cpu);
+	if (!stat)
+		return 0;
+
+	old_index = freq_table_get_index(stat, tc->freqs.old);
+	new_index = freq_table_get_index(stat, tc->freqs.new);
+	if (old_index == -1 || new_index == -1)
+		return 0;
+
+	spin_lock(&cpufreq_stats_lock);
+	cost = &stat->trans_cost[old_index * stat->max_state + new_index];
+	cost->count++;
+	cost->total_ns += tc->latency_ns;
+	if (tc->latency_ns > cost->max_ns)
+		cost->max_ns = tc->latency_ns;
+	for (p = 0; p < CPUFREQ_COST_NR_PHASES; p++)
+		cost->phase_ns[p] += tc->phase_ns[p];
+	spin_unlock(&cpufreq_stats_lock);
+	return 0;
+}
+#endif
+
 static int cpufreq_stat_notifier_trans(struct notifier_block *nb,
 		unsigned long val, void *data)
 {
@@ -278,6 +446,11 @@ static int cpufreq_stat_notifier_trans(struct notifier_block *nb,
 	struct cpufreq_stats *stat;
 	int old_index, new_index;
 
+#ifdef CONFIG_CPU_FREQ_STAT_DETAILS
+	if (val == CPUFREQ_TRANSITION_COST)
+		return cpufreq_stat_trans_cost(data);
+#endif
+
 	if (val != CPUFREQ_POSTCHANGE)
 		return 0;
 
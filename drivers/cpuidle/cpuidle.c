@@ -17,6 +17,8 @@
 #include <linux/cpuidle.h>
 #include <linux/ktime.h>
 #include <linux/hrtimer.h>
+#include <linux/tick.h>
+#include <linux/clockchips.h>
 #include <trace/events/power.h>
 
 #include "cpuidle.h"
@@ -42,6 +44,53 @@ static void cpuidle_kick_cpus(void) {}
 
 static int __cpuidle_register_device(struct cpuidle_device *dev);
 
+#ifdef CONFIG_CPU_IDLE_STAT_DETAILS
+/* time from now to the expiry of the tick device, or -1 if none is set */
+static s64 cpuidle_timer_us(struct cpuidle_device *dev)
+{
+	struct clock_event_device *evt = tick_get_device(dev->cpu)->evtdev;
+
+	if (!evt || evt->next_event.tv64 == KTIME_MAX)
+		return -1;
+	return ktime_to_us(ktime_sub(evt->next_event, ktime_get()));
+}
+
+static inline int cpuidle_hist_bucket(s64 us)
+{
+	if (us <= 0)
+		return 0;
+	if (us >= 1LL << (CPUIDLE_HIST_BUCKETS - 2))
+		return CPUIDLE_HIST_BUCKETS - 1;
+	return fls((u32)us);
+}
+
+/*
+ * Account the residency of the idle period that just ended and, if the
+ * timer expired during it, how long after the expiry it ended.
+ */
+static void cpuidle_update_hist(struct cpuidle_device *dev,
+				struct cpuidle_state *state, s64 timer_us)
+{
+	state->residency_hist[cpuidle_hist_bucket(dev->last_residency)]++;
+
+	if (timer_us >= 0 && dev->last_residency >= timer_us &&
+	    (state->flags & CPUIDLE_FLAG_TIME_VALID))
+		state->wakeup_hist[cpuidle_hist_bucket(dev->last_residency -
+						       timer_us)]++;
+}
+#else
+static inline s64 cpuidle_timer_us(struct cpuidle_device *dev)
+{
+	return -1;
+}
+
+static inline void cpuidle_update_hist(struct cpuidle_device *dev,
+				       struct cpuidle_state *state,
+				       s64 timer_us)
+{
+}
+#endif
+
 /**
  * cpuidle_idle_call - the main idle loop
  *
@@ -52,6 +101,7 @@ static void cpuidle_idle_call(void)
 	struct cpuidle_device *dev = __get_cpu_var(cpuidle_devices);
 	struct cpuidle_state *target_state;
 	int next_state;
+	s64 timer_us;
 
 	/* check if the device is ready */
 	if (!dev || !dev->enabled) {
@@ -84,6 +134,7 @@ static void cpuidle_idle_call(void)
 	target_state = &dev->states[next_state];
 
 	/* enter the state and update stats */
+	timer_us = cpuidle_timer_us(dev);
 	dev->last_state = target_state;
 	dev->last_residency = target_state->enter(dev, target_state);
 	if (dev->last_state)
@@ -91,6 +142,7 @@ static void cpuidle_idle_call(void)
 
 	target_state->time += (unsigned long long)dev->last_residency;
 	target_state->usage++;
+	cpuidle_update_hist(dev, target_state, timer_us);
 
 	/* give the governor an opportunity to reflect on the outcome */
 	if (cpuidle_curr_governor->reflect)
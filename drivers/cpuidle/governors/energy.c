@@ -0,0 +1,232 @@
+/*
+ * energy.c - the energy-aware idle governor
+ *
+ * Copyright (C) 2010 Samsung Electronics
+ *
+ * This code is licenced under the GPL version 2 as described
+ * in the COPYING file that acompanies the Linux Kernel.
+ */
+
+#include <linux/kernel.h>
+#include <linux/cpuidle.h>
+#include <linux/pm_qos_params.h>
+#include <linux/ktime.h>
+#include <linux/hrtimer.h>
+#include <linux/tick.h>
+#include <linux/math64.h>
+
+#define INTERVALS 16
+#define NO_WAKEUP UINT_MAX
+
+/*
+ * Concepts behind the energy governor
+ *
+ * An idle period ends at the next timer event, which is known, or earlier
+ * at an interrupt, which is not.  The governor keeps the last 16 idle
+ * periods of each CPU as a history of "time to the first interrupt": the
+ * length of a period that ended well before its timer, or NO_WAKEUP for
+ * one that lasted until its timer.  Capping each of them at the time to
+ * the next timer event gives 16 equally likely guesses of how long this
+ * idle period will last.
+ *
+ * Entering a state and leaving it again costs energy, which the lower
+ * power of the state pays back after its target residency, the break-even
+ * point.  With the shallowest state as the reference, the energy of a
+ * period of length t in state i, which draws power P_i, is
+ *
+ *	E_i(t) = P_i * t + (P_0 - P_i) * T_i
+ *
+ * where T_i is the target residency.  E_i is linear in t, so its expected
+ * value over the guesses is E_i at their mean, and the governor picks the
+ * state with the lowest.  This is where it differs from menu, which
+ * compares target residencies to a single prediction scaled for the
+ * load: a CPU that is usually woken up early but sometimes sleeps long
+ * still goes deep if the long sleeps pay for the short ones.
+ *
+ * Drivers that do not give a power figure lower than the shallowest state
+ * for each deeper state get the deepest state whose target residency is
+ * at most the mean.  With two states that is the same choice whatever the
+ * power figures are.
+ *
+ * States with an exit latency above the PM QoS latency requirement are
+ * never picked.
+ */
+
+struct energy_device {
+	int		last_state_idx;
+	int		needs_update;
+	int		use_power;
+
+	unsigned int	expected_us;
+	unsigned int	predicted_us;
+	unsigned int	intervals[INTERVALS];
+	int		interval_ptr;
+};
+
+static DEFINE_PER_CPU(struct energy_device, energy_devices);
+
+static void energy_update(struct cpuidle_device *dev);
+
+/* mean of the wakeup history, each entry capped at the next timer event */
+static unsigned int energy_predict(struct energy_device *data)
+{
+	u64 sum = 0;
+	int i;
+
+	for (i = 0; i < INTERVALS; i++)
+		sum += min(data->intervals[i], data->expected_us);
+
+	return div_u64(sum, INTERVALS);
+}
+
+/**
+ * energy_select - selects the next idle state to enter
+ * @dev: the CPU
+ */
+static int energy_select(struct cpuidle_device *dev)
+{
+	struct energy_device *data = &__get_cpu_var(energy_devices);
+	int latency_req = pm_qos_request(PM_QOS_CPU_DMA_LATENCY);
+	struct cpuidle_state *ref = &dev->states[CPUIDLE_DRIVER_STATE_START];
+	u64 energy, best = 0;
+	s64 expected_us;
+	int i;
+
+	if (data->needs_update) {
+		energy_update(dev);
+		data->needs_update = 0;
+	}
+
+	data->last_state_idx = 0;
+
+	/* Special case when user has set very strict latency requirement */
+	if (unlikely(latency_req == 0))
+		return 0;
+
+	expected_us = ktime_to_us(tick_nohz_get_sleep_length());
+	data->expected_us = clamp_t(s64, expected_us, 0, NO_WAKEUP - 1);
+	data->predicted_us = energy_predict(data);
+
+	/* as menu, only busy poll if the timer is really really soon */
+	if (data->expected_us <= 5)
+		return 0;
+
+	data->last_state_idx = CPUIDLE_DRIVER_STATE_START;
+
+	for (i = CPUIDLE_DRIVER_STATE_START; i < dev->state_count; i++) {
+		struct cpuidle_state *s = &dev->states[i];
+
+		if (s->exit_latency > latency_req)
+			break;
+
+		if (!data->use_power) {
+			if (s->target_residency > data->predicted_us)
+				break;
+			data->last_state_idx = i;
+			continue;
+		}
+
+		energy = (u64)s->power_usage * data->predicted_us +
+			 (u64)(ref->power_usage - s->power_usage) *
+			 s->target_residency;
+		if (i == CPUIDLE_DRIVER_STATE_START || energy < best) {
+			best = energy;
+			data->last_state_idx = i;
+		}
+	}
+
+	return data->last_state_idx;
+}
+
+/**
+ * energy_reflect - records that data structures need update
+ * @dev: the CPU
+ *
+ * NOTE: it's important to be fast here because this operation will add to
+ *       the overall exit latency.
+ */
+static void energy_reflect(struct cpuidle_device *dev)
+{
+	struct energy_device *data = &__get_cpu_var(energy_devices);
+	data->needs_update = 1;
+}
+
+/**
+ * energy_update - adds the last idle period to the wakeup history
+ * @dev: the CPU
+ */
+static void energy_update(struct cpuidle_device *dev)
+{
+	struct energy_device *data = &__get_cpu_var(energy_devices);
+	struct cpuidle_state *target = dev->last_state;
+	unsigned int measured_us = cpuidle_get_last_residency(dev);
+
+	/* without a measurement, assume the timer ended the period */
+	if (unlikely(!target || !(target->flags & CPUIDLE_FLAG_TIME_VALID)))
+		measured_us = data->expected_us;
+
+	/*
+	 * A period that got to within an eighth of its timer event is taken
+	 * to have been ended by the timer, the rest by an interrupt.
+	 */
+	if (measured_us < data->expected_us - data->expected_us / 8)
+		data->intervals[data->interval_ptr] = measured_us;
+	else
+		data->intervals[data->interval_ptr] = NO_WAKEUP;
+
+	if (++data->interval_ptr >= INTERVALS)
+		data->interval_ptr = 0;
+}
+
+/**
+ * energy_enable_device - scans a CPU's states and does setup
+ * @dev: the CPU
+ */
+static int energy_enable_device(struct cpuidle_device *dev)
+{
+	struct energy_device *data = &per_cpu(energy_devices, dev->cpu);
+	int i;
+
+	memset(data, 0, sizeof(struct energy_device));
+
+	/* no history yet: predict from the timer alone */
+	for (i = 0; i < INTERVALS; i++)
+		data->intervals[i] = NO_WAKEUP;
+
+	data->use_power = 1;
+	for (i = CPUIDLE_DRIVER_STATE_START + 1; i < dev->state_count; i++)
+		if (dev->states[i].power_usage >=
+		    dev->states[CPUIDLE_DRIVER_STATE_START].power_usage)
+			data->use_power = 0;
+
+	return 0;
+}
+
+static struct cpuidle_governor energy_governor = {
+	.name =		"energy",
+	.rating =	30,
+	.enable =	energy_enable_device,
+	.select =	energy_select,
+	.reflect =	energy_reflect,
+	.owner =	THIS_MODULE,
+};
+
+/**
+ * init_energy - initializes the governor
+ */
+static int __init init_energy(void)
+{
+	return cpuidle_register_governor(&energy_governor);
+}
+
+/**
+ * exit_energy - exits the governor
+ */
+static void __exit exit_energy(void)
+{
+	cpuidle_unregister_governor(&energy_governor);
+}
+
+MODULE_LICENSE("GPL");
+module_init(init_energy);
+module_exit(exit_energy);
@@ -250,12 +250,41 @@ define_show_state_ull_function(time)
 define_show_state_str_function(name)
 define_show_state_str_function(desc)
 
+#ifdef CONFIG_CPU_IDLE_STAT_DETAILS
+/* one line per bucket: lower bound in uS, count */
+static ssize_t show_hist(unsigned long long *hist, char *buf)
+{
+	ssize_t len = 0;
+	int i;
+
+	for (i = 0; i < CPUIDLE_HIST_BUCKETS; i++)
+		len += sprintf(buf + len, "%u %llu\n",
+			       i ? 1U << (i - 1) : 0, hist[i]);
+	return len;
+}
+
+static ssize_t show_state_residency_hist(struct cpuidle_state *state,
+					 char *buf)
+{
+	return show_hist(state->residency_hist, buf);
+}
+
+static ssize_t show_state_wakeup_hist(struct cpuidle_state *state, char *buf)
+{
+	return show_hist(state->wakeup_hist, buf);
+}
+#endif
+
 define_one_state_ro(name, show_state_name);
 define_one_state_ro(desc, show_state_desc);
 define_one_state_ro(latency, show_state_exit_latency);
 define_one_state_ro(power, show_state_power_usage);
 define_one_state_ro(usage, show_state_usage);
 define_one_state_ro(time, show_state_time);
+#ifdef CONFIG_CPU_IDLE_STAT_DETAILS
+define_one_state_ro(residency_hist, show_state_residency_hist);
+define_one_state_ro(wakeup_hist, show_state_wakeup_hist);
+#endif
 
 static struct attribute *cpuidle_state_default_attrs[] = {
 	&attr_name.attr,
@@ -264,6 +293,10 @@ static struct attribute *cpuidle_state_default_attrs[] = {
 	&attr_power.attr,
 	&attr_usage.attr,
 	&attr_time.attr,
+#ifdef CONFIG_CPU_IDLE_STAT_DETAILS
+	&attr_residency_hist.attr,
+	&attr_wakeup_hist.attr,
+#endif
 	NULL
 };
 
@@ -0,0 +1,377 @@
+/**
+ * OneDRAM loopback: a software stand-in for the OneDRAM shared memory
+ *
+ * Copyright (C) 2010 Samsung Electronics. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+/*
+ * Exports the API of onedram.c over ordinary memory, with the modem side
+ * played by a tasklet: whatever the AP sends in an out ring comes back in
+ * the matching in ring, with the mailbox interrupt for it.  The AP always
+ * holds the semaphore.  Frames sent on a PDP channel thus come back on the
+ * same PDP device, which is enough to run the svnet rx and tx paths
+ * without a modem.
+ *
+ * With irq_per_frame the raw ring comes back a frame at a time, with a
+ * mailbox interrupt for each, as a modem under load raises them; that is
+ * what the svnet mailbox coalescing has to cope with.
+ */
+
+//#define DEBUG
+
+#include <linux/init.h>
+#include <linux/circ_buf.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/interrupt.h>
+#include <linux/ioport.h>
+#include <linux/spinlock.h>
+#include <linux/vmalloc.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include "onedram.h"
+#include "../svnet/sipc4.h"
+
+#define DRVNAME "onedram"
+
+struct onedram_handler {
+	struct list_head list;
+	void *data;
+	void (*handler)(u32, void *);
+};
+
+static LIST_HEAD(h_list);
+static DEFINE_SPINLOCK(h_lock);
+
+static struct resource onedram_resource = {
+	.name = DRVNAME,
+	.start = 0,
+	.end = SIPC_MAP_SIZE - 1,
+	.flags = IORESOURCE_MEM,
+};
+
+static const struct {
+	u32 out_off;
+	u32 in_off;
+	u32 size;
+	u16 mask_send;
+} loop_rings[IPCIDX_MAX] = {
+	[IPCIDX_FMT] = { FMT_OUT, FMT_IN, FMT_SZ, MBD_SEND_FMT },
+	[IPCIDX_RAW] = { RAW_OUT, RAW_IN, RAW_SZ, MBD_SEND_RAW },
+	[IPCIDX_RFS] = { RFS_OUT, RFS_IN, RFS_SZ, MBD_SEND_RFS },
+};
+
+static unsigned char *vbase;
+static DEFINE_SPINLOCK(mb_lock);
+static u32 mb_pending;	/* send bits the AP raised, for the tasklet */
+static u32 mb_recv;	/* mailbox for the AP, 0 when read */
+
+static unsigned long loop_bytes[IPCIDX_MAX];
+module_param_array_named(bytes, loop_bytes, ulong, NULL, 0444);
+static unsigned long loop_irqs;
+module_param_named(irqs, loop_irqs, ulong, 0444);
+
+static int irq_per_frame;
+module_param(irq_per_frame, bool, 0644);
+
+/* in pieces, split where either ring wraps */
+static void _ring_copy(unsigned char *dst, u32 dhead, u32 dsize,
+		const unsigned char *src, u32 stail, u32 ssize, u32 len)
+{
+	u32 n;
+
+	while (len) {
+		n = min(len, min(dsize - dhead, ssize - stail));
+		memcpy(dst + dhead, src + stail, n);
+		dhead = (dhead + n) % dsize;
+		stail = (stail + n) % ssize;
+		len -= n;
+	}
+}
+
+static void _raise(u32 mb)
+{
+	struct onedram_handler *h;
+	unsigned long flags;
+
+	pr_debug("%s: recv %x\n", DRVNAME, mb);
+
+	spin_lock_irqsave(&mb_lock, flags);
+	mb_recv = mb;
+	spin_unlock_irqrestore(&mb_lock, flags);
+
+	loop_irqs++;
+
+	spin_lock_irqsave(&h_lock, flags);
+	list_for_each_entry(h, &h_list, list)
+		h->handler(mb, h->data);
+	spin_unlock_irqrestore(&h_lock, flags);
+}
+
+/*
+ * Moves what the AP sent on a ring, the first @limit bytes of it or all
+ * of it, whole or not at all: the svnet reader takes frames up to
+ * in_head, so no partial frame may show up there.  What does not fit
+ * stays pending until the AP says send again.
+ */
+static u32 _loop_ring(int i, u32 limit)
+{
+	struct sipc_mapped *map = (struct sipc_mapped *)vbase;
+	struct ringbuf_cont *cont = &map->rbcont[i];
+	u32 size = loop_rings[i].size;
+	u32 out_head, out_tail, in_head, in_tail, len;
+
+	out_head = cont->out_head;
+	out_tail = cont->out_tail;
+	in_head = cont->in_head;
+	in_tail = cont->in_tail;
+	/* the ring data is read after its head */
+	smp_rmb();
+
+	if (out_head >= size || out_tail >= size || in_head >= size ||
+			in_tail >= size)
+		return 0;
+
+	len = CIRC_CNT(out_head, out_tail, size);
+	if (limit && limit < len)
+		len = limit;
+	if (!len || len > CIRC_SPACE(in_head, in_tail, size))
+		return 0;
+
+	_ring_copy(vbase + loop_rings[i].in_off, in_head, size,
+			vbase + loop_rings[i].out_off, out_tail, size, len);
+	/* the data before the heads that publish it */
+	smp_wmb();
+	cont->in_head = (in_head + len) % size;
+	cont->out_tail = (out_tail + len) % size;
+	loop_bytes[i] += len;
+
+	return loop_rings[i].mask_send;
+}
+
+/* the raw ring frame by frame, each with its interrupt */
+static void _loop_frames(int i)
+{
+	struct sipc_mapped *map = (struct sipc_mapped *)vbase;
+	struct ringbuf_cont *cont = &map->rbcont[i];
+	const unsigned char *out = vbase + loop_rings[i].out_off;
+	u32 size = loop_rings[i].size;
+	unsigned char buf[1 + sizeof(struct raw_hdr)];
+	struct raw_hdr *hdr = (struct raw_hdr *)&buf[1];
+	u32 tail, frame;
+
+	while (1) {
+		tail = cont->out_tail;
+		smp_rmb();
+		if (tail >= size ||
+				CIRC_CNT(cont->out_head, tail, size) < sizeof(buf))
+			return;
+
+		_ring_copy(buf, 0, sizeof(buf), out, tail, size, sizeof(buf));
+		/* HDLC start, the header with the length after it, HDLC end */
+		frame = 1 + hdr->len + 1;
+		if (buf[0] != HDLC_START ||
+				frame > CIRC_CNT(cont->out_head, tail, size)) {
+			/* not a frame we can tell: the lot in one go */
+			if (_loop_ring(i, 0))
+				_raise(MB_DATA(loop_rings[i].mask_send));
+			return;
+		}
+
+		if (!_loop_ring(i, frame))
+			return;
+		_raise(MB_DATA(loop_rings[i].mask_send));
+	}
+}
+
+static void _loop_tasklet(unsigned long data)
+{
+	unsigned long flags;
+	u32 pending, mb = 0;
+	int i;
+
+	spin_lock_irqsave(&mb_lock, flags);
+	pending = mb_pending;
+	mb_pending = 0;
+	spin_unlock_irqrestore(&mb_lock, flags);
+
+	for (i = 0; i < IPCIDX_MAX; i++) {
+		if (!(pending & loop_rings[i].mask_send))
+			continue;
+		if (i == IPCIDX_RAW && irq_per_frame)
+			_loop_frames(i);
+		else
+			mb |= _loop_ring(i, 0);
+	}
+
+	if (mb)
+		_raise(MB_DATA(mb));
+}
+static DECLARE_TASKLET(loop_tasklet, _loop_tasklet, 0);
+
+int onedram_read_mailbox(u32 *mb)
+{
+	unsigned long flags;
+	int r = -ENODATA;
+
+	spin_lock_irqsave(&mb_lock, flags);
+	if (mb_recv) {
+		*mb = mb_recv;
+		mb_recv = 0;
+		r = 0;
+	}
+	spin_unlock_irqrestore(&mb_lock, flags);
+
+	return r;
+}
+EXPORT_SYMBOL(onedram_read_mailbox);
+
+int onedram_write_mailbox(u32 mb)
+{
+	unsigned long flags;
+
+	/* commands have no modem to go to */
+	if ((mb & MB_VALID) == 0 || (mb & MB_COMMAND))
+		return 0;
+
+	spin_lock_irqsave(&mb_lock, flags);
+	mb_pending |= mb;
+	spin_unlock_irqrestore(&mb_lock, flags);
+
+	tasklet_schedule(&loop_tasklet);
+
+	return 0;
+}
+EXPORT_SYMBOL(onedram_write_mailbox);
+
+void onedram_init_mailbox(void)
+{
+}
+EXPORT_SYMBOL(onedram_init_mailbox);
+
+int onedram_get_auth(u32 cmd)
+{
+	return 0;
+}
+EXPORT_SYMBOL(onedram_get_auth);
+
+int onedram_put_auth(int release)
+{
+	return 0;
+}
+EXPORT_SYMBOL(onedram_put_auth);
+
+int onedram_rel_sem(void)
+{
+	return 0;
+}
+EXPORT_SYMBOL(onedram_rel_sem);
+
+int onedram_read_sem(void)
+{
+	return 1;
+}
+EXPORT_SYMBOL(onedram_read_sem);
+
+void onedram_get_vbase(void** base)
+{
+	*base = vbase;
+}
+EXPORT_SYMBOL(onedram_get_vbase);
+
+struct resource* onedram_request_region(resource_size_t start,
+		resource_size_t n, const char *name)
+{
+	start += onedram_resource.start;
+	return __request_region(&onedram_resource, start, n, name, 0);
+}
+EXPORT_SYMBOL(onedram_request_region);
+
+void onedram_release_region(resource_size_t start, resource_size_t n)
+{
+	start += onedram_resource.start;
+	__release_region(&onedram_resource, start, n);
+}
+EXPORT_SYMBOL(onedram_release_region);
+
+int onedram_register_handler(void (*handler)(u32, void *), void *data)
+{
+	unsigned long flags;
+	struct onedram_handler *hd;
+
+	if (!handler)
+		return -EINVAL;
+
+	hd = kzalloc(sizeof(struct onedram_handler), GFP_KERNEL);
+	if (!hd)
+		return -ENOMEM;
+
+	hd->data = data;
+	hd->handler = handler;
+
+	spin_lock_irqsave(&h_lock, flags);
+	list_add_tail(&hd->list, &h_list);
+	spin_unlock_irqrestore(&h_lock, flags);
+
+	return 0;
+}
+EXPORT_SYMBOL(onedram_register_handler);
+
+int onedram_unregister_handler(void (*handler)(u32, void *))
+{
+	unsigned long flags;
+	struct onedram_handler *hd, *tmp;
+
+	if (!handler)
+		return -EINVAL;
+
+	spin_lock_irqsave(&h_lock, flags);
+	list_for_each_entry_safe(hd, tmp, &h_list, list) {
+		if (hd->handler == handler) {
+			list_del(&hd->list);
+			kfree(hd);
+		}
+	}
+	spin_unlock_irqrestore(&h_lock, flags);
+
+	return 0;
+}
+EXPORT_SYMBOL(onedram_unregister_handler);
+
+static int __init onedram_init(void)
+{
+	vbase = vmalloc(SIPC_MAP_SIZE);
+	if (!vbase)
+		return -ENOMEM;
+	memset(vbase, 0, SIPC_MAP_SIZE);
+
+	pr_info("%s: loopback, %u bytes\n", DRVNAME, SIPC_MAP_SIZE);
+
+	return 0;
+}
+
+static void __exit onedram_exit(void)
+{
+	tasklet_kill(&loop_tasklet);
+	vfree(vbase);
+}
+
+module_init(onedram_init);
+module_exit(onedram_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Onedram loopback");
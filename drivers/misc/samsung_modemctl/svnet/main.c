@@ -29,6 +29,8 @@
 #include <linux/workqueue.h>
 #include <linux/list.h>
 #include <linux/jiffies.h>
+#include <linux/hrtimer.h>
+#include <linux/moduleparam.h>
 
 #include <linux/netdevice.h>
 #include <linux/skbuff.h>
@@ -73,9 +75,22 @@ struct svnet_stat {
 	unsigned long st_do_write;
 	unsigned long st_do_read;
 	unsigned long st_do_rx;
+	unsigned long st_merge_evt;
+	unsigned long st_coalesce;
+	unsigned long st_coalesce_full;
 };
 static struct svnet_stat stat;
 
+/*
+ * Mailbox interrupts for data are gathered for up to coalesce_us before
+ * the read work runs, or until coalesce_max of them came in, so that one
+ * hold of the OneDRAM authority serves a run of them.  0 reads at once.
+ */
+static unsigned int coalesce_us = 200;
+module_param(coalesce_us, uint, 0644);
+static unsigned int coalesce_max = 16;
+module_param(coalesce_max, uint, 0644);
+
 struct svnet_evt {
 	struct list_head list;
 	u32 event;
@@ -93,6 +108,8 @@ struct svnet {
 
 	struct workqueue_struct *wq;
 	struct work_struct work_read;
+	struct hrtimer coalesce;
+	unsigned int coalesce_cnt;
 	struct delayed_work work_write;
 	struct delayed_work work_rx;
 
@@ -179,6 +196,8 @@ static unsigned long long time_max_read;
 static unsigned long long time_max_write;
 
 extern unsigned long long time_max_semlat;
+extern unsigned long long time_sum_semlat;
+extern unsigned long cnt_semlat;
 
 static int _queue_evt(struct svnet_evt_head *h, u32 event);
 
@@ -237,6 +256,9 @@ static inline int _show_stat(char *buf)
 	p += sprintf(p, "\twrite count: %lu\n", stat.st_do_write);
 	p += sprintf(p, "\tread count: %lu\n", stat.st_do_read);
 	p += sprintf(p, "\trx count: %lu\n", stat.st_do_rx);
+	p += sprintf(p, "\tmerged mailbox: %lu\n", stat.st_merge_evt);
+	p += sprintf(p, "\tcoalesced read: %lu (%lu full)\n",
+			stat.st_coalesce, stat.st_coalesce_full);
 	p += sprintf(p, "\n");
 
 	return p - buf;
@@ -252,6 +274,8 @@ static ssize_t show_latency(struct device *d,
 	p += sprintf(p, "Max write latency: %12llu ns\n", time_max_xtow);
 	p += sprintf(p, "Max write time:    %12llu ns\n", time_max_write);
 	p += sprintf(p, "Max sem. latency:  %12llu ns\n", time_max_semlat);
+	p += sprintf(p, "Avg sem. latency:  %12llu ns\n",
+			cnt_semlat ? div_u64(time_sum_semlat, cnt_semlat) : 0);
 
 	return p - buf;
 }
@@ -347,6 +371,10 @@ int vnet_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 	if (!sn)
 		goto drop;
 
+	/* straight into the ring when OneDRAM is ours */
+	if (!sipc_xmit(sn->si, &sn->txq, skb))
+		return NETDEV_TX_OK;
+
 	if (!tmp_xtow)
 		tmp_xtow = cpu_clock(smp_processor_id());
 
@@ -403,6 +431,17 @@ static int _queue_evt(struct svnet_evt_head *h, u32 event)
 	unsigned long flags;
 	struct svnet_evt *e;
 
+	/* a read serves all the rings: fold into the event still waiting */
+	spin_lock_irqsave(&h->lock, flags);
+	if (!list_empty(&h->list)) {
+		e = list_entry(h->list.prev, struct svnet_evt, list);
+		e->event |= event;
+		spin_unlock_irqrestore(&h->lock, flags);
+		stat.st_merge_evt++;
+		return 0;
+	}
+	spin_unlock_irqrestore(&h->lock, flags);
+
 	e = kmalloc(sizeof(struct svnet_evt), GFP_ATOMIC);
 	if (!e)
 		return -ENOMEM;
@@ -477,6 +516,35 @@ static int _proc_private_event(struct svnet *sn, u32 evt)
 	return 1;
 }
 
+static enum hrtimer_restart _coalesce_expired(struct hrtimer *timer)
+{
+	struct svnet *sn = container_of(timer, struct svnet, coalesce);
+
+	sn->coalesce_cnt = 0;
+	stat.st_coalesce++;
+	queue_work(sn->wq, &sn->work_read);
+
+	return HRTIMER_NORESTART;
+}
+
+static void _schedule_read(struct svnet *sn, u32 evt)
+{
+	if (coalesce_us && !sipc_urgent(evt)) {
+		if (++sn->coalesce_cnt < coalesce_max) {
+			if (!hrtimer_active(&sn->coalesce))
+				hrtimer_start(&sn->coalesce,
+					ns_to_ktime(coalesce_us * NSEC_PER_USEC),
+					HRTIMER_MODE_REL);
+			return;
+		}
+		stat.st_coalesce_full++;
+	}
+
+	hrtimer_try_to_cancel(&sn->coalesce);
+	sn->coalesce_cnt = 0;
+	queue_work(sn->wq, &sn->work_read);
+}
+
 static void svnet_queue_event(u32 evt, void *data)
 {
 	struct net_device *ndev = (struct net_device *)data;
@@ -506,7 +574,7 @@ static void svnet_queue_event(u32 evt, void *data)
 	}
 
 	_wake_process_lock_timeout(sn);
-	queue_work(sn->wq, &sn->work_read);
+	_schedule_read(sn, evt);
 }
 
 static int svnet_open(struct net_device *ndev)
@@ -536,6 +604,7 @@ static int svnet_close(struct net_device *ndev)
 
 	dev_dbg(&ndev->dev, "%s\n", __func__);
 
+	hrtimer_cancel(&sn->coalesce);
 	if (sn->wq)
 		flush_workqueue(sn->wq);
 	skb_queue_purge(&sn->txq);
@@ -616,7 +685,8 @@ static void svnet_read_wq(struct work_struct *work)
 		dev_dbg(&sn->ndev->dev, "event %x\n", event);
 
 		if (sn->si) {
-			r = sipc_read(sn->si, event, &contd);
+			/* and what waits to be sent, under the same authority */
+			r = sipc_transfer(sn->si, event, &sn->txq, &contd);
 			if (r < 0) {
 				dev_err(&sn->ndev->dev, "ret %d -> queue %x\n",
 						r, event);
@@ -633,6 +703,10 @@ static void svnet_read_wq(struct work_struct *work)
 	if (contd > 0)
 		queue_delayed_work(sn->wq, &sn->work_rx, 0);
 
+	/* left over for lack of space: the write work retries */
+	if (!skb_queue_empty(&sn->txq))
+		queue_delayed_work(sn->wq, &sn->work_write, HZ/10);
+
 	switch (r) {
 	case -EINVAL:
 		dev_err(&sn->ndev->dev, "Invalid argument\n");
@@ -765,6 +839,8 @@ static void svnet_exit_wq(struct work_struct *work)
 static inline void _init_data(struct svnet *sn)
 {
 	INIT_WORK(&sn->work_read, svnet_read_wq);
+	hrtimer_init(&sn->coalesce, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	sn->coalesce.function = _coalesce_expired;
 	INIT_DELAYED_WORK(&sn->work_write, svnet_write_wq);
 	INIT_DELAYED_WORK(&sn->work_rx, svnet_rx_wq);
 	INIT_WORK(&sn->work_exit, svnet_exit_wq);
@@ -786,6 +862,7 @@ static void _free(struct svnet *sn)
 		sysfs_remove_group(&sn->ndev->dev.kobj, &svnet_group);
 
 	if (sn->wq) {
+		hrtimer_cancel(&sn->coalesce);
 		flush_workqueue(sn->wq);
 		destroy_workqueue(sn->wq);
 	}
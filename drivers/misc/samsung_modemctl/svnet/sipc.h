@@ -47,7 +47,12 @@ extern void sipc_close(struct sipc **);
 extern void sipc_exit(void);
 
 extern int sipc_write(struct sipc *, struct sk_buff_head *);
+extern int sipc_xmit(struct sipc *, struct sk_buff_head *txq,
+		struct sk_buff *skb);
 extern int sipc_read(struct sipc *, u32 mailbox, int *cond);
+extern int sipc_transfer(struct sipc *, u32 mailbox,
+		struct sk_buff_head *txq, int *cond);
+extern int sipc_urgent(u32 mailbox);
 extern int sipc_rx(struct sipc *);
 
 
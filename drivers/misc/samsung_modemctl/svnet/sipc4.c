@@ -31,6 +31,7 @@
 
 #include <linux/circ_buf.h>
 #include <linux/workqueue.h>
+#include <linux/math64.h>
 #include <asm/errno.h>
 
 #include <net/sock.h>
@@ -89,6 +90,8 @@ static struct mailbox_data mb_data[IPCIDX_MAX] = {
 
 /* semaphore latency */
 unsigned long long time_max_semlat;
+unsigned long long time_sum_semlat;
+unsigned long cnt_semlat;
 //static volatile unsigned long *TCNT = (unsigned long *)0xF520000C;
 
 struct sipc;
@@ -140,6 +143,18 @@ static struct ringbuf_info rb_info[IPCIDX_MAX] = {
 	},
 };
 
+/*
+ * Raw frames are taken out of the ring by the read work, which has to hold
+ * the OneDRAM semaphore and may sleep for it, and handed to the stack by
+ * NAPI on the svnet device, a budget at a time.
+ */
+#define SIPC_NAPI_WEIGHT 64
+/* frames waiting for NAPI before the rest is left in the ring */
+#define SIPC_RX_BACKLOG 1000
+/* PDP receive buffers, reused as the stack frees them: two NAPI budgets */
+#define SIPC_RX_POOL (SIPC_NAPI_WEIGHT * 2)
+#define SIPC_RX_POOL_SIZE (ETH_DATA_LEN + NET_IP_ALIGN)
+
 #define FRAG_BLOCK_MAX (PAGE_SIZE - sizeof(struct list_head) \
 		- sizeof(u32) - sizeof(char *))
 struct frag_block {
@@ -192,8 +207,33 @@ struct sipc {
 	const struct attribute_group *group;
 
 	struct sk_buff_head rfs_rx;
+
+	struct napi_struct napi;
+	struct sk_buff_head rx_batch;
+	unsigned long rx_throttled;
+	struct skb_pool *rx_pool;
+
+	/* the raw ring and the order of the tx queue, against sipc_xmit */
+	spinlock_t tx_lock;
+
+	unsigned long st_rx_frames;
+	unsigned long st_rx_batches;
+	unsigned int st_rx_batch_max;
+	unsigned long st_rx_polls;
+	unsigned long st_rx_throttle;
+	unsigned long st_tx_direct;
+	unsigned long st_tx_deferred;
+
+	/* bytes through each ring, and the batches of sipc_transfer() */
+	unsigned long long st_in_bytes[IPCIDX_MAX];
+	unsigned long long st_out_bytes[IPCIDX_MAX];
+	unsigned long st_batches;
+	unsigned long st_batch_tx;
 };
 
+static int _rx_poll(struct napi_struct *napi, int budget);
+static void _rx_purge(struct sipc *si);
+
 /* sizeof(struct phonethdr) + NET_SKB_PAD > SMP_CACHE_BYTES */
 //#define RFS_MTU (PAGE_SIZE - sizeof(struct phonethdr) - NET_SKB_PAD)
 /* SMP_CACHE_BYTES > sizeof(struct phonethdr) + NET_SKB_PAD */
@@ -304,6 +344,8 @@ static int _get_auth(void)
 	d = cpu_clock(smp_processor_id()) - t;
 	if (d > time_max_semlat)
 		time_max_semlat = d;
+	time_sum_semlat += d;
+	cnt_semlat++;
 
 	return r;
 }
@@ -487,6 +529,13 @@ struct sipc* sipc_open(void (*queue)(u32, void*), struct net_device *ndev)
 	if (!si)
 		return ERR_PTR(-ENOMEM);
 
+	skb_queue_head_init(&si->rx_batch);
+	spin_lock_init(&si->tx_lock);
+	netif_napi_add(ndev, &si->napi, _rx_poll, SIPC_NAPI_WEIGHT);
+	napi_enable(&si->napi);
+	/* without it PDP frames are allocated from the slab */
+	si->rx_pool = skb_pool_create("svnet", SIPC_RX_POOL_SIZE, SIPC_RX_POOL);
+
 	/* If FMT_SZ grown up, MUST be changed!! */
 	si->frag_buf = kmalloc(FMT_SZ, GFP_KERNEL);
 	if (!si->frag_buf) {
@@ -577,6 +626,10 @@ void sipc_close(struct sipc **psi)
 
 	si = *psi;
 
+	napi_disable(&si->napi);
+	netif_napi_del(&si->napi);
+	_rx_purge(si);
+
 	if (si->group && si->svndev) {
 		int i;
 		sysfs_remove_group(&si->svndev->dev.kobj, si->group);
@@ -599,20 +652,11 @@ void sipc_close(struct sipc **psi)
 	if (si->res)
 		onedram_release_region(0, SIPC_MAP_SIZE);
 
+	skb_pool_destroy(si->rx_pool);
 	kfree(si);
 	*psi = NULL;
 }
 
-static inline void _wake_queue(int idx)
-{
-	mutex_lock(&pdp_mutex);
-
-	if (pdp_devs[idx] && !test_bit(idx, pdp_bitmap))
-		netif_wake_queue(pdp_devs[idx]);
-
-	mutex_unlock(&pdp_mutex);
-}
-
 static int __write(struct ringbuf *rb, u8 *buf, unsigned int size)
 {
 	int c;
@@ -651,6 +695,10 @@ static inline void _set_raw_hdr(struct raw_hdr *h, int res,
 	h->control = 0;
 }
 
+/*
+ * The frame goes into the ring straight from the skb, with the HDLC flags
+ * and the header written from the stack, so the skb is left untouched.
+ */
 static int _write_raw_buf(struct ringbuf *rb, int res, struct sk_buff *skb)
 {
 	int len;
@@ -670,26 +718,6 @@ static int _write_raw_buf(struct ringbuf *rb, int res, struct sk_buff *skb)
 	return len;
 }
 
-static int _write_raw_skb(struct ringbuf *rb, int res, struct sk_buff *skb)
-{
-	char *b;
-
-	_dbg("%s: packet %p res 0x%02x\n", __func__, skb, res);
-
-	b = skb_put(skb, sizeof(hdlc_end));
-	memcpy(b, hdlc_end, sizeof(hdlc_end));
-
-	b = skb_push(skb, sizeof(struct raw_hdr) + sizeof(hdlc_start));
-	memcpy(b, hdlc_start, sizeof(hdlc_start));
-
-	b += sizeof(hdlc_start);
-
-	_set_raw_hdr((struct raw_hdr *)b, res,
-			skb->len - sizeof(hdlc_start) - sizeof(hdlc_end), 0);
-
-	return __write(rb, skb->data, skb->len);
-}
-
 static int _write_raw(struct ringbuf *rb, struct sk_buff *skb, int res)
 {
 	int len;
@@ -700,16 +728,11 @@ static int _write_raw(struct ringbuf *rb, struct sk_buff *skb, int res)
 			+ sizeof(hdlc_start) + sizeof(hdlc_end))
 		return -ENOSPC;
 
-	if(skb_headroom(skb) > (sizeof(struct raw_hdr) + sizeof(hdlc_start))
-			&& skb_tailroom(skb) > sizeof(hdlc_end)) {
-		len = _write_raw_skb(rb, res, skb);
-	} else {
-		len = _write_raw_buf(rb, res, skb);
-	}
+	len = _write_raw_buf(rb, res, skb);
 
-	if (res >= PN_PDP_START && res <= PN_PDP_END)
-		_wake_queue(PDP_ID(res));
-	else
+	/* skb->dev is the PDP device, unless the channel is suspended */
+	if (res < PN_PDP_START || res > PN_PDP_END
+			|| !test_bit(PDP_ID(res), pdp_bitmap))
 		netif_wake_queue(skb->dev);
 	return len;
 }
@@ -906,66 +929,62 @@ static inline int _write_pn(struct sipc *si, struct sk_buff *skb, u32 *mb)
 	return r;
 }
 
-int sipc_write(struct sipc *si, struct sk_buff_head *sbh)
+/* called with the authority held; the send bits for the modem in *mailbox */
+static int _write_queue(struct sipc *si, struct sk_buff_head *sbh, u32 *mailbox)
 {
-	int r;
-	u32 mailbox;
+	int r = 0;
+	int i;
+	u32 head[IPCIDX_MAX];
 	struct sk_buff *skb;
 
-	if (!sbh)
-		return -EINVAL;
+	for (i = 0; i < IPCIDX_MAX; i++)
+		head[i] = si->rb[i].rb_out_head;
 
-	if (!si) {
-		skb_queue_purge(sbh);
-		return -ENXIO;
-	}
+	while (1) {
+		struct net_device *ndev;
+		int len;
 
-	r = _get_auth();
-	if (r) {
-		if (factory_test_force_sleep){
-			printk("tx ignored for factory force sleep\n");
-			skb_queue_purge(sbh);
-			return 0;
-		} else {
-			return r;
+		spin_lock_bh(&si->tx_lock);
+		skb = skb_dequeue(sbh);
+		if (!skb) {
+			spin_unlock_bh(&si->tx_lock);
+			break;
 		}
-	}
-
-	r = mailbox = 0;
-	skb = skb_dequeue(sbh);
-	while (skb) {
-		struct net_device *ndev = skb->dev;
-		int len = skb->len;
+		ndev = skb->dev;
+		len = skb->len;
 
 		dev_dbg(&si->svndev->dev, "write packet %p\n", skb);
 
 		if (skb->protocol != __constant_htons(ETH_P_PHONET)) {
 			struct pdp_priv *priv;
 			priv = netdev_priv(ndev);
-			r = _write(si, PN_PDP(priv->channel), skb, &mailbox);
+			r = _write(si, PN_PDP(priv->channel), skb, mailbox);
 		} else
-			r = _write_pn(si, skb, &mailbox);
+			r = _write_pn(si, skb, mailbox);
+
+		/* back in front before sipc_xmit can find the queue empty */
+		if (r == -ENOSPC)
+			skb_queue_head(sbh, skb);
+		spin_unlock_bh(&si->tx_lock);
 
 		if (r < 0)
 			break;
 
 		_update_stat(ndev, len);
 		dev_kfree_skb_any(skb);
-
-		skb = skb_dequeue(sbh);
 	}
 
-	_req_rel_auth(si);
-	_put_auth(si);
+	for (i = 0; i < IPCIDX_MAX; i++) {
+		struct ringbuf *rb = &si->rb[i];
 
-	if(mailbox)
-		onedram_write_mailbox(MB_DATA(mailbox));
+		si->st_out_bytes[i] += CIRC_CNT(rb->rb_out_head, head[i],
+				rb->rb_size);
+	}
 
 	if (r < 0) {
 		if (r == -ENOSPC) {
 			dev_err(&si->svndev->dev,
 					"write nospc queue %p\n", skb);
-			skb_queue_head(sbh, skb);
 			netif_stop_queue(skb->dev);
 		} else {
 			dev_err(&si->svndev->dev,
@@ -977,6 +996,93 @@ int sipc_write(struct sipc *si, struct sk_buff_head *sbh)
 	return r;
 }
 
+int sipc_write(struct sipc *si, struct sk_buff_head *sbh)
+{
+	int r;
+	u32 mailbox;
+
+	if (!sbh)
+		return -EINVAL;
+
+	if (!si) {
+		skb_queue_purge(sbh);
+		return -ENXIO;
+	}
+
+	/* sipc_transfer() may have written it out already */
+	if (skb_queue_empty(sbh))
+		return 0;
+
+	r = _get_auth();
+	if (r) {
+		if (factory_test_force_sleep){
+			printk("tx ignored for factory force sleep\n");
+			skb_queue_purge(sbh);
+			return 0;
+		} else {
+			return r;
+		}
+	}
+
+	mailbox = 0;
+	r = _write_queue(si, sbh, &mailbox);
+
+	_req_rel_auth(si);
+	_put_auth(si);
+
+	if(mailbox)
+		onedram_write_mailbox(MB_DATA(mailbox));
+
+	return r;
+}
+
+/*
+ * Called from the PDP transmit path: write the packet into the raw ring
+ * right away when OneDRAM is ours already and nothing waits in @txq ahead
+ * of it, sparing it the trip through the write work.  Returns 0 once the
+ * packet is written and freed, an error when it is to be queued.
+ */
+int sipc_xmit(struct sipc *si, struct sk_buff_head *txq, struct sk_buff *skb)
+{
+	struct net_device *ndev = skb->dev;
+	struct pdp_priv *priv = netdev_priv(ndev);
+	int len = skb->len;
+	u32 mailbox = 0;
+	int r;
+
+	if (IS_ERR_OR_NULL(si))
+		return -ENXIO;
+
+	if (_get_auth_try()) {
+		si->st_tx_deferred++;
+		return -EAGAIN;
+	}
+
+	spin_lock(&si->tx_lock);
+	if (skb_queue_empty(txq))
+		r = _write(si, PN_PDP(priv->channel), skb, &mailbox);
+	else
+		r = -EAGAIN;
+	spin_unlock(&si->tx_lock);
+
+	if (r > 0)
+		_req_rel_auth(si);
+	_put_auth(si);
+
+	if (r <= 0) {
+		si->st_tx_deferred++;
+		return r ? r : -EAGAIN;
+	}
+
+	onedram_write_mailbox(MB_DATA(mailbox));
+	_update_stat(ndev, len);
+	dev_kfree_skb_any(skb);
+	si->st_tx_direct++;
+	si->st_out_bytes[IPCIDX_RAW] += r;
+
+	return 0;
+}
+
 extern int __read(struct ringbuf *rb, unsigned char *buf, unsigned int size)
 {
 	int c;
@@ -1019,10 +1125,9 @@ static inline void _get_raw_hdr(struct raw_hdr *h, int *res,
 		*control = h->control;
 }
 
-static inline void _phonet_rx(struct net_device *ndev,
+static inline void _phonet_hdr(struct net_device *ndev,
 		struct sk_buff *skb, int res)
 {
-	int r;
 	struct phonethdr *ph;
 
 	skb->protocol = __constant_htons(ETH_P_PHONET);
@@ -1039,6 +1144,14 @@ static inline void _phonet_rx(struct net_device *ndev,
 	ndev->stats.rx_bytes += skb->len;
 
 	skb_reset_mac_header(skb);
+}
+
+static inline void _phonet_rx(struct net_device *ndev,
+		struct sk_buff *skb, int res)
+{
+	int r;
+
+	_phonet_hdr(ndev, skb, res);
 
 	r = netif_rx_ni(skb);
 	if (r != NET_RX_SUCCESS)
@@ -1047,45 +1160,60 @@ static inline void _phonet_rx(struct net_device *ndev,
 	_dbg("%s: res 0x%02x packet %p len %d\n", __func__, res, skb, skb->len);
 }
 
-static int _read_pn(struct net_device *ndev, struct ringbuf *rb, int len,
-		int res)
+static inline struct sk_buff* _alloc_phskb(struct net_device *ndev, int len)
+{
+	struct sk_buff *skb;
+
+	skb = netdev_alloc_skb(ndev, len + sizeof(struct phonethdr));
+	if (likely(skb))
+		skb_reserve(skb, sizeof(struct phonethdr));
+
+	return skb;
+}
+
+/*
+ * A raw frame is copied once, from the ring into its skb; the HDLC end
+ * flag is skipped in the ring.  The skb is then queued for _rx_poll(),
+ * with a hold on its device until the stack has it.
+ */
+static int _read_frame(struct ringbuf *rb, struct sk_buff *skb, int len)
+{
+	if (__read(rb, skb_put(skb, len), len) != len)
+		return -EBADMSG;
+
+	return len + __read(rb, NULL, sizeof(hdlc_end));
+}
+
+static inline void _queue_rx(struct sipc *si, struct sk_buff *skb)
+{
+	dev_hold(skb->dev);
+	skb_queue_tail(&si->rx_batch, skb);
+}
+
+static int _read_pn(struct sipc *si, struct ringbuf *rb, int len, int res)
 {
 	int r;
 	struct sk_buff *skb;
-	char *p;
-	int read_len = len + sizeof(hdlc_end);
+	struct net_device *ndev = si->svndev;
 
 	_dbg("%s: res 0x%02x data %d\n", __func__, res, len);
 
-	skb = netdev_alloc_skb(ndev, read_len + sizeof(struct phonethdr));
+	skb = _alloc_phskb(ndev, len);
 	if (unlikely(!skb))
 		return -ENOMEM;
 
-	skb_reserve(skb, sizeof(struct phonethdr));
-
-	p = skb_put(skb, len);
-	r = __read(rb, p, read_len);
-	if (r != read_len) {
+	r = _read_frame(rb, skb, len);
+	if (r != len + sizeof(hdlc_end)) {
 		kfree_skb(skb);
 		return -EBADMSG;
 	}
 
-	_phonet_rx(ndev, skb, res);
+	_phonet_hdr(ndev, skb, res);
+	_queue_rx(si, skb);
 
 	return r;
 }
 
-static inline struct sk_buff* _alloc_phskb(struct net_device *ndev, int len)
-{
-	struct sk_buff *skb;
-
-	skb = netdev_alloc_skb(ndev, len + sizeof(struct phonethdr));
-	if (likely(skb))
-		skb_reserve(skb, sizeof(struct phonethdr));
-
-	return skb;
-}
-
 static inline int _alloc_rfs(struct net_device *ndev,
 		struct sk_buff_head *list, int len)
 {
@@ -1195,75 +1323,73 @@ free_skb:
 	return r;
 }
 
-static int _read_pdp(struct ringbuf *rb, int len,
-		int res)
+/* called with pdp_mutex held */
+static int _read_pdp(struct sipc *si, struct ringbuf *rb, int len, int res)
 {
 	int r;
 	struct sk_buff *skb;
-	char *p;
-	int read_len = len + sizeof(hdlc_end);
 	struct net_device *ndev;
 
 	_dbg("%s: res 0x%02x data %d\n", __func__, res, len);
 
-	mutex_lock(&pdp_mutex);
-
 	ndev = pdp_devs[PDP_ID(res)];
 	if (!ndev) {
 		// drop data
-		r = __read(rb, NULL, read_len);
-		mutex_unlock(&pdp_mutex);
-		return r;
+		return __read(rb, NULL, len + sizeof(hdlc_end));
 	}
 
-	skb = netdev_alloc_skb(ndev, read_len);
-	if (unlikely(!skb)) {
-		mutex_unlock(&pdp_mutex);
+	/* with the IP header aligned */
+	skb = skb_pool_alloc(si->rx_pool, ndev, len + NET_IP_ALIGN, GFP_ATOMIC);
+	if (unlikely(!skb))
 		return -ENOMEM;
-	}
+	skb_reserve(skb, NET_IP_ALIGN);
 
-	p = skb_put(skb, len);
-	r = __read(rb, p, read_len);
-	if (r != read_len) {
-		mutex_unlock(&pdp_mutex);
+	r = _read_frame(rb, skb, len);
+	if (r != len + sizeof(hdlc_end)) {
 		kfree_skb(skb);
 		return -EBADMSG;
 	}
 	ndev->stats.rx_packets++;
 	ndev->stats.rx_bytes += skb->len;
 
-	mutex_unlock(&pdp_mutex);
-
-	read_len = r;
-
 	skb->protocol = __constant_htons(ETH_P_IP);
 
 	skb_reset_mac_header(skb);
 
 	_dbg("%s: pdp packet %p len %d\n", __func__, skb, skb->len);
 
-	r = netif_rx_ni(skb);
-	if (r != NET_RX_SUCCESS)
-		dev_err(&ndev->dev, "pdp rx error: %d\n", r);
+	_queue_rx(si, skb);
 
-	return read_len;
+	return r;
 }
 
 static int _read_raw(struct sipc *si, int inbuf, struct ringbuf *rb)
 {
-	int r;
+	int r = 0;
 	char buf[sizeof(struct raw_hdr) + sizeof(hdlc_start)];
 	int res, data_len;
+	unsigned int frames = 0;
 	u32 tail;
 
+	/* the PDP devices stay while their frames are taken out */
+	mutex_lock(&pdp_mutex);
+
 	while (inbuf > 0) {
+		if (skb_queue_len(&si->rx_batch) >= SIPC_RX_BACKLOG) {
+			/* the rest waits in the ring for _rx_poll() */
+			set_bit(0, &si->rx_throttled);
+			si->st_rx_throttle++;
+			break;
+		}
+
 		tail = rb->rb_in_tail;
 
 		r = __read(rb, buf, sizeof(buf));
 		if (r < sizeof(buf) ||
 				strncmp(buf, hdlc_start, sizeof(hdlc_start))) {
 			dev_err(&si->svndev->dev, "Bad message: %c %d\n", buf[0], r);
-			return -EBADMSG;
+			r = -EBADMSG;
+			break;
 		}
 		inbuf -= r;
 
@@ -1273,22 +1399,82 @@ static int _read_raw(struct sipc *si, int inbuf, struct ringbuf *rb)
 		data_len -= sizeof(struct raw_hdr);
 
 		if (res >= PN_PDP_START && res <= PN_PDP_END) {
-			r = _read_pdp(rb, data_len, res);
+			r = _read_pdp(si, rb, data_len, res);
 		} else {
-			r = _read_pn(si->svndev, rb, data_len, res);
+			r = _read_pn(si, rb, data_len, res);
 		}
 
 		if (r < 0) {
 			if (r == -ENOMEM)
 				rb->rb_in_tail = tail;
 
-			return r;
+			break;
 		}
 
 		inbuf -= r;
+		frames++;
 	}
 
-	return 0;
+	mutex_unlock(&pdp_mutex);
+
+	if (frames) {
+		si->st_rx_frames += frames;
+		si->st_rx_batches++;
+		if (frames > si->st_rx_batch_max)
+			si->st_rx_batch_max = frames;
+	}
+
+	/* softirqs raised with bottom halves off run at local_bh_enable() */
+	if (frames || test_bit(0, &si->rx_throttled)) {
+		local_bh_disable();
+		napi_schedule(&si->napi);
+		local_bh_enable();
+	}
+
+	return r < 0 ? r : 0;
+}
+
+static int _rx_poll(struct napi_struct *napi, int budget)
+{
+	struct sipc *si = container_of(napi, struct sipc, napi);
+	struct net_device *ndev;
+	struct sk_buff *skb;
+	int done = 0;
+
+	si->st_rx_polls++;
+
+	while (done < budget) {
+		skb = skb_dequeue(&si->rx_batch);
+		if (!skb)
+			break;
+
+		ndev = skb->dev;
+		netif_receive_skb(skb);
+		dev_put(ndev);
+		done++;
+	}
+
+	if (done < budget) {
+		napi_complete(napi);
+
+		/* queued after the queue was found empty */
+		if (!skb_queue_empty(&si->rx_batch))
+			napi_schedule(napi);
+		else if (test_and_clear_bit(0, &si->rx_throttled))
+			si->queue(MB_DATA(MBD_SEND_RAW), si->queue_data);
+	}
+
+	return done;
+}
+
+static void _rx_purge(struct sipc *si)
+{
+	struct sk_buff *skb;
+
+	while ((skb = skb_dequeue(&si->rx_batch))) {
+		dev_put(skb->dev);
+		kfree_skb(skb);
+	}
 }
 
 static int _read_rfs(struct sipc *si, int inbuf, struct ringbuf *rb)
@@ -1570,18 +1756,11 @@ static inline void purge_buffer(struct ringbuf *rb)
 	rb->rb_in_tail = rb->rb_in_head;
 }
 
-int sipc_read(struct sipc *si, u32 mailbox, int *cond)
+/* called with the authority held; the acks due to the modem in *res */
+static int _read_rings(struct sipc *si, u32 mailbox, u32 *res)
 {
 	int r = 0;
 	int i;
-	u32 res = 0;
-
-	if (!si)
-		return -EINVAL;
-
-	r = _get_auth();
-	if (r)
-		return r;
 
 	for (i=0;i<IPCIDX_MAX;i++) {
 		int inbuf;
@@ -1603,6 +1782,8 @@ int sipc_read(struct sipc *si, u32 mailbox, int *cond)
 		_dbg("%s: %d bytes in %d\n", __func__, inbuf, i);
 
 		r = rb->rb_read(si, inbuf, rb);
+		si->st_in_bytes[i] += inbuf -
+			CIRC_CNT(rb->rb_in_head, rb->rb_in_tail, rb->rb_size);
 		if (r < 0) {
 			if (r == -EBADMSG)
 				purge_buffer(rb);
@@ -1612,9 +1793,26 @@ int sipc_read(struct sipc *si, u32 mailbox, int *cond)
 		}
 
 		if (mailbox & mb_data[i].mask_req_ack)
-			res = mb_data[i].mask_res_ack;
+			*res |= mb_data[i].mask_res_ack;
 	}
 
+	return r;
+}
+
+int sipc_read(struct sipc *si, u32 mailbox, int *cond)
+{
+	int r = 0;
+	u32 res = 0;
+
+	if (!si)
+		return -EINVAL;
+
+	r = _get_auth();
+	if (r)
+		return r;
+
+	r = _read_rings(si, mailbox, &res);
+
 #if !defined(CONFIG_ARIES_NTT)
 	_req_rel_auth(si);
 #endif
@@ -1629,6 +1827,57 @@ int sipc_read(struct sipc *si, u32 mailbox, int *cond)
 	return r;
 }
 
+/*
+ * A batch under one hold of the authority: the in rings are read, for
+ * the mailboxes in @mailbox, and then @txq is written out.  The acks and
+ * the send bits go to the modem in a single mailbox write.  Returns the
+ * result of the read; what could not be written stays in @txq.
+ */
+int sipc_transfer(struct sipc *si, u32 mailbox, struct sk_buff_head *txq,
+		int *cond)
+{
+	int r = 0;
+	u32 res = 0, send = 0;
+
+	if (!si)
+		return -EINVAL;
+
+	r = _get_auth();
+	if (r)
+		return r;
+
+	r = _read_rings(si, mailbox, &res);
+
+	if (r >= 0 && !factory_test_force_sleep && !skb_queue_empty(txq)) {
+		_write_queue(si, txq, &send);
+		si->st_batch_tx++;
+	}
+	si->st_batches++;
+
+#if !defined(CONFIG_ARIES_NTT)
+	_req_rel_auth(si);
+#else
+	if (send)
+		_req_rel_auth(si);
+#endif
+
+	_put_auth(si);
+
+	if (res | send)
+		onedram_write_mailbox(MB_DATA(res | send));
+
+	*cond =	skb_queue_len(&si->rfs_rx);
+
+	return r;
+}
+
+/* mailboxes that must not wait for a coalesced batch */
+int sipc_urgent(u32 mailbox)
+{
+	return mailbox & (mb_data[IPCIDX_FMT].mask_send |
+			mb_data[IPCIDX_FMT].mask_req_ack);
+}
+
 int sipc_rx(struct sipc *si)
 {
 	int tx_cnt;
@@ -1700,6 +1949,42 @@ static inline ssize_t _debug_show_pdp(struct sipc *si, char *buf)
 	return p - buf;
 }
 
+static inline ssize_t _debug_show_ipc(struct sipc *si, char *buf)
+{
+	static const char *names[IPCIDX_MAX] = { "FMT", "RAW", "RFS" };
+	char *p = buf;
+	int i;
+
+	p += sprintf(p, "\n\nRing bytes ---------\n");
+	for (i = 0; i < IPCIDX_MAX; i++)
+		p += sprintf(p, "%s\tin %llu\tout %llu\n", names[i],
+				si->st_in_bytes[i], si->st_out_bytes[i]);
+	p += sprintf(p, "batches %lu with tx %lu\n", si->st_batches,
+			si->st_batch_tx);
+	p += sprintf(p, "authority %lu waits, avg %llu max %llu ns\n",
+			cnt_semlat,
+			cnt_semlat ? div_u64(time_sum_semlat, cnt_semlat) : 0,
+			time_max_semlat);
+
+	return p - buf;
+}
+
+static inline ssize_t _debug_show_raw(struct sipc *si, char *buf)
+{
+	char *p = buf;
+
+	p += sprintf(p, "\n\nRaw rx/tx ---------\n");
+	p += sprintf(p, "rx frames %lu batches %lu max %u polls %lu"
+			" backlog %u throttled %lu\n",
+			si->st_rx_frames, si->st_rx_batches,
+			si->st_rx_batch_max, si->st_rx_polls,
+			skb_queue_len(&si->rx_batch), si->st_rx_throttle);
+	p += sprintf(p, "tx direct %lu deferred %lu\n",
+			si->st_tx_direct, si->st_tx_deferred);
+
+	return p - buf;
+}
+
 ssize_t sipc_debug_show(struct sipc *si, char *buf)
 {
 	char *p = buf;
@@ -1711,6 +1996,10 @@ ssize_t sipc_debug_show(struct sipc *si, char *buf)
 
 	p += _debug_show_pdp(si, p);
 
+	p += _debug_show_raw(si, p);
+
+	p += _debug_show_ipc(si, p);
+
 	p += sprintf(p, "\nDebug command -----------\n");
 	p += sprintf(p, "R0\tcopy FMT out to in\n");
 	p += sprintf(p, "R1\tcopy RAW out to in\n");
@@ -13,75 +13,140 @@
  *
  */
 
-#include <asm/atomic.h>
-
 #include <linux/err.h>
+#include <linux/hash.h>
+#include <linux/if_arp.h>
 #include <linux/init.h>
 #include <linux/kernel.h>
 #include <linux/list.h>
+#include <linux/moduleparam.h>
+#include <linux/mutex.h>
+#include <linux/netdevice.h>
+#include <linux/percpu.h>
 #include <linux/proc_fs.h>
+#include <linux/rculist.h>
 #include <linux/slab.h>
-#include <linux/spinlock.h>
 #include <linux/stat.h>
 #include <linux/uid_stat.h>
 #include <net/activity_stats.h>
+#include <net/dst.h>
+#include <net/sock.h>
+
+/*
+ * The uids are hashed and looked up under RCU, without a lock.  Entries
+ * are never freed, so the lock only serializes their creation.
+ */
+#define UID_HASH_BITS	6
 
-static DEFINE_SPINLOCK(uid_lock);
-static LIST_HEAD(uid_list);
+static DEFINE_MUTEX(uid_lock);
+static struct hlist_head uid_hash[1 << UID_HASH_BITS];
 static struct proc_dir_entry *parent;
 
+static int uid_stat_enabled = 1;
+module_param_named(enable, uid_stat_enabled, bool, 0644);
+
+enum {
+	UID_STAT_IFACE_OTHER,
+	UID_STAT_IFACE_WIFI,
+	UID_STAT_IFACE_MOBILE,
+	UID_STAT_NR_IFACES
+};
+
+static const char *uid_stat_iface_names[UID_STAT_NR_IFACES] = {
+	"other", "wifi", "mobile",
+};
+
+static const char *uid_stat_type_names[UID_STAT_NR_TYPES] = {
+	"tcp_snd", "tcp_rcv", "udp_snd", "udp_rcv",
+};
+
+/*
+ * Byte counts, kept per cpu so that accounting touches no shared cache
+ * line, and summed when read.  They wrap at 4GB on 32-bit, as the
+ * tcp_snd and tcp_rcv files always have.
+ */
+struct uid_stat_counters {
+	unsigned long bytes[UID_STAT_NR_IFACES][UID_STAT_NR_TYPES];
+};
+
+struct uid_stat;
+
+struct uid_stat_file {
+	struct uid_stat *stat;
+	enum uid_stat_type type;
+};
+
 struct uid_stat {
-	struct list_head link;
+	struct hlist_node link;
 	uid_t uid;
-	atomic_t tcp_rcv;
-	atomic_t tcp_snd;
+	struct uid_stat_counters __percpu *counters;
+	struct uid_stat_file files[UID_STAT_NR_TYPES];
 };
 
-static struct uid_stat *find_uid_stat(uid_t uid) {
-	unsigned long flags;
+static struct uid_stat *find_uid_stat(uid_t uid)
+{
 	struct uid_stat *entry;
+	struct hlist_node *pos;
 
-	spin_lock_irqsave(&uid_lock, flags);
-	list_for_each_entry(entry, &uid_list, link) {
-		if (entry->uid == uid) {
-			spin_unlock_irqrestore(&uid_lock, flags);
+	hlist_for_each_entry_rcu(entry, pos,
+				 &uid_hash[hash_32(uid, UID_HASH_BITS)], link) {
+		if (entry->uid == uid)
 			return entry;
-		}
 	}
-	spin_unlock_irqrestore(&uid_lock, flags);
 	return NULL;
 }
 
-static int tcp_snd_read_proc(char *page, char **start, off_t off,
-				int count, int *eof, void *data)
+static unsigned long uid_stat_sum(struct uid_stat *entry, int iface, int type)
 {
-	int len;
-	unsigned int bytes;
+	unsigned long bytes = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		bytes += per_cpu_ptr(entry->counters, cpu)->bytes[iface][type];
+	return bytes;
+}
+
+static int type_read_proc(char *page, char **start, off_t off,
+			  int count, int *eof, void *data)
+{
+	struct uid_stat_file *file = data;
+	unsigned long bytes = 0;
 	char *p = page;
-	struct uid_stat *uid_entry = (struct uid_stat *) data;
+	int iface, len;
+
 	if (!data)
 		return 0;
 
-	bytes = (unsigned int) (atomic_read(&uid_entry->tcp_snd) + INT_MIN);
-	p += sprintf(p, "%u\n", bytes);
+	for (iface = 0; iface < UID_STAT_NR_IFACES; iface++)
+		bytes += uid_stat_sum(file->stat, iface, file->type);
+	p += sprintf(p, "%lu\n", bytes);
 	len = (p - page) - off;
 	*eof = (len <= count) ? 1 : 0;
 	*start = page + off;
 	return len;
 }
 
-static int tcp_rcv_read_proc(char *page, char **start, off_t off,
-				int count, int *eof, void *data)
+static int iface_read_proc(char *page, char **start, off_t off,
+			   int count, int *eof, void *data)
 {
-	int len;
-	unsigned int bytes;
+	struct uid_stat *uid_entry = data;
 	char *p = page;
-	struct uid_stat *uid_entry = (struct uid_stat *) data;
+	int iface, type, len;
+
 	if (!data)
 		return 0;
 
-	bytes = (unsigned int) (atomic_read(&uid_entry->tcp_rcv) + INT_MIN);
-	p += sprintf(p, "%u\n", bytes);
+	p += sprintf(p, "iface");
+	for (type = 0; type < UID_STAT_NR_TYPES; type++)
+		p += sprintf(p, " %s", uid_stat_type_names[type]);
+	p += sprintf(p, "\n");
+	for (iface = 0; iface < UID_STAT_NR_IFACES; iface++) {
+		p += sprintf(p, "%s", uid_stat_iface_names[iface]);
+		for (type = 0; type < UID_STAT_NR_TYPES; type++)
+			p += sprintf(p, " %lu",
+				     uid_stat_sum(uid_entry, iface, type));
+		p += sprintf(p, "\n");
+	}
 	len = (p - page) - off;
 	*eof = (len <= count) ? 1 : 0;
 	*start = page + off;
@@ -89,60 +154,128 @@ static int tcp_rcv_read_proc(char *page, char **start, off_t off,
 }
 
 /* Create a new entry for tracking the specified uid. */
-static struct uid_stat *create_stat(uid_t uid) {
-	unsigned long flags;
+static struct uid_stat *create_stat(uid_t uid)
+{
 	char uid_s[32];
 	struct uid_stat *new_uid;
 	struct proc_dir_entry *entry;
+	int type;
 
-	/* Create the uid stat struct and append it to the list. */
-	if ((new_uid = kmalloc(sizeof(struct uid_stat), GFP_KERNEL)) == NULL)
-		return NULL;
+	mutex_lock(&uid_lock);
 
-	new_uid->uid = uid;
-	/* Counters start at INT_MIN, so we can track 4GB of network traffic. */
-	atomic_set(&new_uid->tcp_rcv, INT_MIN);
-	atomic_set(&new_uid->tcp_snd, INT_MIN);
+	/* Someone else may have created it while we waited. */
+	new_uid = find_uid_stat(uid);
+	if (new_uid)
+		goto out;
 
-	spin_lock_irqsave(&uid_lock, flags);
-	list_add_tail(&new_uid->link, &uid_list);
-	spin_unlock_irqrestore(&uid_lock, flags);
+	new_uid = kzalloc(sizeof(struct uid_stat), GFP_KERNEL);
+	if (!new_uid)
+		goto out;
+	new_uid->counters = alloc_percpu(struct uid_stat_counters);
+	if (!new_uid->counters) {
+		kfree(new_uid);
+		new_uid = NULL;
+		goto out;
+	}
+	new_uid->uid = uid;
 
 	sprintf(uid_s, "%d", uid);
 	entry = proc_mkdir(uid_s, parent);
 
 	/* Keep reference to uid_stat so we know what uid to read stats from. */
-	create_proc_read_entry("tcp_snd", S_IRUGO, entry , tcp_snd_read_proc,
-		(void *) new_uid);
-
-	create_proc_read_entry("tcp_rcv", S_IRUGO, entry, tcp_rcv_read_proc,
-		(void *) new_uid);
+	for (type = 0; type < UID_STAT_NR_TYPES; type++) {
+		new_uid->files[type].stat = new_uid;
+		new_uid->files[type].type = type;
+		create_proc_read_entry(uid_stat_type_names[type], S_IRUGO,
+				       entry, type_read_proc,
+				       &new_uid->files[type]);
+	}
+	create_proc_read_entry("iface_stat", S_IRUGO, entry, iface_read_proc,
+			       new_uid);
 
+	hlist_add_head_rcu(&new_uid->link,
+			   &uid_hash[hash_32(uid, UID_HASH_BITS)]);
+out:
+	mutex_unlock(&uid_lock);
 	return new_uid;
 }
 
-int uid_stat_tcp_snd(uid_t uid, int size) {
-	struct uid_stat *entry;
-	activity_stats_update();
-	if ((entry = find_uid_stat(uid)) == NULL &&
-		((entry = create_stat(uid)) == NULL)) {
-			return -1;
-	}
-	atomic_add(size, &entry->tcp_snd);
-	return 0;
+static int uid_stat_iface(const struct net_device *dev)
+{
+	if (!dev)
+		return UID_STAT_IFACE_OTHER;
+	/* rmnet and pdp, the interfaces of the modem, are point-to-point */
+	if (dev->type == ARPHRD_PPP)
+		return UID_STAT_IFACE_MOBILE;
+	if (dev->ieee80211_ptr)
+		return UID_STAT_IFACE_WIFI;
+#ifdef CONFIG_WIRELESS_EXT
+	if (dev->wireless_handlers)
+		return UID_STAT_IFACE_WIFI;
+#endif
+	return UID_STAT_IFACE_OTHER;
 }
 
-int uid_stat_tcp_rcv(uid_t uid, int size) {
+static int uid_stat_account(uid_t uid, int iface, enum uid_stat_type type,
+			    int size)
+{
 	struct uid_stat *entry;
+
+	if (!uid_stat_enabled)
+		return 0;
+
 	activity_stats_update();
-	if ((entry = find_uid_stat(uid)) == NULL &&
-		((entry = create_stat(uid)) == NULL)) {
+
+	rcu_read_lock();
+	entry = find_uid_stat(uid);
+	rcu_read_unlock();
+
+	if (unlikely(!entry)) {
+		/* the proc files can only be made in process context */
+		if (in_interrupt())
+			return -1;
+		entry = create_stat(uid);
+		if (!entry)
 			return -1;
 	}
-	atomic_add(size, &entry->tcp_rcv);
+
+	/* tcp_read_sock() may account from softirq context */
+	irqsafe_cpu_add(entry->counters->bytes[iface][type], size);
 	return 0;
 }
 
+int uid_stat_dev(uid_t uid, const struct net_device *dev,
+		 enum uid_stat_type type, int size)
+{
+	return uid_stat_account(uid, uid_stat_iface(dev), type, size);
+}
+
+int uid_stat_sock(uid_t uid, struct sock *sk, enum uid_stat_type type,
+		  int size)
+{
+	struct dst_entry *dst;
+	int iface;
+
+	rcu_read_lock();
+	dst = __sk_dst_get(sk);
+	iface = uid_stat_iface(dst ? dst->dev : NULL);
+	rcu_read_unlock();
+
+	return uid_stat_account(uid, iface, type, size);
+}
+
+int uid_stat_iif(uid_t uid, struct net *net, int ifindex,
+		 enum uid_stat_type type, int size)
+{
+	int iface;
+
+	rcu_read_lock();
+	iface = uid_stat_iface(dev_get_by_index_rcu(net, ifindex));
+	rcu_read_unlock();
+
+	return uid_stat_account(uid, iface, type, size);
+}
+
 static int __init uid_stat_init(void)
 {
 	parent = proc_mkdir("uid_stat", NULL);
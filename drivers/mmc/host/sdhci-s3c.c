@@ -272,6 +272,15 @@ static void sdhci_s3c_adjust_cfg(struct sdhci_host *host, int rw)
 		pdata->adjust_cfg_card(pdata, host->ioaddr, rw);
 }
 
+static void sdhci_s3c_card_clock(struct sdhci_host *host, int on)
+{
+	struct sdhci_s3c *ourhost = to_s3c(host);
+	struct s3c_sdhci_platdata *pdata = ourhost->pdata;
+
+	if (pdata->card_clock)
+		pdata->card_clock(ourhost->pdev, on);
+}
+
 static struct sdhci_ops sdhci_s3c_ops = {
 	.get_max_clock		= sdhci_s3c_get_max_clk,
 	.get_timeout_clock	= sdhci_s3c_get_timeout_clk,
@@ -279,6 +288,7 @@ static struct sdhci_ops sdhci_s3c_ops = {
 	.set_ios		= sdhci_s3c_set_ios,
 	.get_cd			= sdhci_s3c_get_cd,
 	.adjust_cfg		= sdhci_s3c_adjust_cfg,
+	.card_clock		= sdhci_s3c_card_clock,
 };
 
 /*
@@ -99,6 +99,12 @@ static void sdhci_dumpregs(struct sdhci_host *host)
  *                                                                           *
 \*****************************************************************************/
 
+static void sdhci_card_clock_changed(struct sdhci_host *host, int on)
+{
+	if (host->ops->card_clock)
+		host->ops->card_clock(host, on);
+}
+
 static void sdhci_enable_clock_card(struct sdhci_host *host)
 {
 	u16 clk;
@@ -106,6 +112,7 @@ static void sdhci_enable_clock_card(struct sdhci_host *host)
 	clk = readw(host->ioaddr + SDHCI_CLOCK_CONTROL);
 	clk |= SDHCI_CLOCK_CARD_EN;
 	writew(clk, host->ioaddr + SDHCI_CLOCK_CONTROL);
+	sdhci_card_clock_changed(host, 1);
 }
 
 static void sdhci_disable_clock_card(struct sdhci_host *host)
@@ -115,6 +122,7 @@ static void sdhci_disable_clock_card(struct sdhci_host *host)
 	clk = readw(host->ioaddr + SDHCI_CLOCK_CONTROL);
 	clk &= ~SDHCI_CLOCK_CARD_EN;
 	writew(clk, host->ioaddr + SDHCI_CLOCK_CONTROL);
+	sdhci_card_clock_changed(host, 0);
 }
 
 static void sdhci_clear_set_irqs(struct sdhci_host *host, u32 clear, u32 set)
@@ -1036,6 +1044,7 @@ static void sdhci_set_clock(struct sdhci_host *host, unsigned int clock)
 	}
 
 	sdhci_writew(host, 0, SDHCI_CLOCK_CONTROL);
+	sdhci_card_clock_changed(host, 0);
 
 	if (clock == 0)
 		goto out;
@@ -1066,6 +1075,7 @@ static void sdhci_set_clock(struct sdhci_host *host, unsigned int clock)
 
 	clk |= SDHCI_CLOCK_CARD_EN;
 	sdhci_writew(host, clk, SDHCI_CLOCK_CONTROL);
+	sdhci_card_clock_changed(host, 1);
 
 out:
 	host->clock = clock;
@@ -325,6 +325,7 @@ struct sdhci_ops {
 	int             (*get_ro) (struct mmc_host *mmc);
 	int				(*get_cd)(struct sdhci_host *host);
 	void			(*adjust_cfg)(struct sdhci_host *host, int rw);
+	void			(*card_clock)(struct sdhci_host *host, int on);
 };
 
 #ifdef CONFIG_MMC_SDHCI_IO_ACCESSORS
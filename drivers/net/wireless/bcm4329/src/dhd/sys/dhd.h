@@ -144,6 +144,8 @@ typedef struct dhd_pub {
 	ulong rx_readahead_cnt;	/* Number of packets where header read-ahead was used. */
 	ulong tx_realloc;	/* Number of tx packets we had to realloc for headroom */
 	ulong fc_packets;       /* Number of flow control pkts recvd */
+	ulong rx_napi_polls;	/* NAPI polls that delivered rx packets */
+	ulong rx_gro_merged;	/* Rx packets GRO merged into an earlier one */
 
 	/* Last error return */
 	int bcmerror;
@@ -41,6 +41,9 @@
 #include <linux/random.h>
 #include <linux/spinlock.h>
 #include <linux/ethtool.h>
+#include <net/ip.h>
+#include <linux/tcp.h>
+#include <net/checksum.h>
 #include <linux/fcntl.h>
 #include <linux/fs.h>
 
@@ -283,6 +286,13 @@ typedef struct dhd_info {
 	wait_queue_head_t ctrl_wait;
 	atomic_t pend_8021x_cnt;
 
+#ifdef DHD_NAPI
+	/* Rx frames the DPC passes up, for the NAPI poll */
+	struct sk_buff_head rx_napiq;
+	struct net_device napi_dev;	/* dummy device the NAPI context hangs off */
+	struct napi_struct napi;
+#endif /* DHD_NAPI */
+
 #ifdef CONFIG_HAS_EARLYSUSPEND
 	struct early_suspend early_suspend;
 #endif /* CONFIG_HAS_EARLYSUSPEND */
@@ -353,6 +363,16 @@ module_param(dhd_watchdog_prio, int, 0);
 int dhd_dpc_prio = 98;
 module_param(dhd_dpc_prio, int, 0);
 
+#ifdef DHD_NAPI
+/* Rx frames queued for the NAPI poll before the DPC drops them */
+uint dhd_napi_backlog = 1000;
+module_param(dhd_napi_backlog, uint, 0644);
+
+/* Verify rx TCP checksums in the NAPI poll, so that GRO can merge segments */
+uint dhd_rx_csum = TRUE;
+module_param(dhd_rx_csum, uint, 0644);
+#endif /* DHD_NAPI */
+
 /* DPC thread priority, -1 to use tasklet */
 extern int dhd_dongle_memsize;
 module_param(dhd_dongle_memsize, int, 0);
@@ -450,6 +470,9 @@ struct iw_statistics *dhd_get_wireless_stats(struct net_device *dev);
 #endif /* defined(CONFIG_WIRELESS_EXT) */
 
 static void dhd_dpc(ulong data);
+#ifdef DHD_NAPI
+static int dhd_rx_poll(struct napi_struct *napi, int budget);
+#endif
 /* forward decl */
 extern int dhd_wait_pend8021x(struct net_device *dev);
 
@@ -1286,6 +1309,18 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt)
 		dhdp->dstats.rx_bytes += skb->len;
 		dhdp->rx_packets++; /* Local count */
 
+#ifdef DHD_NAPI
+		/* The stack sees it in the NAPI poll, after the DPC has let
+		 * go of the bus; the reference keeps the device for it.
+		 */
+		if (skb_queue_len(&dhd->rx_napiq) < dhd_napi_backlog) {
+			dev_hold(skb->dev);
+			skb_queue_tail(&dhd->rx_napiq, skb);
+		} else {
+			dhdp->rx_dropped++;
+			dev_kfree_skb_any(skb);
+		}
+#else
 		if (in_interrupt()) {
 			netif_rx(skb);
 		} else {
@@ -1305,9 +1340,83 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt)
 			local_irq_restore(flags);
 #endif /* LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 0) */
 		}
+#endif /* DHD_NAPI */
+	}
+}
+
+#ifdef DHD_NAPI
+/* The dongle does no rx checksum; an unverified TCP segment is not merged */
+static void
+dhd_rx_csum_check(struct sk_buff *skb)
+{
+	struct iphdr *iph = (struct iphdr *)skb->data;
+	uint len;
+
+	if (skb->ip_summed != CHECKSUM_NONE || skb->protocol != htons(ETH_P_IP) ||
+	    skb_headlen(skb) < sizeof(*iph))
+		return;
+	if (iph->ihl != 5 || iph->protocol != IPPROTO_TCP ||
+	    (iph->frag_off & htons(IP_MF | IP_OFFSET)))
+		return;
+	len = ntohs(iph->tot_len);
+	if (len > skb->len || len < sizeof(*iph) + sizeof(struct tcphdr))
+		return;
+
+	len -= sizeof(*iph);
+	if (!csum_tcpudp_magic(iph->saddr, iph->daddr, len, IPPROTO_TCP,
+	                       skb_checksum(skb, sizeof(*iph), len, 0)))
+		skb->ip_summed = CHECKSUM_UNNECESSARY;
+}
+
+/* Passes up what the DPC received, a budget at a time, through GRO */
+static int
+dhd_rx_poll(struct napi_struct *napi, int budget)
+{
+	dhd_info_t *dhd = container_of(napi, dhd_info_t, napi);
+	struct net_device *net;
+	struct sk_buff *skb;
+	int work = 0;
+
+	while (work < budget && (skb = skb_dequeue(&dhd->rx_napiq))) {
+		net = skb->dev;
+		if (dhd_rx_csum)
+			dhd_rx_csum_check(skb);
+		switch (napi_gro_receive(napi, skb)) {
+		case GRO_MERGED:
+		case GRO_MERGED_FREE:
+			dhd->pub.rx_gro_merged++;
+			break;
+		default:
+			break;
+		}
+		dev_put(net);
+		work++;
+	}
+	dhd->pub.rx_napi_polls++;
+
+	if (work < budget) {
+		napi_complete(napi);
+		/* The DPC queued more after the queue ran empty */
+		if (!skb_queue_empty(&dhd->rx_napiq))
+			napi_schedule(napi);
 	}
+
+	return work;
 }
 
+/* Runs the NAPI poll for what the last DPC passed up, as one batch */
+static void
+dhd_napi_sched(dhd_info_t *dhd)
+{
+	if (skb_queue_empty(&dhd->rx_napiq))
+		return;
+
+	local_bh_disable();
+	napi_schedule(&dhd->napi);
+	local_bh_enable();
+}
+#endif /* DHD_NAPI */
+
 void
 dhd_event(struct dhd_info *dhd, char *evpkt, int evlen, int ifidx)
 {
@@ -1471,6 +1580,9 @@ dhd_dpc_thread(void *data)
 					up(&dhd->dpc_sem);
 					WAKE_LOCK_TIMEOUT(&dhd->pub, WAKE_LOCK_TMOUT, 25);
 				}
+#ifdef DHD_NAPI
+				dhd_napi_sched(dhd);
+#endif
 				WAKE_UNLOCK(&dhd->pub, WAKE_LOCK_DPC);
 			} else {
 				dhd_bus_stop(dhd->pub.bus, TRUE);
@@ -1496,6 +1608,9 @@ dhd_dpc(ulong data)
 	if (dhd->pub.busstate != DHD_BUS_DOWN) {
 		if (dhd_bus_dpc(dhd->pub.bus))
 			tasklet_schedule(&dhd->tasklet);
+#ifdef DHD_NAPI
+		dhd_napi_sched(dhd);
+#endif
 	} else {
 		dhd_bus_stop(dhd->pub.bus, TRUE);
 	}
@@ -2014,6 +2129,13 @@ dhd_attach(osl_t *osh, struct dhd_bus *bus, uint bus_hdrlen)
 
 	memset(dhd, 0, sizeof(dhd_info_t));
 
+#ifdef DHD_NAPI
+	skb_queue_head_init(&dhd->rx_napiq);
+	init_dummy_netdev(&dhd->napi_dev);
+	netif_napi_add(&dhd->napi_dev, &dhd->napi, dhd_rx_poll, 64);
+	napi_enable(&dhd->napi);
+#endif /* DHD_NAPI */
+
 	/*
 	 * Save the dhd_info into the priv
 	 */
@@ -2372,6 +2494,9 @@ dhd_net_attach(dhd_pub_t *dhdp, int ifidx)
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 24)
 	net->ethtool_ops = &dhd_ethtool_ops;
 #endif /* LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 24) */
+#ifdef DHD_NAPI
+	net->features |= NETIF_F_GRO;
+#endif
 
 #if defined(CONFIG_WIRELESS_EXT)
 #if WIRELESS_EXT < 19
@@ -2511,6 +2636,19 @@ dhd_detach(dhd_pub_t *dhdp)
 			else
 				tasklet_kill(&dhd->tasklet);
 
+#ifdef DHD_NAPI
+			napi_disable(&dhd->napi);
+			netif_napi_del(&dhd->napi);
+			{
+				struct sk_buff *skb;
+
+				while ((skb = skb_dequeue(&dhd->rx_napiq))) {
+					dev_put(skb->dev);
+					dev_kfree_skb_any(skb);
+				}
+			}
+#endif /* DHD_NAPI */
+
 			dhd_bus_detach(dhdp);
 	
 			if (dhdp->prot)
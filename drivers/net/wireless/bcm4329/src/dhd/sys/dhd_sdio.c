@@ -87,6 +87,8 @@
 
 #define DHD_TXMINMAX	1	/* Max tx frames if rx still pending */
 
+#define DHD_DPC_RXHIST	8	/* Buckets of rx frames per dpc: 0, 1, 2-3, ... 64+ */
+
 #define MEMBLOCK	2048		/* Block size used for downloading of dongle image */
 #define MAX_DATA_BUF	(32 * 1024)	/* Must be large enough to hold biggest possible glom */
 
@@ -296,6 +298,15 @@ typedef struct dhd_bus {
 	uint		f2rxdata;		/* Number of frame data reads */
 	uint		f2txdata;		/* Number of f2 frame writes */
 	uint		f1regdata;		/* Number of f1 register accesses */
+	uint		dpc_runs;		/* Number of dpc runs */
+	uint		dpc_rxframes;		/* Rx frames read by dpc runs */
+	uint		dpc_rxmax;		/* Most rx frames read in one dpc run */
+	uint		dpc_resched;		/* Dpc runs that asked to run again */
+	uint		dpc_rxhist[DHD_DPC_RXHIST];	/* Dpc runs by rx frames read */
+	uint		txq_runs;		/* Runs of the tx queue that sent frames */
+	uint		txq_frames;		/* Data frames sent by those runs */
+	uint		txq_max;		/* Most data frames sent in one run */
+	uint		tx_realign;		/* Tx frames copied for lack of align headroom */
 
 	uint8		*ctrl_frame_buf;
 	uint32		ctrl_frame_len;
@@ -937,7 +948,7 @@ dhdsdio_txpkt(dhd_bus_t *bus, void *pkt, uint chan, bool free_pkt)
 		if (PKTHEADROOM(osh, pkt) < pad) {
 			DHD_INFO(("%s: insufficient headroom %d for %d pad\n",
 			          __FUNCTION__, (int)PKTHEADROOM(osh, pkt), pad));
-			bus->dhd->tx_realloc++;
+			bus->tx_realign++;
 			new = PKTGET(osh, (PKTLEN(osh, pkt) + DHD_SDALIGN), TRUE);
 			if (!new) {
 				DHD_ERROR(("%s: couldn't allocate new %d-byte packet\n",
@@ -1210,6 +1221,13 @@ dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 		}
 	}
 
+	if (cnt) {
+		bus->txq_runs++;
+		bus->txq_frames += cnt;
+		if (cnt > bus->txq_max)
+			bus->txq_max = cnt;
+	}
+
 	/* Deflow-control stack if needed */
 	if (dhd_doflow && dhd->up && (dhd->busstate == DHD_BUS_DATA) &&
 	    dhd->txoff && (pktq_len(&bus->txq) < FCLOW))
@@ -1512,6 +1530,7 @@ void
 dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 {
 	dhd_bus_t *bus = dhdp->bus;
+	int i;
 
 	bcm_bprintf(strbuf, "Bus SDIO structure:\n");
 	bcm_bprintf(strbuf, "hostintmask 0x%08x intstatus 0x%08x sdpcm_ver %d\n",
@@ -1537,6 +1556,14 @@ dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 	bcm_bprintf(strbuf, "f2rx (hdrs/data) %d (%d/%d), f2tx %d f1regs %d\n",
 	            (bus->f2rxhdrs + bus->f2rxdata), bus->f2rxhdrs, bus->f2rxdata,
 	            bus->f2txdata, bus->f1regdata);
+	bcm_bprintf(strbuf, "dpc runs %d rxframes %d rxmax %d resched %d\n",
+	            bus->dpc_runs, bus->dpc_rxframes, bus->dpc_rxmax, bus->dpc_resched);
+	bcm_bprintf(strbuf, "txq runs %d frames %d max %d, tx realign %d\n",
+	            bus->txq_runs, bus->txq_frames, bus->txq_max, bus->tx_realign);
+	bcm_bprintf(strbuf, "dpc rx hist (0 1 2-3 4-7 8-15 16-31 32-63 64+)");
+	for (i = 0; i < DHD_DPC_RXHIST; i++)
+		bcm_bprintf(strbuf, " %d", bus->dpc_rxhist[i]);
+	bcm_bprintf(strbuf, "\n");
 	{
 		dhd_dump_pct(strbuf, "\nRx: pkts/f2rd", bus->dhd->rx_packets,
 		             (bus->f2rxhdrs + bus->f2rxdata));
@@ -1544,6 +1571,7 @@ dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 		dhd_dump_pct(strbuf, ", pkts/sd", bus->dhd->rx_packets,
 		             (bus->f2rxhdrs + bus->f2rxdata + bus->f1regdata));
 		dhd_dump_pct(strbuf, ", pkts/int", bus->dhd->rx_packets, bus->intrcount);
+		dhd_dump_pct(strbuf, ", pkts/dpc", bus->dpc_rxframes, bus->dpc_runs);
 		bcm_bprintf(strbuf, "\n");
 
 		dhd_dump_pct(strbuf, "Rx: glom pct", (100 * bus->rxglompkts),
@@ -1556,6 +1584,7 @@ dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 		dhd_dump_pct(strbuf, ", pkts/sd", bus->dhd->tx_packets,
 		             (bus->f2txdata + bus->f1regdata));
 		dhd_dump_pct(strbuf, ", pkts/int", bus->dhd->tx_packets, bus->intrcount);
+		dhd_dump_pct(strbuf, ", pkts/txq", bus->txq_frames, bus->txq_runs);
 		bcm_bprintf(strbuf, "\n");
 
 		dhd_dump_pct(strbuf, "Total: pkts/f2rw",
@@ -1601,6 +1630,9 @@ dhd_bus_clearcounts(dhd_pub_t *dhdp)
 	bus->tx_sderrs = bus->fc_rcvd = bus->fc_xoff = bus->fc_xon = 0;
 	bus->rxglomfail = bus->rxglomframes = bus->rxglompkts = 0;
 	bus->f2rxhdrs = bus->f2rxdata = bus->f2txdata = bus->f1regdata = 0;
+	bus->dpc_runs = bus->dpc_rxframes = bus->dpc_rxmax = bus->dpc_resched = 0;
+	bzero(bus->dpc_rxhist, sizeof(bus->dpc_rxhist));
+	bus->txq_runs = bus->txq_frames = bus->txq_max = bus->tx_realign = 0;
 }
 
 #ifdef SDTEST
@@ -4107,6 +4139,7 @@ dhdsdio_dpc(dhd_bus_t *bus)
 	uint framecnt = 0;		  /* Temporary counter of tx/rx frames */
 	bool rxdone = TRUE;		  /* Flag for no more read data */
 	bool resched = FALSE;	  /* Flag indicating resched wanted */
+	uint rxframes, hist;
 
 	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
 
@@ -4322,6 +4355,17 @@ clkwait:
 		resched = TRUE;
 	}
 
+	/* How many frames each run hands up at once */
+	rxframes = dhd_rxbound - rxlimit;
+	bus->dpc_runs++;
+	bus->dpc_rxframes += rxframes;
+	if (rxframes > bus->dpc_rxmax)
+		bus->dpc_rxmax = rxframes;
+	if (resched)
+		bus->dpc_resched++;
+	for (hist = 0; rxframes && hist < DHD_DPC_RXHIST - 1; rxframes >>= 1)
+		hist++;
+	bus->dpc_rxhist[hist]++;
 
 	bus->dpc_sched = resched;
 
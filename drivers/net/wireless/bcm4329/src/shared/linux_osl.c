@@ -51,6 +51,10 @@
 #define OS_HANDLE_MAGIC		0x1234abcd	
 #define BCM_MEM_FILENAME_LEN 	24		
 
+/* received frames up to an MTU fit, with the buffer in a 2K kmalloc */
+#define OSL_RX_POOL_SIZE	(SKB_WITH_OVERHEAD(2048) - NET_SKB_PAD)
+#define OSL_RX_POOL		128
+
 #ifdef DHD_USE_STATIC_BUF
 #define DHD_SKB_HDRSIZE 		336
 #define DHD_SKB_1PAGE_BUFSIZE	((PAGE_SIZE*1)-DHD_SKB_HDRSIZE)
@@ -95,6 +99,7 @@ struct osl_info {
 	uint failed;
 	uint bustype;
 	bcm_mem_link_t *dbgmem_list;
+	struct skb_pool *rx_pool;
 };
 
 static int16 linuxbcmerrormap[] =
@@ -260,6 +265,12 @@ osl_attach(void *pdev, uint bustype, bool pkttag)
 		init_MUTEX(&bcm_static_skb->osl_pkt_sem);
 	}
 #endif 
+
+	/* dhd receives with the SDIO bus handle; without a pool, from the slab */
+	if (bustype == SDIO_BUS)
+		osh->rx_pool = skb_pool_create("bcm4329", OSL_RX_POOL_SIZE,
+			OSL_RX_POOL);
+
 	return osh;
 
 #ifdef SAMSUNG_STATIC_BUF
@@ -297,6 +308,7 @@ osl_detach(osl_t *osh)
 	}
 #endif 
 	ASSERT(osh->magic == OS_HANDLE_MAGIC);
+	skb_pool_destroy(osh->rx_pool);
 	kfree(osh);
 }
 
@@ -306,7 +318,7 @@ osl_pktget(osl_t *osh, uint len)
 {
 	struct sk_buff *skb;
 
-	if ((skb = dev_alloc_skb(len))) {
+	if ((skb = skb_pool_alloc(osh->rx_pool, NULL, len, GFP_ATOMIC))) {
 		skb_put(skb, len);
 		skb->priority = 0;
 
@@ -29,6 +29,7 @@
 #include <linux/i2c.h>
 #include <linux/regulator/consumer.h>
 #include <mach/cpu-freq-v210.h>
+#include <mach/cpuidle.h>
 #if	defined(CONFIG_USB_GADGET_S3C_OTGD_DMA_MODE) /* DMA mode */
 #define OTG_DMA_MODE		1
 
@@ -232,6 +233,7 @@ static void udc_disable(struct s3c_udc *dev)
 	dev->usb_address = 0;
 
 	otg_phy_off();
+	s5pv210_idle_set_busy(S5P_IDLE_BUSY_USBOTG, 0);
 }
 
 /*
@@ -274,6 +276,7 @@ static int udc_enable(struct s3c_udc *dev)
 {
 	DEBUG_SETUP("%s: %p\n", __func__, dev);
 
+	s5pv210_idle_set_busy(S5P_IDLE_BUSY_USBOTG, 1);
 	otg_phy_init();
 	reconfig_usbd();
 
@@ -838,6 +838,12 @@ struct ext4_inode_info {
 	 */
 	tid_t i_sync_tid;
 	tid_t i_datasync_tid;
+
+	/*
+	 * Transaction that last changed more of the inode than its size
+	 * and timestamps, which is all a fast commit records.
+	 */
+	tid_t i_fc_ineligible_tid;
 };
 
 /*
@@ -883,6 +889,7 @@ struct ext4_inode_info {
 #define EXT4_MOUNT_JOURNAL_CHECKSUM	0x800000 /* Journal checksums */
 #define EXT4_MOUNT_JOURNAL_ASYNC_COMMIT	0x1000000 /* Journal Async Commit */
 #define EXT4_MOUNT_I_VERSION            0x2000000 /* i_version support */
+#define EXT4_MOUNT_FAST_COMMIT		0x4000000 /* Fast commits for fsync */
 #define EXT4_MOUNT_DELALLOC		0x8000000 /* Delalloc support */
 #define EXT4_MOUNT_DATA_ERR_ABORT	0x10000000 /* Abort on file data write */
 #define EXT4_MOUNT_BLOCK_VALIDITY	0x20000000 /* Block validity checking */
@@ -1520,6 +1527,29 @@ extern int ext4_htree_store_dirent(struct file *dir_file, __u32 hash,
 				    struct ext4_dir_entry_2 *dirent);
 extern void ext4_htree_free_dir_info(struct dir_private_info *p);
 
+/* fast_commit.c */
+struct ext4_fc_snapshot {
+	__le16	i_mode;
+	__le16	i_uid_low;
+	__le16	i_gid_low;
+	__le16	i_links_count;
+	__le32	i_dtime;
+	__le32	i_blocks_lo;
+	__le32	i_flags;
+	__le32	i_generation;
+	__le32	i_file_acl_lo;
+	__le32	i_block[EXT4_N_BLOCKS];
+	__u8	osd2[12];
+};
+extern int ext4_fc_snapshot(handle_t *handle, struct inode *inode,
+			    struct ext4_fc_snapshot *snap,
+			    struct ext4_inode *raw_inode);
+extern void ext4_fc_track_inode(handle_t *handle, struct inode *inode,
+				struct ext4_fc_snapshot *snap,
+				struct ext4_inode *raw_inode);
+extern int ext4_fc_commit(struct inode *inode, tid_t tid);
+extern int ext4_fc_replay(journal_t *journal, void *rec, unsigned int len);
+
 /* fsync.c */
 extern int ext4_sync_file(struct file *, int);
 
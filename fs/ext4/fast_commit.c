@@ -0,0 +1,199 @@
+/*
+ *  linux/fs/ext4/fast_commit.c
+ *
+ *  Copyright (c) 2010 by Samsung Electronics
+ *
+ *  Fast commits: fsync() of a regular file whose inode only had its size
+ *  and timestamps changed since the last commit writes one record to the
+ *  fast commit area of the journal instead of committing the transaction.
+ *
+ *  This covers the common pattern of databases that append to, or rewrite
+ *  in place, an already allocated file and fsync() after every transaction.
+ *  Anything else - block allocation, unwritten extent conversion, changes
+ *  of mode, owner, link count, flags or extended attributes, rename - makes
+ *  the inode ineligible until the transaction carrying the change commits,
+ *  and fsync() falls back to a full commit.
+ */
+
+#include <linux/fs.h>
+#include <linux/jbd2.h>
+#include <linux/buffer_head.h>
+#include "ext4.h"
+#include "ext4_jbd2.h"
+
+/*
+ * A fast commit record: the on-disk size and timestamps of one inode, as
+ * in the raw inode.  The generation guards against replaying onto an inode
+ * that was freed and reused by the transactions before.
+ */
+struct ext4_fc_inode {
+	__le32	fc_ino;
+	__le32	fc_generation;
+	__le32	fc_size_lo;
+	__le32	fc_size_high;
+	__le32	fc_mtime;
+	__le32	fc_ctime;
+	__le32	fc_mtime_extra;
+	__le32	fc_ctime_extra;
+};
+
+#define EXT4_FC_FITS_IN_INODE(sb, raw_inode, field)			\
+	(EXT4_INODE_SIZE(sb) > EXT4_GOOD_OLD_INODE_SIZE &&		\
+	 offsetof(struct ext4_inode, field) + sizeof((raw_inode)->field) <= \
+	 EXT4_GOOD_OLD_INODE_SIZE + le16_to_cpu((raw_inode)->i_extra_isize))
+
+/*
+ * Called by ext4_do_update_inode() before it copies the inode into its
+ * buffer.  Saves what a fast commit can not record, unless the inode is
+ * already ineligible in this transaction; returns whether it did.
+ */
+int ext4_fc_snapshot(handle_t *handle, struct inode *inode,
+		     struct ext4_fc_snapshot *snap,
+		     struct ext4_inode *raw_inode)
+{
+	if (!test_opt(inode->i_sb, FAST_COMMIT) || !ext4_handle_valid(handle))
+		return 0;
+	if (EXT4_I(inode)->i_fc_ineligible_tid == handle->h_transaction->t_tid)
+		return 0;
+	if (ext4_test_inode_state(inode, EXT4_STATE_NEW)) {
+		ext4_fc_mark_ineligible(handle, inode);
+		return 0;
+	}
+
+	BUILD_BUG_ON(sizeof(snap->osd2) != sizeof(raw_inode->osd2));
+	snap->i_mode = raw_inode->i_mode;
+	snap->i_uid_low = raw_inode->i_uid_low;
+	snap->i_gid_low = raw_inode->i_gid_low;
+	snap->i_links_count = raw_inode->i_links_count;
+	snap->i_dtime = raw_inode->i_dtime;
+	snap->i_blocks_lo = raw_inode->i_blocks_lo;
+	snap->i_flags = raw_inode->i_flags;
+	snap->i_generation = raw_inode->i_generation;
+	snap->i_file_acl_lo = raw_inode->i_file_acl_lo;
+	memcpy(snap->i_block, raw_inode->i_block, sizeof(snap->i_block));
+	memcpy(snap->osd2, &raw_inode->osd2, sizeof(snap->osd2));
+	return 1;
+}
+
+/*
+ * Called once the inode has been copied into its buffer: if anything but
+ * size and timestamps changed, fsync has to commit the transaction.
+ */
+void ext4_fc_track_inode(handle_t *handle, struct inode *inode,
+			 struct ext4_fc_snapshot *snap,
+			 struct ext4_inode *raw_inode)
+{
+	if (snap->i_mode != raw_inode->i_mode ||
+	    snap->i_uid_low != raw_inode->i_uid_low ||
+	    snap->i_gid_low != raw_inode->i_gid_low ||
+	    snap->i_links_count != raw_inode->i_links_count ||
+	    snap->i_dtime != raw_inode->i_dtime ||
+	    snap->i_blocks_lo != raw_inode->i_blocks_lo ||
+	    snap->i_flags != raw_inode->i_flags ||
+	    snap->i_generation != raw_inode->i_generation ||
+	    snap->i_file_acl_lo != raw_inode->i_file_acl_lo ||
+	    memcmp(snap->i_block, raw_inode->i_block, sizeof(snap->i_block)) ||
+	    memcmp(snap->osd2, &raw_inode->osd2, sizeof(snap->osd2)))
+		ext4_fc_mark_ineligible(handle, inode);
+}
+
+/*
+ * Make the size and timestamps of @inode, last changed in transaction
+ * @tid, durable with a fast commit.  The caller has written and waited on
+ * the file data.  Returns -EAGAIN when a full commit is needed instead.
+ */
+int ext4_fc_commit(struct inode *inode, tid_t tid)
+{
+	struct ext4_inode_info *ei = EXT4_I(inode);
+	journal_t *journal = EXT4_JOURNAL(inode);
+	struct ext4_inode *raw_inode;
+	struct ext4_fc_inode rec;
+	struct ext4_iloc iloc;
+	int err;
+
+	if (!test_opt(inode->i_sb, FAST_COMMIT) || !S_ISREG(inode->i_mode) ||
+	    ext4_should_journal_data(inode))
+		return -EAGAIN;
+
+	/*
+	 * Blocks allocated or converted in @tid, and any change the record
+	 * can not carry, only reach the disk with the full commit.
+	 */
+	if (!tid_gt(tid, ei->i_datasync_tid) ||
+	    !tid_gt(tid, ei->i_fc_ineligible_tid))
+		return -EAGAIN;
+
+	err = ext4_get_inode_loc(inode, &iloc);
+	if (err)
+		return err;
+	raw_inode = ext4_raw_inode(&iloc);
+
+	memset(&rec, 0, sizeof(rec));
+	rec.fc_ino = cpu_to_le32(inode->i_ino);
+	rec.fc_generation = raw_inode->i_generation;
+	rec.fc_size_lo = raw_inode->i_size_lo;
+	rec.fc_size_high = raw_inode->i_size_high;
+	rec.fc_mtime = raw_inode->i_mtime;
+	rec.fc_ctime = raw_inode->i_ctime;
+	if (EXT4_FC_FITS_IN_INODE(inode->i_sb, raw_inode, i_ctime_extra)) {
+		rec.fc_mtime_extra = raw_inode->i_mtime_extra;
+		rec.fc_ctime_extra = raw_inode->i_ctime_extra;
+	}
+	brelse(iloc.bh);
+
+	return jbd2_journal_fast_commit(journal, tid, &rec, sizeof(rec));
+}
+
+/*
+ * jbd2 recovery callback: apply one record on top of the replayed log.
+ * The filesystem is not mounted yet, so the inode is patched directly in
+ * the inode table; jbd2 syncs the device once recovery is done.
+ */
+int ext4_fc_replay(journal_t *journal, void *data, unsigned int len)
+{
+	struct super_block *sb = journal->j_private;
+	struct ext4_fc_inode *rec = data;
+	struct ext4_group_desc *gdp;
+	struct ext4_inode *raw_inode;
+	struct buffer_head *bh;
+	unsigned long ino, offset;
+	ext4_group_t group;
+
+	if (len < sizeof(*rec))
+		return -EINVAL;
+
+	ino = le32_to_cpu(rec->fc_ino);
+	if (ino < EXT4_FIRST_INO(sb) ||
+	    ino > le32_to_cpu(EXT4_SB(sb)->s_es->s_inodes_count)) {
+		ext4_msg(sb, KERN_ERR, "fast commit of bad inode %lu", ino);
+		return -EINVAL;
+	}
+
+	group = (ino - 1) / EXT4_INODES_PER_GROUP(sb);
+	offset = ((ino - 1) % EXT4_INODES_PER_GROUP(sb)) * EXT4_INODE_SIZE(sb);
+	gdp = ext4_get_group_desc(sb, group, NULL);
+	if (!gdp)
+		return -EIO;
+
+	bh = sb_bread(sb, ext4_inode_table(sb, gdp) +
+		      (offset >> EXT4_BLOCK_SIZE_BITS(sb)));
+	if (!bh)
+		return -EIO;
+	raw_inode = (struct ext4_inode *)(bh->b_data +
+				(offset & (EXT4_BLOCK_SIZE(sb) - 1)));
+
+	if (raw_inode->i_generation == rec->fc_generation &&
+	    raw_inode->i_links_count) {
+		raw_inode->i_size_lo = rec->fc_size_lo;
+		raw_inode->i_size_high = rec->fc_size_high;
+		raw_inode->i_mtime = rec->fc_mtime;
+		raw_inode->i_ctime = rec->fc_ctime;
+		if (EXT4_FC_FITS_IN_INODE(sb, raw_inode, i_ctime_extra)) {
+			raw_inode->i_mtime_extra = rec->fc_mtime_extra;
+			raw_inode->i_ctime_extra = rec->fc_ctime_extra;
+		}
+		mark_buffer_dirty(bh);
+	}
+	brelse(bh);
+	return 0;
+}
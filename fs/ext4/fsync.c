@@ -66,7 +66,8 @@ static void ext4_sync_parent(struct inode *inode)
  * state in the journalling system.
  *
  * What we do is just kick off a commit and wait on it.  This will snapshot the
- * inode to disk.
+ * inode to disk.  If only the size and timestamps of the inode changed since
+ * the last commit, a fast commit record is written instead.
  *
  * i_mutex lock is held when entering and exiting this function
  */
@@ -115,6 +116,9 @@ int ext4_sync_file(struct file *file, int datasync)
 		return ext4_force_commit(inode->i_sb);
 
 	commit_tid = datasync ? ei->i_datasync_tid : ei->i_sync_tid;
+	if (!tid_geq(journal->j_commit_sequence, commit_tid) &&
+	    ext4_fc_commit(inode, commit_tid) == 0)
+		return 0;
 	if (jbd2_log_start_commit(journal, commit_tid)) {
 		/*
 		 * When the journal is on a different device than the
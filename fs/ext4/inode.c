@@ -5095,6 +5095,7 @@ struct inode *ext4_iget(struct super_block *sb, unsigned long ino)
 		spin_unlock(&journal->j_state_lock);
 		ei->i_sync_tid = tid;
 		ei->i_datasync_tid = tid;
+		ei->i_fc_ineligible_tid = tid;
 	}
 
 	if (EXT4_INODE_SIZE(inode->i_sb) > EXT4_GOOD_OLD_INODE_SIZE) {
@@ -5246,7 +5247,10 @@ static int ext4_do_update_inode(handle_t *handle,
 	struct ext4_inode *raw_inode = ext4_raw_inode(iloc);
 	struct ext4_inode_info *ei = EXT4_I(inode);
 	struct buffer_head *bh = iloc->bh;
-	int err = 0, rc, block;
+	struct ext4_fc_snapshot fc_snap;
+	int err = 0, rc, block, fc_track;
+
+	fc_track = ext4_fc_snapshot(handle, inode, &fc_snap, raw_inode);
 
 	/* For fields not not tracking in the in-memory inode,
 	 * initialise them to zero for new inodes. */
@@ -5342,6 +5346,9 @@ static int ext4_do_update_inode(handle_t *handle,
 		raw_inode->i_extra_isize = cpu_to_le16(ei->i_extra_isize);
 	}
 
+	if (fc_track)
+		ext4_fc_track_inode(handle, inode, &fc_snap, raw_inode);
+
 	BUFFER_TRACE(bh, "call ext4_handle_dirty_metadata");
 	rc = ext4_handle_dirty_metadata(handle, NULL, bh);
 	if (!err)
@@ -2454,6 +2454,8 @@ static int ext4_rename(struct inode *old_dir, struct dentry *old_dentry,
 	 * rename.
 	 */
 	old_inode->i_ctime = ext4_current_time(old_inode);
+	/* fsync of the renamed file has to commit the new name too */
+	ext4_fc_mark_ineligible(handle, old_inode);
 	ext4_mark_inode_dirty(handle, old_inode);
 
 	/*
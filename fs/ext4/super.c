@@ -766,6 +766,7 @@ static struct inode *ext4_alloc_inode(struct super_block *sb)
 	ei->cur_aio_dio = NULL;
 	ei->i_sync_tid = 0;
 	ei->i_datasync_tid = 0;
+	ei->i_fc_ineligible_tid = 0;
 
 	return &ei->vfs_inode;
 }
@@ -950,6 +951,8 @@ static int ext4_show_options(struct seq_file *seq, struct vfsmount *vfs)
 		seq_puts(seq, ",nobh");
 	if (test_opt(sb, I_VERSION))
 		seq_puts(seq, ",i_version");
+	if (test_opt(sb, FAST_COMMIT))
+		seq_puts(seq, ",fast_commit");
 	if (!test_opt(sb, DELALLOC))
 		seq_puts(seq, ",nodelalloc");
 
@@ -1160,7 +1163,7 @@ enum {
 	Opt_block_validity, Opt_noblock_validity,
 	Opt_inode_readahead_blks, Opt_journal_ioprio,
 	Opt_dioread_nolock, Opt_dioread_lock,
-	Opt_discard, Opt_nodiscard,
+	Opt_discard, Opt_nodiscard, Opt_fast_commit, Opt_nofast_commit,
 };
 
 static const match_table_t tokens = {
@@ -1216,6 +1219,8 @@ static const match_table_t tokens = {
 	{Opt_barrier, "barrier"},
 	{Opt_nobarrier, "nobarrier"},
 	{Opt_i_version, "i_version"},
+	{Opt_fast_commit, "fast_commit"},
+	{Opt_nofast_commit, "nofast_commit"},
 	{Opt_stripe, "stripe=%u"},
 	{Opt_resize, "resize"},
 	{Opt_delalloc, "delalloc"},
@@ -1633,6 +1638,21 @@ set_qf_format:
 			set_opt(sbi->s_mount_opt, I_VERSION);
 			sb->s_flags |= MS_I_VERSION;
 			break;
+		case Opt_fast_commit:
+		case Opt_nofast_commit:
+			/* the area is only taken from a journal just loaded */
+			if (is_remount) {
+				if (!!test_opt(sb, FAST_COMMIT) !=
+				    (token == Opt_fast_commit)) {
+					ext4_msg(sb, KERN_ERR, "Cannot change "
+						 "fast_commit on remount");
+					return 0;
+				}
+			} else if (token == Opt_fast_commit)
+				set_opt(sbi->s_mount_opt, FAST_COMMIT);
+			else
+				clear_opt(sbi->s_mount_opt, FAST_COMMIT);
+			break;
 		case Opt_nodelalloc:
 			clear_opt(sbi->s_mount_opt, DELALLOC);
 			break;
@@ -2869,6 +2889,13 @@ static int ext4_fill_super(struct super_block *sb, void *data, int silent)
 				JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT);
 	}
 
+	if (test_opt(sb, FAST_COMMIT) && !(sb->s_flags & MS_RDONLY) &&
+	    jbd2_journal_init_fast_commit(sbi->s_journal)) {
+		ext4_msg(sb, KERN_WARNING, "no room in journal for fast "
+			 "commits, disabling them");
+		clear_opt(sbi->s_mount_opt, FAST_COMMIT);
+	}
+
 	/* We have now updated the journal if required, so we can
 	 * validate the data journaling mode. */
 	switch (test_opt(sb, DATA_FLAGS)) {
@@ -3325,6 +3352,8 @@ static int ext4_load_journal(struct super_block *sb,
 		}
 	}
 
+	journal->j_fc_replay = ext4_fc_replay;
+
 	if (!EXT4_HAS_INCOMPAT_FEATURE(sb, EXT4_FEATURE_INCOMPAT_RECOVER))
 		err = jbd2_journal_wipe(journal, !really_read_only);
 	if (!err)
@@ -3706,6 +3735,13 @@ static int ext4_remount(struct super_block *sb, int *flags, char *data)
 			 */
 			if (sbi->s_journal)
 				ext4_clear_journal_err(sb, es);
+			/* a read-only mount left the fast commit area alone */
+			if (sbi->s_journal && test_opt(sb, FAST_COMMIT) &&
+			    jbd2_journal_init_fast_commit(sbi->s_journal)) {
+				ext4_msg(sb, KERN_WARNING, "no room in journal "
+					 "for fast commits, disabling them");
+				clear_opt(sbi->s_mount_opt, FAST_COMMIT);
+			}
 			sbi->s_mount_state = le16_to_cpu(es->s_state);
 			if ((err = ext4_group_extend(sb, es, n_blocks_count)))
 				goto restore_opts;
@@ -1072,3 +1072,128 @@ restart_loop:
 
 	wake_up(&journal->j_wait_done_commit);
 }
+
+/**
+ * int jbd2_journal_fast_commit() - Make a record durable for a transaction.
+ * @journal: Journal to act on.
+ * @tid: The running transaction the record belongs to.
+ * @rec: Filesystem record, replayed through j_fc_replay on recovery.
+ * @len: Length of the record.
+ *
+ * Write @rec to the next block of the fast commit area and flush the
+ * device caches, instead of committing @tid.  If the system crashes before
+ * @tid commits, recovery hands the record back to the filesystem after
+ * replaying the log.  The caller guarantees that the record, applied on
+ * top of the transactions before @tid, yields the state it needs on disk;
+ * data blocks the record depends on must already have been written.
+ *
+ * Returns -EAGAIN if @tid can not be fast committed (it is no longer
+ * running, the area is full or still in use by an older transaction, or
+ * the log is empty); the caller must then commit @tid the normal way.
+ */
+int jbd2_journal_fast_commit(journal_t *journal, tid_t tid,
+			     const void *rec, unsigned int len)
+{
+	jbd2_journal_fc_header_t *fc;
+	transaction_t *commit;
+	struct buffer_head *bh;
+	unsigned long long blocknr;
+	unsigned int index;
+	int err;
+
+	if (len > journal->j_blocksize - sizeof(*fc))
+		return -EINVAL;
+
+	/*
+	 * Recovery only replays the fast commits of the first transaction
+	 * missing from the log, so everything before @tid has to be on disk.
+	 */
+	spin_lock(&journal->j_state_lock);
+	while ((commit = journal->j_committing_transaction) != NULL &&
+	       commit->t_tid != tid) {
+		tid_t commit_tid = commit->t_tid;
+
+		spin_unlock(&journal->j_state_lock);
+		err = jbd2_log_wait_commit(journal, commit_tid);
+		if (err)
+			return err;
+		spin_lock(&journal->j_state_lock);
+	}
+
+	/*
+	 * With the log flushed (s_start == 0) recovery does not run at all;
+	 * the next commit rewrites the superblock and lifts that.
+	 */
+	err = -EAGAIN;
+	if (!journal->j_fc_blocks ||
+	    (journal->j_flags & (JBD2_ABORT | JBD2_FLUSHED)) ||
+	    !journal->j_running_transaction ||
+	    journal->j_running_transaction->t_tid != tid)
+		goto out_unlock;
+
+	/*
+	 * The area passes to a new transaction once all writes of the old
+	 * one have finished, so that none of them can land on a block the
+	 * new owner has already written.
+	 */
+	if (journal->j_fc_tid != tid) {
+		if (journal->j_fc_writers)
+			goto out_unlock;
+		journal->j_fc_tid = tid;
+		journal->j_fc_next = 0;
+	}
+	if (journal->j_fc_next == journal->j_fc_blocks)
+		goto out_unlock;
+	index = journal->j_fc_next++;
+	journal->j_fc_writers++;
+	spin_unlock(&journal->j_state_lock);
+
+	err = jbd2_journal_bmap(journal, journal->j_fc_first + index, &blocknr);
+	if (err)
+		goto out;
+	bh = __getblk(journal->j_dev, blocknr, journal->j_blocksize);
+	if (!bh) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	lock_buffer(bh);
+	memset(bh->b_data, 0, journal->j_blocksize);
+	fc = (jbd2_journal_fc_header_t *)bh->b_data;
+	fc->fc_header.h_magic = cpu_to_be32(JBD2_MAGIC_NUMBER);
+	fc->fc_header.h_blocktype = cpu_to_be32(JBD2_FC_BLOCK);
+	fc->fc_header.h_sequence = cpu_to_be32(tid);
+	fc->fc_index = cpu_to_be32(index);
+	fc->fc_len = cpu_to_be32(len);
+	memcpy(fc + 1, rec, len);
+	fc->fc_checksum = cpu_to_be32(crc32_be(~0, (void *)bh->b_data,
+					       journal->j_blocksize));
+	set_buffer_uptodate(bh);
+	unlock_buffer(bh);
+
+	BUFFER_TRACE(bh, "fast commit");
+	mark_buffer_dirty(bh);
+	err = sync_dirty_buffer(bh);
+	brelse(bh);
+	if (err)
+		goto out;
+
+	/* One cache flush covers both the caller's data and the record */
+	if (journal->j_flags & JBD2_BARRIER) {
+		if (journal->j_fs_dev != journal->j_dev)
+			blkdev_issue_flush(journal->j_fs_dev, GFP_KERNEL, NULL,
+					   BLKDEV_IFL_WAIT);
+		blkdev_issue_flush(journal->j_dev, GFP_KERNEL, NULL,
+				   BLKDEV_IFL_WAIT);
+	}
+
+	spin_lock(&journal->j_history_lock);
+	journal->j_stats.ts_fc++;
+	spin_unlock(&journal->j_history_lock);
+out:
+	spin_lock(&journal->j_state_lock);
+	journal->j_fc_writers--;
+out_unlock:
+	spin_unlock(&journal->j_state_lock);
+	return err;
+}
@@ -74,6 +74,8 @@ EXPORT_SYMBOL(jbd2_journal_check_used_features);
 EXPORT_SYMBOL(jbd2_journal_check_available_features);
 EXPORT_SYMBOL(jbd2_journal_set_features);
 EXPORT_SYMBOL(jbd2_journal_load);
+EXPORT_SYMBOL(jbd2_journal_init_fast_commit);
+EXPORT_SYMBOL(jbd2_journal_fast_commit);
 EXPORT_SYMBOL(jbd2_journal_destroy);
 EXPORT_SYMBOL(jbd2_journal_abort);
 EXPORT_SYMBOL(jbd2_journal_errno);
@@ -702,6 +704,9 @@ static int jbd2_seq_info_show(struct seq_file *seq, void *v)
 	seq_printf(seq, "%lu transaction, each up to %u blocks\n",
 			s->stats->ts_tid,
 			s->journal->j_max_transaction_buffers);
+	if (s->journal->j_fc_blocks)
+		seq_printf(seq, "%lu fast commits, %u fast commit blocks\n",
+			   s->stats->ts_fc, s->journal->j_fc_blocks);
 	if (s->stats->ts_tid == 0)
 		return 0;
 	seq_printf(seq, "average: \n  %ums waiting for transaction\n",
@@ -1019,13 +1024,32 @@ static void journal_fail_superblock (journal_t *journal)
  * subsequent use.
  */
 
+/*
+ * The fast commit area, if the journal has one, takes the last blocks of
+ * the journal; the log proper ends where it starts.
+ */
+static void journal_set_fc_area(journal_t *journal)
+{
+	journal_superblock_t *sb = journal->j_superblock;
+	unsigned int blocks = 0;
+
+	if (JBD2_HAS_INCOMPAT_FEATURE(journal,
+				      JBD2_FEATURE_INCOMPAT_FAST_COMMIT))
+		blocks = be32_to_cpu(sb->s_num_fc_blks) ?:
+			 JBD2_DEFAULT_FC_BLOCKS;
+
+	journal->j_fc_blocks = blocks;
+	journal->j_fc_first = be32_to_cpu(sb->s_maxlen) - blocks;
+}
+
 static int journal_reset(journal_t *journal)
 {
 	journal_superblock_t *sb = journal->j_superblock;
 	unsigned long long first, last;
 
+	journal_set_fc_area(journal);
 	first = be32_to_cpu(sb->s_first);
-	last = be32_to_cpu(sb->s_maxlen);
+	last = journal->j_fc_first;
 	if (first + JBD2_MIN_JOURNAL_BLOCKS > last + 1) {
 		printk(KERN_ERR "JBD: Journal too short (blocks %llu-%llu).\n",
 		       first, last);
@@ -1211,7 +1235,8 @@ static int load_superblock(journal_t *journal)
 	journal->j_tail_sequence = be32_to_cpu(sb->s_sequence);
 	journal->j_tail = be32_to_cpu(sb->s_start);
 	journal->j_first = be32_to_cpu(sb->s_first);
-	journal->j_last = be32_to_cpu(sb->s_maxlen);
+	journal_set_fc_area(journal);
+	journal->j_last = journal->j_fc_first;
 	journal->j_errno = be32_to_cpu(sb->s_errno);
 
 	return 0;
@@ -1284,6 +1309,53 @@ recovery_error:
 	return -EIO;
 }
 
+/**
+ * int jbd2_journal_init_fast_commit() - Reserve the fast commit area.
+ * @journal: Journal to act on.
+ *
+ * Set the fast commit feature on a journal and take the fast commit area
+ * out of the end of the log.  The journal must just have been loaded, so
+ * that no transaction has yet used the blocks being given up.  The
+ * superblock is written out at once: recovery has to know where the log
+ * ends before the first transaction wraps around it.
+ */
+int jbd2_journal_init_fast_commit(journal_t *journal)
+{
+	journal_superblock_t *sb = journal->j_superblock;
+	unsigned int blocks;
+
+	if (journal->j_fc_blocks)
+		return 0;
+
+	blocks = be32_to_cpu(sb->s_num_fc_blks) ?: JBD2_DEFAULT_FC_BLOCKS;
+	if (be32_to_cpu(sb->s_first) + JBD2_MIN_JOURNAL_BLOCKS + blocks >
+	    be32_to_cpu(sb->s_maxlen) + 1)
+		return -ENOSPC;
+
+	spin_lock(&journal->j_state_lock);
+	if (journal->j_running_transaction ||
+	    journal->j_committing_transaction ||
+	    journal->j_head != journal->j_first) {
+		spin_unlock(&journal->j_state_lock);
+		return -EBUSY;
+	}
+	if (!jbd2_journal_set_features(journal, 0, 0,
+				       JBD2_FEATURE_INCOMPAT_FAST_COMMIT)) {
+		spin_unlock(&journal->j_state_lock);
+		return -EINVAL;
+	}
+	sb->s_num_fc_blks = cpu_to_be32(blocks);
+	journal_set_fc_area(journal);
+	journal->j_last = journal->j_fc_first;
+	journal->j_free = journal->j_last - journal->j_first;
+	journal->j_fc_tid = journal->j_commit_sequence;
+	journal->j_fc_next = 0;
+	spin_unlock(&journal->j_state_lock);
+
+	mark_buffer_dirty(journal->j_sb_buffer);
+	return sync_dirty_buffer(journal->j_sb_buffer);
+}
+
 /**
  * void jbd2_journal_destroy() - Release a journal_t structure.
  * @journal: Journal to act on.
@@ -210,6 +210,63 @@ do {									\
 		var -= ((journal)->j_last - (journal)->j_first);	\
 } while (0)
 
+/*
+ * Hand the fast commit records of transaction @tid, the first one not
+ * found in the log, to the filesystem.  Records are taken in order from
+ * the start of the fast commit area until the first block that was not
+ * completely written for @tid.
+ */
+static int fc_do_replay(journal_t *journal, tid_t tid)
+{
+	jbd2_journal_fc_header_t *fc;
+	struct buffer_head *bh;
+	unsigned int i, len;
+	__be32 checksum;
+	int err = 0;
+
+	for (i = 0; i < journal->j_fc_blocks; i++) {
+		err = jread(&bh, journal, journal->j_fc_first + i);
+		if (err)
+			break;
+
+		fc = (jbd2_journal_fc_header_t *)bh->b_data;
+		len = be32_to_cpu(fc->fc_len);
+		if (fc->fc_header.h_magic != cpu_to_be32(JBD2_MAGIC_NUMBER) ||
+		    fc->fc_header.h_blocktype != cpu_to_be32(JBD2_FC_BLOCK) ||
+		    be32_to_cpu(fc->fc_header.h_sequence) != tid ||
+		    be32_to_cpu(fc->fc_index) != i ||
+		    len > journal->j_blocksize - sizeof(*fc)) {
+			brelse(bh);
+			break;
+		}
+
+		checksum = fc->fc_checksum;
+		fc->fc_checksum = 0;
+		if (crc32_be(~0, (void *)bh->b_data, journal->j_blocksize) !=
+		    be32_to_cpu(checksum)) {
+			fc->fc_checksum = checksum;
+			brelse(bh);
+			break;
+		}
+		fc->fc_checksum = checksum;
+
+		if (!journal->j_fc_replay) {
+			printk(KERN_WARNING "JBD: no handler for fast commits "
+			       "of transaction %u\n", tid);
+			brelse(bh);
+			break;
+		}
+		err = journal->j_fc_replay(journal, fc + 1, len);
+		brelse(bh);
+		if (err)
+			break;
+	}
+
+	jbd_debug(1, "JBD: replayed %u fast commits of transaction %u\n",
+		  i, tid);
+	return err;
+}
+
 /**
  * jbd2_journal_recover - recovers a on-disk journal
  * @journal: the journal to recover
@@ -250,6 +307,8 @@ int jbd2_journal_recover(journal_t *journal)
 		err = do_one_pass(journal, &info, PASS_REVOKE);
 	if (!err)
 		err = do_one_pass(journal, &info, PASS_REPLAY);
+	if (!err && journal->j_fc_blocks)
+		err = fc_do_replay(journal, info.end_transaction);
 
 	jbd_debug(1, "JBD: recovery, exit status %d, "
 		  "recovered transactions %u to %u\n",
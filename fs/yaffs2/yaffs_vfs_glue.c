@@ -2380,6 +2380,11 @@ static int yaffs_BackgroundThread(void *data)
 		timer.expires = expires+1;
 		timer.data = (unsigned long) current;
 		timer.function = yaffs_background_waker;
+		/*
+		 * Background work can wait for something else to wake
+		 * the cpu, for up to half as long again.
+		 */
+		set_timer_window(&timer, (expires - now) / 2);
 
                 set_current_state(TASK_INTERRUPTIBLE);
 		add_timer(&timer);
@@ -36,4 +36,8 @@ int crypto_aes_set_key(struct crypto_tfm *tfm, const u8 *in_key,
 		unsigned int key_len);
 int crypto_aes_expand_key(struct crypto_aes_ctx *ctx, const u8 *in_key,
 		unsigned int key_len);
+void crypto_aes_encrypt_block(const struct crypto_aes_ctx *ctx, u8 *out,
+			      const u8 *in);
+void crypto_aes_decrypt_block(const struct crypto_aes_ctx *ctx, u8 *out,
+			      const u8 *in);
 #endif
@@ -122,6 +122,7 @@ struct cpufreq_policy {
 #define CPUFREQ_POSTCHANGE	(1)
 #define CPUFREQ_RESUMECHANGE	(8)
 #define CPUFREQ_SUSPENDCHANGE	(9)
+#define CPUFREQ_TRANSITION_COST	(10)
 
 struct cpufreq_freqs {
 	unsigned int cpu;	/* cpu nr */
@@ -130,6 +131,26 @@ struct cpufreq_freqs {
 	u8 flags;		/* flags of cpufreq_driver, see below. */
 };
 
+/*
+ * What a frequency transition cost, as measured by the driver, passed to
+ * the transition notifiers with CPUFREQ_TRANSITION_COST once the
+ * transition is complete.  The phases are those the driver can tell
+ * apart; they need not add up to the total.
+ */
+enum cpufreq_cost_phase {
+	CPUFREQ_COST_VOLTAGE,	/* regulator ramps */
+	CPUFREQ_COST_PLL_LOCK,	/* waiting for PLLs to lock */
+	CPUFREQ_COST_CLOCK,	/* clock source and divider switching */
+	CPUFREQ_COST_MEMORY,	/* memory controller reprogramming */
+	CPUFREQ_COST_NR_PHASES,
+};
+
+struct cpufreq_transition_cost {
+	struct cpufreq_freqs freqs;	/* must be first */
+	unsigned int latency_ns;	/* the whole transition */
+	unsigned int phase_ns[CPUFREQ_COST_NR_PHASES];
+};
+
 
 /**
  * cpufreq_scale - "old * mult / div" calculation for large values (32-bit-arch safe)
@@ -255,6 +276,7 @@ int cpufreq_unregister_driver(struct cpufreq_driver *driver_data);
 
 
 void cpufreq_notify_transition(struct cpufreq_freqs *freqs, unsigned int state);
+void cpufreq_notify_transition_cost(struct cpufreq_transition_cost *cost);
 
 
 static inline void cpufreq_verify_within_limits(struct cpufreq_policy *policy, unsigned int min, unsigned int max) 
@@ -369,6 +391,9 @@ extern struct cpufreq_governor cpufreq_gov_ondemand;
 #elif defined(CONFIG_CPU_FREQ_DEFAULT_GOV_CONSERVATIVE)
 extern struct cpufreq_governor cpufreq_gov_conservative;
 #define CPUFREQ_DEFAULT_GOVERNOR	(&cpufreq_gov_conservative)
+#elif defined(CONFIG_CPU_FREQ_DEFAULT_GOV_INTERACTIVE)
+extern struct cpufreq_governor cpufreq_gov_interactive;
+#define CPUFREQ_DEFAULT_GOVERNOR	(&cpufreq_gov_interactive)
 #endif
 
 
@@ -20,6 +20,7 @@
 #define CPUIDLE_STATE_MAX	8
 #define CPUIDLE_NAME_LEN	16
 #define CPUIDLE_DESC_LEN	32
+#define CPUIDLE_HIST_BUCKETS	20 /* log2 of uS, last one open-ended */
 
 struct cpuidle_device;
 
@@ -40,6 +41,10 @@ struct cpuidle_state {
 
 	unsigned long long	usage;
 	unsigned long long	time; /* in US */
+#ifdef CONFIG_CPU_IDLE_STAT_DETAILS
+	unsigned long long	residency_hist[CPUIDLE_HIST_BUCKETS];
+	unsigned long long	wakeup_hist[CPUIDLE_HIST_BUCKETS];
+#endif
 
 	int (*enter)	(struct cpuidle_device *dev,
 			 struct cpuidle_state *state);
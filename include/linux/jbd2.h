@@ -130,6 +130,7 @@ typedef struct journal_s	journal_t;	/* Journal control structure */
 #define JBD2_SUPERBLOCK_V1	3
 #define JBD2_SUPERBLOCK_V2	4
 #define JBD2_REVOKE_BLOCK	5
+#define JBD2_FC_BLOCK		6
 
 /*
  * Standard header for all descriptor blocks:
@@ -193,6 +194,22 @@ typedef struct jbd2_journal_revoke_header_s
 } jbd2_journal_revoke_header_t;
 
 
+/*
+ * The fast commit block: a single block written outside the log proper, in
+ * the fast commit area at the end of the journal.  It carries a record
+ * opaque to jbd2 which the filesystem replays, through j_fc_replay, after
+ * all complete transactions have been recovered.  Only blocks whose
+ * h_sequence is that of the first transaction not found in the log, and
+ * whose fc_index matches their position in the area, are replayed.
+ */
+typedef struct jbd2_journal_fc_header_s
+{
+	journal_header_t fc_header;
+	__be32		 fc_index;	/* Position in the fast commit area */
+	__be32		 fc_len;	/* Bytes of record following the header */
+	__be32		 fc_checksum;	/* crc32_be of the block, this field 0 */
+} jbd2_journal_fc_header_t;
+
 /* Definitions for the journal tag flags word: */
 #define JBD2_FLAG_ESCAPE		1	/* on-disk block is escaped */
 #define JBD2_FLAG_SAME_UUID	2	/* block has same uuid as previous */
@@ -241,7 +258,8 @@ typedef struct journal_superblock_s
 	__be32	s_max_trans_data;	/* Limit of data blocks per trans. */
 
 /* 0x0050 */
-	__u32	s_padding[44];
+	__be32	s_num_fc_blks;		/* Blocks in the fast commit area */
+	__u32	s_padding[43];
 
 /* 0x0100 */
 	__u8	s_users[16*48];		/* ids of all fs'es sharing the log */
@@ -263,13 +281,23 @@ typedef struct journal_superblock_s
 #define JBD2_FEATURE_INCOMPAT_REVOKE		0x00000001
 #define JBD2_FEATURE_INCOMPAT_64BIT		0x00000002
 #define JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT	0x00000004
+/*
+ * Not the upstream fast commit format: its own bit, far from the ones
+ * upstream assigns (0x20 is theirs), so that neither side takes the
+ * other's journal for its own.
+ */
+#define JBD2_FEATURE_INCOMPAT_FAST_COMMIT	0x80000000
 
 /* Features known to this kernel version: */
 #define JBD2_KNOWN_COMPAT_FEATURES	JBD2_FEATURE_COMPAT_CHECKSUM
 #define JBD2_KNOWN_ROCOMPAT_FEATURES	0
 #define JBD2_KNOWN_INCOMPAT_FEATURES	(JBD2_FEATURE_INCOMPAT_REVOKE | \
 					JBD2_FEATURE_INCOMPAT_64BIT | \
-					JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT)
+					JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT | \
+					JBD2_FEATURE_INCOMPAT_FAST_COMMIT)
+
+/* Default size of the fast commit area, in journal blocks */
+#define JBD2_DEFAULT_FC_BLOCKS	64
 
 #ifdef __KERNEL__
 
@@ -659,6 +687,7 @@ struct transaction_run_stats_s {
 
 struct transaction_stats_s {
 	unsigned long		ts_tid;
+	unsigned long		ts_fc;
 	struct transaction_run_stats_s run;
 };
 
@@ -733,6 +762,11 @@ jbd2_time_diff(unsigned long start, unsigned long end)
  * @j_wbuf: array of buffer_heads for jbd2_journal_commit_transaction
  * @j_wbufsize: maximum number of buffer_heads allowed in j_wbuf, the
  *	number that will fit in j_blocksize
+ * @j_fc_first: first journal block of the fast commit area
+ * @j_fc_blocks: number of blocks in the fast commit area
+ * @j_fc_tid: transaction the fast commit area currently belongs to
+ * @j_fc_next: next free block of the fast commit area
+ * @j_fc_writers: number of fast commits in flight
  * @j_last_sync_writer: most recent pid which did a synchronous write
  * @j_history: Buffer storing the transactions statistics history
  * @j_history_max: Maximum number of transactions in the statistics history
@@ -740,6 +774,7 @@ jbd2_time_diff(unsigned long start, unsigned long end)
  * @j_history_lock: Protect the transactions statistics history
  * @j_proc_entry: procfs entry for the jbd statistics directory
  * @j_stats: Overall statistics
+ * @j_fc_replay: fs callback replaying one fast commit record
  * @j_private: An opaque pointer to fs-private information.
  */
 
@@ -938,6 +973,18 @@ struct journal_s
 	struct buffer_head	**j_wbuf;
 	int			j_wbufsize;
 
+	/*
+	 * Fast commit area: j_fc_blocks blocks starting at journal block
+	 * j_fc_first, just beyond j_last.  It is owned by transaction
+	 * j_fc_tid, which has used j_fc_next blocks of it; j_fc_writers
+	 * fast commits are in flight. [j_state_lock]
+	 */
+	unsigned long		j_fc_first;
+	unsigned int		j_fc_blocks;
+	tid_t			j_fc_tid;
+	unsigned int		j_fc_next;
+	unsigned int		j_fc_writers;
+
 	/*
 	 * this is the pid of hte last person to run a synchronous operation
 	 * through the journal
@@ -962,6 +1009,12 @@ struct journal_s
 	void			(*j_commit_callback)(journal_t *,
 						     transaction_t *);
 
+	/*
+	 * Called during recovery for each fast commit record of the
+	 * transaction that did not make it to the log
+	 */
+	int			(*j_fc_replay)(journal_t *, void *, unsigned int);
+
 	/*
 	 * Journal statistics
 	 */
@@ -1115,6 +1168,9 @@ extern int	   jbd2_journal_set_features
 extern void	   jbd2_journal_clear_features
 		   (journal_t *, unsigned long, unsigned long, unsigned long);
 extern int	   jbd2_journal_load       (journal_t *journal);
+extern int	   jbd2_journal_init_fast_commit(journal_t *journal);
+extern int	   jbd2_journal_fast_commit(journal_t *journal, tid_t tid,
+					    const void *rec, unsigned int len);
 extern int	   jbd2_journal_destroy    (journal_t *);
 extern int	   jbd2_journal_recover    (journal_t *journal);
 extern int	   jbd2_journal_wipe       (journal_t *, int);
@@ -0,0 +1,19 @@
+#ifndef _XT_UIDTAG_MATCH_H
+#define _XT_UIDTAG_MATCH_H
+
+#include <linux/types.h>
+
+enum {
+	XT_UIDTAG_UID     = 1 << 0,
+	XT_UIDTAG_TAG     = 1 << 1,
+	XT_UIDTAG_SOCKET  = 1 << 2,
+	XT_UIDTAG_ACCOUNT = 1 << 3,
+};
+
+struct xt_uidtag_match_info {
+	__u32 uid_min, uid_max;
+	__u32 tag;
+	__u8 match, invert;
+};
+
+#endif /* _XT_UIDTAG_MATCH_H */
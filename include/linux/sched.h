@@ -1217,6 +1217,9 @@ struct task_struct {
 #if defined(CONFIG_SCHEDSTATS) || defined(CONFIG_TASK_DELAY_ACCT)
 	struct sched_info sched_info;
 #endif
+#ifdef CONFIG_CGROUP_SCHED_LATENCY
+	u64 sched_wakeup_stamp;		/* rq->clock at wakeup, 0 once running */
+#endif
 
 	struct list_head tasks;
 	struct plist_node pushable_tasks;
@@ -306,6 +306,7 @@ typedef unsigned char *sk_buff_data_t;
  *	@tc_index: Traffic control index
  *	@tc_verd: traffic control verdict
  *	@ndisc_nodetype: router type (from link layer)
+ *	@pool_id: receive buffer pool the data goes back to, 0 for none
  *	@dma_cookie: a cookie to one of several possible DMA operations
  *		done by skb DMA functions
  *	@secmark: security marking
@@ -387,9 +388,10 @@ struct sk_buff {
 #else
 	__u8			deliver_no_wcard:1;
 #endif
+	__u8			pool_id:3;
 	kmemcheck_bitfield_end(flags2);
 
-	/* 0/14 bit hole */
+	/* 0/11 bit hole */
 
 #ifdef CONFIG_NET_DMA
 	dma_cookie_t		dma_cookie;
@@ -508,6 +510,15 @@ static inline struct sk_buff *alloc_skb_fclone(unsigned int size,
 
 extern bool skb_recycle_check(struct sk_buff *skb, int skb_size);
 
+struct skb_pool;
+extern int sysctl_skb_pool;
+extern struct skb_pool *skb_pool_create(const char *name, unsigned int size,
+					unsigned int count);
+extern void skb_pool_destroy(struct skb_pool *pool);
+extern struct sk_buff *skb_pool_alloc(struct skb_pool *pool,
+				      struct net_device *dev,
+				      unsigned int length, gfp_t gfp_mask);
+
 extern struct sk_buff *skb_morph(struct sk_buff *dst, struct sk_buff *src);
 extern struct sk_buff *skb_clone(struct sk_buff *skb,
 				 gfp_t priority);
@@ -459,6 +459,16 @@ struct tcp_sock {
 	 * contains related tcp_cookie_transactions fields.
 	 */
 	struct tcp_cookie_values  *cookie_values;
+
+/* Small queues: sending held back until the device frees what it has */
+	unsigned long	tsq_flags;
+	struct list_head tsq_node;	/* on the tasklet list while queued */
+};
+
+enum tsq_flags {
+	TSQ_THROTTLED,		/* over tcp_limit_output_bytes */
+	TSQ_QUEUED,		/* on the tasklet list */
+	TCP_TSQ_DEFERRED,	/* tasklet found the socket owned by user */
 };
 
 static inline struct tcp_sock *tcp_sk(const struct sock *sk)
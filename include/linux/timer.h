@@ -172,6 +172,7 @@ extern int mod_timer_pending(struct timer_list *timer, unsigned long expires);
 extern int mod_timer_pinned(struct timer_list *timer, unsigned long expires);
 
 extern void set_timer_slack(struct timer_list *time, int slack_hz);
+extern void set_timer_window(struct timer_list *timer, int window_hz);
 
 #define TIMER_NOT_PINNED	0
 #define TIMER_PINNED		1
@@ -196,6 +197,7 @@ extern unsigned long get_next_timer_interrupt(unsigned long now);
 extern int timer_stats_active;
 
 #define TIMER_STATS_FLAG_DEFERRABLE	0x1
+#define TIMER_STATS_FLAG_WINDOW		0x2
 
 extern void init_timer_stats(void);
 
@@ -217,11 +219,27 @@ static inline void timer_stats_timer_clear_start_info(struct timer_list *timer)
 {
 	timer->start_site = NULL;
 }
+
+extern void timer_stats_idle_enter(void);
+extern void timer_stats_idle_exit(ktime_t now);
+extern void timer_stats_pass_wakeup(void *timer);
 #else
 static inline void init_timer_stats(void)
 {
 }
 
+static inline void timer_stats_idle_enter(void)
+{
+}
+
+static inline void timer_stats_idle_exit(ktime_t now)
+{
+}
+
+static inline void timer_stats_pass_wakeup(void *timer)
+{
+}
+
 static inline void timer_stats_timer_set_start_info(struct timer_list *timer)
 {
 }
@@ -18,12 +18,57 @@
 
 /* Contains definitions for resource tracking per uid. */
 
+#include <linux/types.h>
+
+struct net;
+struct net_device;
+struct sock;
+
+enum uid_stat_type {
+	UID_STAT_TCP_SND,
+	UID_STAT_TCP_RCV,
+	UID_STAT_UDP_SND,
+	UID_STAT_UDP_RCV,
+	UID_STAT_NR_TYPES
+};
+
+/*
+ * Bytes are counted against the interface they went through, which is
+ * given as the device, as the device of the route cached in the socket,
+ * or as an interface index.
+ */
 #ifdef CONFIG_UID_STAT
-int uid_stat_tcp_snd(uid_t uid, int size);
-int uid_stat_tcp_rcv(uid_t uid, int size);
+int uid_stat_dev(uid_t uid, const struct net_device *dev,
+		 enum uid_stat_type type, int size);
+int uid_stat_sock(uid_t uid, struct sock *sk,
+		  enum uid_stat_type type, int size);
+int uid_stat_iif(uid_t uid, struct net *net, int ifindex,
+		 enum uid_stat_type type, int size);
 #else
-#define uid_stat_tcp_snd(uid, size) do {} while (0);
-#define uid_stat_tcp_rcv(uid, size) do {} while (0);
+static inline int uid_stat_dev(uid_t uid, const struct net_device *dev,
+			       enum uid_stat_type type, int size)
+{
+	return 0;
+}
+static inline int uid_stat_sock(uid_t uid, struct sock *sk,
+				enum uid_stat_type type, int size)
+{
+	return 0;
+}
+static inline int uid_stat_iif(uid_t uid, struct net *net, int ifindex,
+			       enum uid_stat_type type, int size)
+{
+	return 0;
+}
 #endif
 
+#define uid_stat_tcp_snd(uid, sk, size) \
+	uid_stat_sock(uid, sk, UID_STAT_TCP_SND, size)
+#define uid_stat_tcp_rcv(uid, sk, size) \
+	uid_stat_sock(uid, sk, UID_STAT_TCP_RCV, size)
+#define uid_stat_udp_snd(uid, dev, size) \
+	uid_stat_dev(uid, dev, UID_STAT_UDP_SND, size)
+#define uid_stat_udp_rcv(uid, net, ifindex, size) \
+	uid_stat_iif(uid, net, ifindex, UID_STAT_UDP_RCV, size)
+
 #endif /* _LINUX_UID_STAT_H */
@@ -128,6 +128,26 @@ void get_dirty_limits(unsigned long *pbackground, unsigned long *pdirty,
 		      unsigned long *pbdi_dirty, struct backing_dev_info *bdi);
 
 void page_writeback_init(void);
+
+#ifdef CONFIG_CGROUP_SCHED
+/*
+ * Dirty page accounting of a cpu cgroup. Pages are not tagged with the
+ * group that dirtied them; instead the group's share of recently dirtied
+ * pages is tracked and applied to the global dirty count.
+ */
+struct group_dirty {
+	struct prop_local_single dirties;
+	unsigned int dirty_ratio;	/* % of the dirty limit the group may use */
+	atomic_long_t nr_dirtied;	/* pages dirtied */
+	atomic_long_t nr_throttled;	/* times a task was throttled on the group limit */
+	atomic_long_t throttle_time;	/* jiffies spent throttled on it */
+};
+
+void group_dirty_init(struct group_dirty *gd);
+unsigned long group_dirty_pages(struct group_dirty *gd);
+extern struct group_dirty *task_group_dirty(struct task_struct *tsk);
+#endif
+
 void balance_dirty_pages_ratelimited_nr(struct address_space *mapping,
 					unsigned long nr_pages_dirtied);
 
@@ -0,0 +1,46 @@
+#ifndef _LINUX_ZERO_POOL_H
+#define _LINUX_ZERO_POOL_H
+
+/*
+ * Pool of pages zeroed in idle time, for allocations that want a zeroed,
+ * movable, highmem order-0 page - anonymous page faults above all.
+ */
+
+#include <linux/gfp.h>
+
+#ifdef CONFIG_PAGE_ZERO_POOL
+
+#define ZERO_POOL_GFP_MASK	(__GFP_ZERO | __GFP_HIGHMEM | __GFP_MOVABLE)
+
+extern int zero_pool_run;
+extern struct page *__zero_pool_alloc(void);
+extern u64 zero_pool_fault_start(void);
+extern void zero_pool_fault_end(u64 start);
+
+static inline struct page *zero_pool_alloc(gfp_t gfp_mask, unsigned int order)
+{
+	if (!zero_pool_run || order ||
+	    (gfp_mask & ZERO_POOL_GFP_MASK) != ZERO_POOL_GFP_MASK)
+		return NULL;
+	return __zero_pool_alloc();
+}
+
+#else /* !CONFIG_PAGE_ZERO_POOL */
+
+static inline struct page *zero_pool_alloc(gfp_t gfp_mask, unsigned int order)
+{
+	return NULL;
+}
+
+static inline u64 zero_pool_fault_start(void)
+{
+	return 0;
+}
+
+static inline void zero_pool_fault_end(u64 start)
+{
+}
+
+#endif /* !CONFIG_PAGE_ZERO_POOL */
+
+#endif /* _LINUX_ZERO_POOL_H */
@@ -16,10 +16,26 @@
 #ifndef __activity_stats_h
 #define __activity_stats_h
 
+#include <linux/if_arp.h>
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
+
 #ifdef CONFIG_NET_ACTIVITY_STATS
 void activity_stats_update(void);
+void __activity_stats_radio(struct sk_buff *skb, int rx);
+
+/*
+ * A packet sent or received on @skb->dev.  The interfaces of the modem
+ * are point-to-point; what goes over them keeps the radio up.
+ */
+static inline void activity_stats_radio(struct sk_buff *skb, int rx)
+{
+	if (unlikely(skb->dev->type == ARPHRD_PPP))
+		__activity_stats_radio(skb, rx);
+}
 #else
 #define activity_stats_update(void) {}
+#define activity_stats_radio(skb, rx) do { } while (0)
 #endif
 
 #endif /* _NET_ACTIVITY_STATS_H */
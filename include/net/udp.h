@@ -185,6 +185,9 @@ extern int 	udp_lib_setsockopt(struct sock *sk, int level, int optname,
 extern struct sock *udp4_lib_lookup(struct net *net, __be32 saddr, __be16 sport,
 				    __be32 daddr, __be16 dport,
 				    int dif);
+extern struct sock *udp6_lib_lookup(struct net *net, struct in6_addr *saddr,
+				    __be16 sport, struct in6_addr *daddr,
+				    __be16 dport, int dif);
 
 /*
  * 	SNMP statistics for UDP and UDP-Lite
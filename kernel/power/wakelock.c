@@ -563,6 +563,9 @@ static int __init wakelocks_init(void)
 	for (i = 0; i < ARRAY_SIZE(active_wake_locks); i++)
 		INIT_LIST_HEAD(&active_wake_locks[i]);
 
+	/* an idle cpu may wait a little for another wakeup to expire locks */
+	set_timer_window(&expire_timer, HZ / 10);
+
 #ifdef CONFIG_WAKELOCK_STAT
 	wake_lock_init(&deleted_wake_locks, WAKE_LOCK_SUSPEND,
 			"deleted_wake_locks");
@@ -37,6 +37,8 @@
 #include <linux/ratelimit.h>
 #include <linux/kmsg_dump.h>
 #include <linux/syslog.h>
+#include <linux/kthread.h>
+#include <linux/sched.h>
 
 #include <asm/uaccess.h>
 
@@ -143,6 +145,15 @@ EXPORT_SYMBOL(console_set_on_cmdline);
 /* Flag: console code may call schedule() */
 static int console_may_schedule;
 
+/* Writes log_buf to the consoles when printk() leaves that for later */
+static struct task_struct *printk_task;
+
+/* printk_pending bits */
+#define PRINTK_PENDING_WAKEUP	0x01	/* klogd has something to read */
+#define PRINTK_PENDING_OUTPUT	0x02	/* printk_task has work */
+
+static DEFINE_PER_CPU(int, printk_pending);
+
 #ifdef CONFIG_PRINTK
 
 static char __log_buf[__LOG_BUF_LEN];
@@ -367,6 +378,8 @@ static inline void boot_delay_msec(void)
 }
 #endif
 
+static void printk_rings_drain(void);
+
 /*
  * Return the number of unread characters in the log buffer.
  */
@@ -394,6 +407,7 @@ int log_buf_copy(char *dest, int idx, int len)
 	if (!oops_in_progress) {
 		spin_lock_irq(&logbuf_lock);
 		took_lock = true;
+		printk_rings_drain();
 	}
 
 	max = log_buf_get_len();
@@ -496,6 +510,7 @@ int do_syslog(int type, char __user *buf, int len, bool from_file)
 		if (count > log_buf_len)
 			count = log_buf_len;
 		spin_lock_irq(&logbuf_lock);
+		printk_rings_drain();
 		if (count > logged_chars)
 			count = logged_chars;
 		if (do_clear)
@@ -859,61 +874,19 @@ static inline void printk_delay(void)
 	}
 }
 
-asmlinkage int vprintk(const char *fmt, va_list args)
+/*
+ * Copy a message into log_buf, putting the loglevel token and the time
+ * stamp t at the start of each of its lines.  Called with logbuf_lock
+ * held; returns the number of characters added to the text.
+ */
+static int log_store(const char *p, int len, unsigned long long t)
 {
-	int printed_len = 0;
 	int current_log_level = default_message_loglevel;
-	unsigned long flags;
-	int this_cpu;
-	char *p;
-
-	boot_delay_msec();
-	printk_delay();
-
-	preempt_disable();
-	/* This stops the holder of console_sem just where we want him */
-	raw_local_irq_save(flags);
-	this_cpu = smp_processor_id();
-
-	/*
-	 * Ouch, printk recursed into itself!
-	 */
-	if (unlikely(printk_cpu == this_cpu)) {
-		/*
-		 * If a crash is occurring during printk() on this CPU,
-		 * then try to get the crash message out but make sure
-		 * we can't deadlock. Otherwise just return to avoid the
-		 * recursion and return - but flag the recursion so that
-		 * it can be printed at the next appropriate moment:
-		 */
-		if (!oops_in_progress) {
-			recursion_bug = 1;
-			goto out_restore_irqs;
-		}
-		zap_locks();
-	}
-
-	lockdep_off();
-	spin_lock(&logbuf_lock);
-	printk_cpu = this_cpu;
-
-	if (recursion_bug) {
-		recursion_bug = 0;
-		strcpy(printk_buf, recursion_bug_msg);
-		printed_len = strlen(recursion_bug_msg);
-	}
-	/* Emit the output into the temporary buffer */
-	printed_len += vscnprintf(printk_buf + printed_len,
-				  sizeof(printk_buf) - printed_len, fmt, args);
-
-#ifdef	CONFIG_DEBUG_LL
-	printascii(printk_buf);
-#endif
-
-	p = printk_buf;
+	const char *end = p + len;
+	int printed_len = 0;
 
 	/* Do we have a loglevel in the string? */
-	if (p[0] == '<') {
+	if (len >= 3 && p[0] == '<') {
 		unsigned char c = p[1];
 		if (c && p[2] == '>') {
 			switch (c) {
@@ -937,7 +910,7 @@ asmlinkage int vprintk(const char *fmt, va_list args)
 	 * Copy the output into log_buf.  If the caller didn't provide
 	 * appropriate log level tags, we insert them here
 	 */
-	for ( ; *p; p++) {
+	for ( ; p < end; p++) {
 		if (new_text_line) {
 			/* Always output the token */
 			emit_log_char('<');
@@ -950,22 +923,18 @@ asmlinkage int vprintk(const char *fmt, va_list args)
 				/* Follow the token with the time */
 				char tbuf[50], *tp;
 				unsigned tlen;
-				unsigned long long t;
+				unsigned long long ts = t;
 				unsigned long nanosec_rem;
 
-				t = cpu_clock(printk_cpu);
-				nanosec_rem = do_div(t, 1000000000);
+				nanosec_rem = do_div(ts, 1000000000);
 				tlen = sprintf(tbuf, "[%5lu.%06lu] ",
-						(unsigned long) t,
+						(unsigned long) ts,
 						nanosec_rem / 1000);
 
 				for (tp = tbuf; tp < tbuf + tlen; tp++)
 					emit_log_char(*tp);
 				printed_len += tlen;
 			}
-
-			if (!*p)
-				break;
 		}
 
 		emit_log_char(*p);
@@ -973,6 +942,275 @@ asmlinkage int vprintk(const char *fmt, va_list args)
 			new_text_line = 1;
 	}
 
+	return printed_len;
+}
+
+/*
+ * Unless printk() has to reach the consoles before returning, it only
+ * formats the message into a ring of the calling cpu, with interrupts
+ * off for that time alone.  printk_task later moves the messages into
+ * log_buf, oldest first across the rings, and writes them out a chunk
+ * at a time, with interrupts on between the chunks.  Each ring has a single writer, its cpu, and a single
+ * reader, whoever holds logbuf_lock, so it needs no lock of its own; a
+ * message that finds its ring full is dropped and counted.
+ */
+#define PRINTK_RING_SIZE	(16 << 10)
+#define PRINTK_REC_PAD		UINT_MAX
+
+struct printk_rec {
+	unsigned long long	ts;
+	unsigned int		len;	/* of the text following, or PAD */
+	unsigned int		unused;
+};
+
+struct printk_ring {
+	unsigned int		head;		/* written by its cpu */
+	unsigned int		tail;		/* written under logbuf_lock */
+	unsigned int		dropped;	/* written by its cpu */
+	unsigned int		dropped_seen;	/* written under logbuf_lock */
+	int			busy;
+	char			text[1024];
+	char			buf[PRINTK_RING_SIZE];
+};
+
+static DEFINE_PER_CPU(struct printk_ring, printk_ring);
+
+static int printk_deferred = 1;
+module_param_named(deferred, printk_deferred, bool, S_IRUGO | S_IWUSR);
+
+/*
+ * Oopses, panics and the messages of early boot and of shutdown go out
+ * before printk() returns, as they always did.
+ */
+static inline int printk_deferred_ok(void)
+{
+	return printk_deferred && printk_task && !oops_in_progress &&
+		system_state <= SYSTEM_RUNNING;
+}
+
+static inline unsigned int printk_rec_size(unsigned int len)
+{
+	return ALIGN(sizeof(struct printk_rec) + len,
+		     sizeof(struct printk_rec));
+}
+
+/* Called by the ring's cpu with interrupts off */
+static void printk_ring_write(struct printk_ring *r, const char *text,
+			      unsigned int len, unsigned long long ts)
+{
+	unsigned int head = r->head, size = printk_rec_size(len);
+	unsigned int off = head & (PRINTK_RING_SIZE - 1), pad = 0;
+	struct printk_rec *rec;
+
+	/* a record does not wrap, the end of the ring is skipped instead */
+	if (off + size > PRINTK_RING_SIZE)
+		pad = PRINTK_RING_SIZE - off;
+	if (head + pad + size - ACCESS_ONCE(r->tail) > PRINTK_RING_SIZE) {
+		r->dropped++;
+		return;
+	}
+	/* the reader is done with the space before we write over it */
+	smp_mb();
+
+	if (pad) {
+		rec = (struct printk_rec *)(r->buf + off);
+		rec->len = PRINTK_REC_PAD;
+		head += pad;
+		off = 0;
+	}
+	rec = (struct printk_rec *)(r->buf + off);
+	rec->ts = ts;
+	rec->len = len;
+	memcpy(rec + 1, text, len);
+
+	smp_wmb();
+	r->head = head + size;
+}
+
+/* The oldest record in r, or NULL; called with logbuf_lock held */
+static struct printk_rec *printk_ring_peek(struct printk_ring *r)
+{
+	unsigned int head = ACCESS_ONCE(r->head);
+	struct printk_rec *rec;
+
+	smp_rmb();
+	while (r->tail != head) {
+		rec = (struct printk_rec *)
+			(r->buf + (r->tail & (PRINTK_RING_SIZE - 1)));
+		if (rec->len != PRINTK_REC_PAD)
+			return rec;
+		r->tail += PRINTK_RING_SIZE -
+			(r->tail & (PRINTK_RING_SIZE - 1));
+	}
+	return NULL;
+}
+
+static inline int printk_rings_empty(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct printk_ring *r = &per_cpu(printk_ring, cpu);
+
+		if (ACCESS_ONCE(r->head) != r->tail)
+			return 0;
+	}
+	return 1;
+}
+
+/* Move the messages of the rings into log_buf; logbuf_lock held */
+static void printk_rings_drain(void)
+{
+	struct printk_ring *r, *oldest;
+	struct printk_rec *rec, *first;
+	unsigned int dropped;
+	char buf[64];
+	int cpu;
+
+	if (recursion_bug) {
+		recursion_bug = 0;
+		log_store(recursion_bug_msg, strlen(recursion_bug_msg),
+			  cpu_clock(smp_processor_id()));
+	}
+
+	for (;;) {
+		first = NULL;
+		oldest = NULL;
+		for_each_possible_cpu(cpu) {
+			r = &per_cpu(printk_ring, cpu);
+			rec = printk_ring_peek(r);
+			if (rec && (!first || rec->ts < first->ts)) {
+				first = rec;
+				oldest = r;
+			}
+		}
+		if (!first)
+			break;
+
+		log_store((const char *)(first + 1), first->len, first->ts);
+		/* done with the record before its cpu may write over it */
+		smp_mb();
+		oldest->tail += printk_rec_size(first->len);
+	}
+
+	for_each_possible_cpu(cpu) {
+		r = &per_cpu(printk_ring, cpu);
+		dropped = ACCESS_ONCE(r->dropped);
+		if (dropped == r->dropped_seen)
+			continue;
+		log_store(buf, snprintf(buf, sizeof(buf),
+			  KERN_WARNING "printk: %u messages dropped on cpu %d\n",
+			  dropped - r->dropped_seen, cpu),
+			  cpu_clock(smp_processor_id()));
+		r->dropped_seen = dropped;
+	}
+}
+
+static int vprintk_deferred(const char *fmt, va_list args)
+{
+	struct printk_ring *r;
+	unsigned long flags;
+	int len = 0;
+
+	raw_local_irq_save(flags);
+	r = &__get_cpu_var(printk_ring);
+
+	/* printk() from within vscnprintf() */
+	if (unlikely(r->busy)) {
+		recursion_bug = 1;
+		goto out;
+	}
+	r->busy = 1;
+
+	len = vscnprintf(r->text, sizeof(r->text), fmt, args);
+#ifdef	CONFIG_DEBUG_LL
+	printascii(r->text);
+#endif
+	printk_ring_write(r, r->text, len, cpu_clock(smp_processor_id()));
+
+	/* printk_tick() wakes printk_task, waking it here could deadlock */
+	__get_cpu_var(printk_pending) |= PRINTK_PENDING_OUTPUT;
+	r->busy = 0;
+out:
+	raw_local_irq_restore(flags);
+	return len;
+}
+
+/*
+ * The holder of console_sem, such as printk_task between two chunks, may
+ * be what the oops interrupted, and never get to write it out.  So an
+ * oops is written without console_sem, as the console drivers expect
+ * with oops_in_progress set.  Called with interrupts off.
+ */
+static void printk_oops_flush(void)
+{
+	unsigned _con_start, _log_end;
+
+	if (console_suspended || !spin_trylock(&logbuf_lock))
+		return;
+	_con_start = con_start;
+	_log_end = log_end;
+	con_start = log_end;
+	spin_unlock(&logbuf_lock);
+	call_console_drivers(_con_start, _log_end);
+}
+
+asmlinkage int vprintk(const char *fmt, va_list args)
+{
+	int printed_len = 0;
+	unsigned long flags;
+	int this_cpu;
+
+	boot_delay_msec();
+	printk_delay();
+
+	if (printk_deferred_ok())
+		return vprintk_deferred(fmt, args);
+
+	preempt_disable();
+	/* This stops the holder of console_sem just where we want him */
+	raw_local_irq_save(flags);
+	this_cpu = smp_processor_id();
+
+	/*
+	 * Ouch, printk recursed into itself!
+	 */
+	if (unlikely(printk_cpu == this_cpu)) {
+		/*
+		 * If a crash is occurring during printk() on this CPU,
+		 * then try to get the crash message out but make sure
+		 * we can't deadlock. Otherwise just return to avoid the
+		 * recursion and return - but flag the recursion so that
+		 * it can be printed at the next appropriate moment:
+		 */
+		if (!oops_in_progress) {
+			recursion_bug = 1;
+			goto out_restore_irqs;
+		}
+		zap_locks();
+	}
+
+	lockdep_off();
+	spin_lock(&logbuf_lock);
+	printk_cpu = this_cpu;
+
+	if (recursion_bug) {
+		recursion_bug = 0;
+		strcpy(printk_buf, recursion_bug_msg);
+		printed_len = strlen(recursion_bug_msg);
+	}
+	/* Emit the output into the temporary buffer */
+	printed_len += vscnprintf(printk_buf + printed_len,
+				  sizeof(printk_buf) - printed_len, fmt, args);
+
+#ifdef	CONFIG_DEBUG_LL
+	printascii(printk_buf);
+#endif
+
+	/* what was left in the rings goes first */
+	printk_rings_drain();
+	printed_len += log_store(printk_buf, printed_len, cpu_clock(this_cpu));
+
 	/*
 	 * Try to acquire and then immediately release the
 	 * console semaphore. The release will do all the
@@ -985,6 +1223,8 @@ asmlinkage int vprintk(const char *fmt, va_list args)
 	 */
 	if (acquire_console_semaphore_for_printk(this_cpu))
 		release_console_sem();
+	else if (oops_in_progress && can_use_console(this_cpu))
+		printk_oops_flush();
 
 	lockdep_on();
 out_restore_irqs:
@@ -1002,6 +1242,20 @@ static void call_console_drivers(unsigned start, unsigned end)
 {
 }
 
+static inline int printk_deferred_ok(void)
+{
+	return 0;
+}
+
+static inline int printk_rings_empty(void)
+{
+	return 1;
+}
+
+static inline void printk_rings_drain(void)
+{
+}
+
 #endif
 
 static int __add_preferred_console(char *name, int idx, char *options,
@@ -1157,6 +1411,9 @@ void resume_console(void)
 	down(&console_sem);
 	console_suspended = 0;
 	release_console_sem();
+	/* it sleeps through the suspend with the output held back */
+	if (printk_task)
+		wake_up_process(printk_task);
 }
 
 /**
@@ -1197,13 +1454,16 @@ int is_console_locked(void)
 	return console_locked;
 }
 
-static DEFINE_PER_CPU(int, printk_pending);
-
 void printk_tick(void)
 {
-	if (__get_cpu_var(printk_pending)) {
+	int pending = __get_cpu_var(printk_pending);
+
+	if (pending) {
 		__get_cpu_var(printk_pending) = 0;
-		wake_up_interruptible(&log_wait);
+		if ((pending & PRINTK_PENDING_OUTPUT) && printk_task)
+			wake_up_process(printk_task);
+		if (pending & PRINTK_PENDING_WAKEUP)
+			wake_up_interruptible(&log_wait);
 	}
 }
 
@@ -1212,10 +1472,19 @@ int printk_needs_cpu(int cpu)
 	return per_cpu(printk_pending, cpu);
 }
 
+static void printk_set_pending(int bits)
+{
+	unsigned long flags;
+
+	raw_local_irq_save(flags);
+	__raw_get_cpu_var(printk_pending) |= bits;
+	raw_local_irq_restore(flags);
+}
+
 void wake_up_klogd(void)
 {
 	if (waitqueue_active(&log_wait))
-		__raw_get_cpu_var(printk_pending) = 1;
+		printk_set_pending(PRINTK_PENDING_WAKEUP);
 }
 
 /**
@@ -1243,10 +1512,20 @@ void release_console_sem(void)
 		return;
 	}
 
+	/* the output is printk_task's to write */
+	if (printk_deferred_ok()) {
+		console_locked = 0;
+		up(&console_sem);
+		if (con_start != log_end || !printk_rings_empty())
+			printk_set_pending(PRINTK_PENDING_OUTPUT);
+		return;
+	}
+
 	console_may_schedule = 0;
 
 	for ( ; ; ) {
 		spin_lock_irqsave(&logbuf_lock, flags);
+		printk_rings_drain();
 		wake_klogd |= log_start - log_end;
 		if (con_start == log_end)
 			break;			/* Nothing to print */
@@ -1267,6 +1546,91 @@ void release_console_sem(void)
 }
 EXPORT_SYMBOL(release_console_sem);
 
+#ifdef CONFIG_PRINTK
+/*
+ * The console drivers are written with interrupts off, as some of them
+ * rely on it instead of a lock; bounding what each call writes bounds
+ * the time they stay off.  About 11ms at 115200 baud.
+ */
+#define PRINTK_FLUSH_CHUNK	128
+
+/*
+ * What release_console_sem() does for printk_task, but a chunk at a
+ * time, with interrupts on and a chance to reschedule between chunks.
+ */
+static void printk_flush_consoles(void)
+{
+	unsigned long flags;
+	unsigned _con_start, _log_end;
+	unsigned wake_klogd = 0;
+
+	for ( ; ; ) {
+		spin_lock_irqsave(&logbuf_lock, flags);
+		printk_rings_drain();
+		wake_klogd |= log_start - log_end;
+		if (console_suspended || con_start == log_end)
+			break;
+		_con_start = con_start;
+		_log_end = log_end;
+		if (_log_end - _con_start > PRINTK_FLUSH_CHUNK)
+			_log_end = _con_start + PRINTK_FLUSH_CHUNK;
+		con_start = _log_end;
+		spin_unlock(&logbuf_lock);
+		stop_critical_timings();	/* don't trace print latency */
+		call_console_drivers(_con_start, _log_end);
+		start_critical_timings();
+		local_irq_restore(flags);
+		cond_resched();
+	}
+	if (!console_suspended)
+		console_locked = 0;
+	up(&console_sem);
+	spin_unlock_irqrestore(&logbuf_lock, flags);
+	if (wake_klogd)
+		wake_up_interruptible(&log_wait);
+}
+
+static int printk_thread(void *unused)
+{
+	struct sched_param param = { .sched_priority = 1 };
+
+	/* keep the place the writers had in the queue for the consoles */
+	sched_setscheduler(current, SCHED_FIFO, &param);
+
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		/*
+		 * With the consoles suspended only the rings are drained,
+		 * and the output waits for resume_console() to wake us.
+		 */
+		if (printk_rings_empty() &&
+		    (con_start == log_end || console_suspended))
+			schedule();
+		__set_current_state(TASK_RUNNING);
+
+		acquire_console_sem();
+		printk_flush_consoles();
+	}
+
+	return 0;
+}
+
+static int __init printk_thread_init(void)
+{
+	struct task_struct *p;
+
+	p = kthread_run(printk_thread, NULL, "printk");
+	if (IS_ERR(p)) {
+		printk(KERN_ERR "printk: no thread, consoles stay synchronous\n");
+		return PTR_ERR(p);
+	}
+	printk_task = p;
+
+	return 0;
+}
+early_initcall(printk_thread_init);
+#endif
+
 /**
  * console_conditional_schedule - yield the CPU if required
  *
@@ -1691,6 +2055,7 @@ void kmsg_dump(enum kmsg_dump_reason reason)
 	   there's not a lot we can do about that. The new messages
 	   will overwrite the start of what we dump. */
 	spin_lock_irqsave(&logbuf_lock, flags);
+	printk_rings_drain();
 	end = log_end & LOG_BUF_MASK;
 	chars = logged_chars;
 	spin_unlock_irqrestore(&logbuf_lock, flags);
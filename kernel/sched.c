@@ -73,6 +73,7 @@
 #include <linux/ftrace.h>
 #include <linux/slab.h>
 #include <linux/cpuacct.h>
+#include <linux/writeback.h>
 
 #include <asm/tlb.h>
 #include <asm/irq_regs.h>
@@ -271,6 +272,13 @@ struct task_group {
 	struct task_group *parent;
 	struct list_head siblings;
 	struct list_head children;
+
+	struct group_dirty dirty;
+
+#ifdef CONFIG_CGROUP_SCHED_LATENCY
+	/* wakeup-to-run latency of the group's tasks, per cpu */
+	struct sched_latency *latency;
+#endif
 };
 
 #define root_task_group init_task_group
@@ -635,6 +643,12 @@ static inline void set_task_rq(struct task_struct *p, unsigned int cpu)
 #endif
 }
 
+/* Must be called under rcu_read_lock() or with the task's rq lock held */
+struct group_dirty *task_group_dirty(struct task_struct *p)
+{
+	return &task_group(p)->dirty;
+}
+
 #else /* CONFIG_CGROUP_SCHED */
 
 static inline void set_task_rq(struct task_struct *p, unsigned int cpu) { }
@@ -645,6 +659,63 @@ static inline struct task_group *task_group(struct task_struct *p)
 
 #endif /* CONFIG_CGROUP_SCHED */
 
+#ifdef CONFIG_CGROUP_SCHED_LATENCY
+/*
+ * Time from a task being woken (or forked) to it getting the cpu, counted
+ * in the task's group on the cpu it ran on.  Bucket 0 holds delays below
+ * 2^10 ns, bucket i those from 2^(i+9) up to 2^(i+10) ns, and the last
+ * bucket everything from 2^(SCHED_LAT_BUCKETS+8) ns (268ms) on.  A task
+ * that is preempted and later gets the cpu back is not counted again.
+ */
+#define SCHED_LAT_SHIFT		10
+#define SCHED_LAT_BUCKETS	20
+
+struct sched_latency {
+	unsigned long	count[SCHED_LAT_BUCKETS];
+	u64		sum;
+	u64		max;
+};
+
+static DEFINE_PER_CPU(struct sched_latency, root_sched_latency);
+
+static inline void sched_latency_wakeup(struct rq *rq, struct task_struct *p)
+{
+	/* a zero stamp means "not waiting", so never store one */
+	p->sched_wakeup_stamp = rq->clock | 1;
+}
+
+/* @next is about to run on @rq; called with rq->lock held */
+static inline void sched_latency_switch(struct rq *rq, struct task_struct *next)
+{
+	struct sched_latency *lat;
+	u64 delta;
+	int bucket;
+
+	if (!next->sched_wakeup_stamp)
+		return;
+
+	delta = rq->clock - next->sched_wakeup_stamp;
+	next->sched_wakeup_stamp = 0;
+	if ((s64)delta < 0)
+		delta = 0;
+
+	/* fls() is a single clz; the clamp keeps the argument in 32 bits */
+	bucket = fls((u32)min_t(u64, delta >> SCHED_LAT_SHIFT,
+				1U << (SCHED_LAT_BUCKETS - 1)));
+	if (bucket >= SCHED_LAT_BUCKETS)
+		bucket = SCHED_LAT_BUCKETS - 1;
+
+	lat = per_cpu_ptr(task_group(next)->latency, cpu_of(rq));
+	lat->count[bucket]++;
+	lat->sum += delta;
+	if (delta > lat->max)
+		lat->max = delta;
+}
+#else
+static inline void sched_latency_wakeup(struct rq *rq, struct task_struct *p) { }
+static inline void sched_latency_switch(struct rq *rq, struct task_struct *next) { }
+#endif /* CONFIG_CGROUP_SCHED_LATENCY */
+
 inline void update_rq_clock(struct rq *rq)
 {
 	if (!rq->skip_clock_update)
@@ -2363,6 +2434,7 @@ out_activate:
 	else
 		schedstat_inc(p, se.statistics.nr_wakeups_remote);
 	activate_task(rq, p, en_flags);
+	sched_latency_wakeup(rq, p);
 	success = 1;
 
 out_running:
@@ -2549,6 +2621,7 @@ void wake_up_new_task(struct task_struct *p, unsigned long clone_flags)
 
 	rq = task_rq_lock(p, &flags);
 	activate_task(rq, p, 0);
+	sched_latency_wakeup(rq, p);
 	trace_sched_wakeup_new(p, 1);
 	check_preempt_curr(rq, p, WF_FORK);
 #ifdef CONFIG_SMP
@@ -3623,6 +3696,7 @@ need_resched_nonpreemptible:
 
 	if (likely(prev != next)) {
 		sched_info_switch(prev, next);
+		sched_latency_switch(rq, next);
 		perf_event_task_sched_out(prev, next);
 
 		rq->nr_switches++;
@@ -7578,6 +7652,10 @@ void __init sched_init(void)
 #ifdef CONFIG_CGROUP_SCHED
 	list_add(&init_task_group.list, &task_groups);
 	INIT_LIST_HEAD(&init_task_group.children);
+	group_dirty_init(&init_task_group.dirty);
+#ifdef CONFIG_CGROUP_SCHED_LATENCY
+	init_task_group.latency = &root_sched_latency;
+#endif
 
 #endif /* CONFIG_CGROUP_SCHED */
 
@@ -8039,6 +8117,9 @@ static void free_sched_group(struct task_group *tg)
 {
 	free_fair_sched_group(tg);
 	free_rt_sched_group(tg);
+#ifdef CONFIG_CGROUP_SCHED_LATENCY
+	free_percpu(tg->latency);
+#endif
 	kfree(tg);
 }
 
@@ -8059,6 +8140,14 @@ struct task_group *sched_create_group(struct task_group *parent)
 	if (!alloc_rt_sched_group(tg, parent))
 		goto err;
 
+#ifdef CONFIG_CGROUP_SCHED_LATENCY
+	tg->latency = alloc_percpu(struct sched_latency);
+	if (!tg->latency)
+		goto err;
+#endif
+
+	group_dirty_init(&tg->dirty);
+
 	spin_lock_irqsave(&task_group_lock, flags);
 	for_each_possible_cpu(i) {
 		register_fair_sched_group(tg, i);
@@ -8646,6 +8735,95 @@ static u64 cpu_rt_period_read_uint(struct cgroup *cgrp, struct cftype *cft)
 }
 #endif /* CONFIG_RT_GROUP_SCHED */
 
+static int cpu_dirty_ratio_write_u64(struct cgroup *cgrp, struct cftype *cft,
+				     u64 ratio)
+{
+	if (ratio < 1 || ratio > 100)
+		return -EINVAL;
+
+	cgroup_tg(cgrp)->dirty.dirty_ratio = ratio;
+	return 0;
+}
+
+static u64 cpu_dirty_ratio_read_u64(struct cgroup *cgrp, struct cftype *cft)
+{
+	return cgroup_tg(cgrp)->dirty.dirty_ratio;
+}
+
+static int cpu_dirty_stat_read_map(struct cgroup *cgrp, struct cftype *cft,
+				   struct cgroup_map_cb *cb)
+{
+	struct group_dirty *gd = &cgroup_tg(cgrp)->dirty;
+
+	cb->fill(cb, "dirty_pages", group_dirty_pages(gd));
+	cb->fill(cb, "dirtied", atomic_long_read(&gd->nr_dirtied));
+	cb->fill(cb, "throttled", atomic_long_read(&gd->nr_throttled));
+	cb->fill(cb, "throttle_time",
+		 jiffies_to_msecs(atomic_long_read(&gd->throttle_time)));
+	return 0;
+}
+
+#ifdef CONFIG_CGROUP_SCHED_LATENCY
+static int cpu_wakeup_latency_read_map(struct cgroup *cgrp, struct cftype *cft,
+				       struct cgroup_map_cb *cb)
+{
+	struct task_group *tg = cgroup_tg(cgrp);
+	struct sched_latency sum, lat;
+	unsigned long count = 0;
+	char name[24];
+	int cpu, i;
+
+	memset(&sum, 0, sizeof(sum));
+	for_each_possible_cpu(cpu) {
+		/* the rq->lock makes the 64-bit fields safe on 32-bit */
+		raw_spin_lock_irq(&cpu_rq(cpu)->lock);
+		lat = *per_cpu_ptr(tg->latency, cpu);
+		raw_spin_unlock_irq(&cpu_rq(cpu)->lock);
+
+		for (i = 0; i < SCHED_LAT_BUCKETS; i++)
+			sum.count[i] += lat.count[i];
+		sum.sum += lat.sum;
+		sum.max = max(sum.max, lat.max);
+	}
+
+	for (i = 0; i < SCHED_LAT_BUCKETS; i++)
+		count += sum.count[i];
+	cb->fill(cb, "wakeups", count);
+	cb->fill(cb, "total_ns", sum.sum);
+	cb->fill(cb, "max_ns", sum.max);
+
+	/* each bucket is named after its upper bound, the last its lower */
+	for (i = 0; i < SCHED_LAT_BUCKETS - 1; i++) {
+		snprintf(name, sizeof(name), "lt_%ldus",
+			 (1U << (i + SCHED_LAT_SHIFT)) / NSEC_PER_USEC);
+		cb->fill(cb, name, sum.count[i]);
+	}
+	snprintf(name, sizeof(name), "ge_%ldus",
+		 (1U << (i + SCHED_LAT_SHIFT - 1)) / NSEC_PER_USEC);
+	cb->fill(cb, name, sum.count[i]);
+	return 0;
+}
+
+static int cpu_wakeup_latency_write_u64(struct cgroup *cgrp, struct cftype *cft,
+					u64 val)
+{
+	struct task_group *tg = cgroup_tg(cgrp);
+	int cpu;
+
+	/* only writing 0 is allowed, and it clears the histogram */
+	if (val)
+		return -EINVAL;
+
+	for_each_possible_cpu(cpu) {
+		raw_spin_lock_irq(&cpu_rq(cpu)->lock);
+		memset(per_cpu_ptr(tg->latency, cpu), 0,
+		       sizeof(struct sched_latency));
+		raw_spin_unlock_irq(&cpu_rq(cpu)->lock);
+	}
+	return 0;
+}
+#endif /* CONFIG_CGROUP_SCHED_LATENCY */
+
 static struct cftype cpu_files[] = {
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	{
@@ -8665,6 +8843,22 @@ static struct cftype cpu_files[] = {
 		.read_u64 = cpu_rt_period_read_uint,
 		.write_u64 = cpu_rt_period_write_uint,
 	},
+#endif
+	{
+		.name = "dirty_ratio",
+		.read_u64 = cpu_dirty_ratio_read_u64,
+		.write_u64 = cpu_dirty_ratio_write_u64,
+	},
+	{
+		.name = "dirty_stat",
+		.read_map = cpu_dirty_stat_read_map,
+	},
+#ifdef CONFIG_CGROUP_SCHED_LATENCY
+	{
+		.name = "wakeup_latency",
+		.read_map = cpu_wakeup_latency_read_map,
+		.write_u64 = cpu_wakeup_latency_write_u64,
+	},
 #endif
 };
 
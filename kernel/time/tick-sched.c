@@ -179,6 +179,7 @@ static void tick_nohz_stop_idle(int cpu, ktime_t now)
 	ts->idle_active = 0;
 
 	sched_clock_idle_wakeup_event(0);
+	timer_stats_idle_exit(now);
 }
 
 static ktime_t tick_nohz_start_idle(int cpu, struct tick_sched *ts)
@@ -192,6 +193,7 @@ static ktime_t tick_nohz_start_idle(int cpu, struct tick_sched *ts)
 	ts->idle_entrytime = now;
 	ts->idle_active = 1;
 	sched_clock_idle_sleep_event();
+	timer_stats_idle_enter();
 	return now;
 }
 
@@ -747,6 +749,9 @@ static enum hrtimer_restart tick_sched_timer(struct hrtimer *timer)
 	if (tick_do_timer_cpu == cpu)
 		tick_do_update_jiffies64(now);
 
+	/* a wakeup for the tick is one for the wheel timers it runs */
+	timer_stats_pass_wakeup(timer);
+
 	/*
 	 * Do not call, when we are not in irq context and have
 	 * no valid regs pointer
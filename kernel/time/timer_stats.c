@@ -31,6 +31,9 @@
  * Display the information collected so far:
  * # cat /proc/timer_stats
  *
+ * and the timers which woke an idle cpu:
+ * # cat /proc/timer_wakeups
+ *
  * This program is free software; you can redistribute it and/or modify
  * it under the terms of the GNU General Public License version 2 as
  * published by the Free Software Foundation.
@@ -65,9 +68,10 @@ struct entry {
 	pid_t			pid;
 
 	/*
-	 * Number of timeout events:
+	 * Number of timeout events, and of those which woke an idle cpu:
 	 */
 	unsigned long		count;
+	unsigned long		wakeups;
 	unsigned int		timer_flag;
 
 	/*
@@ -88,6 +92,22 @@ static DEFINE_SPINLOCK(table_lock);
  */
 static DEFINE_PER_CPU(raw_spinlock_t, tstats_lookup_lock);
 
+/*
+ * Wakeup attribution.  An interrupt which ends idle arms 'pending' and the
+ * first timer expiring within a tick of it which could have woken the cpu
+ * takes the wakeup.  The tick hands a wakeup on to the wheel timers it
+ * runs; if none of them takes it, it goes back to the tick when the cpu
+ * idles again.  Protected by the lookup lock of the cpu:
+ */
+struct tstats_wakeup {
+	int			pending;
+	ktime_t			stamp;
+	struct entry		*charged;
+	struct entry		*passed;
+};
+
+static DEFINE_PER_CPU(struct tstats_wakeup, tstats_wakeup);
+
 /*
  * Mutex to serialize state changes with show-stats activities:
  */
@@ -137,10 +157,15 @@ static struct entry *tstat_hash_table[TSTAT_HASH_SIZE] __read_mostly;
 
 static void reset_entries(void)
 {
+	int cpu;
+
 	nr_entries = 0;
 	memset(entries, 0, sizeof(entries));
 	memset(tstat_hash_table, 0, sizeof(tstat_hash_table));
 	atomic_set(&overflow_count, 0);
+	for_each_possible_cpu(cpu)
+		memset(&per_cpu(tstats_wakeup, cpu), 0,
+		       sizeof(struct tstats_wakeup));
 }
 
 static struct entry *alloc_entry(void)
@@ -204,6 +229,7 @@ static struct entry *tstat_lookup(struct entry *entry, char *comm)
 	if (curr) {
 		*curr = *entry;
 		curr->count = 0;
+		curr->wakeups = 0;
 		curr->next = NULL;
 		memcpy(curr->comm, comm, TASK_COMM_LEN);
 
@@ -220,6 +246,38 @@ static struct entry *tstat_lookup(struct entry *entry, char *comm)
 	return curr;
 }
 
+/*
+ * A wakeup not taken by a timer is given back to the tick which passed
+ * it on, if any.  Called with the lookup lock held:
+ */
+static void tstat_settle_wakeup(struct tstats_wakeup *w)
+{
+	if (w->pending && w->passed)
+		w->passed->wakeups++;
+	w->pending = 0;
+	w->charged = NULL;
+	w->passed = NULL;
+}
+
+static void tstat_charge_wakeup(struct entry *entry)
+{
+	struct tstats_wakeup *w = &__get_cpu_var(tstats_wakeup);
+
+	if (likely(!w->pending))
+		return;
+
+	/* too long after the wakeup for this timer to have caused it */
+	if (ktime_to_ns(ktime_sub(ktime_get(), w->stamp)) > TICK_NSEC) {
+		tstat_settle_wakeup(w);
+		return;
+	}
+
+	entry->wakeups++;
+	w->pending = 0;
+	w->charged = entry;
+	w->passed = NULL;
+}
+
 /**
  * timer_stats_update_stats - Update the statistics for a timer.
  * @timer:	pointer to either a timer_list or a hrtimer
@@ -258,15 +316,85 @@ void timer_stats_update_stats(void *timer, pid_t pid, void *startf,
 		goto out_unlock;
 
 	entry = tstat_lookup(&input, comm);
-	if (likely(entry))
+	if (likely(entry)) {
 		entry->count++;
-	else
+		if (!(timer_flag & TIMER_STATS_FLAG_DEFERRABLE))
+			tstat_charge_wakeup(entry);
+	} else
 		atomic_inc(&overflow_count);
 
  out_unlock:
 	raw_spin_unlock_irqrestore(lock, flags);
 }
 
+static void tstat_wakeup_op(void (*op)(struct tstats_wakeup *, void *),
+			    void *arg)
+{
+	raw_spinlock_t *lock;
+	unsigned long flags;
+
+	if (likely(!timer_stats_active))
+		return;
+
+	lock = &per_cpu(tstats_lookup_lock, raw_smp_processor_id());
+	raw_spin_lock_irqsave(lock, flags);
+	if (timer_stats_active)
+		op(&__get_cpu_var(tstats_wakeup), arg);
+	raw_spin_unlock_irqrestore(lock, flags);
+}
+
+static void __timer_stats_idle_enter(struct tstats_wakeup *w, void *arg)
+{
+	tstat_settle_wakeup(w);
+}
+
+static void __timer_stats_idle_exit(struct tstats_wakeup *w, void *arg)
+{
+	tstat_settle_wakeup(w);
+	w->pending = 1;
+	w->stamp = *(ktime_t *)arg;
+}
+
+static void __timer_stats_pass_wakeup(struct tstats_wakeup *w, void *timer)
+{
+	if (!w->charged || w->charged->timer != timer)
+		return;
+
+	w->charged->wakeups--;
+	w->passed = w->charged;
+	w->charged = NULL;
+	w->pending = 1;
+}
+
+/**
+ * timer_stats_idle_enter - the cpu is going idle
+ */
+void timer_stats_idle_enter(void)
+{
+	tstat_wakeup_op(__timer_stats_idle_enter, NULL);
+}
+
+/**
+ * timer_stats_idle_exit - an interrupt has ended idle
+ * @now:	the time of the interrupt
+ */
+void timer_stats_idle_exit(ktime_t now)
+{
+	tstat_wakeup_op(__timer_stats_idle_exit, &now);
+}
+
+/**
+ * timer_stats_pass_wakeup - hand the wakeup on to the timer wheel
+ * @timer:	the tick hrtimer, which has just expired
+ *
+ * Called by the tick, so that the wakeup goes to the timer_list timer
+ * which needed the tick rather than to the tick itself.
+ */
+void timer_stats_pass_wakeup(void *timer)
+{
+	tstat_wakeup_op(__timer_stats_pass_wakeup, timer);
+}
+
 static void print_name_offset(struct seq_file *m, unsigned long addr)
 {
 	char symname[KSYM_NAME_LEN];
@@ -277,6 +405,14 @@ static void print_name_offset(struct seq_file *m, unsigned long addr)
 		seq_printf(m, "%s", symname);
 }
 
+static void print_entry_funcs(struct seq_file *m, struct entry *entry)
+{
+	print_name_offset(m, (unsigned long)entry->start_func);
+	seq_puts(m, " (");
+	print_name_offset(m, (unsigned long)entry->expire_func);
+	seq_puts(m, ")\n");
+}
+
 static int tstats_show(struct seq_file *m, void *v)
 {
 	struct timespec period;
@@ -309,16 +445,15 @@ static int tstats_show(struct seq_file *m, void *v)
  		if (entry->timer_flag & TIMER_STATS_FLAG_DEFERRABLE) {
 			seq_printf(m, "%4luD, %5d %-16s ",
 				entry->count, entry->pid, entry->comm);
+		} else if (entry->timer_flag & TIMER_STATS_FLAG_WINDOW) {
+			seq_printf(m, "%4luW, %5d %-16s ",
+				entry->count, entry->pid, entry->comm);
 		} else {
 			seq_printf(m, " %4lu, %5d %-16s ",
 				entry->count, entry->pid, entry->comm);
 		}
 
-		print_name_offset(m, (unsigned long)entry->start_func);
-		seq_puts(m, " (");
-		print_name_offset(m, (unsigned long)entry->expire_func);
-		seq_puts(m, ")\n");
-
+		print_entry_funcs(m, entry);
 		events += entry->count;
 	}
 
@@ -397,6 +532,65 @@ static int tstats_open(struct inode *inode, struct file *filp)
 	return single_open(filp, tstats_show, NULL);
 }
 
+/*
+ * The timers which woke an idle cpu, out of the same sample as
+ * /proc/timer_stats.  Sort on the first column for the worst ones.
+ */
+static int twakeups_show(struct seq_file *m, void *v)
+{
+	struct timespec period;
+	struct entry *entry;
+	unsigned long ms;
+	long wakeups = 0;
+	ktime_t time;
+	int i;
+
+	mutex_lock(&show_mutex);
+	time = ktime_sub(timer_stats_active ? ktime_get() : time_stop,
+			 time_start);
+	period = ktime_to_timespec(time);
+	ms = period.tv_sec * 1000 + period.tv_nsec / 1000000;
+	if (!ms)
+		ms = 1;
+
+	seq_puts(m, "Timer Wakeups Version: v0.1\n");
+	seq_printf(m, "Sample period: %ld.%03ld s\n", period.tv_sec,
+		   period.tv_nsec / 1000000);
+
+	for (i = 0; i < nr_entries; i++) {
+		entry = entries + i;
+		if (!entry->wakeups)
+			continue;
+
+		seq_printf(m, "%6lu, %6lu%c, %5d %-16s ",
+			   entry->wakeups, entry->count,
+			   entry->timer_flag & TIMER_STATS_FLAG_WINDOW ? 'W' : ' ',
+			   entry->pid, entry->comm);
+		print_entry_funcs(m, entry);
+		wakeups += entry->wakeups;
+	}
+
+	seq_printf(m, "%ld total wakeups, %ld.%03ld wakeups/sec\n",
+		   wakeups, wakeups * 1000 / ms,
+		   (wakeups * 1000000 / ms) % 1000);
+
+	mutex_unlock(&show_mutex);
+
+	return 0;
+}
+
+static int twakeups_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, twakeups_show, NULL);
+}
+
+static const struct file_operations twakeups_fops = {
+	.open		= twakeups_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static const struct file_operations tstats_fops = {
 	.open		= tstats_open,
 	.read		= seq_read,
@@ -420,6 +614,11 @@ static int __init init_tstats_procfs(void)
 	pe = proc_create("timer_stats", 0644, NULL, &tstats_fops);
 	if (!pe)
 		return -ENOMEM;
+	pe = proc_create("timer_wakeups", 0444, NULL, &twakeups_fops);
+	if (!pe) {
+		remove_proc_entry("timer_stats", NULL);
+		return -ENOMEM;
+	}
 	return 0;
 }
 __initcall(init_tstats_procfs);
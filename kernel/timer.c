@@ -337,6 +337,102 @@ void set_timer_slack(struct timer_list *timer, int slack_hz)
 }
 EXPORT_SYMBOL_GPL(set_timer_slack);
 
+/*
+ * Decide where to put the timer while taking the slack into account
+ *
+ * Algorithm:
+ *   1) calculate the maximum (absolute) time
+ *   2) calculate the highest bit where the expires and new max are different
+ *   3) use this bit to make a mask
+ *   4) use the bitmask to round down the maximum time, so that all last
+ *      bits are zeros
+ */
+static inline
+unsigned long apply_slack(struct timer_list *timer, unsigned long expires)
+{
+	unsigned long expires_limit, mask;
+	int bit;
+
+	expires_limit = expires;
+
+	if (timer->slack >= 0) {
+		expires_limit = expires + timer->slack;
+	} else {
+		unsigned long now = jiffies;
+
+		/* No slack, if already expired else auto slack 0.4% */
+		if (time_after(expires, now))
+			expires_limit = expires + (expires - now)/256;
+	}
+	mask = expires ^ expires_limit;
+	if (mask == 0)
+		return expires;
+
+	bit = find_last_bit(&mask, BITS_PER_LONG);
+
+	mask = (1 << bit) - 1;
+
+	expires_limit = expires_limit & ~(mask);
+
+	return expires_limit;
+}
+
+/**
+ * set_timer_window - let a timer wait for another wakeup
+ * @timer: the timer to be set up, which must not be pending
+ * @window_hz: how long (in jiffies) past its expiry the timer may be held
+ *
+ * The timer runs at its expiry if the cpu is awake then, but an idle cpu
+ * is not woken for it before the end of the window, so it goes along with
+ * whatever wakes the cpu first.  The end of the window is rounded like the
+ * slack of set_timer_slack(), so that timers whose windows end close
+ * together share one wakeup.
+ *
+ * A @window_hz of -1 makes it a plain deferrable timer, which an idle cpu
+ * may hold back indefinitely.
+ */
+void set_timer_window(struct timer_list *timer, int window_hz)
+{
+	WARN_ON(timer_pending(timer));
+	timer_set_deferrable(timer);
+	timer->slack = window_hz;
+}
+EXPORT_SYMBOL_GPL(set_timer_window);
+
+/*
+ * Whether an idle cpu has to wake up for the timer, and by which jiffy:
+ * its expiry, or for a timer with a window the end of the window.
+ */
+static inline int timer_wakes_cpu(struct timer_list *timer)
+{
+	return !tbase_get_deferrable(timer->base) || timer->slack >= 0;
+}
+
+static inline unsigned long timer_deadline(struct timer_list *timer)
+{
+	if (tbase_get_deferrable(timer->base))
+		return apply_slack(timer, timer->expires);
+	return timer->expires;
+}
+
+/* keep base->next_timer no later than the deadline of a timer being added */
+static inline void next_timer_add(struct tvec_base *base,
+				  struct timer_list *timer)
+{
+	if (timer_wakes_cpu(timer) &&
+	    time_before(timer_deadline(timer), base->next_timer))
+		base->next_timer = timer_deadline(timer);
+}
+
+/* force a rescan if the timer being removed was the next one */
+static inline void next_timer_del(struct tvec_base *base,
+				  struct timer_list *timer)
+{
+	if (timer_wakes_cpu(timer) &&
+	    timer_deadline(timer) == base->next_timer)
+		base->next_timer = base->timer_jiffies;
+}
+
 
 static inline void set_running_timer(struct tvec_base *base,
 					struct timer_list *timer)
@@ -406,7 +502,8 @@ static void timer_stats_account_timer(struct timer_list *timer)
 	if (likely(!timer->start_site))
 		return;
 	if (unlikely(tbase_get_deferrable(timer->base)))
-		flag |= TIMER_STATS_FLAG_DEFERRABLE;
+		flag |= timer->slack >= 0 ? TIMER_STATS_FLAG_WINDOW :
+					    TIMER_STATS_FLAG_DEFERRABLE;
 
 	timer_stats_update_stats(timer, timer->start_pid, timer->start_site,
 				 timer->function, timer->start_comm, flag);
@@ -665,9 +762,7 @@ __mod_timer(struct timer_list *timer, unsigned long expires,
 
 	if (timer_pending(timer)) {
 		detach_timer(timer, 0);
-		if (timer->expires == base->next_timer &&
-		    !tbase_get_deferrable(timer->base))
-			base->next_timer = base->timer_jiffies;
+		next_timer_del(base, timer);
 		ret = 1;
 	} else {
 		if (pending_only)
@@ -707,9 +802,7 @@ __mod_timer(struct timer_list *timer, unsigned long expires,
 	}
 
 	timer->expires = expires;
-	if (time_before(timer->expires, base->next_timer) &&
-	    !tbase_get_deferrable(timer->base))
-		base->next_timer = timer->expires;
+	next_timer_add(base, timer);
 	internal_add_timer(base, timer);
 
 out_unlock:
@@ -734,46 +827,6 @@ int mod_timer_pending(struct timer_list *timer, unsigned long expires)
 }
 EXPORT_SYMBOL(mod_timer_pending);
 
-/*
- * Decide where to put the timer while taking the slack into account
- *
- * Algorithm:
- *   1) calculate the maximum (absolute) time
- *   2) calculate the highest bit where the expires and new max are different
- *   3) use this bit to make a mask
- *   4) use the bitmask to round down the maximum time, so that all last
- *      bits are zeros
- */
-static inline
-unsigned long apply_slack(struct timer_list *timer, unsigned long expires)
-{
-	unsigned long expires_limit, mask;
-	int bit;
-
-	expires_limit = expires;
-
-	if (timer->slack >= 0) {
-		expires_limit = expires + timer->slack;
-	} else {
-		unsigned long now = jiffies;
-
-		/* No slack, if already expired else auto slack 0.4% */
-		if (time_after(expires, now))
-			expires_limit = expires + (expires - now)/256;
-	}
-	mask = expires ^ expires_limit;
-	if (mask == 0)
-		return expires;
-
-	bit = find_last_bit(&mask, BITS_PER_LONG);
-
-	mask = (1 << bit) - 1;
-
-	expires_limit = expires_limit & ~(mask);
-
-	return expires_limit;
-}
-
 /**
  * mod_timer - modify a timer's timeout
  * @timer: the timer to be modified
@@ -804,7 +857,9 @@ int mod_timer(struct timer_list *timer, unsigned long expires)
 	if (timer_pending(timer) && timer->expires == expires)
 		return 1;
 
-	expires = apply_slack(timer, expires);
+	/* a timer with a window is queued as asked and rounded at its end */
+	if (!tbase_get_deferrable(timer->base) || timer->slack < 0)
+		expires = apply_slack(timer, expires);
 
 	return __mod_timer(timer, expires, false, TIMER_NOT_PINNED);
 }
@@ -870,9 +925,7 @@ void add_timer_on(struct timer_list *timer, int cpu)
 	spin_lock_irqsave(&base->lock, flags);
 	timer_set_base(timer, base);
 	debug_activate(timer, timer->expires);
-	if (time_before(timer->expires, base->next_timer) &&
-	    !tbase_get_deferrable(timer->base))
-		base->next_timer = timer->expires;
+	next_timer_add(base, timer);
 	internal_add_timer(base, timer);
 	/*
 	 * Check whether the other CPU is idle and needs to be
@@ -909,9 +962,7 @@ int del_timer(struct timer_list *timer)
 		base = lock_timer_base(timer, &flags);
 		if (timer_pending(timer)) {
 			detach_timer(timer, 1);
-			if (timer->expires == base->next_timer &&
-			    !tbase_get_deferrable(timer->base))
-				base->next_timer = base->timer_jiffies;
+			next_timer_del(base, timer);
 			ret = 1;
 		}
 		spin_unlock_irqrestore(&base->lock, flags);
@@ -946,9 +997,7 @@ int try_to_del_timer_sync(struct timer_list *timer)
 	ret = 0;
 	if (timer_pending(timer)) {
 		detach_timer(timer, 1);
-		if (timer->expires == base->next_timer &&
-		    !tbase_get_deferrable(timer->base))
-			base->next_timer = base->timer_jiffies;
+		next_timer_del(base, timer);
 		ret = 1;
 	}
 out:
@@ -1118,23 +1167,35 @@ static unsigned long __next_timer_interrupt(struct tvec_base *base)
 {
 	unsigned long timer_jiffies = base->timer_jiffies;
 	unsigned long expires = timer_jiffies + NEXT_TIMER_MAX_DELTA;
+	unsigned long window_end = expires;
 	int index, slot, array, found = 0;
 	struct timer_list *nte;
 	struct tvec *varray[4];
 
+	/*
+	 * Timers with a window sit in the wheel at their expiry but only
+	 * need the cpu by the end of the window.  They are noted as they
+	 * are passed; the ones not reached expire after the timer found,
+	 * so their windows end later still.
+	 */
+
 	/* Look for timer events in tv1. */
 	index = slot = timer_jiffies & TVR_MASK;
 	do {
 		list_for_each_entry(nte, base->tv1.vec + slot, entry) {
-			if (tbase_get_deferrable(nte->base))
+			if (tbase_get_deferrable(nte->base)) {
+				if (nte->slack >= 0 &&
+				    time_before(timer_deadline(nte), window_end))
+					window_end = timer_deadline(nte);
 				continue;
+			}
 
 			found = 1;
 			expires = nte->expires;
 			/* Look at the cascade bucket(s)? */
 			if (!index || slot < index)
 				goto cascade;
-			return expires;
+			goto out;
 		}
 		slot = (slot + 1) & TVR_MASK;
 	} while (slot != index);
@@ -1157,8 +1218,13 @@ cascade:
 		index = slot = timer_jiffies & TVN_MASK;
 		do {
 			list_for_each_entry(nte, varp->vec + slot, entry) {
-				if (tbase_get_deferrable(nte->base))
+				if (tbase_get_deferrable(nte->base)) {
+					if (nte->slack >= 0 &&
+					    time_before(timer_deadline(nte),
+							window_end))
+						window_end = timer_deadline(nte);
 					continue;
+				}
 
 				found = 1;
 				if (time_before(nte->expires, expires))
@@ -1172,7 +1238,7 @@ cascade:
 				/* Look at the cascade bucket(s)? */
 				if (!index || slot < index)
 					break;
-				return expires;
+				goto out;
 			}
 			slot = (slot + 1) & TVN_MASK;
 		} while (slot != index);
@@ -1181,7 +1247,8 @@ cascade:
 			timer_jiffies += TVN_SIZE - index;
 		timer_jiffies >>= TVN_BITS;
 	}
-	return expires;
+out:
+	return time_before(window_end, expires) ? window_end : expires;
 }
 
 /*
@@ -1640,9 +1707,7 @@ static void migrate_timer_list(struct tvec_base *new_base, struct list_head *hea
 		timer = list_first_entry(head, struct timer_list, entry);
 		detach_timer(timer, 0);
 		timer_set_base(timer, new_base);
-		if (time_before(timer->expires, new_base->next_timer) &&
-		    !tbase_get_deferrable(timer->base))
-			new_base->next_timer = timer->expires;
+		next_timer_add(new_base, timer);
 		internal_add_timer(new_base, timer);
 	}
 }
@@ -2836,6 +2836,7 @@ static int do_anonymous_page(struct mm_struct *mm, struct vm_area_struct *vma,
 	struct page *page;
 	spinlock_t *ptl;
 	pte_t entry;
+	u64 start;
 
 	pte_unmap(page_table);
 
@@ -2856,7 +2857,9 @@ static int do_anonymous_page(struct mm_struct *mm, struct vm_area_struct *vma,
 	/* Allocate our own private page. */
 	if (unlikely(anon_vma_prepare(vma)))
 		goto oom;
+	start = zero_pool_fault_start();
 	page = alloc_zeroed_user_highpage_movable(vma, address);
+	zero_pool_fault_end(start);
 	if (!page)
 		goto oom;
 	__SetPageUptodate(page);
@@ -129,6 +129,9 @@ EXPORT_SYMBOL(laptop_mode);
  */
 static struct prop_descriptor vm_completions;
 static struct prop_descriptor vm_dirties;
+#ifdef CONFIG_CGROUP_SCHED
+static struct prop_descriptor vm_group_dirties;
+#endif
 
 /*
  * couple the period to the dirty_ratio:
@@ -155,6 +158,9 @@ static void update_completion_period(void)
 	int shift = calc_period_shift();
 	prop_change_shift(&vm_completions, shift);
 	prop_change_shift(&vm_dirties, shift);
+#ifdef CONFIG_CGROUP_SCHED
+	prop_change_shift(&vm_group_dirties, shift);
+#endif
 }
 
 int dirty_background_ratio_handler(struct ctl_table *table, int write,
@@ -232,9 +238,92 @@ void bdi_writeout_inc(struct backing_dev_info *bdi)
 }
 EXPORT_SYMBOL_GPL(bdi_writeout_inc);
 
+#ifdef CONFIG_CGROUP_SCHED
+void group_dirty_init(struct group_dirty *gd)
+{
+	prop_local_init_single(&gd->dirties);
+	gd->dirty_ratio = 100;
+	atomic_long_set(&gd->nr_dirtied, 0);
+	atomic_long_set(&gd->nr_throttled, 0);
+	atomic_long_set(&gd->throttle_time, 0);
+}
+
+static void group_dirty_inc(struct task_struct *tsk)
+{
+	struct group_dirty *gd;
+
+	rcu_read_lock();
+	gd = task_group_dirty(tsk);
+	prop_inc_single(&vm_group_dirties, &gd->dirties);
+	atomic_long_inc(&gd->nr_dirtied);
+	rcu_read_unlock();
+}
+
+/*
+ * estimate the dirty and writeback pages owned by the group:
+ *
+ *   dirty_{g} = (dirty + writeback) * p_{g}
+ */
+unsigned long group_dirty_pages(struct group_dirty *gd)
+{
+	long numerator, denominator;
+	u64 dirty;
+
+	dirty = global_page_state(NR_FILE_DIRTY) +
+		global_page_state(NR_UNSTABLE_NFS) +
+		global_page_state(NR_WRITEBACK);
+
+	prop_fraction_single(&vm_group_dirties, &gd->dirties,
+			     &numerator, &denominator);
+	dirty *= numerator;
+	do_div(dirty, denominator);
+
+	return dirty;
+}
+
+/*
+ * Is the current task's group over its share of the dirty limit? Groups
+ * with dirty_ratio 100, which includes the root group by default, are
+ * only subject to the global and per-bdi limits.
+ */
+static int group_dirty_exceeded(unsigned long dirty_thresh)
+{
+	struct group_dirty *gd;
+	int exceeded = 0;
+
+	rcu_read_lock();
+	gd = task_group_dirty(current);
+	if (gd->dirty_ratio < 100)
+		exceeded = group_dirty_pages(gd) >
+			dirty_thresh * gd->dirty_ratio / 100;
+	rcu_read_unlock();
+
+	return exceeded;
+}
+
+static void group_dirty_throttled(unsigned long start)
+{
+	struct group_dirty *gd;
+
+	rcu_read_lock();
+	gd = task_group_dirty(current);
+	atomic_long_inc(&gd->nr_throttled);
+	atomic_long_add(jiffies - start, &gd->throttle_time);
+	rcu_read_unlock();
+}
+#else
+static inline void group_dirty_inc(struct task_struct *tsk) { }
+static inline int group_dirty_exceeded(unsigned long dirty_thresh)
+{
+	return 0;
+}
+static inline void group_dirty_throttled(unsigned long start) { }
+#endif
+
 void task_dirty_inc(struct task_struct *tsk)
 {
 	prop_inc_single(&vm_dirties, &tsk->dirties);
+	group_dirty_inc(tsk);
 }
 
 /*
@@ -490,6 +579,8 @@ static void balance_dirty_pages(struct address_space *mapping,
 	unsigned long bdi_thresh;
 	unsigned long pages_written = 0;
 	unsigned long pause = 1;
+	unsigned long throttle_start = 0;
+	int group_exceeded;
 
 	struct backing_dev_info *bdi = mapping->backing_dev_info;
 
@@ -511,20 +602,32 @@ static void balance_dirty_pages(struct address_space *mapping,
 		bdi_nr_reclaimable = bdi_stat(bdi, BDI_RECLAIMABLE);
 		bdi_nr_writeback = bdi_stat(bdi, BDI_WRITEBACK);
 
-		if (bdi_nr_reclaimable + bdi_nr_writeback <= bdi_thresh)
-			break;
-
 		/*
-		 * Throttle it only when the background writeback cannot
-		 * catch-up. This avoids (excessively) small writeouts
-		 * when the bdi limits are ramping up.
+		 * A group over its own share of the dirty limit is throttled
+		 * regardless of the global state, so that a background group
+		 * cannot fill the dirty limit that foreground fsync()s have
+		 * to wait behind.
 		 */
-		if (nr_reclaimable + nr_writeback <
-				(background_thresh + dirty_thresh) / 2)
-			break;
+		group_exceeded = group_dirty_exceeded(dirty_thresh);
+		if (group_exceeded && !throttle_start)
+			throttle_start = jiffies;
+
+		if (!group_exceeded) {
+			if (bdi_nr_reclaimable + bdi_nr_writeback <= bdi_thresh)
+				break;
 
-		if (!bdi->dirty_exceeded)
-			bdi->dirty_exceeded = 1;
+			/*
+			 * Throttle it only when the background writeback
+			 * cannot catch-up. This avoids (excessively) small
+			 * writeouts when the bdi limits are ramping up.
+			 */
+			if (nr_reclaimable + nr_writeback <
+					(background_thresh + dirty_thresh) / 2)
+				break;
+
+			if (!bdi->dirty_exceeded)
+				bdi->dirty_exceeded = 1;
+		}
 
 		/* Note: nr_reclaimable denotes nr_dirty + nr_unstable.
 		 * Unstable writes are a feature of certain networked
@@ -535,7 +638,8 @@ static void balance_dirty_pages(struct address_space *mapping,
 		 * threshold otherwise wait until the disk writes catch
 		 * up.
 		 */
-		if (bdi_nr_reclaimable > bdi_thresh) {
+		if (bdi_nr_reclaimable > bdi_thresh ||
+		    (group_exceeded && bdi_nr_reclaimable)) {
 			writeback_inodes_wb(&bdi->wb, &wbc);
 			pages_written += write_chunk - wbc.nr_to_write;
 			get_dirty_limits(&background_thresh, &dirty_thresh,
@@ -560,7 +664,12 @@ static void balance_dirty_pages(struct address_space *mapping,
 			bdi_nr_writeback = bdi_stat(bdi, BDI_WRITEBACK);
 		}
 
-		if (bdi_nr_reclaimable + bdi_nr_writeback <= bdi_thresh)
+		/*
+		 * Over the group limit, wait for this bdi's writeback to
+		 * make progress; there is nothing to wait for if it is idle.
+		 */
+		if (bdi_nr_reclaimable + bdi_nr_writeback <=
+				(group_exceeded ? 0 : bdi_thresh))
 			break;
 		if (pages_written >= write_chunk)
 			break;		/* We've done our duty */
@@ -577,6 +686,9 @@ static void balance_dirty_pages(struct address_space *mapping,
 			pause = HZ / 10;
 	}
 
+	if (throttle_start)
+		group_dirty_throttled(throttle_start);
+
 	if (bdi_nr_reclaimable + bdi_nr_writeback < bdi_thresh &&
 			bdi->dirty_exceeded)
 		bdi->dirty_exceeded = 0;
@@ -802,6 +914,9 @@ void __init page_writeback_init(void)
 	shift = calc_period_shift();
 	prop_descriptor_init(&vm_completions, shift);
 	prop_descriptor_init(&vm_dirties, shift);
+#ifdef CONFIG_CGROUP_SCHED
+	prop_descriptor_init(&vm_group_dirties, shift);
+#endif
 }
 
 /**
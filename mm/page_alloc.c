@@ -52,6 +52,7 @@
 #include <linux/compaction.h>
 #include <trace/events/kmem.h>
 #include <linux/ftrace_event.h>
+#include <linux/zero_pool.h>
 
 #include <asm/tlbflush.h>
 #include <asm/div64.h>
@@ -2125,6 +2126,10 @@ __alloc_pages_nodemask(gfp_t gfp_mask, unsigned int order,
 	if (should_fail_alloc_page(gfp_mask, order))
 		return NULL;
 
+	page = zero_pool_alloc(gfp_mask, order);
+	if (page)
+		return page;
+
 	/*
 	 * Check the zones suitable for the gfp_mask contain at least one
 	 * valid zone. It's possible to have an empty zonelist as a result
@@ -0,0 +1,414 @@
+/*
+ * mm/zero_pool.c - pages zeroed in idle time
+ *
+ * Copyright (c) 2010 by Samsung Electronics
+ *
+ * Anonymous page faults spend much of their time clearing the new page.
+ * A SCHED_IDLE thread on each cpu, kzerod/N, only runs when that cpu has
+ * nothing else to do: it allocates free pages in batches, clears them and
+ * keeps them in a per-cpu pool.  Order-0 __GFP_ZERO allocations of movable
+ * highmem pages, and the zeroed pages of anonymous faults, are served from
+ * the pool of the local cpu when it is not empty.
+ *
+ * Pool pages are taken out of the free lists, so the pool is kept small,
+ * is only refilled while free memory is well above the watermarks, and
+ * is emptied by a shrinker under memory pressure.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2.
+ */
+
+#include <linux/mm.h>
+#include <linux/highmem.h>
+#include <linux/swap.h>
+#include <linux/sched.h>
+#include <linux/kthread.h>
+#include <linux/freezer.h>
+#include <linux/cpu.h>
+#include <linux/vmstat.h>
+#include <linux/zero_pool.h>
+
+/* Pages allocated and cleared by kzerod before they go to the pool */
+#define ZERO_POOL_BATCH		16
+
+#define ZERO_POOL_FILL_GFP	((GFP_HIGHUSER_MOVABLE & ~__GFP_WAIT) | \
+				 __GFP_NOWARN | __GFP_NORETRY | \
+				 __GFP_NOMEMALLOC)
+
+struct zero_pool {
+	spinlock_t		lock;
+	struct list_head	list;
+	unsigned int		pages;
+	struct task_struct	*thread;
+
+	/* statistics */
+	unsigned long		hits;
+	unsigned long		misses;
+	unsigned long		zeroed;
+	u64			faults;
+	u64			fault_ns;
+};
+
+static DEFINE_PER_CPU(struct zero_pool, zero_pool);
+
+/* Set once the pools are initialised, cleared through sysfs */
+int zero_pool_run;
+
+/* Pages kept per cpu */
+static unsigned int zero_pool_max_pages = 256;
+
+static DEFINE_MUTEX(zero_pool_mutex);
+
+/*
+ * Refill only with plenty of free memory: pool pages must never be the
+ * reason for the allocator to dip into its reserves or wake kswapd.
+ */
+static int zero_pool_memory_ok(void)
+{
+	return global_page_state(NR_FREE_PAGES) > 2 * totalreserve_pages;
+}
+
+static int zero_pool_want(struct zero_pool *pool)
+{
+	return zero_pool_run && pool->pages < zero_pool_max_pages &&
+	       zero_pool_memory_ok();
+}
+
+struct page *__zero_pool_alloc(void)
+{
+	struct zero_pool *pool;
+	struct page *page = NULL;
+	unsigned long flags;
+	unsigned int nr;
+
+	local_irq_save(flags);
+	pool = &__get_cpu_var(zero_pool);
+	spin_lock(&pool->lock);
+	nr = pool->pages;
+	if (nr) {
+		page = list_first_entry(&pool->list, struct page, lru);
+		list_del(&page->lru);
+		pool->pages = --nr;
+		pool->hits++;
+	} else
+		pool->misses++;
+	spin_unlock(&pool->lock);
+
+	/* kick the refill when crossing half full, and on every miss */
+	if (pool->thread && (!page || nr == zero_pool_max_pages / 2))
+		wake_up_process(pool->thread);
+	local_irq_restore(flags);
+
+	return page;
+}
+
+/* Fault times are kept with the pool off too, for comparison */
+u64 zero_pool_fault_start(void)
+{
+	return sched_clock();
+}
+
+void zero_pool_fault_end(u64 start)
+{
+	struct zero_pool *pool;
+	u64 delta = sched_clock() - start;
+
+	pool = &get_cpu_var(zero_pool);
+	pool->faults++;
+	pool->fault_ns += delta;
+	put_cpu_var(zero_pool);
+}
+
+/* Take up to @nr pages out of @pool and free them */
+static unsigned int zero_pool_drain(struct zero_pool *pool, unsigned int nr)
+{
+	struct page *page, *next;
+	unsigned int freed = 0;
+	LIST_HEAD(list);
+
+	spin_lock_irq(&pool->lock);
+	while (pool->pages && freed < nr) {
+		page = list_first_entry(&pool->list, struct page, lru);
+		list_move(&page->lru, &list);
+		pool->pages--;
+		freed++;
+	}
+	spin_unlock_irq(&pool->lock);
+
+	list_for_each_entry_safe(page, next, &list, lru) {
+		list_del(&page->lru);
+		__free_page(page);
+	}
+	return freed;
+}
+
+static int zero_pool_shrink(struct shrinker *shrink, int nr_to_scan,
+			    gfp_t gfp_mask)
+{
+	unsigned long nr = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct zero_pool *pool = &per_cpu(zero_pool, cpu);
+
+		if (nr_to_scan > 0)
+			nr_to_scan -= zero_pool_drain(pool, nr_to_scan);
+		nr += pool->pages;
+	}
+	return nr;
+}
+
+static struct shrinker zero_pool_shrinker = {
+	.shrink = zero_pool_shrink,
+	.seeks = DEFAULT_SEEKS,
+};
+
+static int zero_pool_thread(void *data)
+{
+	struct zero_pool *pool = data;
+	struct sched_param param = { .sched_priority = 0 };
+
+	sched_setscheduler(current, SCHED_IDLE, &param);
+	set_freezable();
+
+	while (!kthread_should_stop()) {
+		struct page *page;
+		unsigned int n = 0;
+		LIST_HEAD(batch);
+
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!zero_pool_want(pool)) {
+			schedule();
+			try_to_freeze();
+			continue;
+		}
+		__set_current_state(TASK_RUNNING);
+
+		while (n < ZERO_POOL_BATCH) {
+			page = alloc_page(ZERO_POOL_FILL_GFP);
+			if (!page)
+				break;
+			clear_highpage(page);
+			/* the page will be mapped at some user address */
+			flush_dcache_page(page);
+			list_add(&page->lru, &batch);
+			n++;
+		}
+		if (!n) {
+			schedule_timeout_interruptible(HZ);
+			continue;
+		}
+
+		spin_lock_irq(&pool->lock);
+		list_splice(&batch, &pool->list);
+		pool->pages += n;
+		pool->zeroed += n;
+		spin_unlock_irq(&pool->lock);
+
+		/* raced with the pool being switched off */
+		if (!zero_pool_run)
+			zero_pool_drain(pool, UINT_MAX);
+	}
+	return 0;
+}
+
+static void zero_pool_wake_all(void)
+{
+	int cpu;
+
+	get_online_cpus();
+	for_each_online_cpu(cpu) {
+		struct zero_pool *pool = &per_cpu(zero_pool, cpu);
+
+		if (pool->thread)
+			wake_up_process(pool->thread);
+	}
+	put_online_cpus();
+}
+
+static void zero_pool_drain_all(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		zero_pool_drain(&per_cpu(zero_pool, cpu), UINT_MAX);
+}
+
+static int __cpuinit zero_pool_cpu_callback(struct notifier_block *nfb,
+					    unsigned long action, void *hcpu)
+{
+	int cpu = (unsigned long)hcpu;
+	struct zero_pool *pool = &per_cpu(zero_pool, cpu);
+	struct task_struct *p;
+
+	switch (action) {
+	case CPU_UP_PREPARE:
+	case CPU_UP_PREPARE_FROZEN:
+		p = kthread_create(zero_pool_thread, pool, "kzerod/%d", cpu);
+		if (IS_ERR(p))
+			return notifier_from_errno(PTR_ERR(p));
+		kthread_bind(p, cpu);
+		pool->thread = p;
+		break;
+	case CPU_ONLINE:
+	case CPU_ONLINE_FROZEN:
+		if (pool->thread)
+			wake_up_process(pool->thread);
+		break;
+#ifdef CONFIG_HOTPLUG_CPU
+	case CPU_UP_CANCELED:
+	case CPU_UP_CANCELED_FROZEN:
+		if (!pool->thread)
+			break;
+		kthread_bind(pool->thread, cpumask_any(cpu_online_mask));
+		/* fall through */
+	case CPU_DEAD:
+	case CPU_DEAD_FROZEN:
+		p = pool->thread;
+		pool->thread = NULL;
+		kthread_stop(p);
+		zero_pool_drain(pool, UINT_MAX);
+		break;
+#endif
+	}
+	return NOTIFY_OK;
+}
+
+static struct notifier_block __cpuinitdata zero_pool_cpu_nfb = {
+	.notifier_call = zero_pool_cpu_callback,
+};
+
+#ifdef CONFIG_SYSFS
+/*
+ * This all compiles without CONFIG_SYSFS, but is a waste of space.
+ */
+
+#define ZERO_POOL_ATTR_RO(_name) \
+	static struct kobj_attribute _name##_attr = __ATTR_RO(_name)
+#define ZERO_POOL_ATTR(_name) \
+	static struct kobj_attribute _name##_attr = \
+		__ATTR(_name, 0644, _name##_show, _name##_store)
+
+static ssize_t run_show(struct kobject *kobj, struct kobj_attribute *attr,
+			char *buf)
+{
+	return sprintf(buf, "%d\n", zero_pool_run);
+}
+
+static ssize_t run_store(struct kobject *kobj, struct kobj_attribute *attr,
+			 const char *buf, size_t count)
+{
+	unsigned long run;
+
+	if (strict_strtoul(buf, 10, &run) || run > 1)
+		return -EINVAL;
+
+	mutex_lock(&zero_pool_mutex);
+	zero_pool_run = run;
+	if (run)
+		zero_pool_wake_all();
+	else
+		zero_pool_drain_all();
+	mutex_unlock(&zero_pool_mutex);
+
+	return count;
+}
+ZERO_POOL_ATTR(run);
+
+static ssize_t max_pages_show(struct kobject *kobj,
+			      struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", zero_pool_max_pages);
+}
+
+static ssize_t max_pages_store(struct kobject *kobj,
+			       struct kobj_attribute *attr,
+			       const char *buf, size_t count)
+{
+	unsigned long pages;
+	int cpu;
+
+	if (strict_strtoul(buf, 10, &pages) || pages > UINT_MAX)
+		return -EINVAL;
+
+	mutex_lock(&zero_pool_mutex);
+	zero_pool_max_pages = pages;
+	for_each_possible_cpu(cpu) {
+		struct zero_pool *pool = &per_cpu(zero_pool, cpu);
+
+		if (pool->pages > pages)
+			zero_pool_drain(pool, pool->pages - pages);
+	}
+	zero_pool_wake_all();
+	mutex_unlock(&zero_pool_mutex);
+
+	return count;
+}
+ZERO_POOL_ATTR(max_pages);
+
+#define ZERO_POOL_STAT(_name, _fmt)					\
+static ssize_t _name##_show(struct kobject *kobj,			\
+			    struct kobj_attribute *attr, char *buf)	\
+{									\
+	typeof(((struct zero_pool *)0)->_name) sum = 0;			\
+	int cpu;							\
+									\
+	for_each_possible_cpu(cpu)					\
+		sum += per_cpu(zero_pool, cpu)._name;			\
+	return sprintf(buf, _fmt "\n", sum);				\
+}									\
+ZERO_POOL_ATTR_RO(_name)
+
+ZERO_POOL_STAT(pages, "%u");
+ZERO_POOL_STAT(hits, "%lu");
+ZERO_POOL_STAT(misses, "%lu");
+ZERO_POOL_STAT(zeroed, "%lu");
+ZERO_POOL_STAT(faults, "%llu");
+ZERO_POOL_STAT(fault_ns, "%llu");
+
+static struct attribute *zero_pool_attrs[] = {
+	&run_attr.attr,
+	&max_pages_attr.attr,
+	&pages_attr.attr,
+	&hits_attr.attr,
+	&misses_attr.attr,
+	&zeroed_attr.attr,
+	&faults_attr.attr,
+	&fault_ns_attr.attr,
+	NULL,
+};
+
+static struct attribute_group zero_pool_attr_group = {
+	.attrs = zero_pool_attrs,
+	.name = "zero_pool",
+};
+#endif /* CONFIG_SYSFS */
+
+static int __init zero_pool_init(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct zero_pool *pool = &per_cpu(zero_pool, cpu);
+
+		spin_lock_init(&pool->lock);
+		INIT_LIST_HEAD(&pool->list);
+	}
+
+	zero_pool_run = 1;
+
+	for_each_online_cpu(cpu) {
+		void *hcpu = (void *)(long)cpu;
+
+		zero_pool_cpu_callback(&zero_pool_cpu_nfb, CPU_UP_PREPARE, hcpu);
+		zero_pool_cpu_callback(&zero_pool_cpu_nfb, CPU_ONLINE, hcpu);
+	}
+	register_cpu_notifier(&zero_pool_cpu_nfb);
+	register_shrinker(&zero_pool_shrinker);
+
+#ifdef CONFIG_SYSFS
+	if (sysfs_create_group(mm_kobj, &zero_pool_attr_group))
+		printk(KERN_ERR "zero_pool: register sysfs failed\n");
+#endif
+	return 0;
+}
+module_init(zero_pool_init)
@@ -16,7 +16,24 @@
 
 #include <linux/proc_fs.h>
 #include <linux/suspend.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/rculist.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/udp.h>
+#include <linux/workqueue.h>
+#include <net/activity_stats.h>
+#include <net/inet_hashtables.h>
+#include <net/inet6_hashtables.h>
+#include <net/ip.h>
+#include <net/ipv6.h>
 #include <net/net_namespace.h>
+#include <net/sock.h>
+#include <net/tcp.h>
+#include <net/udp.h>
 
 /*
  * Track transmission rates in buckets (power of 2).
@@ -84,6 +101,423 @@ static int activity_stats_read_proc(char *page, char **start, off_t off,
 	return p - page;
 }
 
+/*
+ * Radio wakeups.  A mobile interface is active from a packet it sends or
+ * receives until idle_secs pass without one, about as long as the modem
+ * keeps a dedicated channel after the last packet.  Each change from idle
+ * to active is a wakeup of the radio: it is counted for the interface and
+ * for the uid of the socket the packet came from or went to, and logged
+ * with the protocol and the local port of the packet.  Each change of
+ * state is sent to userspace as a change uevent of the interface, so that
+ * the framework can hold back background work while the radio is idle and
+ * run it while it is up anyway.
+ */
+#define RADIO_UIDS	64	/* uids counted per interface */
+#define RADIO_LOG	16	/* last wakeups kept per interface */
+#define RADIO_NO_UID	((uid_t)-1)
+
+static int radio_idle_secs = 5;
+module_param_named(idle_secs, radio_idle_secs, int, 0644);
+
+struct radio_uid {
+	uid_t uid;
+	unsigned long wakeups[2];	/* by a packet sent, received */
+};
+
+struct radio_wakeup {
+	struct timespec time;
+	uid_t uid;
+	unsigned long ino;		/* of the socket, 0 for none */
+	u8 rx;
+	u8 proto;
+	u16 port;			/* local */
+};
+
+struct radio_dev {
+	struct list_head list;
+	struct net_device *dev;
+	spinlock_t lock;
+	int active;
+	unsigned long last;		/* jiffies of the last packet */
+	ktime_t since;			/* of the last change */
+	u64 active_ns;			/* before it */
+	unsigned long wakeups;
+	struct timer_list timer;
+	struct work_struct work;
+	int notified;			/* the state userspace was sent */
+	int log_next;
+	struct radio_wakeup log[RADIO_LOG];
+	int nuids;
+	unsigned long uid_overflow;	/* wakeups of uids that did not fit */
+	struct radio_uid uids[RADIO_UIDS];
+};
+
+static LIST_HEAD(radio_devs);
+static DEFINE_MUTEX(radio_mutex);	/* changes to radio_devs */
+
+static unsigned long radio_idle_jiffies(void)
+{
+	return max(radio_idle_secs, 1) * HZ;
+}
+
+static struct radio_dev *radio_find(const struct net_device *dev)
+{
+	struct radio_dev *rd;
+
+	list_for_each_entry_rcu(rd, &radio_devs, list)
+		if (rd->dev == dev)
+			return rd;
+	return NULL;
+}
+
+static void radio_owner(struct sock *sk, struct radio_wakeup *w)
+{
+	if (sk->sk_state == TCP_TIME_WAIT)
+		return;
+
+	read_lock_bh(&sk->sk_callback_lock);
+	if (sk->sk_socket && sk->sk_socket->file) {
+		w->uid = sk->sk_socket->file->f_cred->fsuid;
+		w->ino = SOCK_INODE(sk->sk_socket)->i_ino;
+	}
+	read_unlock_bh(&sk->sk_callback_lock);
+}
+
+/*
+ * The protocol and local port of the packet that woke the radio, and its
+ * socket: the one that sent it, or for one received the TCP or UDP socket
+ * it is for, looked up here as the packet is not yet tied to one.
+ */
+static void radio_flow(struct sk_buff *skb, int rx, struct radio_wakeup *w)
+{
+	struct net_device *dev = skb->dev;
+	int noff = skb_network_offset(skb);
+	struct sock *sk = NULL;
+	struct udphdr _hdr, *hp;
+
+	switch (skb->protocol) {
+	case htons(ETH_P_IP): {
+		struct iphdr _iph, *iph;
+
+		iph = skb_header_pointer(skb, noff, sizeof(_iph), &_iph);
+		if (!iph)
+			break;
+		w->proto = iph->protocol;
+		if ((iph->protocol != IPPROTO_TCP &&
+		     iph->protocol != IPPROTO_UDP) ||
+		    (iph->frag_off & htons(IP_OFFSET)))
+			break;
+		/* the ports are in the same place in the TCP header */
+		hp = skb_header_pointer(skb, noff + iph->ihl * 4, sizeof(_hdr),
+					&_hdr);
+		if (!hp)
+			break;
+		w->port = ntohs(rx ? hp->dest : hp->source);
+		if (!rx)
+			break;
+		if (iph->protocol == IPPROTO_TCP)
+			sk = inet_lookup(dev_net(dev), &tcp_hashinfo,
+					 iph->saddr, hp->source,
+					 iph->daddr, hp->dest, dev->ifindex);
+		else
+			sk = udp4_lib_lookup(dev_net(dev), iph->saddr,
+					     hp->source, iph->daddr, hp->dest,
+					     dev->ifindex);
+		break;
+	}
+#ifdef CONFIG_IPV6
+	case htons(ETH_P_IPV6): {
+		struct ipv6hdr _ip6h, *ip6h;
+		u8 nexthdr;
+		int thoff;
+
+		ip6h = skb_header_pointer(skb, noff, sizeof(_ip6h), &_ip6h);
+		if (!ip6h)
+			break;
+		nexthdr = ip6h->nexthdr;
+		thoff = ipv6_skip_exthdr(skb, noff + sizeof(*ip6h), &nexthdr);
+		w->proto = nexthdr;
+		if (thoff < 0 ||
+		    (nexthdr != IPPROTO_TCP && nexthdr != IPPROTO_UDP))
+			break;
+		hp = skb_header_pointer(skb, thoff, sizeof(_hdr), &_hdr);
+		if (!hp)
+			break;
+		w->port = ntohs(rx ? hp->dest : hp->source);
+		if (!rx)
+			break;
+		if (nexthdr == IPPROTO_TCP)
+			sk = inet6_lookup(dev_net(dev), &tcp_hashinfo,
+					  &ip6h->saddr, hp->source,
+					  &ip6h->daddr, hp->dest, dev->ifindex);
+		else
+			sk = udp6_lib_lookup(dev_net(dev), &ip6h->saddr,
+					     hp->source, &ip6h->daddr,
+					     hp->dest, dev->ifindex);
+		break;
+	}
+#endif
+	}
+
+	if (!rx && skb->sk)
+		radio_owner(skb->sk, w);
+	if (sk) {
+		radio_owner(sk, w);
+		if (sk->sk_state == TCP_TIME_WAIT)
+			inet_twsk_put(inet_twsk(sk));
+		else
+			sock_put(sk);
+	}
+}
+
+static void radio_count(struct radio_dev *rd, const struct radio_wakeup *w)
+{
+	int i;
+
+	rd->wakeups++;
+	rd->log[rd->log_next] = *w;
+	rd->log_next = (rd->log_next + 1) % RADIO_LOG;
+
+	for (i = 0; i < rd->nuids; i++)
+		if (rd->uids[i].uid == w->uid)
+			break;
+	if (i == rd->nuids) {
+		if (i == RADIO_UIDS) {
+			rd->uid_overflow++;
+			return;
+		}
+		rd->uids[i].uid = w->uid;
+		rd->nuids++;
+	}
+	rd->uids[i].wakeups[w->rx]++;
+}
+
+void __activity_stats_radio(struct sk_buff *skb, int rx)
+{
+	struct radio_wakeup w;
+	struct radio_dev *rd;
+	ktime_t now;
+
+	rcu_read_lock();
+	rd = radio_find(skb->dev);
+	if (!rd)
+		goto out;
+
+	spin_lock_bh(&rd->lock);
+	rd->last = jiffies;
+	if (rd->active) {
+		spin_unlock_bh(&rd->lock);
+		goto out;
+	}
+	spin_unlock_bh(&rd->lock);
+
+	/* a wakeup; who caused it is looked up outside the lock */
+	memset(&w, 0, sizeof(w));
+	w.uid = RADIO_NO_UID;
+	w.rx = !!rx;
+	radio_flow(skb, rx, &w);
+	getnstimeofday(&w.time);
+
+	spin_lock_bh(&rd->lock);
+	if (!rd->active) {
+		rd->active = 1;
+		now = ktime_get();
+		rd->since = now;
+		radio_count(rd, &w);
+		mod_timer(&rd->timer, rd->last + radio_idle_jiffies());
+		schedule_work(&rd->work);
+	}
+	spin_unlock_bh(&rd->lock);
+out:
+	rcu_read_unlock();
+}
+
+static void radio_idle_timer(unsigned long data)
+{
+	struct radio_dev *rd = (struct radio_dev *)data;
+	unsigned long idle;
+	ktime_t now;
+
+	spin_lock(&rd->lock);
+	idle = rd->last + radio_idle_jiffies();
+	if (time_before(jiffies, idle)) {
+		mod_timer(&rd->timer, idle);
+	} else if (rd->active) {
+		rd->active = 0;
+		now = ktime_get();
+		rd->active_ns += ktime_to_ns(ktime_sub(now, rd->since));
+		rd->since = now;
+		schedule_work(&rd->work);
+	}
+	spin_unlock(&rd->lock);
+}
+
+/* the uevent allocates, so it is sent from a work */
+static void radio_notify_work(struct work_struct *work)
+{
+	struct radio_dev *rd = container_of(work, struct radio_dev, work);
+	char state[24], uid[24], time[40];
+	char *envp[] = { state, uid, time, NULL };
+	const struct radio_wakeup *w;
+	struct timespec ts;
+	int active;
+
+	spin_lock_bh(&rd->lock);
+	active = rd->active;
+	if (active == rd->notified) {
+		spin_unlock_bh(&rd->lock);
+		return;
+	}
+	rd->notified = active;
+	w = &rd->log[(rd->log_next + RADIO_LOG - 1) % RADIO_LOG];
+	snprintf(uid, sizeof(uid), "RADIO_UID=%d",
+		 active ? (int)w->uid : (int)RADIO_NO_UID);
+	spin_unlock_bh(&rd->lock);
+
+	getnstimeofday(&ts);
+	snprintf(state, sizeof(state), "RADIO_STATE=%s",
+		 active ? "active" : "idle");
+	snprintf(time, sizeof(time), "RADIO_TIME_NS=%llu",
+		 (unsigned long long)timespec_to_ns(&ts));
+	kobject_uevent_env(&rd->dev->dev.kobj, KOBJ_CHANGE, envp);
+}
+
+static void radio_add(struct net_device *dev)
+{
+	struct radio_dev *rd;
+
+	rd = kzalloc(sizeof(*rd), GFP_KERNEL);
+	if (!rd)
+		return;
+	dev_hold(dev);
+	rd->dev = dev;
+	spin_lock_init(&rd->lock);
+	rd->since = ktime_get();
+	setup_timer(&rd->timer, radio_idle_timer, (unsigned long)rd);
+	INIT_WORK(&rd->work, radio_notify_work);
+
+	mutex_lock(&radio_mutex);
+	list_add_tail_rcu(&rd->list, &radio_devs);
+	mutex_unlock(&radio_mutex);
+}
+
+static void radio_del(struct net_device *dev)
+{
+	struct radio_dev *rd;
+
+	mutex_lock(&radio_mutex);
+	rd = radio_find(dev);
+	if (rd)
+		list_del_rcu(&rd->list);
+	mutex_unlock(&radio_mutex);
+	if (!rd)
+		return;
+
+	synchronize_rcu();
+	del_timer_sync(&rd->timer);
+	cancel_work_sync(&rd->work);
+	dev_put(dev);
+	kfree(rd);
+}
+
+static int radio_netdev_event(struct notifier_block *nb, unsigned long event,
+			      void *ptr)
+{
+	struct net_device *dev = ptr;
+
+	if (dev->type != ARPHRD_PPP)
+		return NOTIFY_DONE;
+
+	switch (event) {
+	case NETDEV_REGISTER:
+		radio_add(dev);
+		break;
+	case NETDEV_UNREGISTER:
+		radio_del(dev);
+		break;
+	}
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block radio_netdev_notifier = {
+	.notifier_call = radio_netdev_event,
+};
+
+/* after a suspend as long as the idle time the radio is idle too */
+static void radio_resume(ktime_t slept)
+{
+	struct radio_dev *rd;
+
+	if (ktime_to_ns(slept) < (s64)max(radio_idle_secs, 1) * NSEC_PER_SEC)
+		return;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(rd, &radio_devs, list) {
+		spin_lock_bh(&rd->lock);
+		if (rd->active) {
+			rd->last = jiffies - radio_idle_jiffies();
+			mod_timer(&rd->timer, jiffies);
+		}
+		spin_unlock_bh(&rd->lock);
+	}
+	rcu_read_unlock();
+}
+
+static void radio_seq_dev(struct seq_file *m, struct radio_dev *rd)
+{
+	const struct radio_wakeup *w;
+	u64 active_ns;
+	int i;
+
+	spin_lock_bh(&rd->lock);
+	active_ns = rd->active_ns;
+	if (rd->active)
+		active_ns += ktime_to_ns(ktime_sub(ktime_get(), rd->since));
+	seq_printf(m, "%s %s wakeups %lu active_ms %llu\n", rd->dev->name,
+		   rd->active ? "active" : "idle", rd->wakeups,
+		   (unsigned long long)div_u64(active_ns, NSEC_PER_MSEC));
+	for (i = 0; i < rd->nuids; i++)
+		seq_printf(m, "  uid %d tx %lu rx %lu\n", (int)rd->uids[i].uid,
+			   rd->uids[i].wakeups[0], rd->uids[i].wakeups[1]);
+	if (rd->uid_overflow)
+		seq_printf(m, "  uid other %lu\n", rd->uid_overflow);
+	for (i = 0; i < RADIO_LOG; i++) {
+		w = &rd->log[(rd->log_next + i) % RADIO_LOG];
+		if (!w->time.tv_sec)
+			continue;
+		seq_printf(m, "  at %ld.%03ld %s uid %d ino %lu proto %u "
+			   "port %u\n", w->time.tv_sec,
+			   w->time.tv_nsec / NSEC_PER_MSEC, w->rx ? "rx" : "tx",
+			   (int)w->uid, w->ino, w->proto, w->port);
+	}
+	spin_unlock_bh(&rd->lock);
+}
+
+static int radio_seq_show(struct seq_file *m, void *v)
+{
+	struct radio_dev *rd;
+
+	seq_printf(m, "idle_secs %d\n", radio_idle_secs);
+	rcu_read_lock();
+	list_for_each_entry_rcu(rd, &radio_devs, list)
+		radio_seq_dev(m, rd);
+	rcu_read_unlock();
+	return 0;
+}
+
+static int radio_seq_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, radio_seq_show, NULL);
+}
+
+static const struct file_operations radio_fops = {
+	.owner		= THIS_MODULE,
+	.open		= radio_seq_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int activity_stats_notifier(struct notifier_block *nb,
 					unsigned long event, void *dummy)
 {
@@ -95,6 +529,7 @@ static int activity_stats_notifier(struct notifier_block *nb,
 		case PM_POST_SUSPEND:
 			suspend_time = ktime_sub(ktime_get_real(), suspend_time);
 			last_transmit = ktime_sub(last_transmit, suspend_time);
+			radio_resume(suspend_time);
 	}
 
 	return 0;
@@ -108,6 +543,8 @@ static int  __init activity_stats_init(void)
 {
 	create_proc_read_entry("activity", S_IRUGO,
 			init_net.proc_net_stat, activity_stats_read_proc, NULL);
+	proc_create("radio", S_IRUGO, init_net.proc_net_stat, &radio_fops);
+	register_netdevice_notifier(&radio_netdev_notifier);
 	return register_pm_notifier(&activity_stats_notifier_block);
 }
 
@@ -131,6 +131,7 @@
 #include <linux/random.h>
 #include <trace/events/napi.h>
 #include <linux/pci.h>
+#include <net/activity_stats.h>
 
 #include "net-sysfs.h"
 
@@ -2142,6 +2143,8 @@ int dev_queue_xmit(struct sk_buff *skb)
 	struct Qdisc *q;
 	int rc = -ENOMEM;
 
+	activity_stats_radio(skb, 0);
+
 	/* GSO will handle the following emulations directly. */
 	if (netif_needs_gso(dev, skb))
 		goto gso;
@@ -2864,6 +2867,8 @@ static int __netif_receive_skb(struct sk_buff *skb)
 	skb_reset_transport_header(skb);
 	skb->mac_len = skb->network_header - skb->mac_header;
 
+	activity_stats_radio(skb, 1);
+
 	pt_prev = NULL;
 
 	rcu_read_lock();
@@ -56,6 +56,9 @@
 #include <linux/rtnetlink.h>
 #include <linux/init.h>
 #include <linux/scatterlist.h>
+#include <linux/percpu.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
 #include <linux/errqueue.h>
 
 #include <net/protocol.h>
@@ -63,6 +66,7 @@
 #include <net/sock.h>
 #include <net/checksum.h>
 #include <net/xfrm.h>
+#include <net/net_namespace.h>
 
 #include <asm/uaccess.h>
 #include <asm/system.h>
@@ -407,6 +411,8 @@ static void skb_release_head_state(struct sk_buff *skb)
 #endif
 }
 
+static bool skb_pool_recycle(struct sk_buff *skb);
+
 /* Free everything but the sk_buff shell. */
 static void skb_release_all(struct sk_buff *skb)
 {
@@ -425,6 +431,8 @@ static void skb_release_all(struct sk_buff *skb)
 
 void __kfree_skb(struct sk_buff *skb)
 {
+	if (unlikely(skb->pool_id) && skb_pool_recycle(skb))
+		return;
 	skb_release_all(skb);
 	kfree_skbmem(skb);
 }
@@ -513,6 +521,304 @@ bool skb_recycle_check(struct sk_buff *skb, int skb_size)
 }
 EXPORT_SYMBOL(skb_recycle_check);
 
+/*
+ * Receive buffer pools.  A driver that receives into buffers of one size
+ * can make a pool of them and allocate from it.  Once the stack is done
+ * with such a buffer, __kfree_skb() puts it back in the pool of the cpu
+ * that frees it, reset by skb_recycle_check(), instead of in the slab.
+ * Under steady receive the buffers then go round without the allocator,
+ * so it cannot fail them when memory is short.  skb->pool_id says which
+ * pool a buffer is from; it is 3 bits, so there are at most 7 pools.
+ *
+ * A buffer whose head was reallocated, or that is still shared, cloned or
+ * nonlinear when freed, is freed as any other.  So is one freed to a full
+ * pool, or with irqs off.
+ */
+#define SKB_POOL_MAX	7
+
+struct skb_pool_cpu {
+	struct sk_buff_head	list;
+	unsigned long		hits;		/* allocated from the pool */
+	unsigned long		misses;		/* from the slab, pool empty */
+	unsigned long		recycled;	/* put back in the pool */
+	unsigned long		full;		/* freed, the pool full */
+	unsigned long		failed;		/* allocations that failed */
+};
+
+struct skb_pool {
+	const char		*name;
+	unsigned int		size;		/* room after NET_SKB_PAD */
+	unsigned int		bufsize;	/* from head to end */
+	unsigned int		count;		/* per cpu, at most */
+	int			id;
+	struct skb_pool_cpu __percpu *cpu;
+};
+
+/* the pools by pool_id; 0 is none */
+static struct skb_pool *skb_pools[SKB_POOL_MAX + 1];
+static DEFINE_MUTEX(skb_pool_mutex);
+
+/* 0 has skb_pool_alloc() allocate from the slab, for comparison */
+int sysctl_skb_pool __read_mostly = 1;
+
+/* what the driver would have allocated without a pool; @dev may be NULL */
+static struct sk_buff *skb_pool_slab(struct net_device *dev,
+				     unsigned int length, gfp_t gfp_mask)
+{
+	if (!dev)
+		return __dev_alloc_skb(length, gfp_mask);
+	return __netdev_alloc_skb(dev, length, gfp_mask);
+}
+
+static struct sk_buff *skb_pool_new(struct skb_pool *pool, gfp_t gfp_mask)
+{
+	struct sk_buff *skb = alloc_skb(pool->size + NET_SKB_PAD, gfp_mask);
+
+	if (skb)
+		skb_reserve(skb, NET_SKB_PAD);
+	return skb;
+}
+
+/**
+ *	skb_pool_create - make a pool of receive buffers
+ *	@name: name of the pool in /proc/net/stat/skb_pool
+ *	@size: room in each buffer, as asked of netdev_alloc_skb()
+ *	@count: buffers the pool of each cpu holds at most
+ *
+ *	Makes a pool, and fills it with @count buffers for each cpu, or
+ *	as many as can be had.  Returns %NULL if there is no memory or
+ *	no pool_id left.  May sleep.
+ */
+struct skb_pool *skb_pool_create(const char *name, unsigned int size,
+				 unsigned int count)
+{
+	struct skb_pool_cpu *pc;
+	struct skb_pool *pool;
+	struct sk_buff *skb;
+	int cpu, id, i;
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return NULL;
+	pool->cpu = alloc_percpu(struct skb_pool_cpu);
+	if (!pool->cpu) {
+		kfree(pool);
+		return NULL;
+	}
+	pool->name = name;
+	pool->size = size;
+	pool->bufsize = SKB_DATA_ALIGN(size + NET_SKB_PAD);
+	pool->count = count;
+
+	for_each_possible_cpu(cpu) {
+		pc = per_cpu_ptr(pool->cpu, cpu);
+		skb_queue_head_init(&pc->list);
+		for (i = 0; i < count; i++) {
+			skb = skb_pool_new(pool, GFP_KERNEL);
+			if (!skb)
+				break;
+			__skb_queue_tail(&pc->list, skb);
+		}
+	}
+
+	mutex_lock(&skb_pool_mutex);
+	for (id = 1; id <= SKB_POOL_MAX; id++)
+		if (!skb_pools[id])
+			break;
+	if (id <= SKB_POOL_MAX) {
+		pool->id = id;
+		rcu_assign_pointer(skb_pools[id], pool);
+	}
+	mutex_unlock(&skb_pool_mutex);
+
+	if (!pool->id) {
+		for_each_possible_cpu(cpu)
+			skb_queue_purge(&per_cpu_ptr(pool->cpu, cpu)->list);
+		free_percpu(pool->cpu);
+		kfree(pool);
+		return NULL;
+	}
+	return pool;
+}
+EXPORT_SYMBOL(skb_pool_create);
+
+/**
+ *	skb_pool_destroy - free a pool of receive buffers
+ *	@pool: pool from skb_pool_create(), or %NULL
+ *
+ *	Frees the buffers in the pool, and the pool.  Buffers of the pool
+ *	still in use are freed to the slab when done with.  May sleep.
+ */
+void skb_pool_destroy(struct skb_pool *pool)
+{
+	int cpu;
+
+	if (!pool)
+		return;
+
+	mutex_lock(&skb_pool_mutex);
+	rcu_assign_pointer(skb_pools[pool->id], NULL);
+	mutex_unlock(&skb_pool_mutex);
+	/* for skb_pool_recycle() to be done with it */
+	synchronize_rcu();
+
+	for_each_possible_cpu(cpu)
+		skb_queue_purge(&per_cpu_ptr(pool->cpu, cpu)->list);
+	free_percpu(pool->cpu);
+	kfree(pool);
+}
+EXPORT_SYMBOL(skb_pool_destroy);
+
+/**
+ *	skb_pool_alloc - allocate a receive buffer from a pool
+ *	@pool: pool from skb_pool_create(), or %NULL
+ *	@dev: network device to receive on, or %NULL
+ *	@length: length to allocate
+ *	@gfp_mask: get_free_pages mask, passed to alloc_skb
+ *
+ *	As __netdev_alloc_skb(), or __dev_alloc_skb() without @dev, but from
+ *	@pool if @length fits its buffers.  The buffer goes back to the pool
+ *	when freed.  If the pool is empty, a buffer for it is allocated.
+ *	Returns %NULL if none can be had.
+ */
+struct sk_buff *skb_pool_alloc(struct skb_pool *pool, struct net_device *dev,
+			       unsigned int length, gfp_t gfp_mask)
+{
+	struct skb_pool_cpu *pc;
+	struct sk_buff *skb;
+	unsigned long flags;
+
+	if (!pool)
+		return skb_pool_slab(dev, length, gfp_mask);
+
+	skb = NULL;
+	if (length <= pool->size && sysctl_skb_pool) {
+		local_irq_save(flags);
+		pc = per_cpu_ptr(pool->cpu, smp_processor_id());
+		skb = __skb_dequeue(&pc->list);
+		if (skb)
+			pc->hits++;
+		else
+			pc->misses++;
+		local_irq_restore(flags);
+
+		if (!skb)
+			skb = skb_pool_new(pool, gfp_mask);
+		if (skb) {
+			skb->dev = dev;
+			skb->pool_id = pool->id;
+		}
+	} else {
+		skb = skb_pool_slab(dev, length, gfp_mask);
+	}
+
+	if (unlikely(!skb)) {
+		local_irq_save(flags);
+		per_cpu_ptr(pool->cpu, smp_processor_id())->failed++;
+		local_irq_restore(flags);
+	}
+	return skb;
+}
+EXPORT_SYMBOL(skb_pool_alloc);
+
+/* from __kfree_skb(); true if the pool took @skb */
+static bool skb_pool_recycle(struct sk_buff *skb)
+{
+	struct skb_pool_cpu *pc;
+	struct skb_pool *pool;
+	unsigned long flags;
+	bool taken = false, full;
+
+	rcu_read_lock();
+	pool = rcu_dereference(skb_pools[skb->pool_id]);
+	if (!pool || skb_end_pointer(skb) - skb->head != pool->bufsize)
+		goto out;
+
+	/*
+	 * Not reset unless it fits; the pool may fill up before it goes
+	 * in, and then holds one more.
+	 */
+	local_irq_save(flags);
+	pc = per_cpu_ptr(pool->cpu, smp_processor_id());
+	full = skb_queue_len(&pc->list) >= pool->count;
+	if (full)
+		pc->full++;
+	local_irq_restore(flags);
+	if (full || !skb_recycle_check(skb, pool->size))
+		goto out;
+
+	/* at the head, where the next allocation finds it still in cache */
+	local_irq_save(flags);
+	pc = per_cpu_ptr(pool->cpu, smp_processor_id());
+	__skb_queue_head(&pc->list, skb);
+	pc->recycled++;
+	local_irq_restore(flags);
+	taken = true;
+out:
+	rcu_read_unlock();
+	return taken;
+}
+
+static int skb_pool_seq_show(struct seq_file *seq, void *v)
+{
+	unsigned long hits, misses, recycled, full, failed;
+	struct skb_pool_cpu *pc;
+	struct skb_pool *pool;
+	int id, cpu, held;
+	unsigned int rate;
+
+	seq_printf(seq, "%-12s %6s %6s %6s %10s %10s %10s %8s %8s %6s\n",
+		   "pool", "size", "count", "held", "hits", "misses",
+		   "recycled", "full", "failed", "hit_%");
+
+	mutex_lock(&skb_pool_mutex);
+	for (id = 1; id <= SKB_POOL_MAX; id++) {
+		pool = skb_pools[id];
+		if (!pool)
+			continue;
+		hits = misses = recycled = full = failed = 0;
+		held = 0;
+		for_each_possible_cpu(cpu) {
+			pc = per_cpu_ptr(pool->cpu, cpu);
+			hits += pc->hits;
+			misses += pc->misses;
+			recycled += pc->recycled;
+			full += pc->full;
+			failed += pc->failed;
+			held += skb_queue_len(&pc->list);
+		}
+		rate = hits + misses ?
+		       div_u64(100ULL * hits, hits + misses) : 0;
+		seq_printf(seq, "%-12s %6u %6u %6d %10lu %10lu %10lu %8lu %8lu "
+			   "%6u\n", pool->name, pool->size, pool->count, held,
+			   hits, misses, recycled, full, failed, rate);
+	}
+	mutex_unlock(&skb_pool_mutex);
+	return 0;
+}
+
+static int skb_pool_seq_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, skb_pool_seq_show, NULL);
+}
+
+static const struct file_operations skb_pool_fops = {
+	.owner	 = THIS_MODULE,
+	.open	 = skb_pool_seq_open,
+	.read	 = seq_read,
+	.llseek	 = seq_lseek,
+	.release = single_release,
+};
+
+static int __init skb_pool_proc_init(void)
+{
+	if (!proc_create("skb_pool", S_IRUGO, init_net.proc_net_stat,
+			 &skb_pool_fops))
+		return -ENOMEM;
+	return 0;
+}
+subsys_initcall(skb_pool_proc_init);
+
 static void __copy_skb_header(struct sk_buff *new, const struct sk_buff *old)
 {
 	new->tstamp		= old->tstamp;
@@ -579,6 +885,7 @@ static struct sk_buff *__skb_clone(struct sk_buff *n, struct sk_buff *skb)
 	C(head);
 	C(data);
 	C(truesize);
+	C(pool_id);
 	atomic_set(&n->users, 1);
 
 	atomic_inc(&(skb_shinfo(skb)->dataref));
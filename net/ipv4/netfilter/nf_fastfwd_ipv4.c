@@ -0,0 +1,694 @@
+/*
+ * Fast path for established forwarded IPv4 flows: a flow cache that
+ * forwards the packets of a flow conntrack and NAT have already decided
+ * on, without taking them through either again.
+ *
+ * Copyright (c) 2010 by Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+#include <linux/module.h>
+#include <linux/capability.h>
+#include <linux/inetdevice.h>
+#include <linux/ip.h>
+#include <linux/jhash.h>
+#include <linux/netdevice.h>
+#include <linux/netfilter.h>
+#include <linux/netfilter_ipv4.h>
+#include <linux/netfilter/x_tables.h>
+#include <linux/proc_fs.h>
+#include <linux/random.h>
+#include <linux/rculist.h>
+#include <linux/seq_file.h>
+#include <linux/skbuff.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/tcp.h>
+#include <linux/timer.h>
+#include <linux/udp.h>
+#include <net/checksum.h>
+#include <net/dst.h>
+#include <net/ip.h>
+#include <net/neighbour.h>
+#include <net/net_namespace.h>
+#include <net/route.h>
+#include <net/netfilter/nf_conntrack.h>
+#include <net/netfilter/nf_conntrack_acct.h>
+#include <net/netfilter/nf_conntrack_helper.h>
+
+/*
+ * A tethered packet goes through defrag, conntrack, NAT, the filter
+ * table and the route lookup twice over, in PREROUTING and POSTROUTING,
+ * though after the first packets of a flow each of them only finds what
+ * it found for the packet before.  So the first packet of an established
+ * flow that leaves in POSTROUTING, with conntrack and NAT done, puts the
+ * flow in the cache: its tuple as it arrives, the addresses and ports
+ * NAT gave it, its conntrack and its route.  The packets after it are
+ * found in the cache as they arrive, ahead of defrag, rewritten, and
+ * handed to the neighbour of the route; conntrack is only told of them
+ * once a second, to keep the connection from timing out and its counters
+ * right.
+ *
+ * Only what needs nothing of the slow path goes in: TCP in the
+ * established state and assured UDP, without a helper, sequence
+ * adjustment, mark, IP options or IPsec.  TCP packets with SYN, FIN or
+ * RST take the slow path, and the state change they make there ends the
+ * flow here.  A flow ends when its conntrack is dying or leaves the
+ * established state, when its route is flushed or its device goes down,
+ * when the rules of any table are replaced, and after a minute without
+ * packets.  Forwarding being turned off on the device a packet came in
+ * on sends it to the slow path, and flushes the routes, ending the flows.
+ * A write to /proc/net/nf_fastfwd flushes the cache.
+ *
+ * Past its first packets a cached flow no longer goes through the raw,
+ * mangle, filter or nat tables: per-packet matches and targets (quota,
+ * limit, length, statistic, LOG, ...) stop seeing it, and the counters
+ * of the rules stop counting it.  So the fast path is off until the
+ * enable parameter is set, by whoever knows the rules allow it.
+ */
+#define FASTFWD_HASH_BITS	10
+#define FASTFWD_HASH_SIZE	(1 << FASTFWD_HASH_BITS)
+#define FASTFWD_IDLE		(60 * HZ)
+#define FASTFWD_GC		(5 * HZ)
+
+struct fastfwd_key {
+	__be32 saddr;
+	__be32 daddr;
+	__be16 sport;
+	__be16 dport;
+	u8 proto;
+	int iif;
+};
+
+struct fastfwd_flow {
+	struct hlist_node link;
+	struct rcu_head rcu;
+	struct fastfwd_key key;
+	/* what the packet leaves as */
+	__be32 saddr;
+	__be32 daddr;
+	__be16 sport;
+	__be16 dport;
+	struct nf_conn *ct;
+	enum ip_conntrack_dir dir;
+	struct dst_entry *dst;
+	int genid;		/* of the rules the flow was let through by */
+	int dead;
+	unsigned long timeout;	/* of the conntrack in its state */
+	unsigned long last;	/* jiffies of the last packet */
+	unsigned long synced;	/* jiffies conntrack was last told */
+	/* not yet told to conntrack; on SMP a race may lose a few */
+	u32 packets;
+	u32 bytes;
+	u64 hits;
+};
+
+static struct hlist_head fastfwd_hash[FASTFWD_HASH_SIZE];
+static DEFINE_SPINLOCK(fastfwd_lock);
+static unsigned int fastfwd_count;
+static u32 fastfwd_rnd __read_mostly;
+static struct kmem_cache *fastfwd_cache __read_mostly;
+static struct timer_list fastfwd_gc_timer;
+
+static struct {
+	unsigned long learned;
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long full;
+	unsigned long ended;
+} fastfwd_stats;
+
+static int fastfwd_enabled;
+module_param_named(enable, fastfwd_enabled, bool, 0644);
+MODULE_PARM_DESC(enable, "forward cached flows, and cache new ones; "
+		 "cached flows bypass the per-packet rules");
+
+static unsigned int fastfwd_max = 4096;
+module_param_named(max_flows, fastfwd_max, uint, 0644);
+MODULE_PARM_DESC(max_flows, "flows the cache holds at most");
+
+static inline unsigned int fastfwd_hashfn(const struct fastfwd_key *key)
+{
+	return jhash_3words(key->saddr, key->daddr,
+			    ((u32)key->sport << 16 | key->dport) ^
+			    key->proto ^ key->iif,
+			    fastfwd_rnd) & (FASTFWD_HASH_SIZE - 1);
+}
+
+static inline bool fastfwd_key_equal(const struct fastfwd_key *a,
+				     const struct fastfwd_key *b)
+{
+	return a->saddr == b->saddr && a->daddr == b->daddr &&
+	       a->sport == b->sport && a->dport == b->dport &&
+	       a->proto == b->proto && a->iif == b->iif;
+}
+
+/* under rcu_read_lock() or fastfwd_lock */
+static struct fastfwd_flow *fastfwd_find(const struct fastfwd_key *key)
+{
+	struct fastfwd_flow *flow;
+	struct hlist_node *n;
+
+	hlist_for_each_entry_rcu(flow, n, &fastfwd_hash[fastfwd_hashfn(key)],
+				 link)
+		if (fastfwd_key_equal(&flow->key, key))
+			return flow;
+	return NULL;
+}
+
+/*
+ * What conntrack would have done for the packets since the last time:
+ * push the timeout out, as __nf_ct_refresh_acct() does, and count them.
+ */
+static void fastfwd_sync(struct fastfwd_flow *flow)
+{
+	struct nf_conn *ct = flow->ct;
+	struct nf_conn_counter *acct;
+	unsigned long newtime = jiffies + flow->timeout;
+
+	if (!test_bit(IPS_FIXED_TIMEOUT_BIT, &ct->status) &&
+	    newtime - ct->timeout.expires >= HZ)
+		mod_timer_pending(&ct->timeout, newtime);
+
+	acct = nf_conn_acct_find(ct);
+	if (acct && flow->packets) {
+		spin_lock_bh(&ct->lock);
+		acct[flow->dir].packets += flow->packets;
+		acct[flow->dir].bytes += flow->bytes;
+		spin_unlock_bh(&ct->lock);
+	}
+	flow->packets = 0;
+	flow->bytes = 0;
+	flow->synced = jiffies;
+}
+
+static void fastfwd_free_rcu(struct rcu_head *head)
+{
+	struct fastfwd_flow *flow = container_of(head, struct fastfwd_flow,
+						 rcu);
+
+	fastfwd_sync(flow);
+	nf_ct_put(flow->ct);
+	dst_release(flow->dst);
+	kmem_cache_free(fastfwd_cache, flow);
+}
+
+/* under fastfwd_lock */
+static void __fastfwd_end(struct fastfwd_flow *flow)
+{
+	if (flow->dead)
+		return;
+	flow->dead = 1;
+	hlist_del_rcu(&flow->link);
+	fastfwd_count--;
+	fastfwd_stats.ended++;
+	call_rcu(&flow->rcu, fastfwd_free_rcu);
+}
+
+static void fastfwd_end(struct fastfwd_flow *flow)
+{
+	spin_lock_bh(&fastfwd_lock);
+	__fastfwd_end(flow);
+	spin_unlock_bh(&fastfwd_lock);
+}
+
+static void fastfwd_flush(void)
+{
+	struct fastfwd_flow *flow;
+	struct hlist_node *n, *tmp;
+	int i;
+
+	spin_lock_bh(&fastfwd_lock);
+	for (i = 0; i < FASTFWD_HASH_SIZE; i++)
+		hlist_for_each_entry_safe(flow, n, tmp, &fastfwd_hash[i], link)
+			__fastfwd_end(flow);
+	spin_unlock_bh(&fastfwd_lock);
+}
+
+/* whether what the flow was cached with still holds */
+static bool fastfwd_valid(const struct fastfwd_flow *flow)
+{
+	struct nf_conn *ct = flow->ct;
+	struct dst_entry *dst = flow->dst;
+	struct rtable *rt = (struct rtable *)dst;
+
+	if (nf_ct_is_dying(ct))
+		return false;
+	if (flow->key.proto == IPPROTO_TCP &&
+	    ct->proto.tcp.state != TCP_CONNTRACK_ESTABLISHED)
+		return false;
+	if (flow->genid != atomic_read(&xt_table_genid))
+		return false;
+	if (dst->obsolete ||
+	    rt->rt_genid != atomic_read(&dev_net(dst->dev)->ipv4.rt_genid))
+		return false;
+	return netif_running(dst->dev) && netif_carrier_ok(dst->dev);
+}
+
+static void fastfwd_mangle(struct sk_buff *skb,
+			   const struct fastfwd_flow *flow)
+{
+	struct iphdr *iph = ip_hdr(skb);
+	void *th = (void *)iph + sizeof(*iph);
+	__sum16 *check;
+	__be16 *ports = th;
+
+	if (iph->protocol == IPPROTO_TCP) {
+		check = &((struct tcphdr *)th)->check;
+	} else {
+		check = &((struct udphdr *)th)->check;
+		/* no checksum to keep, as in nf_nat_proto_udp */
+		if (!*check && skb->ip_summed != CHECKSUM_PARTIAL)
+			check = NULL;
+	}
+
+	if (iph->saddr != flow->saddr) {
+		if (check)
+			inet_proto_csum_replace4(check, skb, iph->saddr,
+						 flow->saddr, 1);
+		csum_replace4(&iph->check, iph->saddr, flow->saddr);
+		iph->saddr = flow->saddr;
+	}
+	if (iph->daddr != flow->daddr) {
+		if (check)
+			inet_proto_csum_replace4(check, skb, iph->daddr,
+						 flow->daddr, 1);
+		csum_replace4(&iph->check, iph->daddr, flow->daddr);
+		iph->daddr = flow->daddr;
+	}
+	if (ports[0] != flow->sport) {
+		if (check)
+			inet_proto_csum_replace2(check, skb, ports[0],
+						 flow->sport, 0);
+		ports[0] = flow->sport;
+	}
+	if (ports[1] != flow->dport) {
+		if (check)
+			inet_proto_csum_replace2(check, skb, ports[1],
+						 flow->dport, 0);
+		ports[1] = flow->dport;
+	}
+	if (check && iph->protocol == IPPROTO_UDP && !*check)
+		*check = CSUM_MANGLED_0;
+}
+
+/* ip_finish_output2(), for a route known to be unicast */
+static int fastfwd_output(struct sk_buff *skb, struct dst_entry *dst)
+{
+	if (dst->hh)
+		return neigh_hh_output(dst->hh, skb);
+	return dst->neighbour->output(skb);
+}
+
+static unsigned int fastfwd_in(unsigned int hooknum, struct sk_buff *skb,
+			       const struct net_device *in,
+			       const struct net_device *out,
+			       int (*okfn)(struct sk_buff *))
+{
+	struct fastfwd_flow *flow;
+	struct fastfwd_key key;
+	struct in_device *in_dev;
+	struct dst_entry *dst;
+	const struct iphdr *iph;
+	const struct tcphdr *th;
+	const __be16 *ports;
+	unsigned int thlen;
+
+	if (!fastfwd_enabled || !fastfwd_count ||
+	    skb->pkt_type != PACKET_HOST)
+		return NF_ACCEPT;
+
+	iph = ip_hdr(skb);
+	if (iph->ihl != 5 || (iph->frag_off & htons(IP_MF | IP_OFFSET)) ||
+	    iph->ttl <= 1)
+		return NF_ACCEPT;
+	if (iph->protocol == IPPROTO_TCP)
+		thlen = sizeof(struct tcphdr);
+	else if (iph->protocol == IPPROTO_UDP)
+		thlen = sizeof(struct udphdr);
+	else
+		return NF_ACCEPT;
+	if (!pskb_may_pull(skb, sizeof(*iph) + thlen))
+		return NF_ACCEPT;
+
+	iph = ip_hdr(skb);
+	ports = (const __be16 *)((const void *)iph + sizeof(*iph));
+	if (iph->protocol == IPPROTO_TCP) {
+		th = (const struct tcphdr *)ports;
+		/* for conntrack to see */
+		if (th->syn || th->fin || th->rst)
+			return NF_ACCEPT;
+	}
+
+	key.saddr = iph->saddr;
+	key.daddr = iph->daddr;
+	key.sport = ports[0];
+	key.dport = ports[1];
+	key.proto = iph->protocol;
+	key.iif = in->ifindex;
+
+	rcu_read_lock();
+	/* as ip_route_input() does, for the slow path to refuse it */
+	in_dev = __in_dev_get_rcu(in);
+	if (!in_dev || !IN_DEV_FORWARD(in_dev))
+		goto slow;
+
+	flow = fastfwd_find(&key);
+	if (!flow) {
+		fastfwd_stats.misses++;
+		goto slow;
+	}
+	if (!fastfwd_valid(flow)) {
+		fastfwd_end(flow);
+		goto slow;
+	}
+
+	dst = flow->dst;
+	if (skb->len > dst_mtu(dst) && !skb_is_gso(skb))
+		goto slow;
+	if (skb_cow(skb, LL_RESERVED_SPACE(dst->dev) + dst->header_len))
+		goto slow;
+
+	fastfwd_mangle(skb, flow);
+	ip_decrease_ttl(ip_hdr(skb));
+	skb->priority = rt_tos2priority(ip_hdr(skb)->tos);
+
+	flow->packets++;
+	flow->bytes += skb->len;
+	flow->hits++;
+	flow->last = jiffies;
+	if (time_after(jiffies, flow->synced + HZ))
+		fastfwd_sync(flow);
+	fastfwd_stats.hits++;
+
+	skb_dst_drop(skb);
+	skb_dst_set(skb, dst_clone(dst));
+	skb->dev = dst->dev;
+	skb->protocol = htons(ETH_P_IP);
+	IP_INC_STATS_BH(dev_net(dst->dev), IPSTATS_MIB_OUTFORWDATAGRAMS);
+	rcu_read_unlock();
+
+	fastfwd_output(skb, dst);
+	return NF_STOLEN;
+
+slow:
+	rcu_read_unlock();
+	return NF_ACCEPT;
+}
+
+static unsigned int fastfwd_learn(unsigned int hooknum, struct sk_buff *skb,
+				  const struct net_device *in,
+				  const struct net_device *out,
+				  int (*okfn)(struct sk_buff *))
+{
+	enum ip_conntrack_info ctinfo;
+	struct fastfwd_flow *flow;
+	struct nf_conn_help *help;
+	struct fastfwd_key key;
+	struct dst_entry *dst = skb_dst(skb);
+	struct nf_conntrack_tuple *tuple;
+	const struct iphdr *iph;
+	const __be16 *ports;
+	struct nf_conn *ct;
+	long timeout;
+
+	if (!fastfwd_enabled || !(IPCB(skb)->flags & IPSKB_FORWARDED))
+		return NF_ACCEPT;
+
+	ct = nf_ct_get(skb, &ctinfo);
+	if (!ct || nf_ct_is_untracked(skb) ||
+	    (ctinfo != IP_CT_ESTABLISHED &&
+	     ctinfo != IP_CT_ESTABLISHED + IP_CT_IS_REPLY) ||
+	    !test_bit(IPS_ASSURED_BIT, &ct->status) ||
+	    test_bit(IPS_SEQ_ADJUST_BIT, &ct->status) || skb->mark)
+		return NF_ACCEPT;
+	help = nfct_help(ct);
+	if (help && help->helper)
+		return NF_ACCEPT;
+
+	iph = ip_hdr(skb);
+	if (iph->ihl != 5 || (iph->frag_off & htons(IP_MF | IP_OFFSET)))
+		return NF_ACCEPT;
+	if (iph->protocol == IPPROTO_TCP) {
+		if (ct->proto.tcp.state != TCP_CONNTRACK_ESTABLISHED)
+			return NF_ACCEPT;
+	} else if (iph->protocol != IPPROTO_UDP) {
+		return NF_ACCEPT;
+	}
+	if (!pskb_may_pull(skb, sizeof(*iph) + 2 * sizeof(__be16)))
+		return NF_ACCEPT;
+	iph = ip_hdr(skb);
+	ports = (const __be16 *)((const void *)iph + sizeof(*iph));
+
+	if (!dst || dst->xfrm || (!dst->hh && !dst->neighbour) ||
+	    ((struct rtable *)dst)->rt_type != RTN_UNICAST)
+		return NF_ACCEPT;
+
+	/* what conntrack just set it to, for the state it is in */
+	timeout = (long)(ct->timeout.expires - jiffies);
+	if (!timer_pending(&ct->timeout) || timeout <= 0)
+		return NF_ACCEPT;
+
+	/* the packet as it arrived, before NAT */
+	tuple = &ct->tuplehash[CTINFO2DIR(ctinfo)].tuple;
+	key.saddr = tuple->src.u3.ip;
+	key.daddr = tuple->dst.u3.ip;
+	key.sport = tuple->src.u.all;
+	key.dport = tuple->dst.u.all;
+	key.proto = iph->protocol;
+	key.iif = skb->skb_iif;
+
+	rcu_read_lock();
+	flow = fastfwd_find(&key);
+	rcu_read_unlock();
+	if (flow)
+		return NF_ACCEPT;
+	if (fastfwd_count >= fastfwd_max) {
+		fastfwd_stats.full++;
+		return NF_ACCEPT;
+	}
+
+	flow = kmem_cache_zalloc(fastfwd_cache, GFP_ATOMIC);
+	if (!flow)
+		return NF_ACCEPT;
+	flow->key = key;
+	flow->saddr = iph->saddr;
+	flow->daddr = iph->daddr;
+	flow->sport = ports[0];
+	flow->dport = ports[1];
+	flow->dir = CTINFO2DIR(ctinfo);
+	flow->timeout = timeout;
+	/*
+	 * The packet went through the tables in this softirq, which a
+	 * replace cannot interrupt on UP; on SMP one racing with it is
+	 * missed, until the next replace or the end of the flow.
+	 */
+	flow->genid = atomic_read(&xt_table_genid);
+	flow->last = jiffies;
+	flow->synced = jiffies;
+
+	spin_lock_bh(&fastfwd_lock);
+	if (fastfwd_find(&key) || fastfwd_count >= fastfwd_max) {
+		spin_unlock_bh(&fastfwd_lock);
+		kmem_cache_free(fastfwd_cache, flow);
+		return NF_ACCEPT;
+	}
+	nf_conntrack_get(&ct->ct_general);
+	flow->ct = ct;
+	flow->dst = dst_clone(dst);
+	hlist_add_head_rcu(&flow->link, &fastfwd_hash[fastfwd_hashfn(&key)]);
+	fastfwd_count++;
+	fastfwd_stats.learned++;
+	spin_unlock_bh(&fastfwd_lock);
+
+	/*
+	 * The window tracking of conntrack does not see the packets we
+	 * forward; when the flow is back on the slow path, it must not
+	 * take the first of them for out of window.
+	 */
+	if (iph->protocol == IPPROTO_TCP) {
+		spin_lock_bh(&ct->lock);
+		ct->proto.tcp.seen[0].flags |= IP_CT_TCP_FLAG_BE_LIBERAL;
+		ct->proto.tcp.seen[1].flags |= IP_CT_TCP_FLAG_BE_LIBERAL;
+		spin_unlock_bh(&ct->lock);
+	}
+	return NF_ACCEPT;
+}
+
+static struct nf_hook_ops fastfwd_ops[] __read_mostly = {
+	{
+		.hook		= fastfwd_in,
+		.owner		= THIS_MODULE,
+		.pf		= NFPROTO_IPV4,
+		.hooknum	= NF_INET_PRE_ROUTING,
+		/* ahead of defrag, for the whole slow path to be skipped */
+		.priority	= NF_IP_PRI_CONNTRACK_DEFRAG - 1,
+	},
+	{
+		.hook		= fastfwd_learn,
+		.owner		= THIS_MODULE,
+		.pf		= NFPROTO_IPV4,
+		.hooknum	= NF_INET_POST_ROUTING,
+		/* after SNAT, with the packet as it leaves */
+		.priority	= NF_IP_PRI_CONNTRACK_CONFIRM - 1,
+	},
+};
+
+/* ends the flows that are over or idle, and tells conntrack of the rest */
+static void fastfwd_gc(unsigned long data)
+{
+	struct fastfwd_flow *flow;
+	struct hlist_node *n, *tmp;
+	int i;
+
+	spin_lock(&fastfwd_lock);
+	for (i = 0; i < FASTFWD_HASH_SIZE; i++) {
+		hlist_for_each_entry_safe(flow, n, tmp, &fastfwd_hash[i],
+					  link) {
+			if (!fastfwd_valid(flow) ||
+			    time_after(jiffies, flow->last + FASTFWD_IDLE))
+				__fastfwd_end(flow);
+			else if (flow->packets)
+				fastfwd_sync(flow);
+		}
+	}
+	spin_unlock(&fastfwd_lock);
+
+	mod_timer(&fastfwd_gc_timer, jiffies + FASTFWD_GC);
+}
+
+static int fastfwd_netdev_event(struct notifier_block *nb,
+				unsigned long event, void *ptr)
+{
+	switch (event) {
+	case NETDEV_DOWN:
+	case NETDEV_UNREGISTER:
+	case NETDEV_CHANGEADDR:
+		fastfwd_flush();
+		break;
+	}
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block fastfwd_netdev_notifier = {
+	.notifier_call	= fastfwd_netdev_event,
+};
+
+static int fastfwd_seq_show(struct seq_file *s, void *v)
+{
+	struct fastfwd_flow *flow;
+	struct hlist_node *n;
+	struct net_device *dev;
+	int i;
+
+	seq_printf(s, "flows %u max %u learned %lu hits %lu misses %lu "
+		   "full %lu ended %lu\n", fastfwd_count, fastfwd_max,
+		   fastfwd_stats.learned, fastfwd_stats.hits,
+		   fastfwd_stats.misses, fastfwd_stats.full,
+		   fastfwd_stats.ended);
+
+	rcu_read_lock();
+	for (i = 0; i < FASTFWD_HASH_SIZE; i++) {
+		hlist_for_each_entry_rcu(flow, n, &fastfwd_hash[i], link) {
+			dev = flow->dst->dev;
+			seq_printf(s, "%s %pI4:%u > %pI4:%u iif %d "
+				   "as %pI4:%u > %pI4:%u on %s hits %llu\n",
+				   flow->key.proto == IPPROTO_TCP ?
+				   "tcp" : "udp",
+				   &flow->key.saddr, ntohs(flow->key.sport),
+				   &flow->key.daddr, ntohs(flow->key.dport),
+				   flow->key.iif,
+				   &flow->saddr, ntohs(flow->sport),
+				   &flow->daddr, ntohs(flow->dport),
+				   dev->name, (unsigned long long)flow->hits);
+		}
+	}
+	rcu_read_unlock();
+	return 0;
+}
+
+static int fastfwd_seq_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, fastfwd_seq_show, NULL);
+}
+
+/* any write flushes the cache */
+static ssize_t fastfwd_write(struct file *file, const char __user *buf,
+			     size_t count, loff_t *ppos)
+{
+	if (!capable(CAP_NET_ADMIN))
+		return -EPERM;
+	fastfwd_flush();
+	return count;
+}
+
+static const struct file_operations fastfwd_fops = {
+	.owner		= THIS_MODULE,
+	.open		= fastfwd_seq_open,
+	.read		= seq_read,
+	.write		= fastfwd_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init fastfwd_init(void)
+{
+	int ret;
+
+	get_random_bytes(&fastfwd_rnd, sizeof(fastfwd_rnd));
+
+	fastfwd_cache = kmem_cache_create("nf_fastfwd",
+					  sizeof(struct fastfwd_flow), 0, 0,
+					  NULL);
+	if (!fastfwd_cache)
+		return -ENOMEM;
+
+	if (!proc_create("nf_fastfwd", S_IRUGO | S_IWUSR, init_net.proc_net,
+			 &fastfwd_fops)) {
+		ret = -ENOMEM;
+		goto err_cache;
+	}
+
+	ret = register_netdevice_notifier(&fastfwd_netdev_notifier);
+	if (ret < 0)
+		goto err_proc;
+
+	/* a phone sleeps through the collection of a quiet cache */
+	init_timer_deferrable(&fastfwd_gc_timer);
+	fastfwd_gc_timer.function = fastfwd_gc;
+	mod_timer(&fastfwd_gc_timer, jiffies + FASTFWD_GC);
+
+	ret = nf_register_hooks(fastfwd_ops, ARRAY_SIZE(fastfwd_ops));
+	if (ret < 0)
+		goto err_timer;
+	return 0;
+
+err_timer:
+	del_timer_sync(&fastfwd_gc_timer);
+	unregister_netdevice_notifier(&fastfwd_netdev_notifier);
+err_proc:
+	remove_proc_entry("nf_fastfwd", init_net.proc_net);
+err_cache:
+	kmem_cache_destroy(fastfwd_cache);
+	return ret;
+}
+
+static void __exit fastfwd_exit(void)
+{
+	nf_unregister_hooks(fastfwd_ops, ARRAY_SIZE(fastfwd_ops));
+	del_timer_sync(&fastfwd_gc_timer);
+	unregister_netdevice_notifier(&fastfwd_netdev_notifier);
+	remove_proc_entry("nf_fastfwd", init_net.proc_net);
+	fastfwd_flush();
+	rcu_barrier();
+	kmem_cache_destroy(fastfwd_cache);
+}
+
+module_init(fastfwd_init);
+module_exit(fastfwd_exit);
+
+MODULE_DESCRIPTION("Fast path for established forwarded IPv4 flows");
+MODULE_LICENSE("GPL");
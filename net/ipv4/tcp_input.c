@@ -66,6 +66,7 @@
 #include <linux/module.h>
 #include <linux/sysctl.h>
 #include <linux/kernel.h>
+#include <linux/inetdevice.h>
 #include <net/dst.h>
 #include <net/tcp.h>
 #include <net/inet_common.h>
@@ -246,6 +247,39 @@ static inline int TCP_ECN_rcv_ecn_echo(struct tcp_sock *tp, struct tcphdr *th)
 	return 0;
 }
 
+/* The most the buffers of the socket are autotuned to: the global tcp_rmem
+ * and tcp_wmem maximum, or the tcp_rmem_max and tcp_wmem_max of the
+ * interface the socket is routed through, if set and lower.  A slow link
+ * whose bandwidth-delay product is known needs no more than its own.
+ */
+static int tcp_buf_max(const struct sock *sk, int attr, int max)
+{
+	struct dst_entry *dst;
+	struct in_device *in_dev;
+	int v = 0;
+
+	rcu_read_lock();
+	dst = __sk_dst_get((struct sock *)sk);
+	if (dst && dst->dev) {
+		in_dev = __in_dev_get_rcu(dst->dev);
+		if (in_dev)
+			v = ipv4_devconf_get(in_dev, attr);
+	}
+	rcu_read_unlock();
+
+	return v > 0 ? min(v, max) : max;
+}
+
+static inline int tcp_rmem_max(const struct sock *sk)
+{
+	return tcp_buf_max(sk, IPV4_DEVCONF_TCP_RMEM_MAX, sysctl_tcp_rmem[2]);
+}
+
+static inline int tcp_wmem_max(const struct sock *sk)
+{
+	return tcp_buf_max(sk, IPV4_DEVCONF_TCP_WMEM_MAX, sysctl_tcp_wmem[2]);
+}
+
 /* Buffer size and advertised window tuning.
  *
  * 1. Tuning sk->sk_sndbuf, when connection enters established state.
@@ -257,7 +291,7 @@ static void tcp_fixup_sndbuf(struct sock *sk)
 		     sizeof(struct sk_buff);
 
 	if (sk->sk_sndbuf < 3 * sndmem)
-		sk->sk_sndbuf = min(3 * sndmem, sysctl_tcp_wmem[2]);
+		sk->sk_sndbuf = min(3 * sndmem, tcp_wmem_max(sk));
 }
 
 /* 2. Tuning advertised window (window_clamp, rcv_ssthresh)
@@ -343,7 +377,7 @@ static void tcp_fixup_rcvbuf(struct sock *sk)
 	while (tcp_win_from_space(rcvmem) < tp->advmss)
 		rcvmem += 128;
 	if (sk->sk_rcvbuf < 4 * rcvmem)
-		sk->sk_rcvbuf = min(4 * rcvmem, sysctl_tcp_rmem[2]);
+		sk->sk_rcvbuf = min(4 * rcvmem, tcp_rmem_max(sk));
 }
 
 /* 4. Try to fixup all. It is made immediately after connection enters
@@ -387,15 +421,16 @@ static void tcp_clamp_window(struct sock *sk)
 {
 	struct tcp_sock *tp = tcp_sk(sk);
 	struct inet_connection_sock *icsk = inet_csk(sk);
+	int rmem_max = tcp_rmem_max(sk);
 
 	icsk->icsk_ack.quick = 0;
 
-	if (sk->sk_rcvbuf < sysctl_tcp_rmem[2] &&
+	if (sk->sk_rcvbuf < rmem_max &&
 	    !(sk->sk_userlocks & SOCK_RCVBUF_LOCK) &&
 	    !tcp_memory_pressure &&
 	    atomic_read(&tcp_memory_allocated) < sysctl_tcp_mem[0]) {
 		sk->sk_rcvbuf = min(atomic_read(&sk->sk_rmem_alloc),
-				    sysctl_tcp_rmem[2]);
+				    rmem_max);
 	}
 	if (atomic_read(&sk->sk_rmem_alloc) > sk->sk_rcvbuf)
 		tp->rcv_ssthresh = min(tp->window_clamp, 2U * tp->advmss);
@@ -529,7 +564,7 @@ void tcp_rcv_space_adjust(struct sock *sk)
 			while (tcp_win_from_space(rcvmem) < tp->advmss)
 				rcvmem += 128;
 			space *= rcvmem;
-			space = min(space, sysctl_tcp_rmem[2]);
+			space = min(space, tcp_rmem_max(sk));
 			if (space > sk->sk_rcvbuf) {
 				sk->sk_rcvbuf = space;
 
@@ -4887,7 +4922,7 @@ static void tcp_new_space(struct sock *sk)
 				     tp->reordering + 1);
 		sndmem *= 2 * demanded;
 		if (sndmem > sk->sk_sndbuf)
-			sk->sk_sndbuf = min(sndmem, sysctl_tcp_wmem[2]);
+			sk->sk_sndbuf = min(sndmem, tcp_wmem_max(sk));
 		tp->snd_cwnd_stamp = tcp_time_stamp;
 	}
 
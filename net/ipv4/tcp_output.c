@@ -63,6 +63,11 @@ int sysctl_tcp_slow_start_after_idle __read_mostly = 1;
 int sysctl_tcp_cookie_size __read_mostly = 0; /* TCP_COOKIE_MAX */
 EXPORT_SYMBOL_GPL(sysctl_tcp_cookie_size);
 
+/* Most a socket may have in the qdisc and the device at once, 0 for no
+ * limit.  Lowered per socket to what its rate needs, see tcp_tsq_limit().
+ */
+int sysctl_tcp_limit_output_bytes __read_mostly = 131072;
+
 
 /* Account for new data that has been sent to the network. */
 static void tcp_event_new_data_sent(struct sock *sk, struct sk_buff *skb)
@@ -832,7 +837,13 @@ static int tcp_transmit_skb(struct sock *sk, struct sk_buff *skb, int clone_it,
 
 	skb_push(skb, tcp_header_size);
 	skb_reset_transport_header(skb);
-	skb_set_owner_w(skb, sk);
+
+	/* skb_set_owner_w(), with the small queue destructor */
+	skb_orphan(skb);
+	skb->sk = sk;
+	skb->destructor = sysctl_tcp_limit_output_bytes > 0 ?
+			  tcp_wfree : sock_wfree;
+	atomic_add(skb->truesize, &sk->sk_wmem_alloc);
 
 	/* Build TCP header and checksum it. */
 	th = tcp_hdr(skb);
@@ -1708,6 +1719,30 @@ static int tcp_mtu_probe(struct sock *sk)
 	return -1;
 }
 
+/* Whether the socket is at its small queue limit, sending @skb next:
+ * sysctl_tcp_limit_output_bytes, or about 1ms of data at twice the rate
+ * of the connection, cwnd per srtt, if that is less, so that a slow link
+ * is not queued up below us; but never less than two skbs, or it could
+ * not keep the device busy at all.
+ */
+static int tcp_tsq_full(const struct sock *sk, const struct sk_buff *skb)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+	unsigned int queued = atomic_read(&sk->sk_wmem_alloc);
+	unsigned int limit = sysctl_tcp_limit_output_bytes;
+
+	if (queued < 2 * skb->truesize)
+		return 0;
+	if (queued < limit && tp->srtt) {
+		/* srtt is in jiffies << 3 */
+		u64 rate = (u64)tp->snd_cwnd * tp->mss_cache * (HZ << 3) * 2;
+
+		do_div(rate, tp->srtt);
+		limit = min_t(u64, limit, rate >> 10);
+	}
+	return queued >= limit;
+}
+
 /* This routine writes packets to the network.  It advances the
  * send_head.  This happens as incoming acks open up the remote
  * window for us.
@@ -1763,6 +1798,16 @@ static int tcp_write_xmit(struct sock *sk, unsigned int mss_now, int nonagle,
 				break;
 		}
 
+		/* Small queues: sk_wmem_alloc counts what was sent and is
+		 * still in the qdisc or the device, truesize and all.  Over
+		 * the limit we wait for tcp_wfree() to call us again.
+		 */
+		if (sysctl_tcp_limit_output_bytes > 0 &&
+		    tcp_tsq_full(sk, skb)) {
+			set_bit(TSQ_THROTTLED, &tp->tsq_flags);
+			break;
+		}
+
 		limit = mss_now;
 		if (tso_segs > 1 && !tcp_urg_mode(tp))
 			limit = tcp_mss_split_point(sk, skb, mss_now,
@@ -1796,6 +1841,111 @@ static int tcp_write_xmit(struct sock *sk, unsigned int mss_now, int nonagle,
 	return !tp->packets_out && tcp_send_head(sk);
 }
 
+/* Each cpu has a list of the sockets whose throttled packets were freed,
+ * and a tasklet that sends more for them: tcp_wfree() runs wherever the
+ * device frees the skb, often in hard irq, and may not send from there.
+ */
+struct tsq_tasklet {
+	struct tasklet_struct	tasklet;
+	struct list_head	head;
+};
+static DEFINE_PER_CPU(struct tsq_tasklet, tsq_tasklet);
+
+static void tcp_tsq_handler(struct sock *sk)
+{
+	if ((1 << sk->sk_state) &
+	    (TCPF_ESTABLISHED | TCPF_FIN_WAIT1 | TCPF_CLOSING |
+	     TCPF_CLOSE_WAIT | TCPF_LAST_ACK))
+		tcp_write_xmit(sk, tcp_current_mss(sk), tcp_sk(sk)->nonagle,
+			       0, GFP_ATOMIC);
+}
+
+static void tcp_tasklet_func(unsigned long data)
+{
+	struct tsq_tasklet *tsq = (struct tsq_tasklet *)data;
+	LIST_HEAD(list);
+	unsigned long flags;
+	struct list_head *q, *n;
+	struct tcp_sock *tp;
+	struct sock *sk;
+
+	local_irq_save(flags);
+	list_splice_init(&tsq->head, &list);
+	local_irq_restore(flags);
+
+	list_for_each_safe(q, n, &list) {
+		tp = list_entry(q, struct tcp_sock, tsq_node);
+		list_del(&tp->tsq_node);
+
+		sk = (struct sock *)tp;
+		bh_lock_sock(sk);
+
+		if (!sock_owned_by_user(sk))
+			tcp_tsq_handler(sk);
+		else
+			/* the owner sends from tcp_release_cb() */
+			set_bit(TCP_TSQ_DEFERRED, &tp->tsq_flags);
+		bh_unlock_sock(sk);
+
+		clear_bit(TSQ_QUEUED, &tp->tsq_flags);
+		/* the reference tcp_wfree() kept */
+		sk_free(sk);
+	}
+}
+
+/**
+ * tcp_release_cb - sends what the tasklet could not while user owned it
+ * @sk: socket
+ *
+ * Called from release_sock(), with the socket spinlock held.
+ */
+void tcp_release_cb(struct sock *sk)
+{
+	if (test_and_clear_bit(TCP_TSQ_DEFERRED, &tcp_sk(sk)->tsq_flags))
+		tcp_tsq_handler(sk);
+}
+EXPORT_SYMBOL(tcp_release_cb);
+
+void __init tcp_tasklet_init(void)
+{
+	int i;
+
+	for_each_possible_cpu(i) {
+		struct tsq_tasklet *tsq = &per_cpu(tsq_tasklet, i);
+
+		INIT_LIST_HEAD(&tsq->head);
+		tasklet_init(&tsq->tasklet, tcp_tasklet_func,
+			     (unsigned long)tsq);
+	}
+}
+
+/*
+ * Destructor of the skbs TCP sends.  If the socket was throttled, the
+ * freed bytes let it send again: it goes on the tasklet list, keeping a
+ * byte of sk_wmem_alloc as its reference until the tasklet is done.
+ */
+void tcp_wfree(struct sk_buff *skb)
+{
+	struct sock *sk = skb->sk;
+	struct tcp_sock *tp = tcp_sk(sk);
+
+	if (test_and_clear_bit(TSQ_THROTTLED, &tp->tsq_flags) &&
+	    !test_and_set_bit(TSQ_QUEUED, &tp->tsq_flags)) {
+		unsigned long flags;
+		struct tsq_tasklet *tsq;
+
+		atomic_sub(skb->truesize - 1, &sk->sk_wmem_alloc);
+
+		local_irq_save(flags);
+		tsq = &__get_cpu_var(tsq_tasklet);
+		list_add(&tp->tsq_node, &tsq->head);
+		tasklet_schedule(&tsq->tasklet);
+		local_irq_restore(flags);
+	} else {
+		sock_wfree(skb);
+	}
+}
+
 /* Push out any pending frames which were held back due to
  * TCP_CORK or attempt at coalescing tiny packets.
  * The socket must be locked by the caller.
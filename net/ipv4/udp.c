@@ -105,6 +105,7 @@
 #include <net/route.h>
 #include <net/checksum.h>
 #include <net/xfrm.h>
+#include <linux/uid_stat.h>
 #include "udp_impl.h"
 
 struct udp_table udp_table __read_mostly;
@@ -956,6 +957,9 @@ do_append_data:
 		err = udp_push_pending_frames(sk);
 	else if (unlikely(skb_queue_empty(&sk->sk_write_queue)))
 		up->pending = 0;
+	if (!err)
+		uid_stat_udp_snd(current_uid(), rt ? rt->u.dst.dev : NULL,
+				 len);
 	release_sock(sk);
 
 out:
@@ -1192,6 +1196,9 @@ try_again:
 	err = len;
 	if (flags & MSG_TRUNC)
 		err = ulen;
+	if (!(flags & MSG_PEEK))
+		uid_stat_udp_rcv(current_uid(), sock_net(sk), skb->skb_iif,
+				 len);
 
 out_free:
 	skb_free_datagram_locked(sk, skb);
@@ -45,6 +45,7 @@
 #include <net/tcp_states.h>
 #include <net/ip6_checksum.h>
 #include <net/xfrm.h>
+#include <linux/uid_stat.h>
 
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
@@ -320,6 +321,15 @@ static struct sock *__udp6_lib_lookup_skb(struct sk_buff *skb,
 				 udptable);
 }
 
+struct sock *udp6_lib_lookup(struct net *net, struct in6_addr *saddr,
+			     __be16 sport, struct in6_addr *daddr,
+			     __be16 dport, int dif)
+{
+	return __udp6_lib_lookup(net, saddr, sport, daddr, dport, dif,
+				 &udp_table);
+}
+EXPORT_SYMBOL_GPL(udp6_lib_lookup);
+
 /*
  * 	This should be easy, if there is something there we
  * 	return it, otherwise we block.
@@ -427,6 +437,9 @@ try_again:
 	err = len;
 	if (flags & MSG_TRUNC)
 		err = ulen;
+	if (!(flags & MSG_PEEK))
+		uid_stat_udp_rcv(current_uid(), sock_net(sk), skb->skb_iif,
+				 len);
 
 out_free:
 	skb_free_datagram_locked(sk, skb);
@@ -1181,6 +1194,8 @@ do_append_data:
 		err = udp_v6_push_pending_frames(sk);
 	else if (unlikely(skb_queue_empty(&sk->sk_write_queue)))
 		up->pending = 0;
+	if (!err)
+		uid_stat_udp_snd(current_uid(), dst ? dst->dev : NULL, len);
 
 	if (dst) {
 		if (connected) {
@@ -785,6 +785,10 @@ static int xt_jumpstack_alloc(struct xt_table_info *i)
 	return 0;
 }
 
+/* Bumped whenever the rules of a table are replaced, for caches of verdicts */
+atomic_t xt_table_genid = ATOMIC_INIT(0);
+EXPORT_SYMBOL_GPL(xt_table_genid);
+
 struct xt_table_info *
 xt_replace_table(struct xt_table *table,
 	      unsigned int num_counters,
@@ -815,6 +819,7 @@ xt_replace_table(struct xt_table *table,
 
 	table->private = newinfo;
 	newinfo->initial_entries = private->initial_entries;
+	atomic_inc(&xt_table_genid);
 
 	/*
 	 * Even though table entries have now been swapped, other CPU's
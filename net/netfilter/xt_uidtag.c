@@ -0,0 +1,624 @@
+/*
+ * Kernel module to match packets on the uid and tag of their socket, and
+ * to count traffic per interface, uid and tag.
+ *
+ * Copyright (c) 2010 by Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+#include <linux/module.h>
+#include <linux/capability.h>
+#include <linux/file.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+#include <linux/jhash.h>
+#include <linux/netdevice.h>
+#include <linux/percpu.h>
+#include <linux/proc_fs.h>
+#include <linux/rculist.h>
+#include <linux/seq_file.h>
+#include <linux/skbuff.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/udp.h>
+#include <linux/uaccess.h>
+#include <net/inet_hashtables.h>
+#include <net/inet6_hashtables.h>
+#include <net/ipv6.h>
+#include <net/net_namespace.h>
+#include <net/sock.h>
+#include <net/tcp.h>
+#include <net/udp.h>
+#include <linux/netfilter/x_tables.h>
+#include <linux/netfilter/xt_uidtag.h>
+
+/*
+ * Counts are kept per cpu, each cpu in a hash table of its own that only
+ * it adds to, so that accounting a packet touches no shared cache line
+ * and takes no shared lock.  The lock of a table is taken by its own cpu,
+ * and by a reset; readers walk the tables under RCU and fold the entries
+ * of the different cpus for a key together.
+ */
+#define UIDTAG_HASH_BITS	8
+#define UIDTAG_HASH_SIZE	(1 << UIDTAG_HASH_BITS)
+#define UIDTAG_MAX_ENTRIES	2048
+
+/* the uid traffic without a socket, or of a closed one, is counted under */
+#define UIDTAG_NO_UID		((uid_t)-1)
+
+enum {
+	UIDTAG_RX,
+	UIDTAG_TX,
+	UIDTAG_NR_DIRS
+};
+
+struct uidtag_key {
+	int ifindex;
+	uid_t uid;
+	u32 tag;
+};
+
+struct uidtag_entry {
+	struct hlist_node link;
+	struct rcu_head rcu;
+	struct uidtag_key key;
+	char ifname[IFNAMSIZ];
+	/* only written by the cpu of the table, a reader may see them torn */
+	u64 bytes[UIDTAG_NR_DIRS];
+	u64 packets[UIDTAG_NR_DIRS];
+};
+
+struct uidtag_table {
+	spinlock_t lock;
+	unsigned int entries;
+	unsigned long overflows;
+	struct hlist_head hash[UIDTAG_HASH_SIZE];
+};
+
+static DEFINE_PER_CPU(struct uidtag_table, uidtag_tables);
+static struct proc_dir_entry *uidtag_dir;
+
+static int uidtag_enabled = 1;
+module_param_named(enable, uidtag_enabled, bool, 0644);
+MODULE_PARM_DESC(enable, "count packets of --account rules");
+
+static inline bool uidtag_key_equal(const struct uidtag_key *a,
+				    const struct uidtag_key *b)
+{
+	return a->ifindex == b->ifindex && a->uid == b->uid &&
+	       a->tag == b->tag;
+}
+
+static inline unsigned int uidtag_hash(const struct uidtag_key *key)
+{
+	return jhash_3words(key->ifindex, key->uid, key->tag, 0) &
+	       (UIDTAG_HASH_SIZE - 1);
+}
+
+static struct uidtag_entry *uidtag_find(struct uidtag_table *t,
+					const struct uidtag_key *key)
+{
+	struct uidtag_entry *e;
+	struct hlist_node *pos;
+
+	hlist_for_each_entry_rcu(e, pos, &t->hash[uidtag_hash(key)], link)
+		if (uidtag_key_equal(&e->key, key))
+			return e;
+	return NULL;
+}
+
+static void uidtag_account(const struct net_device *dev, uid_t uid, u32 tag,
+			   int dir, const struct sk_buff *skb)
+{
+	struct uidtag_key key = {
+		.ifindex = dev ? dev->ifindex : 0,
+		.uid = uid,
+		.tag = tag,
+	};
+	struct uidtag_table *t;
+	struct uidtag_entry *e;
+
+	/* locally generated packets may get here with bottom halves on */
+	local_bh_disable();
+	t = &__get_cpu_var(uidtag_tables);
+	spin_lock(&t->lock);
+
+	e = uidtag_find(t, &key);
+	if (unlikely(!e)) {
+		if (t->entries >= UIDTAG_MAX_ENTRIES ||
+		    !(e = kzalloc(sizeof(*e), GFP_ATOMIC))) {
+			t->overflows++;
+			goto out;
+		}
+		e->key = key;
+		strlcpy(e->ifname, dev ? dev->name : "-", IFNAMSIZ);
+		hlist_add_head_rcu(&e->link, &t->hash[uidtag_hash(&key)]);
+		t->entries++;
+	}
+	e->bytes[dir] += skb->len;
+	e->packets[dir] += skb_is_gso(skb) ? skb_shinfo(skb)->gso_segs : 1;
+out:
+	spin_unlock(&t->lock);
+	local_bh_enable();
+}
+
+static void uidtag_free_rcu(struct rcu_head *head)
+{
+	kfree(container_of(head, struct uidtag_entry, rcu));
+}
+
+static void uidtag_reset(void)
+{
+	struct uidtag_table *t;
+	struct uidtag_entry *e;
+	struct hlist_node *pos, *n;
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		t = &per_cpu(uidtag_tables, cpu);
+		spin_lock_bh(&t->lock);
+		for (i = 0; i < UIDTAG_HASH_SIZE; i++)
+			hlist_for_each_entry_safe(e, pos, n, &t->hash[i], link) {
+				hlist_del_rcu(&e->link);
+				call_rcu(&e->rcu, uidtag_free_rcu);
+			}
+		t->entries = 0;
+		t->overflows = 0;
+		spin_unlock_bh(&t->lock);
+	}
+}
+
+/*
+ * Incoming packets are not yet tied to a socket where netfilter sees
+ * them, so look up the TCP or UDP socket they are for.  Non-first
+ * fragments and other protocols stay without one.
+ */
+static struct sock *uidtag_lookup_v4(const struct sk_buff *skb,
+				     const struct net_device *in)
+{
+	const struct iphdr *iph = ip_hdr(skb);
+	struct udphdr _hdr, *hp;
+
+	if (iph->protocol != IPPROTO_TCP && iph->protocol != IPPROTO_UDP)
+		return NULL;
+	if (iph->frag_off & htons(IP_OFFSET))
+		return NULL;
+	/* the ports are in the same place in the TCP header */
+	hp = skb_header_pointer(skb, ip_hdrlen(skb), sizeof(_hdr), &_hdr);
+	if (hp == NULL)
+		return NULL;
+
+	if (iph->protocol == IPPROTO_TCP)
+		return inet_lookup(dev_net(in), &tcp_hashinfo,
+				   iph->saddr, hp->source,
+				   iph->daddr, hp->dest, in->ifindex);
+	return udp4_lib_lookup(dev_net(in), iph->saddr, hp->source,
+			       iph->daddr, hp->dest, in->ifindex);
+}
+
+#if defined(CONFIG_IPV6) || defined(CONFIG_IPV6_MODULE)
+static struct sock *uidtag_lookup_v6(const struct sk_buff *skb,
+				     const struct net_device *in)
+{
+	struct ipv6hdr *ip6h = ipv6_hdr(skb);
+	u8 nexthdr = ip6h->nexthdr;
+	struct udphdr _hdr, *hp;
+	int thoff;
+
+	thoff = ipv6_skip_exthdr(skb, sizeof(*ip6h), &nexthdr);
+	if (thoff < 0 || (nexthdr != IPPROTO_TCP && nexthdr != IPPROTO_UDP))
+		return NULL;
+	hp = skb_header_pointer(skb, thoff, sizeof(_hdr), &_hdr);
+	if (hp == NULL)
+		return NULL;
+
+	if (nexthdr == IPPROTO_TCP)
+		return inet6_lookup(dev_net(in), &tcp_hashinfo,
+				    &ip6h->saddr, hp->source,
+				    &ip6h->daddr, hp->dest, in->ifindex);
+	return udp6_lib_lookup(dev_net(in), &ip6h->saddr, hp->source,
+			       &ip6h->daddr, hp->dest, in->ifindex);
+}
+#endif
+
+static void uidtag_put(struct sock *sk)
+{
+	if (sk->sk_state == TCP_TIME_WAIT)
+		inet_twsk_put(inet_twsk(sk));
+	else
+		sock_put(sk);
+}
+
+/* the uid and tag of an open socket */
+static bool uidtag_owner(struct sock *sk, uid_t *uid, u32 *tag)
+{
+	bool owned = false;
+
+	if (sk->sk_state == TCP_TIME_WAIT)
+		return false;
+
+	read_lock_bh(&sk->sk_callback_lock);
+	if (sk->sk_socket && sk->sk_socket->file) {
+		*uid = sk->sk_socket->file->f_cred->fsuid;
+		*tag = sk->sk_tag;
+		owned = true;
+	}
+	read_unlock_bh(&sk->sk_callback_lock);
+	return owned;
+}
+
+static bool uidtag_match(const struct xt_uidtag_match_info *info,
+			 bool owned, uid_t uid, u32 tag)
+{
+	if (!owned)
+		return ((info->match ^ info->invert) &
+			(XT_UIDTAG_UID | XT_UIDTAG_TAG | XT_UIDTAG_SOCKET)) == 0;
+	else if (info->match & info->invert & XT_UIDTAG_SOCKET)
+		return false;
+
+	if (info->match & XT_UIDTAG_UID)
+		if ((uid >= info->uid_min && uid <= info->uid_max) ^
+		    !(info->invert & XT_UIDTAG_UID))
+			return false;
+
+	if (info->match & XT_UIDTAG_TAG)
+		if ((tag == info->tag) ^ !(info->invert & XT_UIDTAG_TAG))
+			return false;
+
+	return true;
+}
+
+static bool
+uidtag_mt(const struct sk_buff *skb, struct xt_action_param *par)
+{
+	const struct xt_uidtag_match_info *info = par->matchinfo;
+	bool account = (info->match & XT_UIDTAG_ACCOUNT) && uidtag_enabled;
+	bool rx = par->hooknum == NF_INET_PRE_ROUTING ||
+		  par->hooknum == NF_INET_LOCAL_IN;
+	uid_t uid = UIDTAG_NO_UID;
+	bool owned = false;
+	struct sock *sk;
+	u32 tag = 0;
+
+	if (!account && !(info->match & ~XT_UIDTAG_ACCOUNT))
+		return true;
+
+	if (rx) {
+		sk = NULL;
+		if (par->family == NFPROTO_IPV4)
+			sk = uidtag_lookup_v4(skb, par->in);
+#if defined(CONFIG_IPV6) || defined(CONFIG_IPV6_MODULE)
+		else
+			sk = uidtag_lookup_v6(skb, par->in);
+#endif
+		if (sk) {
+			owned = uidtag_owner(sk, &uid, &tag);
+			uidtag_put(sk);
+		}
+	} else if (skb->sk) {
+		owned = uidtag_owner(skb->sk, &uid, &tag);
+	}
+	if (!owned) {
+		uid = UIDTAG_NO_UID;
+		tag = 0;
+	}
+
+	if (account)
+		uidtag_account(rx ? par->in : par->out, uid, tag,
+			       rx ? UIDTAG_RX : UIDTAG_TX, skb);
+
+	return uidtag_match(info, owned, uid, tag);
+}
+
+static int uidtag_mt_check(const struct xt_mtchk_param *par)
+{
+	const struct xt_uidtag_match_info *info = par->matchinfo;
+
+	if (info->match & ~(XT_UIDTAG_UID | XT_UIDTAG_TAG |
+			    XT_UIDTAG_SOCKET | XT_UIDTAG_ACCOUNT))
+		return -EINVAL;
+	if (info->invert & XT_UIDTAG_ACCOUNT)
+		return -EINVAL;
+	return 0;
+}
+
+static struct xt_match uidtag_mt_reg[] __read_mostly = {
+	{
+		.name       = "uidtag",
+		.family     = NFPROTO_IPV4,
+		.checkentry = uidtag_mt_check,
+		.match      = uidtag_mt,
+		.matchsize  = sizeof(struct xt_uidtag_match_info),
+		.hooks      = (1 << NF_INET_PRE_ROUTING) |
+		              (1 << NF_INET_LOCAL_IN) |
+		              (1 << NF_INET_LOCAL_OUT) |
+		              (1 << NF_INET_POST_ROUTING),
+		.me         = THIS_MODULE,
+	},
+#if defined(CONFIG_IPV6) || defined(CONFIG_IPV6_MODULE)
+	{
+		.name       = "uidtag",
+		.family     = NFPROTO_IPV6,
+		.checkentry = uidtag_mt_check,
+		.match      = uidtag_mt,
+		.matchsize  = sizeof(struct xt_uidtag_match_info),
+		.hooks      = (1 << NF_INET_PRE_ROUTING) |
+		              (1 << NF_INET_LOCAL_IN) |
+		              (1 << NF_INET_LOCAL_OUT) |
+		              (1 << NF_INET_POST_ROUTING),
+		.me         = THIS_MODULE,
+	},
+#endif
+};
+
+/*
+ * /proc/net/xt_uidtag/stats has a line per interface, uid and tag.  The
+ * iterator walks the tables of all cpus and shows an entry at the first
+ * cpu that has its key, with the counts of all cpus summed.
+ */
+struct uidtag_iter {
+	int cpu;
+	int bucket;
+};
+
+static bool uidtag_first(const struct uidtag_entry *e, int cpu)
+{
+	int c;
+
+	for_each_possible_cpu(c) {
+		if (c >= cpu)
+			break;
+		if (uidtag_find(&per_cpu(uidtag_tables, c), &e->key))
+			return false;
+	}
+	return true;
+}
+
+static struct uidtag_entry *uidtag_get_next(struct uidtag_iter *it,
+					    struct hlist_node *node)
+{
+	struct uidtag_entry *e;
+
+	for (;;) {
+		for (; node; node = rcu_dereference(node->next)) {
+			e = hlist_entry(node, struct uidtag_entry, link);
+			if (uidtag_first(e, it->cpu))
+				return e;
+		}
+		if (++it->bucket == UIDTAG_HASH_SIZE) {
+			it->bucket = 0;
+			it->cpu = cpumask_next(it->cpu, cpu_possible_mask);
+			if (it->cpu >= nr_cpu_ids)
+				return NULL;
+		}
+		node = rcu_dereference(
+			per_cpu(uidtag_tables, it->cpu).hash[it->bucket].first);
+	}
+}
+
+static struct uidtag_entry *uidtag_get_first(struct uidtag_iter *it)
+{
+	it->cpu = cpumask_first(cpu_possible_mask);
+	it->bucket = 0;
+	return uidtag_get_next(it, rcu_dereference(
+			per_cpu(uidtag_tables, it->cpu).hash[0].first));
+}
+
+static void *uidtag_seq_start(struct seq_file *s, loff_t *pos)
+	__acquires(RCU)
+{
+	struct uidtag_entry *e;
+	loff_t n = *pos;
+
+	rcu_read_lock();
+	if (n == 0)
+		return SEQ_START_TOKEN;
+
+	e = uidtag_get_first(s->private);
+	while (e && --n)
+		e = uidtag_get_next(s->private,
+				    rcu_dereference(e->link.next));
+	return e;
+}
+
+static void *uidtag_seq_next(struct seq_file *s, void *v, loff_t *pos)
+{
+	struct uidtag_entry *e = v;
+
+	++*pos;
+	if (v == SEQ_START_TOKEN)
+		return uidtag_get_first(s->private);
+	return uidtag_get_next(s->private, rcu_dereference(e->link.next));
+}
+
+static void uidtag_seq_stop(struct seq_file *s, void *v)
+	__releases(RCU)
+{
+	rcu_read_unlock();
+}
+
+static int uidtag_seq_show(struct seq_file *s, void *v)
+{
+	const struct uidtag_entry *e = v, *o;
+	u64 bytes[UIDTAG_NR_DIRS] = { 0 }, packets[UIDTAG_NR_DIRS] = { 0 };
+	int cpu, dir;
+
+	if (v == SEQ_START_TOKEN) {
+		seq_puts(s, "iface uid tag rx_bytes rx_packets "
+			    "tx_bytes tx_packets\n");
+		return 0;
+	}
+
+	for_each_possible_cpu(cpu) {
+		o = uidtag_find(&per_cpu(uidtag_tables, cpu), &e->key);
+		if (!o)
+			continue;
+		for (dir = 0; dir < UIDTAG_NR_DIRS; dir++) {
+			bytes[dir] += o->bytes[dir];
+			packets[dir] += o->packets[dir];
+		}
+	}
+	seq_printf(s, "%s %d 0x%x %llu %llu %llu %llu\n",
+		   e->ifname, (int)e->key.uid, e->key.tag,
+		   bytes[UIDTAG_RX], packets[UIDTAG_RX],
+		   bytes[UIDTAG_TX], packets[UIDTAG_TX]);
+	return 0;
+}
+
+static const struct seq_operations uidtag_seq_ops = {
+	.start = uidtag_seq_start,
+	.next  = uidtag_seq_next,
+	.stop  = uidtag_seq_stop,
+	.show  = uidtag_seq_show,
+};
+
+static int uidtag_stats_open(struct inode *inode, struct file *file)
+{
+	return seq_open_private(file, &uidtag_seq_ops,
+				sizeof(struct uidtag_iter));
+}
+
+static const struct file_operations uidtag_stats_fops = {
+	.owner   = THIS_MODULE,
+	.open    = uidtag_stats_open,
+	.read    = seq_read,
+	.llseek  = seq_lseek,
+	.release = seq_release_private,
+};
+
+/*
+ * /proc/net/xt_uidtag/ctrl tags the sockets of the writer:
+ *
+ *	t <fd> <tag>	tag the socket open as fd, 0 clears the tag
+ *	r		drop all counts, with CAP_NET_ADMIN
+ *
+ * and reads back the number of entries and of packets that found the
+ * tables full.
+ */
+static int uidtag_ctrl_show(struct seq_file *s, void *v)
+{
+	struct uidtag_table *t;
+	unsigned long overflows = 0;
+	unsigned int entries = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		t = &per_cpu(uidtag_tables, cpu);
+		entries += t->entries;
+		overflows += t->overflows;
+	}
+	seq_printf(s, "entries %u\noverflows %lu\n", entries, overflows);
+	return 0;
+}
+
+static int uidtag_ctrl_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, uidtag_ctrl_show, NULL);
+}
+
+static int uidtag_tag_socket(int fd, u32 tag)
+{
+	struct socket *sock;
+	int err;
+
+	sock = sockfd_lookup(fd, &err);
+	if (!sock)
+		return err;
+	if (sock->sk)
+		sock->sk->sk_tag = tag;
+	sockfd_put(sock);
+	return 0;
+}
+
+static ssize_t uidtag_ctrl_write(struct file *file, const char __user *buf,
+				 size_t count, loff_t *ppos)
+{
+	char cmd[64];
+	int fd, tag, err;
+
+	if (count >= sizeof(cmd))
+		return -EINVAL;
+	if (copy_from_user(cmd, buf, count))
+		return -EFAULT;
+	cmd[count] = '\0';
+
+	switch (cmd[0]) {
+	case 't':
+		if (sscanf(cmd + 1, "%d %i", &fd, &tag) != 2)
+			return -EINVAL;
+		err = uidtag_tag_socket(fd, tag);
+		break;
+	case 'r':
+		if (!capable(CAP_NET_ADMIN))
+			return -EPERM;
+		uidtag_reset();
+		err = 0;
+		break;
+	default:
+		return -EINVAL;
+	}
+	return err ? err : count;
+}
+
+static const struct file_operations uidtag_ctrl_fops = {
+	.owner   = THIS_MODULE,
+	.open    = uidtag_ctrl_open,
+	.read    = seq_read,
+	.write   = uidtag_ctrl_write,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+
+static int __init uidtag_mt_init(void)
+{
+	int cpu, i, ret;
+
+	for_each_possible_cpu(cpu) {
+		struct uidtag_table *t = &per_cpu(uidtag_tables, cpu);
+
+		spin_lock_init(&t->lock);
+		for (i = 0; i < UIDTAG_HASH_SIZE; i++)
+			INIT_HLIST_HEAD(&t->hash[i]);
+	}
+
+	uidtag_dir = proc_mkdir("xt_uidtag", init_net.proc_net);
+	if (!uidtag_dir)
+		return -ENOMEM;
+	if (!proc_create("stats", S_IRUGO, uidtag_dir, &uidtag_stats_fops) ||
+	    !proc_create("ctrl", S_IRUGO | S_IWUGO, uidtag_dir,
+			 &uidtag_ctrl_fops)) {
+		ret = -ENOMEM;
+		goto err;
+	}
+
+	ret = xt_register_matches(uidtag_mt_reg, ARRAY_SIZE(uidtag_mt_reg));
+	if (ret)
+		goto err;
+	return 0;
+
+err:
+	remove_proc_entry("ctrl", uidtag_dir);
+	remove_proc_entry("stats", uidtag_dir);
+	remove_proc_entry("xt_uidtag", init_net.proc_net);
+	return ret;
+}
+
+static void __exit uidtag_mt_exit(void)
+{
+	xt_unregister_matches(uidtag_mt_reg, ARRAY_SIZE(uidtag_mt_reg));
+	remove_proc_entry("ctrl", uidtag_dir);
+	remove_proc_entry("stats", uidtag_dir);
+	remove_proc_entry("xt_uidtag", init_net.proc_net);
+	uidtag_reset();
+	rcu_barrier();
+}
+
+module_init(uidtag_mt_init);
+module_exit(uidtag_mt_exit);
+MODULE_DESCRIPTION("Xtables: socket uid and tag matching and accounting");
+MODULE_LICENSE("GPL");
+MODULE_ALIAS("ipt_uidtag");
+MODULE_ALIAS("ip6t_uidtag");
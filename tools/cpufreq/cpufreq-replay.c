@@ -0,0 +1,404 @@
+/* $(CROSS_COMPILE)cc -Wall -Wextra -O2 -o cpufreq-replay cpufreq-replay.c */
+
+/*
+ * Copyright (c) 2010 by Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ */
+
+/*
+ * Record a CPU load trace, and replay it under cpufreq governors to compare
+ * how fast they respond to it and at what speeds the CPU spends its time.
+ *
+ * A trace is a text file of periods, one per line: "<period_us> <work_us>",
+ * where work_us is the CPU time the period needs at the highest speed.
+ * Lines starting with '#' are ignored.
+ *
+ * Record mode (-r) samples /proc/stat and scaling_cur_freq of cpu0 every
+ * -p microseconds for -t seconds while the workload of interest runs, e.g.
+ * flinging a list, and writes the busy time of each period scaled to the
+ * highest speed.
+ *
+ * Replay mode (-f) selects each governor named with -g for cpu0 in turn.
+ * Each period is a frame: its work starts at the beginning of the period
+ * and is due by its end.  The time to complete each frame, the number of
+ * frames that missed their deadline and the time spent at each speed, from
+ * cpufreq_stats, are printed per governor.  The work is a calibrated busy
+ * loop, measured with the performance governor beforehand.
+ *
+ *	cpufreq-replay -r /data/scroll.trace -t 10
+ *	cpufreq-replay -f /data/scroll.trace -g ondemand,interactive
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#define CPUFREQ_DIR	"/sys/devices/system/cpu/cpu0/cpufreq/"
+#define MAX_FREQS	32
+
+/* frame completion time histogram, 100us buckets up to 1s */
+#define LAT_BUCKET_US	100
+#define LAT_BUCKETS	(1000000 / LAT_BUCKET_US + 1)
+
+struct period {
+	unsigned long period_us;
+	unsigned long work_us;
+};
+
+static struct period *trace;
+static unsigned long nr_periods;
+
+static double loops_per_us;
+static volatile unsigned long sink;
+
+static unsigned long lat_hist[LAT_BUCKETS];
+static unsigned long long lat_max;
+
+static char default_govs[] = "ondemand,interactive";
+
+static unsigned long long now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void sleep_until(unsigned long long t)
+{
+	struct timespec ts = {
+		.tv_sec = t / 1000000,
+		.tv_nsec = (t % 1000000) * 1000,
+	};
+
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+static void spin(unsigned long loops)
+{
+	unsigned long i;
+
+	for (i = 0; i < loops; i++)
+		sink += i;
+}
+
+static int read_sysfs(const char *name, char *buf, int len)
+{
+	char path[256];
+	FILE *f;
+	int n;
+
+	snprintf(path, sizeof(path), CPUFREQ_DIR "%s", name);
+	f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+	n = fread(buf, 1, len - 1, f);
+	buf[n > 0 ? n : 0] = '\0';
+	fclose(f);
+	return 0;
+}
+
+static unsigned long read_ulong(const char *name)
+{
+	char buf[64];
+
+	if (read_sysfs(name, buf, sizeof(buf)))
+		exit(1);
+	return strtoul(buf, NULL, 10);
+}
+
+static int set_governor(const char *gov)
+{
+	const char *path = CPUFREQ_DIR "scaling_governor";
+	FILE *f;
+
+	f = fopen(path, "w");
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+	if (fprintf(f, "%s\n", gov) < 0 || fclose(f)) {
+		fprintf(stderr, "%s: cannot select %s\n", path, gov);
+		return -1;
+	}
+	return 0;
+}
+
+/* cpufreq_stats time_in_state of cpu0, in 10ms units; returns entries */
+static int read_time_in_state(unsigned long *freq, unsigned long long *time)
+{
+	char buf[4096], *p;
+	int n = 0;
+
+	if (read_sysfs("stats/time_in_state", buf, sizeof(buf)))
+		return 0;
+	for (p = buf; n < MAX_FREQS && *p; n++) {
+		if (sscanf(p, "%lu %llu", &freq[n], &time[n]) != 2)
+			break;
+		p = strchr(p, '\n');
+		if (!p)
+			break;
+		p++;
+	}
+	return n;
+}
+
+static void read_cpu_times(unsigned long long *busy, unsigned long long *total)
+{
+	unsigned long long v[8] = { 0 };
+	FILE *f = fopen("/proc/stat", "r");
+	int i;
+
+	if (!f || fscanf(f, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+			 &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6],
+			 &v[7]) < 4) {
+		perror("/proc/stat");
+		exit(1);
+	}
+	fclose(f);
+
+	for (*total = 0, i = 0; i < 8; i++)
+		*total += v[i];
+	/* idle and iowait */
+	*busy = *total - v[3] - v[4];
+}
+
+static int record(const char *file, unsigned long period_us, int seconds)
+{
+	unsigned long long busy, total, last_busy, next;
+	unsigned long max_freq = read_ulong("cpuinfo_max_freq");
+	unsigned long i, n = seconds * 1000000ULL / period_us;
+	long ticks_per_sec = sysconf(_SC_CLK_TCK);
+	FILE *f = fopen(file, "w");
+
+	if (!f) {
+		perror(file);
+		return 1;
+	}
+	fprintf(f, "# period_us work_us\n");
+
+	/*
+	 * /proc/stat counts in ticks, so short periods are quantised; the
+	 * busy time of a period is charged at the speed seen at its end.
+	 */
+	read_cpu_times(&last_busy, &total);
+	next = now_us();
+	for (i = 0; i < n; i++) {
+		unsigned long cur_freq;
+		double work;
+
+		next += period_us;
+		sleep_until(next);
+		cur_freq = read_ulong("scaling_cur_freq");
+		read_cpu_times(&busy, &total);
+
+		work = (double)(busy - last_busy) * 1000000 / ticks_per_sec;
+		if (work > period_us)
+			work = period_us;
+		work = work * cur_freq / max_freq;
+		fprintf(f, "%lu %.0f\n", period_us, work);
+
+		last_busy = busy;
+	}
+
+	fclose(f);
+	return 0;
+}
+
+static int load_trace(const char *file)
+{
+	unsigned long alloc = 0, p, w;
+	char line[128];
+	FILE *f = fopen(file, "r");
+
+	if (!f) {
+		perror(file);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || sscanf(line, "%lu %lu", &p, &w) != 2)
+			continue;
+		if (nr_periods == alloc) {
+			alloc = alloc ? alloc * 2 : 1024;
+			trace = realloc(trace, alloc * sizeof(*trace));
+			if (!trace) {
+				perror("realloc");
+				exit(1);
+			}
+		}
+		trace[nr_periods].period_us = p;
+		trace[nr_periods].work_us = w > p ? p : w;
+		nr_periods++;
+	}
+	fclose(f);
+
+	if (!nr_periods) {
+		fprintf(stderr, "%s: empty trace\n", file);
+		return -1;
+	}
+	return 0;
+}
+
+/* Busy loop iterations per uS at the highest speed. */
+static int calibrate(void)
+{
+	unsigned long long t;
+	unsigned long loops = 1000000;
+
+	if (set_governor("performance"))
+		return -1;
+	sleep(1);
+
+	do {
+		loops *= 2;
+		t = now_us();
+		spin(loops);
+		t = now_us() - t;
+	} while (t < 200000);
+
+	loops_per_us = (double)loops / t;
+	return 0;
+}
+
+static unsigned long long percentile(double pct)
+{
+	unsigned long want = nr_periods * pct / 100, seen = 0;
+	int i;
+
+	for (i = 0; i < LAT_BUCKETS; i++) {
+		seen += lat_hist[i];
+		if (seen > want)
+			return (unsigned long long)i * LAT_BUCKET_US;
+	}
+	return lat_max;
+}
+
+static void replay(const char *gov)
+{
+	unsigned long freq[MAX_FREQS], freq2[MAX_FREQS];
+	unsigned long long tis[MAX_FREQS], tis2[MAX_FREQS], sum = 0, avg = 0;
+	unsigned long long start, done, lat;
+	unsigned long i, missed = 0;
+	int n, n2, j;
+
+	if (set_governor(gov))
+		return;
+
+	memset(lat_hist, 0, sizeof(lat_hist));
+	lat_max = 0;
+
+	/* start from an idle CPU at the speed the governor picks for it */
+	sleep(2);
+	n = read_time_in_state(freq, tis);
+
+	start = now_us();
+	for (i = 0; i < nr_periods; i++) {
+		spin(trace[i].work_us * loops_per_us);
+		done = now_us();
+
+		lat = done - start;
+		lat_hist[lat / LAT_BUCKET_US < LAT_BUCKETS - 1 ?
+			 lat / LAT_BUCKET_US : LAT_BUCKETS - 1]++;
+		if (lat > lat_max)
+			lat_max = lat;
+
+		/* a late frame delays the next one, as it would on screen */
+		if (lat > trace[i].period_us) {
+			missed++;
+			start = done;
+		} else {
+			start += trace[i].period_us;
+			sleep_until(start);
+		}
+	}
+
+	n2 = read_time_in_state(freq2, tis2);
+	if (n2 != n)
+		n = 0;
+	for (j = 0; j < n; j++) {
+		tis[j] = tis2[j] - tis[j];
+		sum += tis[j];
+		avg += tis[j] * freq[j];
+	}
+
+	printf("%-12s %7.2f %8llu %8llu %8llu %8llu %9llu\n", gov,
+	       100.0 * missed / nr_periods, percentile(50), percentile(95),
+	       percentile(99), lat_max, sum ? avg / sum / 1000 : 0);
+	for (j = 0; j < n; j++)
+		if (tis[j])
+			printf("%12s %7lu MHz %6.1f%%\n", "", freq[j] / 1000,
+			       100.0 * tis[j] / sum);
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s -r <trace> [-t seconds] [-p period us]\n"
+		"       %s -f <trace> [-g gov[,gov...]]\n", name, name);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	const char *rec_file = NULL, *file = NULL;
+	unsigned long period_us = 16667;
+	char *govs = default_govs, *g, old_gov[64];
+	int seconds = 10, c;
+
+	while ((c = getopt(argc, argv, "r:f:g:p:t:")) != -1) {
+		switch (c) {
+		case 'r':
+			rec_file = optarg;
+			break;
+		case 'f':
+			file = optarg;
+			break;
+		case 'g':
+			govs = optarg;
+			break;
+		case 'p':
+			period_us = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			seconds = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (rec_file) {
+		if (file || !period_us || seconds <= 0)
+			usage(argv[0]);
+		return record(rec_file, period_us, seconds);
+	}
+	if (!file || load_trace(file))
+		usage(argv[0]);
+
+	if (read_sysfs("scaling_governor", old_gov, sizeof(old_gov)))
+		return 1;
+	old_gov[strcspn(old_gov, "\n")] = '\0';
+
+	if (calibrate())
+		return 1;
+
+	printf("%lu periods, %.1f loops/us at %lu MHz\n", nr_periods,
+	       loops_per_us, read_ulong("cpuinfo_max_freq") / 1000);
+	printf("%-12s %7s %8s %8s %8s %8s %9s\n", "governor", "missed%",
+	       "p50(us)", "p95(us)", "p99(us)", "max(us)", "avg MHz");
+	for (g = strtok(govs, ","); g; g = strtok(NULL, ","))
+		replay(g);
+
+	set_governor(old_gov);
+	free(trace);
+	return 0;
+}
@@ -0,0 +1,164 @@
+/* $(CROSS_COMPILE)cc -Wall -Wextra -O2 -o fsync-bench fsync-bench.c */
+
+/*
+ * Copyright (c) 2010 by Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ */
+
+/*
+ * Measure fsync() latency for the write pattern of a database journal:
+ * small records written to a file followed by fsync() after each one.
+ *
+ * In append mode (the default) records are appended to the file; in
+ * overwrite mode they are written in place, cycling over the records of a
+ * file that was filled and synced beforehand.  -n fsync() calls are timed
+ * and their latency percentiles printed.
+ *
+ * To compare full and fast commits on ext4, run it on a loop device
+ * mounted with and without -o fast_commit:
+ *
+ *	dd if=/dev/zero of=/data/ext4.img bs=1M count=256
+ *	losetup /dev/block/loop0 /data/ext4.img
+ *	mke2fs -t ext4 /dev/block/loop0
+ *	mount -t ext4 -o fast_commit /dev/block/loop0 /mnt
+ *	fsync-bench -f /mnt/journal -m append
+ *	cat /proc/fs/jbd2/loop0-8/info
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+/* fsync latency histogram, 10us buckets up to 1s, then one overflow bucket */
+#define LAT_BUCKET_US	10
+#define LAT_BUCKETS	(1000000 / LAT_BUCKET_US + 1)
+
+/* records in the file rewritten by overwrite mode */
+#define OVERWRITE_RECORDS	64
+
+static unsigned long lat_hist[LAT_BUCKETS];
+static unsigned long long lat_max, lat_total;
+
+static unsigned long long now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static unsigned long long percentile(unsigned long nr, double pct)
+{
+	unsigned long want = nr * pct / 100, seen = 0;
+	int i;
+
+	for (i = 0; i < LAT_BUCKETS; i++) {
+		seen += lat_hist[i];
+		if (seen > want)
+			return (unsigned long long)i * LAT_BUCKET_US;
+	}
+	return lat_max;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s -f <file> [-m append|overwrite] [-s record bytes] "
+		"[-n records]\n", name);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	const char *file = NULL, *mode = "append";
+	unsigned long size = 512, nr = 2000, i;
+	int overwrite, fd, c;
+	char *buf;
+
+	while ((c = getopt(argc, argv, "f:m:s:n:")) != -1) {
+		switch (c) {
+		case 'f':
+			file = optarg;
+			break;
+		case 'm':
+			mode = optarg;
+			break;
+		case 's':
+			size = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			nr = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (!file || !size || !nr)
+		usage(argv[0]);
+	if (!strcmp(mode, "overwrite"))
+		overwrite = 1;
+	else if (!strcmp(mode, "append"))
+		overwrite = 0;
+	else
+		usage(argv[0]);
+
+	buf = malloc(size);
+	fd = open(file, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (!buf || fd < 0) {
+		perror(file);
+		return 1;
+	}
+	memset(buf, 0xa5, size);
+
+	/* the file, and its allocation, are on disk before timing starts */
+	if (overwrite) {
+		for (i = 0; i < OVERWRITE_RECORDS; i++)
+			if (write(fd, buf, size) != (ssize_t)size) {
+				perror("write");
+				return 1;
+			}
+	}
+	fsync(fd);
+	sync();
+
+	for (i = 0; i < nr; i++) {
+		unsigned long rec = overwrite ? i % OVERWRITE_RECORDS : i;
+		unsigned long long t, lat;
+
+		buf[0] = i;
+		if (pwrite(fd, buf, size, (off_t)rec * size) != (ssize_t)size) {
+			perror("pwrite");
+			return 1;
+		}
+
+		t = now_us();
+		if (fsync(fd)) {
+			perror("fsync");
+			return 1;
+		}
+		lat = now_us() - t;
+		lat_hist[lat / LAT_BUCKET_US < LAT_BUCKETS - 1 ?
+			 lat / LAT_BUCKET_US : LAT_BUCKETS - 1]++;
+		if (lat > lat_max)
+			lat_max = lat;
+		lat_total += lat;
+	}
+
+	printf("%-10s %8s %8s %8s %8s %8s %9s\n", "mode", "avg(us)", "p50(us)",
+	       "p95(us)", "p99(us)", "max(us)", "fsyncs/s");
+	printf("%-10s %8llu %8llu %8llu %8llu %8llu %9.0f\n", mode,
+	       lat_total / nr, percentile(nr, 50), percentile(nr, 95),
+	       percentile(nr, 99), lat_max, nr * 1e6 / lat_total);
+
+	close(fd);
+	free(buf);
+	return 0;
+}
@@ -0,0 +1,243 @@
+/* $(CROSS_COMPILE)cc -Wall -Wextra -O2 -lpthread -o iosched-bench iosched-bench.c */
+
+/*
+ * Copyright (c) 2010 by Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ */
+
+/*
+ * Compare io schedulers on one block device under the load that hurts
+ * interactive use on phones: a foreground task doing small direct random
+ * reads while a background task writes a large file through the page cache
+ * and calls fsync() every few megabytes.
+ *
+ * For each scheduler named with -s the device is switched to it through
+ * /sys/block/<dev>/queue/scheduler, both tasks run for -t seconds, and read
+ * latency percentiles plus write throughput are printed. The first half of
+ * the device is read, the second half is written.
+ *
+ * The device must use the io scheduler: brd and loop do not, scsi_debug
+ * does and is backed by RAM. See Documentation/block/flash-iosched.txt.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <libgen.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+
+#define READ_SIZE	4096
+#define WRITE_CHUNK	(256 * 1024)
+#define FSYNC_EVERY	(4 * 1024 * 1024)
+
+/* read latency histogram, 10us buckets up to 1s, then one overflow bucket */
+#define LAT_BUCKET_US	10
+#define LAT_BUCKETS	(1000000 / LAT_BUCKET_US + 1)
+
+static char default_scheds[] = "noop,deadline,cfq,flash";
+static const char *device;
+static int runtime = 10;
+static volatile int stop;
+static unsigned long long dev_bytes;
+
+static unsigned long lat_hist[LAT_BUCKETS];
+static unsigned long nr_reads;
+static unsigned long long lat_max;
+static unsigned long long written;
+
+static unsigned long long now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void *reader(void *unused)
+{
+	unsigned long long blocks = dev_bytes / 2 / READ_SIZE;
+	unsigned int seed = 1;
+	void *buf;
+	int fd;
+
+	(void)unused;
+	fd = open(device, O_RDONLY | O_DIRECT);
+	if (fd < 0 || posix_memalign(&buf, READ_SIZE, READ_SIZE)) {
+		perror(device);
+		exit(1);
+	}
+
+	while (!stop) {
+		off_t off = (rand_r(&seed) % blocks) * READ_SIZE;
+		unsigned long long t = now_us(), lat;
+
+		if (pread(fd, buf, READ_SIZE, off) != READ_SIZE) {
+			perror("pread");
+			exit(1);
+		}
+		lat = now_us() - t;
+		lat_hist[lat / LAT_BUCKET_US < LAT_BUCKETS - 1 ?
+			 lat / LAT_BUCKET_US : LAT_BUCKETS - 1]++;
+		if (lat > lat_max)
+			lat_max = lat;
+		nr_reads++;
+	}
+
+	free(buf);
+	close(fd);
+	return NULL;
+}
+
+static void *writer(void *unused)
+{
+	unsigned long long base = dev_bytes / 2, off = 0, since_sync = 0;
+	char *buf;
+	int fd;
+
+	(void)unused;
+	fd = open(device, O_WRONLY);
+	buf = malloc(WRITE_CHUNK);
+	if (fd < 0 || !buf) {
+		perror(device);
+		exit(1);
+	}
+	memset(buf, 0x5a, WRITE_CHUNK);
+
+	while (!stop) {
+		if (pwrite(fd, buf, WRITE_CHUNK, base + off) != WRITE_CHUNK) {
+			perror("pwrite");
+			exit(1);
+		}
+		written += WRITE_CHUNK;
+		since_sync += WRITE_CHUNK;
+		off = (off + WRITE_CHUNK) % (dev_bytes / 2 - WRITE_CHUNK);
+		if (since_sync >= FSYNC_EVERY) {
+			fsync(fd);
+			since_sync = 0;
+		}
+	}
+
+	fsync(fd);
+	free(buf);
+	close(fd);
+	return NULL;
+}
+
+static int set_scheduler(const char *sched)
+{
+	char path[256], *dev = strdup(device);
+	FILE *f;
+
+	snprintf(path, sizeof(path), "/sys/block/%s/queue/scheduler",
+		 basename(dev));
+	free(dev);
+
+	f = fopen(path, "w");
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+	if (fprintf(f, "%s\n", sched) < 0 || fclose(f)) {
+		fprintf(stderr, "%s: cannot select %s\n", path, sched);
+		return -1;
+	}
+	return 0;
+}
+
+static unsigned long long percentile(double pct)
+{
+	unsigned long want = nr_reads * pct / 100, seen = 0;
+	int i;
+
+	for (i = 0; i < LAT_BUCKETS; i++) {
+		seen += lat_hist[i];
+		if (seen > want)
+			return (unsigned long long)i * LAT_BUCKET_US;
+	}
+	return lat_max;
+}
+
+static void run(const char *sched)
+{
+	pthread_t r, w;
+
+	if (set_scheduler(sched))
+		return;
+
+	memset(lat_hist, 0, sizeof(lat_hist));
+	nr_reads = lat_max = written = 0;
+	stop = 0;
+
+	/* do not let dirty data of the previous run bleed into this one */
+	sync();
+
+	pthread_create(&w, NULL, writer, NULL);
+	pthread_create(&r, NULL, reader, NULL);
+	sleep(runtime);
+	stop = 1;
+	pthread_join(r, NULL);
+	pthread_join(w, NULL);
+
+	printf("%-10s %9.0f %8llu %8llu %8llu %8llu %9.1f\n", sched,
+	       (double)nr_reads / runtime, percentile(50), percentile(95),
+	       percentile(99), lat_max,
+	       (double)written / runtime / (1024 * 1024));
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s -d <blockdev> [-s sched[,sched...]] [-t seconds]\n",
+		name);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	char *scheds = default_scheds, *s;
+	int fd, c;
+
+	while ((c = getopt(argc, argv, "d:s:t:")) != -1) {
+		switch (c) {
+		case 'd':
+			device = optarg;
+			break;
+		case 's':
+			scheds = optarg;
+			break;
+		case 't':
+			runtime = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (!device || runtime <= 0)
+		usage(argv[0]);
+
+	fd = open(device, O_RDONLY);
+	if (fd < 0 || ioctl(fd, BLKGETSIZE64, &dev_bytes) ||
+	    dev_bytes < 4 * WRITE_CHUNK) {
+		fprintf(stderr, "%s: not a usable block device\n", device);
+		return 1;
+	}
+	close(fd);
+
+	printf("%-10s %9s %8s %8s %8s %8s %9s\n", "sched", "reads/s",
+	       "p50(us)", "p95(us)", "p99(us)", "max(us)", "write MB/s");
+	for (s = strtok(scheds, ","); s; s = strtok(NULL, ","))
+		run(s);
+
+	return 0;
+}
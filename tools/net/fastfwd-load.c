@@ -0,0 +1,278 @@
+/* $(CROSS_COMPILE)cc -Wall -Wextra -O2 -o fastfwd-load fastfwd-load.c */
+
+/*
+ * Copyright (c) 2010 by Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ */
+
+/*
+ * Measure what the forwarding fast path (CONFIG_NF_FASTFWD_IPV4) saves a
+ * tethering phone, while the tethered machine floods it with pktgen.  The
+ * packets come in on -i, the USB or Wi-Fi interface of the tether, are
+ * masqueraded and leave on -o, towards a machine beyond it.
+ *
+ * For -t seconds each, with /sys/module/nf_fastfwd_ipv4/parameters/enable
+ * at 0 and at 1, the packets received on -i and sent on -o, the fast path
+ * hits and the cpu time spent outside the idle loop are sampled; printed
+ * are the forwarding rate, and the cpu time per forwarded packet.
+ *
+ * A UDP flow is only put on the fast path once a reply has been seen for
+ * it.  On the machine the flood goes to, run this program with -r, which
+ * answers every sender on -p once a second:
+ *
+ *	fastfwd-load -r -p 9000
+ *
+ * On the phone, with tethering up the usual way:
+ *
+ *	echo 1 > /proc/sys/net/ipv4/ip_forward
+ *	iptables -t nat -A POSTROUTING -o pdp0 -j MASQUERADE
+ *
+ * start the sender on the tethered machine with pkt_size 60, count 0,
+ * dst_mac the address of the phone on usb0, dst the machine running -r,
+ * and udp_src_min to udp_src_max and udp_dst_min to udp_dst_max giving as
+ * many flows as wanted, all to -p, see Documentation/networking/pktgen.txt.
+ * Then
+ *
+ *	fastfwd-load -i usb0 -o pdp0 -t 10
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#define ENABLE		"/sys/module/nf_fastfwd_ipv4/parameters/enable"
+#define STATS		"/proc/net/nf_fastfwd"
+#define SENDERS		64
+
+static void die(const char *what)
+{
+	fprintf(stderr, "fastfwd-load: %s: %s\n", what, strerror(errno));
+	exit(1);
+}
+
+static void set_enable(int on)
+{
+	int fd = open(ENABLE, O_WRONLY);
+
+	if (fd < 0)
+		die(ENABLE);
+	if (write(fd, on ? "1" : "0", 1) < 0)
+		die(ENABLE);
+	close(fd);
+}
+
+static int get_enable(void)
+{
+	char c = '1';
+	int fd = open(ENABLE, O_RDONLY);
+
+	if (fd < 0)
+		die(ENABLE);
+	if (read(fd, &c, 1) < 0)
+		die(ENABLE);
+	close(fd);
+	return c == 'Y' || c == '1';
+}
+
+/* busy and total cpu time, all cpus, in USER_HZ ticks */
+static void cpu_ticks(unsigned long long *busy, unsigned long long *total)
+{
+	unsigned long long v[8] = { 0 };
+	FILE *f = fopen("/proc/stat", "r");
+	int i;
+
+	if (!f)
+		die("/proc/stat");
+	if (fscanf(f, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+		   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6],
+		   &v[7]) < 7) {
+		errno = EINVAL;
+		die("/proc/stat");
+	}
+	fclose(f);
+
+	*total = 0;
+	for (i = 0; i < 8; i++)
+		*total += v[i];
+	/* idle and iowait */
+	*busy = *total - v[3] - v[4];
+}
+
+/* the packets @iface received, or with @tx sent */
+static unsigned long long dev_packets(const char *iface, int tx)
+{
+	char line[512], name[64];
+	unsigned long long v[10];
+	FILE *f = fopen("/proc/net/dev", "r");
+	char *p;
+
+	if (!f)
+		die("/proc/net/dev");
+	while (fgets(line, sizeof(line), f)) {
+		p = strchr(line, ':');
+		if (!p)
+			continue;
+		*p = ' ';
+		if (sscanf(line, "%63s %llu %llu %llu %llu %llu %llu %llu %llu "
+			   "%llu %llu", name, &v[0], &v[1], &v[2], &v[3],
+			   &v[4], &v[5], &v[6], &v[7], &v[8], &v[9]) == 11 &&
+		    !strcmp(name, iface)) {
+			fclose(f);
+			return tx ? v[9] : v[1];
+		}
+	}
+	fclose(f);
+	errno = ENODEV;
+	die(iface);
+	return 0;
+}
+
+static unsigned long long fast_hits(void)
+{
+	unsigned long long hits = 0;
+	FILE *f = fopen(STATS, "r");
+
+	if (!f)
+		die(STATS);
+	if (fscanf(f, "flows %*u max %*u learned %*u hits %llu", &hits) != 1) {
+		errno = EINVAL;
+		die(STATS);
+	}
+	fclose(f);
+	return hits;
+}
+
+static void run(const char *in, const char *out, int secs, int on)
+{
+	unsigned long long busy0, total0, busy1, total1, rx, tx, hits;
+	long hz = sysconf(_SC_CLK_TCK);
+	double busy;
+
+	set_enable(on);
+	/* let the rates settle, and the flows get on the fast path */
+	sleep(2);
+
+	rx = dev_packets(in, 0);
+	tx = dev_packets(out, 1);
+	hits = fast_hits();
+	cpu_ticks(&busy0, &total0);
+	sleep(secs);
+	rx = dev_packets(in, 0) - rx;
+	tx = dev_packets(out, 1) - tx;
+	hits = fast_hits() - hits;
+	cpu_ticks(&busy1, &total1);
+
+	busy = (double)(busy1 - busy0) / hz;
+	printf("%-8s %10llu %10llu %10llu %8.1f %12.0f\n", on ? "on" : "off",
+	       rx / secs, tx / secs, hits / secs,
+	       100.0 * (busy1 - busy0) / (total1 > total0 ? total1 - total0 : 1),
+	       tx ? busy * 1e9 / tx : 0.0);
+}
+
+/* answers each sender to @port once a second, until killed */
+static void reply(int port)
+{
+	static char buf[65536];
+	struct {
+		struct sockaddr_in sin;
+		time_t last;
+	} senders[SENDERS];
+	struct sockaddr_in sin;
+	socklen_t len;
+	time_t now;
+	int fd, i, n = 0;
+
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0)
+		die("socket");
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons(port);
+	if (bind(fd, (struct sockaddr *)&sin, sizeof(sin)) < 0)
+		die("bind");
+
+	while (1) {
+		len = sizeof(sin);
+		if (recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr *)&sin,
+			     &len) < 0)
+			die("recvfrom");
+		now = time(NULL);
+		for (i = 0; i < n; i++)
+			if (senders[i].sin.sin_addr.s_addr ==
+			    sin.sin_addr.s_addr &&
+			    senders[i].sin.sin_port == sin.sin_port)
+				break;
+		if (i == n) {
+			/* the oldest goes when there is no room */
+			if (n < SENDERS)
+				n++;
+			else
+				i = 0;
+			senders[i].sin = sin;
+			senders[i].last = 0;
+		}
+		if (senders[i].last == now)
+			continue;
+		senders[i].last = now;
+		sendto(fd, "r", 1, 0, (struct sockaddr *)&sin, sizeof(sin));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *in = "usb0", *out = "pdp0";
+	int port = 9000, secs = 10, responder = 0;
+	int opt, saved;
+
+	while ((opt = getopt(argc, argv, "ri:o:p:t:")) != -1) {
+		switch (opt) {
+		case 'r':
+			responder = 1;
+			break;
+		case 'i':
+			in = optarg;
+			break;
+		case 'o':
+			out = optarg;
+			break;
+		case 'p':
+			port = atoi(optarg);
+			break;
+		case 't':
+			secs = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-i in iface] [-o out iface] "
+				"[-t seconds]\n       %s -r [-p udp port]\n",
+				argv[0], argv[0]);
+			return 1;
+		}
+	}
+	if (port < 1 || port > 65535 || secs < 1) {
+		fprintf(stderr, "fastfwd-load: bad port or time\n");
+		return 1;
+	}
+
+	if (responder)
+		reply(port);
+
+	saved = get_enable();
+	printf("%s to %s, %d seconds each\n", in, out, secs);
+	printf("%-8s %10s %10s %10s %8s %12s\n", "fastfwd", "rx_pps", "fwd_pps",
+	       "hits/s", "busy_%", "cpu_ns/pkt");
+	run(in, out, secs, 0);
+	run(in, out, secs, 1);
+	set_enable(saved);
+
+	return 0;
+}
@@ -0,0 +1,275 @@
+/* $(CROSS_COMPILE)cc -Wall -Wextra -O2 -o skb-pool-load skb-pool-load.c */
+
+/*
+ * Copyright (c) 2010 by Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ */
+
+/*
+ * Measure what the receive buffer pool of a driver saves, while another
+ * machine floods this one with pktgen.  The packets go to a UDP port this
+ * program binds and reads, so that each buffer is freed after its copy to
+ * user space, as for any application.
+ *
+ * For -t seconds each, with /proc/sys/net/core/skb_pool at 0 and at 1,
+ * the packets received on -i, those the interface dropped, and the cpu
+ * time spent outside the idle loop are sampled, and so are the counts of
+ * the pool -p in /proc/net/stat/skb_pool.  Printed are the receive rate,
+ * the cpu time per packet, the share of buffers the pool gave and the
+ * allocations that failed.
+ *
+ * -m takes that many megabytes of memory for the run and touches them,
+ * for the allocations to be made as on a phone short of memory; keep it
+ * below what the low memory killer would take the shell for.
+ *
+ * Start the sender with pkt_size 1500, count 0, dst set to this machine
+ * and udp_dst_min and udp_dst_max to -u, see
+ * Documentation/networking/pktgen.txt.  Then, for Wi-Fi and the modem:
+ *
+ *	skb-pool-load -i wlan0 -p bcm4329 -u 9000 -t 10 -m 200
+ *	skb-pool-load -i pdp0 -p svnet -u 9000 -t 10
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#define ENABLE		"/proc/sys/net/core/skb_pool"
+#define STATS		"/proc/net/stat/skb_pool"
+
+struct pool_counts {
+	unsigned long long hits;
+	unsigned long long misses;
+	unsigned long long recycled;
+	unsigned long long full;
+	unsigned long long failed;
+};
+
+static void die(const char *what)
+{
+	fprintf(stderr, "skb-pool-load: %s: %s\n", what, strerror(errno));
+	exit(1);
+}
+
+static void set_enable(int on)
+{
+	int fd = open(ENABLE, O_WRONLY);
+
+	if (fd < 0)
+		die(ENABLE);
+	if (write(fd, on ? "1" : "0", 1) < 0)
+		die(ENABLE);
+	close(fd);
+}
+
+static int get_enable(void)
+{
+	char c = '1';
+	int fd = open(ENABLE, O_RDONLY);
+
+	if (fd < 0)
+		die(ENABLE);
+	if (read(fd, &c, 1) < 0)
+		die(ENABLE);
+	close(fd);
+	return c == '1';
+}
+
+/* busy and total cpu time, all cpus, in USER_HZ ticks */
+static void cpu_ticks(unsigned long long *busy, unsigned long long *total)
+{
+	unsigned long long v[8] = { 0 };
+	FILE *f = fopen("/proc/stat", "r");
+	int i;
+
+	if (!f)
+		die("/proc/stat");
+	if (fscanf(f, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+		   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6],
+		   &v[7]) < 7) {
+		errno = EINVAL;
+		die("/proc/stat");
+	}
+	fclose(f);
+
+	*total = 0;
+	for (i = 0; i < 8; i++)
+		*total += v[i];
+	/* idle and iowait */
+	*busy = *total - v[3] - v[4];
+}
+
+/* the packets @iface received, and those it dropped */
+static void rx_packets(const char *iface, unsigned long long *packets,
+		       unsigned long long *dropped)
+{
+	char line[512], name[64];
+	unsigned long long bytes, errs;
+	FILE *f = fopen("/proc/net/dev", "r");
+	char *p;
+
+	if (!f)
+		die("/proc/net/dev");
+	while (fgets(line, sizeof(line), f)) {
+		p = strchr(line, ':');
+		if (!p)
+			continue;
+		*p = ' ';
+		if (sscanf(line, "%63s %llu %llu %llu %llu", name, &bytes,
+			   packets, &errs, dropped) == 5 &&
+		    !strcmp(name, iface)) {
+			fclose(f);
+			return;
+		}
+	}
+	fclose(f);
+	errno = ENODEV;
+	die(iface);
+}
+
+static void pool_counts(const char *pool, struct pool_counts *c)
+{
+	char line[256], name[64];
+	unsigned int size, count, held;
+	FILE *f = fopen(STATS, "r");
+
+	if (!f)
+		die(STATS);
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "%63s %u %u %u %llu %llu %llu %llu %llu", name,
+			   &size, &count, &held, &c->hits, &c->misses,
+			   &c->recycled, &c->full, &c->failed) == 9 &&
+		    !strcmp(name, pool)) {
+			fclose(f);
+			return;
+		}
+	}
+	fclose(f);
+	errno = ENOENT;
+	die(pool);
+}
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void run(int fd, const char *iface, const char *pool, int secs,
+		int on)
+{
+	unsigned long long busy0, total0, busy1, total1, end, n;
+	unsigned long long pkts0, drops0, pkts1, drops1;
+	struct pool_counts c0, c1;
+	long hz = sysconf(_SC_CLK_TCK);
+	static char buf[65536];
+	double busy;
+
+	set_enable(on);
+	/* let the rates settle */
+	end = now_ns() + 1000000000ULL;
+	while (now_ns() < end)
+		recv(fd, buf, sizeof(buf), 0);
+
+	rx_packets(iface, &pkts0, &drops0);
+	pool_counts(pool, &c0);
+	cpu_ticks(&busy0, &total0);
+	end = now_ns() + secs * 1000000000ULL;
+	while (now_ns() < end)
+		recv(fd, buf, sizeof(buf), 0);
+	rx_packets(iface, &pkts1, &drops1);
+	pool_counts(pool, &c1);
+	cpu_ticks(&busy1, &total1);
+
+	busy = (double)(busy1 - busy0) / hz;
+	/* the allocations from the pool, found in it or not */
+	n = (c1.hits - c0.hits) + (c1.misses - c0.misses);
+	printf("%-8s %10llu %8llu %8.1f %12.0f %8.1f %8llu\n",
+	       on ? "on" : "off", (pkts1 - pkts0) / secs, drops1 - drops0,
+	       100.0 * (busy1 - busy0) / (total1 > total0 ? total1 - total0 : 1),
+	       pkts1 > pkts0 ? busy * 1e9 / (pkts1 - pkts0) : 0.0,
+	       n ? 100.0 * (c1.hits - c0.hits) / n : 0.0,
+	       c1.failed - c0.failed);
+}
+
+int main(int argc, char **argv)
+{
+	const char *iface = "wlan0", *pool = "bcm4329";
+	int port = 9000, secs = 10, mb = 0;
+	struct sockaddr_in sin;
+	struct timeval tv = { 0, 100000 };
+	int fd, opt, saved;
+	char *hog = NULL;
+
+	while ((opt = getopt(argc, argv, "i:p:u:t:m:")) != -1) {
+		switch (opt) {
+		case 'i':
+			iface = optarg;
+			break;
+		case 'p':
+			pool = optarg;
+			break;
+		case 'u':
+			port = atoi(optarg);
+			break;
+		case 't':
+			secs = atoi(optarg);
+			break;
+		case 'm':
+			mb = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-i iface] [-p pool] "
+				"[-u udp port] [-t seconds] [-m megabytes]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+	if (port < 1 || port > 65535 || secs < 1 || mb < 0) {
+		fprintf(stderr, "skb-pool-load: bad port, time or memory\n");
+		return 1;
+	}
+
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0)
+		die("socket");
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons(port);
+	if (bind(fd, (struct sockaddr *)&sin, sizeof(sin)) < 0)
+		die("bind");
+	/* for the loops to see the time when the flood stops */
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	if (mb) {
+		hog = malloc((size_t)mb << 20);
+		if (!hog)
+			die("malloc");
+		memset(hog, 0x5a, (size_t)mb << 20);
+	}
+
+	saved = get_enable();
+	printf("%s, pool %s, udp port %d, %d seconds each, %d MB taken\n",
+	       iface, pool, port, secs, mb);
+	printf("%-8s %10s %8s %8s %12s %8s %8s\n", "skb_pool", "rx_pps",
+	       "dropped", "busy_%", "cpu_ns/pkt", "hit_%", "failed");
+	run(fd, iface, pool, secs, 0);
+	run(fd, iface, pool, secs, 1);
+	set_enable(saved);
+
+	free(hog);
+	close(fd);
+	return 0;
+}
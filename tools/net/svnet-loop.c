@@ -0,0 +1,292 @@
+/* $(CROSS_COMPILE)cc -Wall -Wextra -O2 -o svnet-loop svnet-loop.c */
+
+/*
+ * Copyright (c) 2010 by Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ */
+
+/*
+ * Run packets around a PDP interface of svnet over the OneDRAM loopback
+ * (CONFIG_SAMSUNG_ONEDRAM_LOOPBACK), and measure the rate and the cpu time
+ * per packet.  UDP datagrams of -s bytes are sent, as raw IP packets on
+ * the interface, from -f to the address of the interface; the loopback
+ * brings them back, and they arrive at a UDP socket this program binds.
+ * The address -f has to pass the reverse path check on the interface, so
+ * give it a route through the interface or turn rp_filter off for it.
+ *
+ * For -t seconds the packets are sent as fast as they go, the socket read
+ * in between, and then the packets sent and received, the receive rate
+ * and the busy cpu time per received packet are printed, with the
+ * mailbox interrupts the loopback raised and the reads svnet did for
+ * them.  The svnet debug file shows how the receive batches went.
+ *
+ * -c sets the mailbox coalescing of svnet for the run, in microseconds,
+ * 0 for none.  The loopback raises an interrupt for each frame with
+ * /sys/module/onedram_loopback/parameters/irq_per_frame at 1.
+ *
+ *	ifconfig pdp0 10.0.0.1 pointopoint 10.0.0.2 up
+ *	svnet-loop -i pdp0 -f 10.0.0.2 -s 1400 -t 10 -c 0
+ *	svnet-loop -i pdp0 -f 10.0.0.2 -s 1400 -t 10 -c 200
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+
+#define PORT		9000
+#define COALESCE	"/sys/module/svnet/parameters/coalesce_us"
+#define IRQS		"/sys/module/onedram_loopback/parameters/irqs"
+#define DEBUG		"/sys/class/net/svnet0/debug"
+
+static void die(const char *what)
+{
+	fprintf(stderr, "svnet-loop: %s: %s\n", what, strerror(errno));
+	exit(1);
+}
+
+/* busy and total cpu time, all cpus, in USER_HZ ticks */
+static void cpu_ticks(unsigned long long *busy, unsigned long long *total)
+{
+	unsigned long long v[8] = { 0 };
+	FILE *f = fopen("/proc/stat", "r");
+	int i;
+
+	if (!f)
+		die("/proc/stat");
+	if (fscanf(f, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+		   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6],
+		   &v[7]) < 7) {
+		errno = EINVAL;
+		die("/proc/stat");
+	}
+	fclose(f);
+
+	*total = 0;
+	for (i = 0; i < 8; i++)
+		*total += v[i];
+	/* idle and iowait */
+	*busy = *total - v[3] - v[4];
+}
+
+static void write_param(const char *path, const char *val)
+{
+	int fd = open(path, O_WRONLY);
+
+	if (fd < 0)
+		die(path);
+	if (write(fd, val, strlen(val)) < 0)
+		die(path);
+	close(fd);
+}
+
+/* the first number in @path after @key, 0 if there is none */
+static unsigned long long read_count(const char *path, const char *key)
+{
+	char line[256];
+	unsigned long long v = 0;
+	FILE *f = fopen(path, "r");
+	char *p;
+
+	if (!f)
+		return 0;
+	while (fgets(line, sizeof(line), f)) {
+		p = strstr(line, key);
+		if (p && sscanf(p + strlen(key), "%llu", &v) == 1)
+			break;
+	}
+	fclose(f);
+	return v;
+}
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static unsigned short csum(const void *data, int len)
+{
+	const unsigned short *p = data;
+	unsigned long sum = 0;
+
+	for (; len > 1; len -= 2)
+		sum += *p++;
+	if (len)
+		sum += *(const unsigned char *)p;
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+	return ~sum;
+}
+
+/* an IP packet with a UDP datagram of @size bytes, without a UDP checksum */
+static int build(unsigned char *pkt, struct in_addr from, struct in_addr to,
+		 int size)
+{
+	struct iphdr *ip = (struct iphdr *)pkt;
+	struct udphdr *udp = (struct udphdr *)(ip + 1);
+	int len = sizeof(*ip) + sizeof(*udp) + size;
+
+	memset(pkt, 0, len);
+	ip->version = 4;
+	ip->ihl = sizeof(*ip) / 4;
+	ip->tot_len = htons(len);
+	ip->ttl = 64;
+	ip->protocol = IPPROTO_UDP;
+	ip->saddr = from.s_addr;
+	ip->daddr = to.s_addr;
+	ip->check = csum(ip, sizeof(*ip));
+	udp->source = htons(PORT);
+	udp->dest = htons(PORT);
+	udp->len = htons(sizeof(*udp) + size);
+	memset(udp + 1, 0x5a, size);
+	return len;
+}
+
+int main(int argc, char **argv)
+{
+	const char *iface = "pdp0";
+	struct in_addr from = { 0 }, to;
+	int size = 1400, secs = 10;
+	unsigned long long busy0, total0, busy1, total1, t, end;
+	unsigned long long sent = 0, recvd = 0, blocked = 0;
+	unsigned long long irqs, reads;
+	const char *coalesce = NULL;
+	char saved[32] = "";
+	static unsigned char pkt[65536], buf[65536];
+	struct sockaddr_ll sll;
+	struct sockaddr_in sin;
+	struct ifreq ifr;
+	int tx, rx, len, opt;
+	long hz = sysconf(_SC_CLK_TCK);
+
+	while ((opt = getopt(argc, argv, "i:f:s:t:c:")) != -1) {
+		switch (opt) {
+		case 'i':
+			iface = optarg;
+			break;
+		case 'f':
+			if (!inet_aton(optarg, &from)) {
+				fprintf(stderr, "svnet-loop: bad address\n");
+				return 1;
+			}
+			break;
+		case 's':
+			size = atoi(optarg);
+			break;
+		case 't':
+			secs = atoi(optarg);
+			break;
+		case 'c':
+			coalesce = optarg;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-i iface] -f from [-s bytes] "
+				"[-t seconds] [-c coalesce us]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (!from.s_addr || size < 1 || size > 1472 || secs < 1) {
+		fprintf(stderr, "svnet-loop: bad arguments\n");
+		return 1;
+	}
+
+	tx = socket(AF_PACKET, SOCK_DGRAM, htons(ETH_P_IP));
+	if (tx < 0)
+		die("packet socket");
+	memset(&ifr, 0, sizeof(ifr));
+	strncpy(ifr.ifr_name, iface, IFNAMSIZ - 1);
+	if (ioctl(tx, SIOCGIFINDEX, &ifr) < 0)
+		die(iface);
+	memset(&sll, 0, sizeof(sll));
+	sll.sll_family = AF_PACKET;
+	sll.sll_protocol = htons(ETH_P_IP);
+	sll.sll_ifindex = ifr.ifr_ifindex;
+	if (ioctl(tx, SIOCGIFADDR, &ifr) < 0)
+		die(iface);
+	to = ((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr;
+	/* a full ring or stopped queue shows as ENOBUFS, not as a sleep */
+	fcntl(tx, F_SETFL, O_NONBLOCK);
+
+	rx = socket(AF_INET, SOCK_DGRAM, 0);
+	if (rx < 0)
+		die("socket");
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons(PORT);
+	sin.sin_addr = to;
+	if (bind(rx, (struct sockaddr *)&sin, sizeof(sin)) < 0)
+		die("bind");
+	fcntl(rx, F_SETFL, O_NONBLOCK);
+
+	len = build(pkt, from, to, size);
+
+	if (coalesce) {
+		FILE *f = fopen(COALESCE, "r");
+
+		if (!f || !fgets(saved, sizeof(saved), f))
+			die(COALESCE);
+		fclose(f);
+		write_param(COALESCE, coalesce);
+	}
+
+	irqs = read_count(IRQS, "");
+	reads = read_count(DEBUG, "read count:");
+	cpu_ticks(&busy0, &total0);
+	t = now_ns();
+	end = t + secs * 1000000000ULL;
+	while (now_ns() < end) {
+		if (sendto(tx, pkt, len, 0, (struct sockaddr *)&sll,
+			   sizeof(sll)) == len)
+			sent++;
+		else if (errno == ENOBUFS || errno == EAGAIN)
+			blocked++;
+		else
+			die("sendto");
+		while (recv(rx, buf, sizeof(buf), 0) > 0)
+			recvd++;
+	}
+	/* what is still on its way */
+	usleep(100000);
+	while (recv(rx, buf, sizeof(buf), 0) > 0)
+		recvd++;
+	t = now_ns() - t;
+	cpu_ticks(&busy1, &total1);
+	irqs = read_count(IRQS, "") - irqs;
+	reads = read_count(DEBUG, "read count:") - reads;
+
+	if (coalesce)
+		write_param(COALESCE, saved);
+
+	printf("%s, %s", iface, inet_ntoa(from));
+	printf(" to %s, %d bytes, %d seconds\n", inet_ntoa(to), size, secs);
+	printf("%12s %12s %10s %10s %8s %12s %10s %10s\n", "sent", "received",
+	       "blocked", "rx_pps", "busy_%", "cpu_ns/pkt", "irqs", "reads");
+	printf("%12llu %12llu %10llu %10.0f %8.1f %12.0f %10llu %10llu\n",
+	       sent, recvd, blocked, recvd * 1e9 / t,
+	       100.0 * (busy1 - busy0) / (total1 > total0 ? total1 - total0 : 1),
+	       recvd ? (double)(busy1 - busy0) / hz * 1e9 / recvd : 0.0,
+	       irqs, reads);
+
+	close(rx);
+	close(tx);
+	return 0;
+}
@@ -0,0 +1,332 @@
+/* $(CROSS_COMPILE)cc -Wall -Wextra -O2 -o tcp-mobile tcp-mobile.c */
+
+/*
+ * Copyright (c) 2010 by Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ */
+
+/*
+ * Measure what a bulk TCP upload does to the latency of the link it runs
+ * over: one connection sends as fast as it can for -t seconds, while a
+ * second one sends a small probe every 100ms and waits for it to come
+ * back.  The probes queue behind the bulk data wherever it queues, so
+ * their round trip time is the delay a phone sees on an interactive
+ * connection while something uploads.  Printed are the goodput of the
+ * upload, the round trip times of the probes, and the smoothed RTT and
+ * congestion window the kernel has for the upload at the end.
+ *
+ * Without -a the receiving end is a child on the loopback; -s runs only
+ * that end, for a client on another machine or namespace.  A mobile link
+ * is made out of lo with netem for the delay and tbf for the rate, with
+ * the tbf limit as the buffer of the modem.  lo has to send packets no
+ * larger than tbf lets through:
+ *
+ *	ifconfig lo mtu 1500
+ *	ethtool -K lo tso off gso off
+ *	tc qdisc add dev lo root handle 1: netem delay 40ms 10ms
+ *	tc qdisc add dev lo parent 1:1 handle 10: tbf rate 2mbit \
+ *		buffer 3200 limit 100000
+ *
+ * For an HSPA link, 80ms round trip, with up to 400ms of queue in the
+ * modem.  netem orphans the packets, so the kernel sees the emulated link
+ * as it sees a modem: as gone once they are handed over.
+ *
+ * -l sets /proc/sys/net/ipv4/tcp_limit_output_bytes for the run, and -w
+ * the tcp_wmem_max of the interface -i, and both are put back after it:
+ *
+ *	tcp-mobile -t 20 -l 0 -w 0
+ *	tcp-mobile -t 20 -l 131072 -w 0
+ *	tcp-mobile -t 20 -l 131072 -w 65536
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <linux/sockios.h>
+
+#define PORT		9100	/* bulk data, the probes on PORT + 1 */
+#define LIMIT		"/proc/sys/net/ipv4/tcp_limit_output_bytes"
+#define PROBE_MS	100
+#define CHUNK		65536
+
+static void die(const char *what)
+{
+	fprintf(stderr, "tcp-mobile: %s: %s\n", what, strerror(errno));
+	exit(1);
+}
+
+static unsigned long long now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* what @path holds into @saved, and @val into @path */
+static void set_param(const char *path, const char *val, char *saved,
+		      int size)
+{
+	FILE *f = fopen(path, "r");
+	int fd;
+
+	if (!f || !fgets(saved, size, f))
+		die(path);
+	fclose(f);
+
+	fd = open(path, O_WRONLY);
+	if (fd < 0)
+		die(path);
+	if (write(fd, val, strlen(val)) < 0)
+		die(path);
+	close(fd);
+}
+
+static void put_param(const char *path, const char *saved)
+{
+	int fd = open(path, O_WRONLY);
+
+	if (fd < 0 || write(fd, saved, strlen(saved)) < 0)
+		die(path);
+	close(fd);
+}
+
+static int listen_on(struct in_addr addr, int port)
+{
+	struct sockaddr_in sin;
+	int fd, one = 1;
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+		die("socket");
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons(port);
+	sin.sin_addr = addr;
+	if (bind(fd, (struct sockaddr *)&sin, sizeof(sin)) < 0)
+		die("bind");
+	if (listen(fd, 4) < 0)
+		die("listen");
+	return fd;
+}
+
+static int connect_to(struct in_addr addr, int port)
+{
+	struct sockaddr_in sin;
+	int fd, one = 1;
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+		die("socket");
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons(port);
+	sin.sin_addr = addr;
+	if (connect(fd, (struct sockaddr *)&sin, sizeof(sin)) < 0)
+		die("connect");
+	/* the probes go out as they are written */
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	return fd;
+}
+
+/*
+ * The receiving end: sinks the bulk connection and echoes the probes,
+ * a connection pair at a time, until killed.
+ */
+static void serve(int lbulk, int lprobe)
+{
+	static char buf[CHUNK];
+	struct pollfd p[2];
+	int one = 1;
+	ssize_t n;
+
+	while (1) {
+		p[0].fd = accept(lbulk, NULL, NULL);
+		if (p[0].fd < 0)
+			die("accept");
+		p[1].fd = accept(lprobe, NULL, NULL);
+		if (p[1].fd < 0)
+			die("accept");
+		setsockopt(p[1].fd, IPPROTO_TCP, TCP_NODELAY, &one,
+			   sizeof(one));
+		p[0].events = p[1].events = POLLIN;
+
+		while (poll(p, 2, -1) > 0) {
+			if (p[0].revents) {
+				n = read(p[0].fd, buf, sizeof(buf));
+				if (n <= 0)
+					break;
+			}
+			if (p[1].revents) {
+				n = read(p[1].fd, buf, sizeof(buf));
+				if (n <= 0 || write(p[1].fd, buf, n) != n)
+					break;
+			}
+		}
+		close(p[0].fd);
+		close(p[1].fd);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *iface = "lo", *limit = NULL, *wmem = NULL;
+	struct in_addr addr = { htonl(INADDR_LOOPBACK) };
+	struct in_addr any = { htonl(INADDR_ANY) };
+	int server = 0, remote = 0, secs = 10;
+	char saved_limit[32] = "", saved_wmem[32] = "", path[128];
+	unsigned long long t0, t, end, next, sent_at = 0, echo, rtt;
+	unsigned long long written = 0, probes = 0, rtt_sum = 0, rtt_max = 0;
+	static char buf[CHUNK];
+	struct tcp_info ti;
+	socklen_t len = sizeof(ti);
+	struct pollfd p[2];
+	int bulk, probe, lbulk, lprobe, opt, outq = 0;
+	pid_t child = 0;
+	ssize_t n;
+
+	while ((opt = getopt(argc, argv, "sa:i:t:l:w:")) != -1) {
+		switch (opt) {
+		case 's':
+			server = 1;
+			break;
+		case 'a':
+			if (!inet_aton(optarg, &addr)) {
+				fprintf(stderr, "tcp-mobile: bad address\n");
+				return 1;
+			}
+			remote = 1;
+			break;
+		case 'i':
+			iface = optarg;
+			break;
+		case 't':
+			secs = atoi(optarg);
+			break;
+		case 'l':
+			limit = optarg;
+			break;
+		case 'w':
+			wmem = optarg;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-s] [-a addr] [-i iface] "
+				"[-t seconds] [-l limit_output_bytes] "
+				"[-w tcp_wmem_max]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (secs < 1) {
+		fprintf(stderr, "tcp-mobile: bad time\n");
+		return 1;
+	}
+
+	if (server || !remote) {
+		lbulk = listen_on(server ? any : addr, PORT);
+		lprobe = listen_on(server ? any : addr, PORT + 1);
+		if (server)
+			serve(lbulk, lprobe);
+		child = fork();
+		if (child < 0)
+			die("fork");
+		if (!child)
+			serve(lbulk, lprobe);
+		close(lbulk);
+		close(lprobe);
+	}
+
+	if (limit)
+		set_param(LIMIT, limit, saved_limit, sizeof(saved_limit));
+	snprintf(path, sizeof(path), "/proc/sys/net/ipv4/conf/%s/tcp_wmem_max",
+		 iface);
+	if (wmem)
+		set_param(path, wmem, saved_wmem, sizeof(saved_wmem));
+
+	/* the buffer ceilings apply from the connect on */
+	bulk = connect_to(addr, PORT);
+	probe = connect_to(addr, PORT + 1);
+	fcntl(bulk, F_SETFL, O_NONBLOCK);
+	memset(buf, 0x5a, sizeof(buf));
+
+	p[0].fd = bulk;
+	p[0].events = POLLOUT;
+	p[1].fd = probe;
+	p[1].events = POLLIN;
+	t0 = now_us();
+	end = t0 + secs * 1000000ULL;
+	next = t0;
+	while ((t = now_us()) < end) {
+		if (!sent_at && t >= next) {
+			sent_at = t;
+			if (write(probe, &sent_at, sizeof(sent_at)) !=
+			    sizeof(sent_at))
+				die("probe");
+			next = t + PROBE_MS * 1000;
+		}
+		if (poll(p, 2, PROBE_MS) < 0)
+			die("poll");
+		if (p[0].revents & POLLOUT) {
+			n = write(bulk, buf, sizeof(buf));
+			if (n < 0 && errno != EAGAIN)
+				die("write");
+			if (n > 0)
+				written += n;
+		}
+		if (p[1].revents & POLLIN) {
+			if (read(probe, &echo, sizeof(echo)) != sizeof(echo))
+				die("probe");
+			rtt = now_us() - echo;
+			rtt_sum += rtt;
+			if (rtt > rtt_max)
+				rtt_max = rtt;
+			probes++;
+			sent_at = 0;
+		}
+	}
+	t = now_us() - t0;
+
+	/* what is still unacknowledged did not get there */
+	ioctl(bulk, SIOCOUTQ, &outq);
+	memset(&ti, 0, sizeof(ti));
+	getsockopt(bulk, IPPROTO_TCP, TCP_INFO, &ti, &len);
+
+	if (wmem)
+		put_param(path, saved_wmem);
+	if (limit)
+		put_param(LIMIT, saved_limit);
+
+	printf("%s, %d seconds, limit_output_bytes %s, %s tcp_wmem_max %s\n",
+	       inet_ntoa(addr), secs, limit ? limit : "-", iface,
+	       wmem ? wmem : "-");
+	printf("%12s %8s %12s %12s %10s %6s\n", "goodput_kbps", "probes",
+	       "probe_avg_ms", "probe_max_ms", "srtt_ms", "cwnd");
+	printf("%12.0f %8llu %12.1f %12.1f %10.1f %6u\n",
+	       (written - outq) * 8e3 / t, probes,
+	       probes ? rtt_sum / 1e3 / probes : 0.0, rtt_max / 1e3,
+	       ti.tcpi_rtt / 1e3, ti.tcpi_snd_cwnd);
+
+	close(probe);
+	close(bulk);
+	if (child) {
+		kill(child, SIGTERM);
+		waitpid(child, NULL, 0);
+	}
+	return 0;
+}
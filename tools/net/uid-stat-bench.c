@@ -0,0 +1,263 @@
+/* $(CROSS_COMPILE)cc -Wall -Wextra -O2 -o uid-stat-bench uid-stat-bench.c */
+
+/*
+ * Copyright (c) 2010 by Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ */
+
+/*
+ * Measure what per-uid network accounting (CONFIG_UID_STAT) costs a small
+ * send and receive over loopback, for TCP and UDP.  Each iteration sends
+ * -s bytes on one socket and reads them from the other, in this process,
+ * so both the send and the receive side are accounted.  Every figure is
+ * taken with /sys/module/uid_stat/parameters/enable at 0 and at 1, and is
+ * the best of -r runs of -n iterations.
+ *
+ * With -u the uid table is first filled with that many uids, by children
+ * which each switch to a uid from 10000 on and send one datagram; the
+ * benchmark then runs as the last of them, as the latest app to start
+ * would, keeping root as the saved uid to write the parameter.  This needs
+ * root.
+ *
+ *	uid-stat-bench -s 64 -n 100000
+ *	uid-stat-bench -u 300
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define ENABLE		"/sys/module/uid_stat/parameters/enable"
+#define FIRST_UID	10000
+
+static int bench_uid = -1;
+
+static void die(const char *what)
+{
+	fprintf(stderr, "uid-stat-bench: %s: %s\n", what, strerror(errno));
+	exit(1);
+}
+
+static void set_enable(int on)
+{
+	int fd;
+
+	if (bench_uid >= 0 && seteuid(0) < 0)
+		die("seteuid");
+	fd = open(ENABLE, O_WRONLY);
+	if (fd < 0)
+		die(ENABLE);
+	if (write(fd, on ? "1" : "0", 1) < 0)
+		die(ENABLE);
+	close(fd);
+	if (bench_uid >= 0 && seteuid(bench_uid) < 0)
+		die("seteuid");
+}
+
+static int get_enable(void)
+{
+	char c = '1';
+	int fd = open(ENABLE, O_RDONLY);
+
+	if (fd < 0)
+		die(ENABLE);
+	if (read(fd, &c, 1) < 0)
+		die(ENABLE);
+	close(fd);
+	return c == 'Y' || c == '1';
+}
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static struct sockaddr_in loopback(void)
+{
+	struct sockaddr_in sin;
+
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	return sin;
+}
+
+/* a connected pair of sockets over loopback */
+static void sock_pair(int type, int fd[2])
+{
+	struct sockaddr_in sin = loopback();
+	socklen_t len = sizeof(sin);
+	int one = 1, lfd;
+
+	lfd = socket(AF_INET, type, 0);
+	if (lfd < 0)
+		die("socket");
+	if (bind(lfd, (struct sockaddr *)&sin, sizeof(sin)) < 0)
+		die("bind");
+	if (getsockname(lfd, (struct sockaddr *)&sin, &len) < 0)
+		die("getsockname");
+
+	fd[0] = socket(AF_INET, type, 0);
+	if (fd[0] < 0)
+		die("socket");
+
+	if (type == SOCK_STREAM) {
+		if (listen(lfd, 1) < 0)
+			die("listen");
+		if (connect(fd[0], (struct sockaddr *)&sin, sizeof(sin)) < 0)
+			die("connect");
+		fd[1] = accept(lfd, NULL, NULL);
+		if (fd[1] < 0)
+			die("accept");
+		close(lfd);
+		setsockopt(fd[0], IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	} else {
+		if (connect(fd[0], (struct sockaddr *)&sin, sizeof(sin)) < 0)
+			die("connect");
+		fd[1] = lfd;
+	}
+}
+
+/* best nanoseconds per send and receive */
+static unsigned long long run(int type, int size, int nr, int runs)
+{
+	unsigned long long best = ~0ULL, t;
+	char *buf = malloc(size);
+	int fd[2], i, r, got, n;
+
+	if (!buf)
+		die("malloc");
+	memset(buf, 0x5a, size);
+	sock_pair(type, fd);
+
+	for (r = 0; r < runs; r++) {
+		t = now_ns();
+		for (i = 0; i < nr; i++) {
+			if (send(fd[0], buf, size, 0) != size)
+				die("send");
+			for (got = 0; got < size; got += n) {
+				n = recv(fd[1], buf, size - got, 0);
+				if (n <= 0)
+					die("recv");
+			}
+		}
+		t = (now_ns() - t) / nr;
+		if (t < best)
+			best = t;
+	}
+
+	close(fd[0]);
+	close(fd[1]);
+	free(buf);
+	return best;
+}
+
+/* give the kernel @nr uids to look through, return the last one */
+static uid_t fill_uids(int nr)
+{
+	struct sockaddr_in sin = loopback();
+	int i, fd, status;
+	pid_t pid;
+
+	sin.sin_port = htons(9);	/* discard */
+	for (i = 0; i < nr; i++) {
+		pid = fork();
+		if (pid < 0)
+			die("fork");
+		if (!pid) {
+			if (setuid(FIRST_UID + i) < 0)
+				die("setuid");
+			fd = socket(AF_INET, SOCK_DGRAM, 0);
+			if (fd < 0)
+				die("socket");
+			sendto(fd, "", 1, 0, (struct sockaddr *)&sin,
+			       sizeof(sin));
+			_exit(0);
+		}
+		if (waitpid(pid, &status, 0) < 0)
+			die("waitpid");
+	}
+	return FIRST_UID + nr - 1;
+}
+
+int main(int argc, char **argv)
+{
+	int size = 64, nr = 20000, runs = 5, uids = 0;
+	unsigned long long off, on;
+	int saved, opt, t;
+	static const struct {
+		const char *name;
+		int type;
+	} types[] = {
+		{ "tcp", SOCK_STREAM },
+		{ "udp", SOCK_DGRAM },
+	};
+
+	while ((opt = getopt(argc, argv, "s:n:r:u:")) != -1) {
+		switch (opt) {
+		case 's':
+			size = atoi(optarg);
+			break;
+		case 'n':
+			nr = atoi(optarg);
+			break;
+		case 'r':
+			runs = atoi(optarg);
+			break;
+		case 'u':
+			uids = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-s bytes] [-n iterations] "
+				"[-r runs] [-u uids]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (size < 1 || size > 65000 || nr < 1 || runs < 1) {
+		fprintf(stderr, "uid-stat-bench: bad arguments\n");
+		return 1;
+	}
+
+	saved = get_enable();
+	set_enable(1);
+	if (uids > 0) {
+		uid_t uid = fill_uids(uids);
+
+		/* the accounting goes by the real uid */
+		if (setresuid(uid, uid, 0) < 0)
+			die("setresuid");
+		bench_uid = uid;
+	}
+
+	printf("%d bytes, %d iterations, best of %d, %d extra uids, uid %d\n",
+	       size, nr, runs, uids, (int)getuid());
+	printf("%-6s %10s %10s %10s\n", "proto", "off_ns", "on_ns", "cost_ns");
+	for (t = 0; t < 2; t++) {
+		set_enable(0);
+		off = run(types[t].type, size, nr, runs);
+		set_enable(1);
+		on = run(types[t].type, size, nr, runs);
+		printf("%-6s %10llu %10llu %10lld\n", types[t].name,
+		       off, on, (long long)(on - off));
+	}
+
+	set_enable(saved);
+	return 0;
+}
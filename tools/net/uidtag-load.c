@@ -0,0 +1,196 @@
+/* $(CROSS_COMPILE)cc -Wall -Wextra -O2 -o uidtag-load uidtag-load.c */
+
+/*
+ * Copyright (c) 2010 by Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ */
+
+/*
+ * Measure what the accounting of the uidtag match costs each received
+ * packet, while another machine floods this one with pktgen.  The packets
+ * go to a UDP port this program binds, so that every one of them is looked
+ * up, found owned by our uid and counted, and the socket is never read, so
+ * that they cost nothing after netfilter but the drop.
+ *
+ * For -t seconds each, with /sys/module/xt_uidtag/parameters/enable at 0
+ * and at 1, the packets received on -i and the cpu time spent outside the
+ * idle loop are sampled, and the cpu time per packet printed.  The rules
+ * have to be in place already, say
+ *
+ *	iptables -A INPUT -m uidtag --account
+ *	iptables -A OUTPUT -m uidtag --account
+ *
+ * and the sender started with pkt_size 60, count 0, dst set to this
+ * machine and udp_dst_min and udp_dst_max to -p, see
+ * Documentation/networking/pktgen.txt.  Then
+ *
+ *	uidtag-load -i eth0 -p 9000 -t 10
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#define ENABLE		"/sys/module/xt_uidtag/parameters/enable"
+
+static void die(const char *what)
+{
+	fprintf(stderr, "uidtag-load: %s: %s\n", what, strerror(errno));
+	exit(1);
+}
+
+static void set_enable(int on)
+{
+	int fd = open(ENABLE, O_WRONLY);
+
+	if (fd < 0)
+		die(ENABLE);
+	if (write(fd, on ? "1" : "0", 1) < 0)
+		die(ENABLE);
+	close(fd);
+}
+
+static int get_enable(void)
+{
+	char c = '1';
+	int fd = open(ENABLE, O_RDONLY);
+
+	if (fd < 0)
+		die(ENABLE);
+	if (read(fd, &c, 1) < 0)
+		die(ENABLE);
+	close(fd);
+	return c == 'Y' || c == '1';
+}
+
+/* busy and total cpu time, all cpus, in USER_HZ ticks */
+static void cpu_ticks(unsigned long long *busy, unsigned long long *total)
+{
+	unsigned long long v[8] = { 0 };
+	FILE *f = fopen("/proc/stat", "r");
+	int i;
+
+	if (!f)
+		die("/proc/stat");
+	if (fscanf(f, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+		   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6],
+		   &v[7]) < 7) {
+		errno = EINVAL;
+		die("/proc/stat");
+	}
+	fclose(f);
+
+	*total = 0;
+	for (i = 0; i < 8; i++)
+		*total += v[i];
+	/* idle and iowait */
+	*busy = *total - v[3] - v[4];
+}
+
+static unsigned long long rx_packets(const char *iface)
+{
+	char line[512], name[64];
+	unsigned long long bytes, packets;
+	FILE *f = fopen("/proc/net/dev", "r");
+	char *p;
+
+	if (!f)
+		die("/proc/net/dev");
+	while (fgets(line, sizeof(line), f)) {
+		p = strchr(line, ':');
+		if (!p)
+			continue;
+		*p = ' ';
+		if (sscanf(line, "%63s %llu %llu", name, &bytes, &packets) == 3 &&
+		    !strcmp(name, iface)) {
+			fclose(f);
+			return packets;
+		}
+	}
+	fclose(f);
+	errno = ENODEV;
+	die(iface);
+	return 0;
+}
+
+static void run(const char *iface, int secs, int on)
+{
+	unsigned long long busy0, total0, busy1, total1, pkts;
+	long hz = sysconf(_SC_CLK_TCK);
+	double busy;
+
+	set_enable(on);
+	/* let the rates settle */
+	sleep(1);
+
+	pkts = rx_packets(iface);
+	cpu_ticks(&busy0, &total0);
+	sleep(secs);
+	pkts = rx_packets(iface) - pkts;
+	cpu_ticks(&busy1, &total1);
+
+	busy = (double)(busy1 - busy0) / hz;
+	printf("%-8s %10llu %8.1f %12.0f\n", on ? "on" : "off",
+	       pkts / secs,
+	       100.0 * (busy1 - busy0) / (total1 > total0 ? total1 - total0 : 1),
+	       pkts ? busy * 1e9 / pkts : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+	const char *iface = "eth0";
+	int port = 9000, secs = 10;
+	struct sockaddr_in sin;
+	int fd, opt, saved;
+
+	while ((opt = getopt(argc, argv, "i:p:t:")) != -1) {
+		switch (opt) {
+		case 'i':
+			iface = optarg;
+			break;
+		case 'p':
+			port = atoi(optarg);
+			break;
+		case 't':
+			secs = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-i iface] [-p udp port] "
+				"[-t seconds]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (port < 1 || port > 65535 || secs < 1) {
+		fprintf(stderr, "uidtag-load: bad port or time\n");
+		return 1;
+	}
+
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0)
+		die("socket");
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons(port);
+	if (bind(fd, (struct sockaddr *)&sin, sizeof(sin)) < 0)
+		die("bind");
+
+	saved = get_enable();
+	printf("%s, udp port %d, %d seconds each\n", iface, port, secs);
+	printf("%-8s %10s %8s %12s\n", "account", "rx_pps", "busy_%",
+	       "cpu_ns/pkt");
+	run(iface, secs, 0);
+	run(iface, secs, 1);
+	set_enable(saved);
+
+	close(fd);
+	return 0;
+}
@@ -0,0 +1,185 @@
+/* $(CROSS_COMPILE)cc -Wall -Wextra -O2 -o printk-irqsoff printk-irqsoff.c */
+
+/*
+ * Copyright (c) 2010 by Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ */
+
+/*
+ * Measure the longest interrupts-off section while the kernel logs a burst
+ * of messages, with printk writing the consoles itself (printk.deferred=0)
+ * and with printk_task writing them (printk.deferred=1).  Needs a kernel
+ * built with CONFIG_IRQSOFF_TRACER and debugfs mounted.
+ *
+ * Each run clears tracing_max_latency, selects the irqsoff tracer, writes
+ * -n messages of -s bytes at loglevel -l to /dev/kmsg, which printk()s
+ * them, waits for the consoles to catch up and reads the maximum back.
+ * With -v the trace of the longest section is printed as well.
+ *
+ *	printk-irqsoff -n 200 -s 120
+ *	printk-irqsoff -d /sys/kernel/debug -v
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#define DEFERRED	"/sys/module/printk/parameters/deferred"
+
+static char tracing[256];
+static int verbose;
+
+static void die(const char *what)
+{
+	fprintf(stderr, "printk-irqsoff: %s: %s\n", what, strerror(errno));
+	exit(1);
+}
+
+static void write_file(const char *path, const char *val)
+{
+	int fd = open(path, O_WRONLY | O_TRUNC);
+
+	if (fd < 0)
+		die(path);
+	if (write(fd, val, strlen(val)) < 0)
+		die(path);
+	close(fd);
+}
+
+static int read_file(const char *path, char *buf, int len)
+{
+	int fd = open(path, O_RDONLY);
+	int n;
+
+	if (fd < 0)
+		die(path);
+	n = read(fd, buf, len - 1);
+	if (n < 0)
+		die(path);
+	buf[n] = '\0';
+	close(fd);
+	return n;
+}
+
+static void write_tracing(const char *file, const char *val)
+{
+	char path[320];
+
+	snprintf(path, sizeof(path), "%s/%s", tracing, file);
+	write_file(path, val);
+}
+
+static void print_trace(void)
+{
+	char path[320], buf[4096];
+	int fd, n;
+
+	snprintf(path, sizeof(path), "%s/trace", tracing);
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		die(path);
+	while ((n = read(fd, buf, sizeof(buf))) > 0)
+		fwrite(buf, 1, n, stdout);
+	close(fd);
+}
+
+/* the longest interrupts-off section in microseconds during the burst */
+static unsigned long run(int deferred, int nr, int size, int level)
+{
+	char path[320], buf[64], *msg;
+	int fd, i, len;
+
+	write_file(DEFERRED, deferred ? "1" : "0");
+
+	msg = malloc(size + 16);
+	if (!msg)
+		die("malloc");
+	len = sprintf(msg, "<%d>", level);
+	for (; len < size - 1; len++)
+		msg[len] = 'a' + len % 26;
+	msg[len++] = '\n';
+
+	fd = open("/dev/kmsg", O_WRONLY);
+	if (fd < 0)
+		die("/dev/kmsg");
+
+	write_tracing("current_tracer", "irqsoff");
+	write_tracing("tracing_max_latency", "0");
+	write_tracing("tracing_enabled", "1");
+
+	for (i = 0; i < nr; i++)
+		if (write(fd, msg, len) < 0)
+			die("/dev/kmsg");
+	/* printk_task writes the consoles after we return */
+	sleep(2);
+
+	write_tracing("tracing_enabled", "0");
+	snprintf(path, sizeof(path), "%s/tracing_max_latency", tracing);
+	read_file(path, buf, sizeof(buf));
+	if (verbose)
+		print_trace();
+	write_tracing("current_tracer", "nop");
+
+	close(fd);
+	free(msg);
+	return strtoul(buf, NULL, 10);
+}
+
+int main(int argc, char **argv)
+{
+	const char *debugfs = "/sys/kernel/debug";
+	int nr = 100, size = 80, level = 4;
+	unsigned long sync, deferred;
+	char saved[8];
+	int opt;
+
+	while ((opt = getopt(argc, argv, "d:n:s:l:v")) != -1) {
+		switch (opt) {
+		case 'd':
+			debugfs = optarg;
+			break;
+		case 'n':
+			nr = atoi(optarg);
+			break;
+		case 's':
+			size = atoi(optarg);
+			break;
+		case 'l':
+			level = atoi(optarg);
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-d debugfs] [-n messages] "
+				"[-s bytes] [-l loglevel] [-v]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (size < 8 || size > 1000 || level < 0 || level > 7) {
+		fprintf(stderr, "printk-irqsoff: bad size or loglevel\n");
+		return 1;
+	}
+	snprintf(tracing, sizeof(tracing), "%s/tracing", debugfs);
+
+	read_file(DEFERRED, saved, sizeof(saved));
+
+	sync = run(0, nr, size, level);
+	deferred = run(1, nr, size, level);
+
+	write_file(DEFERRED, saved[0] == 'Y' || saved[0] == '1' ? "1" : "0");
+
+	printf("%d messages of %d bytes at loglevel %d\n", nr, size, level);
+	printf("%-10s %12s\n", "printk", "irqsoff_us");
+	printf("%-10s %12lu\n", "sync", sync);
+	printf("%-10s %12lu\n", "deferred", deferred);
+
+	return 0;
+}